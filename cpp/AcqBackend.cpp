@@ -0,0 +1,154 @@
+/*
+  ---------------------------------------------
+  Acquisition backends - GigE-V library
+  -----------------------------------------------
+*/
+
+#include "stdio.h"
+#include "cordef.h"
+#include "GenApi/GenApi.h"		//!< GenApi lib definitions.
+#include "gevapi.h"				//!< GEV lib definitions.
+#include "AcqBackend.h"
+
+// Read the mandatory image features from the camera's feature node map.
+static GEV_STATUS _GevGetImageGeometry( GEV_CAMERA_HANDLE handle, UINT32 *width, UINT32 *height, UINT64 *payloadSize, UINT32 *format)
+{
+	GenApi::CNodeMapRef *Camera = static_cast<GenApi::CNodeMapRef*>(GevGetFeatureNodeMap(handle));
+	GEV_STATUS status = GEVLIB_ERROR_NULL_PTR;
+
+	if (Camera)
+	{
+		try
+		{
+			GenApi::CIntegerPtr ptrIntNode = Camera->_GetNode("Width");
+			*width = (UINT32) ptrIntNode->GetValue();
+			ptrIntNode = Camera->_GetNode("Height");
+			*height = (UINT32) ptrIntNode->GetValue();
+			ptrIntNode = Camera->_GetNode("PayloadSize");
+			*payloadSize = (UINT64) ptrIntNode->GetValue();
+			GenApi::CEnumerationPtr ptrEnumNode = Camera->_GetNode("PixelFormat") ;
+			*format = (UINT32)ptrEnumNode->GetIntValue();
+			status = 0;
+		}
+		// Catch all possible exceptions from a node access.
+		CATCH_GENAPI_ERROR(status);
+	}
+	return status;
+}
+
+static GEV_STATUS _GevExecuteCommand( GEV_CAMERA_HANDLE handle, const char *name)
+{
+	GenApi::CNodeMapRef *Camera = static_cast<GenApi::CNodeMapRef*>(GevGetFeatureNodeMap(handle));
+	GEV_STATUS status = GEVLIB_ERROR_NULL_PTR;
+
+	if (Camera)
+	{
+		try
+		{
+			GenApi::CCommandPtr ptrCommandNode = Camera->_GetNode(name);
+			if (ptrCommandNode.IsValid())
+			{
+				ptrCommandNode->Execute();
+				status = 0;
+			}
+			else
+			{
+				status = GEVLIB_ERROR_PARAMETER_INVALID;
+			}
+		}
+		// Catch all possible exceptions from a node access.
+		CATCH_GENAPI_ERROR(status);
+	}
+	return status;
+}
+
+// Read a register from the camera itself (GenApi would answer most reads from its cache).
+// The heartbeat timeout is a bootstrap register every GigE Vision camera has.
+static GEV_STATUS _GevCheckConnection( GEV_CAMERA_HANDLE handle)
+{
+	GenApi::CNodeMapRef *Camera = static_cast<GenApi::CNodeMapRef*>(GevGetFeatureNodeMap(handle));
+	GEV_STATUS status = GEVLIB_ERROR_NULL_PTR;
+
+	if (Camera)
+	{
+		try
+		{
+			GenApi::CIntegerPtr ptrIntNode = Camera->_GetNode("GevHeartbeatTimeout");
+			if (!ptrIntNode.IsValid())
+			{
+				ptrIntNode = Camera->_GetNode("Width");
+			}
+			ptrIntNode->GetValue( false, true);
+			status = 0;
+		}
+		// Catch all possible exceptions from a node access.
+		CATCH_GENAPI_ERROR(status);
+	}
+	return status;
+}
+
+const ACQ_BACKEND AcqBackend_Gev =
+{
+	"gev",
+	GevGetCameraList,
+	GevOpenCamera,
+	GevCloseCamera,
+	GevGetCameraInterfaceOptions,
+	GevSetCameraInterfaceOptions,
+	GevGetFeatureValue,
+	GevSetFeatureValue,
+	GevGetFeatureValueAsString,
+	GevSetFeatureValueAsString,
+	_GevExecuteCommand,
+	_GevGetImageGeometry,
+	GevInitializeTransfer,
+	GevStartTransfer,
+	GevAbortTransfer,
+	GevFreeTransfer,
+	GevWaitForNextImage,
+	GevReleaseImage,
+	_GevCheckConnection
+};
+
+// !
+// AcqBackend_Select
+//
+/*!
+	Find a backend by name.
+
+	\param name  "gev" or "synthetic" - "synthetic:<settings>" also passes the
+	             settings to AcqSynthetic_Configure - or "replay:<settings>"
+	             (settings for AcqReplay_Configure, at least one recording).
+
+	\return The backend (NULL = unknown name or bad settings).
+*/
+const ACQ_BACKEND *AcqBackend_Select( const char *name)
+{
+	if ((name == NULL) || (strcmp(name, AcqBackend_Gev.name) == 0))
+	{
+		return &AcqBackend_Gev;
+	}
+	if (strncmp(name, AcqBackend_Synthetic.name, strlen(AcqBackend_Synthetic.name)) == 0)
+	{
+		const char *settings = name + strlen(AcqBackend_Synthetic.name);
+
+		if (*settings == ':')
+		{
+			return (AcqSynthetic_Configure( settings + 1) == 0) ? &AcqBackend_Synthetic : NULL;
+		}
+		if (*settings == '\0')
+		{
+			return &AcqBackend_Synthetic;
+		}
+	}
+	if (strncmp(name, AcqBackend_Replay.name, strlen(AcqBackend_Replay.name)) == 0)
+	{
+		const char *settings = name + strlen(AcqBackend_Replay.name);
+
+		if (*settings == ':')
+		{
+			return (AcqReplay_Configure( settings + 1) == 0) ? &AcqBackend_Replay : NULL;
+		}
+	}
+	return NULL;
+}
@@ -0,0 +1,72 @@
+#ifndef __ACQ_BACKEND_H__
+#define __ACQ_BACKEND_H__
+
+#include "gevapi.h"
+
+//=============================================================================
+// Acquisition backend.
+//
+// The camera calls genicam makes, as a table of functions with the same
+// arguments as the GigE-V (Gev*) calls they stand for, so the rest of the
+// program does not know where the frames come from :
+//
+//	AcqBackend_Gev        The GigE-V library (a real camera).
+//	AcqBackend_Synthetic  A frame generator (no camera or network needed) -
+//	                      see AcqSynthetic_Configure for its settings.
+//	AcqBackend_Replay     Recordings (see FrameRecord.h) played back as they
+//	                      were received - see AcqReplay_Configure.
+//
+// Handles are only valid with the backend that opened them.
+//
+
+#define ACQ_SYNTHETIC_MAX_CAMERAS		8
+#define ACQ_SYNTHETIC_MAX_BUFFERS		64
+
+typedef struct ACQ_BACKEND_t
+{
+	const char	*name;
+
+	// Discovery / connection.
+	GEV_STATUS	(*GetCameraList)( GEV_DEVICE_INTERFACE *devices, int maxDevices, int *numDevices);
+	GEV_STATUS	(*OpenCamera)( GEV_DEVICE_INTERFACE *device, GevAccessMode mode, GEV_CAMERA_HANDLE *handle);
+	GEV_STATUS	(*CloseCamera)( GEV_CAMERA_HANDLE *handle);
+	GEV_STATUS	(*GetCameraInterfaceOptions)( GEV_CAMERA_HANDLE handle, GEV_CAMERA_OPTIONS *options);
+	GEV_STATUS	(*SetCameraInterfaceOptions)( GEV_CAMERA_HANDLE handle, GEV_CAMERA_OPTIONS *options);
+
+	// Features.
+	GEV_STATUS	(*GetFeatureValue)( GEV_CAMERA_HANDLE handle, const char *name, int *type, int size, void *value);
+	GEV_STATUS	(*SetFeatureValue)( GEV_CAMERA_HANDLE handle, const char *name, int size, void *value);
+	GEV_STATUS	(*GetFeatureValueAsString)( GEV_CAMERA_HANDLE handle, const char *name, int *type, int size, char *value);
+	GEV_STATUS	(*SetFeatureValueAsString)( GEV_CAMERA_HANDLE handle, const char *name, const char *value);
+	GEV_STATUS	(*ExecuteCommand)( GEV_CAMERA_HANDLE handle, const char *name);
+	GEV_STATUS	(*GetImageGeometry)( GEV_CAMERA_HANDLE handle, UINT32 *width, UINT32 *height, UINT64 *payloadSize, UINT32 *format);
+
+	// Transfer.
+	GEV_STATUS	(*InitializeTransfer)( GEV_CAMERA_HANDLE handle, GevBufferCyclingMode mode, UINT64 bufSize, UINT32 numBuffers, UINT8 **bufAddress);
+	GEV_STATUS	(*StartTransfer)( GEV_CAMERA_HANDLE handle, UINT32 numFrames);
+	GEV_STATUS	(*AbortTransfer)( GEV_CAMERA_HANDLE handle);
+	GEV_STATUS	(*FreeTransfer)( GEV_CAMERA_HANDLE handle);
+	GEV_STATUS	(*WaitForNextImage)( GEV_CAMERA_HANDLE handle, GEV_BUFFER_OBJECT **image, UINT32 timeoutMs);
+	GEV_STATUS	(*ReleaseImage)( GEV_CAMERA_HANDLE handle, GEV_BUFFER_OBJECT *image);
+
+	// Connection : 0 if the camera still answers (a read that does not come from a cache).
+	GEV_STATUS	(*CheckConnection)( GEV_CAMERA_HANDLE handle);
+} ACQ_BACKEND;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern const ACQ_BACKEND AcqBackend_Gev;
+extern const ACQ_BACKEND AcqBackend_Synthetic;
+extern const ACQ_BACKEND AcqBackend_Replay;
+
+const ACQ_BACKEND *AcqBackend_Select( const char *name);
+int AcqSynthetic_Configure( const char *settings);
+int AcqReplay_Configure( const char *settings);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
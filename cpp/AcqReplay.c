@@ -0,0 +1,764 @@
+/*
+  ---------------------------------------------
+  Acquisition backends - recording replay
+  -----------------------------------------------
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include "AcqBackend.h"
+#include "FrameRecord.h"
+
+//=============================================================================
+// Recordings (see FrameRecord.h) played back as cameras : one camera per
+// recording, with the frames as they were received - payload, frame ids,
+// camera timestamps and transfer status (incomplete frames stay incomplete).
+//
+// The frames come at the pace they arrived when recorded (scaled by the
+// speed), or as fast as they are taken (speed 0). A reader thread per camera
+// reads ahead into the free transfer buffers, as the GEV stream thread
+// would, so the acquisition thread does not wait for the disk. A late
+// consumer delays the frames rather than losing them : every recorded frame
+// is played, so runs over the same recording can be compared.
+//
+// Buffers are handed out as by a GEV transfer : with SynchronousNextEmpty
+// until released, with Asynchronous until the next one is waited for.
+//
+
+#define REPLAY_MAX_FILES		ACQ_SYNTHETIC_MAX_CAMERAS
+#define REPLAY_MAX_PATH			256
+
+typedef struct REPLAY_SETTINGS_t
+{
+	int		numFiles;
+	char		files[REPLAY_MAX_FILES][REPLAY_MAX_PATH];
+	double	speed;					// 1 = as recorded, 0 = as fast as the frames are taken.
+	int		loop;						// Start again at the end.
+} REPLAY_SETTINGS;
+
+typedef struct REPLAY_CAMERA_t
+{
+	int		index;
+	int		open;
+	REPLAY_SETTINGS	settings;
+	FRAME_RECORDING	recording;
+	GEV_CAMERA_OPTIONS	options;
+	UINT32	width;
+	UINT32	height;
+	UINT32	format;
+	UINT64	payloadSize;			// Largest record.
+	pthread_mutex_t	lock;
+	pthread_cond_t		wake;		// Frame read / due, transfer started or stopped, buffer released.
+
+	// Transfer.
+	int		initialized;
+	int		running;
+	int		ended;					// Every frame was read (and no loop).
+	int		stop;						// The reader thread is to exit.
+	pthread_t	reader;
+	GevBufferCyclingMode	mode;
+	UINT64	bufSize;
+	UINT32	numBuffers;
+	GEV_BUFFER_OBJECT	images[ACQ_SYNTHETIC_MAX_BUFFERS];
+	int		busy[ACQ_SYNTHETIC_MAX_BUFFERS];	// Being read into, queued or handed out.
+	UINT64	due[ACQ_SYNTHETIC_MAX_BUFFERS];	// When a queued frame is due (CLOCK_MONOTONIC).
+	UINT64	record[ACQ_SYNTHETIC_MAX_BUFFERS];	// Record read into the buffer.
+	int		queue[ACQ_SYNTHETIC_MAX_BUFFERS];	// Buffers read and not handed out yet (oldest first).
+	int		queueHead;
+	int		queueCount;
+	int		lastOut;					// Buffer handed out last (Asynchronous : reused from the next wait on).
+	UINT64	next;						// Next record to read.
+	UINT32	generation;				// Changed by an abort (a read going on is thrown away).
+	int		reading;					// A record is being read (outside the lock).
+	UINT64	startNs;					// Schedule : record r is due at startNs + (hostNs(r) - firstNs) / speed.
+	UINT64	firstNs;
+} REPLAY_CAMERA;
+
+static REPLAY_SETTINGS s_settings = { 0, { { 0 } }, 1.0, 0 };
+static REPLAY_CAMERA s_cameras[REPLAY_MAX_FILES];
+static pthread_mutex_t s_openLock = PTHREAD_MUTEX_INITIALIZER;
+
+static UINT64 _NowNs( void )
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ((UINT64)ts.tv_sec * 1000000000ULL) + ts.tv_nsec;
+}
+
+static REPLAY_CAMERA *_Camera( GEV_CAMERA_HANDLE handle)
+{
+	REPLAY_CAMERA *cam = (REPLAY_CAMERA *)handle;
+	if ((cam < &s_cameras[0]) || (cam >= &s_cameras[REPLAY_MAX_FILES]) || !cam->open)
+	{
+		return NULL;
+	}
+	return cam;
+}
+
+// !
+// AcqReplay_Configure
+//
+/*!
+	Set up the replay from a comma separated list of recordings and settings :
+
+		<file>               A recording (one camera per recording, in order).
+		speed=<factor>       Pace of the frames relative to the recording (1) - 0 plays
+		                     them as fast as they are taken.
+		loop=<0|1>           Start again at the end (0).
+
+	\return Error status
+		0   = Success
+		GEVLIB_ERROR_PARAMETER_INVALID  Unknown setting, bad value or no recording (nothing is changed).
+*/
+int AcqReplay_Configure( const char *settings)
+{
+	REPLAY_SETTINGS config;
+	const char *p = settings;
+
+	memset(&config, 0, sizeof(config));
+	config.speed = 1.0;
+	while ((p != NULL) && (*p != '\0'))
+	{
+		char item[REPLAY_MAX_PATH] = {0};
+		const char *end = strchr(p, ',');
+		size_t length = (end != NULL) ? (size_t)(end - p) : strlen(p);
+		char *value = NULL;
+		char *rest = NULL;
+
+		if (length >= sizeof(item))
+		{
+			return GEVLIB_ERROR_PARAMETER_INVALID;
+		}
+		memcpy(item, p, length);
+		p = (end != NULL) ? (end + 1) : NULL;
+		if (length == 0)
+		{
+			continue;
+		}
+		value = strchr(item, '=');
+		if (value == NULL)
+		{
+			if (config.numFiles == REPLAY_MAX_FILES)
+			{
+				return GEVLIB_ERROR_PARAMETER_INVALID;
+			}
+			snprintf(config.files[config.numFiles++], REPLAY_MAX_PATH, "%s", item);
+			continue;
+		}
+		*value++ = '\0';
+		if (strcmp(item, "speed") == 0)
+		{
+			double number = strtod(value, &rest);
+			if ((rest == value) || (*rest != '\0') || (number < 0.0))
+			{
+				return GEVLIB_ERROR_PARAMETER_INVALID;
+			}
+			config.speed = number;
+		}
+		else if (strcmp(item, "loop") == 0)
+		{
+			unsigned long number = strtoul(value, &rest, 0);
+			if ((rest == value) || (*rest != '\0') || (number > 1))
+			{
+				return GEVLIB_ERROR_PARAMETER_INVALID;
+			}
+			config.loop = (int)number;
+		}
+		else
+		{
+			return GEVLIB_ERROR_PARAMETER_INVALID;
+		}
+	}
+	if (config.numFiles == 0)
+	{
+		return GEVLIB_ERROR_PARAMETER_INVALID;
+	}
+	s_settings = config;
+	return 0;
+}
+
+// Restart the schedule at record "next" (with the lock held).
+static void _StartSchedule( REPLAY_CAMERA *cam, UINT64 now)
+{
+	cam->startNs = now;
+	cam->firstNs = (cam->next < cam->recording.count) ? cam->recording.index[cam->next].hostNs : 0;
+}
+
+// Reads the next records into the free buffers, ahead of the consumer.
+static void *_ReaderThread( void *arg)
+{
+	REPLAY_CAMERA *cam = (REPLAY_CAMERA *)arg;
+
+	pthread_mutex_lock(&cam->lock);
+	while (!cam->stop)
+	{
+		int index = -1;
+		UINT32 i;
+
+		if (cam->running && !cam->ended)
+		{
+			for (i = 0; i < cam->numBuffers; i++)
+			{
+				if (!cam->busy[i] && ((int)i != cam->lastOut))
+				{
+					index = (int)i;
+					break;
+				}
+			}
+		}
+		if (index < 0)
+		{
+			pthread_cond_wait(&cam->wake, &cam->lock);
+			continue;
+		}
+
+		if (cam->next >= cam->recording.count)
+		{
+			if (!cam->settings.loop || (cam->recording.count == 0))
+			{
+				cam->ended = TRUE;
+				pthread_cond_broadcast(&cam->wake);
+				continue;
+			}
+			// Again from the start, one (mean) frame interval after the last one.
+			{
+				UINT64 count = cam->recording.count;
+				UINT64 span = cam->recording.index[count - 1].hostNs - cam->recording.index[0].hostNs;
+				UINT64 gap = (count > 1) ? (span / (count - 1)) : 0;
+				UINT64 elapsed = cam->recording.index[count - 1].hostNs - cam->firstNs + gap;
+
+				cam->startNs += (cam->settings.speed > 0.0) ? (UINT64)((double)elapsed / cam->settings.speed) : 0;
+				cam->next = 0;
+				cam->firstNs = cam->recording.index[0].hostNs;
+			}
+		}
+
+		// Read outside the lock (the buffer is busy, no one else touches it).
+		{
+			GEV_BUFFER_OBJECT *img = &cam->images[index];
+			FRAME_RECORD record;
+			UINT64 n = cam->next++;
+			UINT32 generation = cam->generation;
+			int length = 0;
+
+			cam->busy[index] = TRUE;
+			cam->reading = TRUE;
+			pthread_mutex_unlock(&cam->lock);
+			length = FrameRecord_Read( &cam->recording, n, &record, img->address, cam->bufSize);
+			pthread_mutex_lock(&cam->lock);
+			cam->reading = FALSE;
+			if ((length < 0) || (generation != cam->generation))
+			{
+				// (An unreadable record is skipped, one read across an abort is read again).
+				cam->busy[index] = FALSE;
+				continue;
+			}
+			cam->record[index] = n;
+			img->id = record.frameId;
+			img->timestamp = record.timestamp;
+			img->timestamp_hi = (UINT32)(record.timestamp >> 32);
+			img->timestamp_lo = (UINT32)(record.timestamp & 0xFFFFFFFF);
+			img->status = ((UINT64)length < record.length) ? GEV_FRAME_STATUS_OVERFLOW : record.status;
+			img->recv_size = (UINT32)length;
+			img->w = record.width;
+			img->h = record.height;
+			img->format = record.format;
+			img->d = record.depth;
+			cam->due[index] = cam->startNs +
+					((cam->settings.speed > 0.0) ? (UINT64)((double)(record.hostNs - cam->firstNs) / cam->settings.speed) : 0);
+			cam->queue[(cam->queueHead + cam->queueCount) % ACQ_SYNTHETIC_MAX_BUFFERS] = index;
+			cam->queueCount++;
+			pthread_cond_broadcast(&cam->wake);
+		}
+	}
+	pthread_mutex_unlock(&cam->lock);
+	return NULL;
+}
+
+static GEV_STATUS _ReplayGetCameraList( GEV_DEVICE_INTERFACE *devices, int maxDevices, int *numDevices)
+{
+	int i;
+
+	if ((devices == NULL) || (numDevices == NULL))
+	{
+		return GEVLIB_ERROR_NULL_PTR;
+	}
+	for (i = 0; (i < s_settings.numFiles) && (i < maxDevices); i++)
+	{
+		const char *name = strrchr(s_settings.files[i], '/');
+
+		memset(&devices[i], 0, sizeof(GEV_DEVICE_INTERFACE));
+		devices[i].macLow = (UINT32)i;
+		snprintf(devices[i].manufacturer, sizeof(devices[i].manufacturer), "genicam");
+		snprintf(devices[i].model, sizeof(devices[i].model), "Replay");
+		snprintf(devices[i].serial, sizeof(devices[i].serial), "%s", (name != NULL) ? (name + 1) : s_settings.files[i]);
+		snprintf(devices[i].version, sizeof(devices[i].version), "1.0");
+	}
+	*numDevices = i;
+	return 0;
+}
+
+static GEV_STATUS _ReplayOpenCamera( GEV_DEVICE_INTERFACE *device, GevAccessMode mode, GEV_CAMERA_HANDLE *handle)
+{
+	REPLAY_CAMERA *cam = NULL;
+	pthread_condattr_t attr;
+	FRAME_RECORD record;
+	UINT64 i;
+
+	if ((device == NULL) || (handle == NULL))
+	{
+		return GEVLIB_ERROR_NULL_PTR;
+	}
+	if ((int)device->macLow >= s_settings.numFiles)
+	{
+		return GEVLIB_ERROR_DEVICE_NOT_FOUND;
+	}
+	pthread_mutex_lock(&s_openLock);
+	cam = &s_cameras[device->macLow];
+	if (cam->open)
+	{
+		pthread_mutex_unlock(&s_openLock);
+		return GEVLIB_ERROR_INVALID_HANDLE;
+	}
+	memset(cam, 0, sizeof(REPLAY_CAMERA));
+	cam->index = (int)device->macLow;
+	cam->settings = s_settings;
+	if ((FrameRecord_Open( &cam->recording, s_settings.files[cam->index]) != 0) ||
+		 (FrameRecord_Read( &cam->recording, 0, &record, NULL, 0) < 0))
+	{
+		FrameRecord_Close( &cam->recording);
+		pthread_mutex_unlock(&s_openLock);
+		return GEVLIB_ERROR_DEVICE_NOT_FOUND;
+	}
+	// The geometry of the first frame, room for the largest one.
+	cam->width = record.width;
+	cam->height = record.height;
+	cam->format = record.format;
+	cam->payloadSize = (UINT64)record.width * record.height * record.depth;
+	for (i = 0; i < cam->recording.count; i++)
+	{
+		if (cam->recording.index[i].length > cam->payloadSize)
+		{
+			cam->payloadSize = cam->recording.index[i].length;
+		}
+	}
+	cam->lastOut = -1;
+	pthread_mutex_init(&cam->lock, NULL);
+	pthread_condattr_init(&attr);
+	pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+	pthread_cond_init(&cam->wake, &attr);
+	pthread_condattr_destroy(&attr);
+	cam->open = TRUE;
+	pthread_mutex_unlock(&s_openLock);
+
+	*handle = (GEV_CAMERA_HANDLE)cam;
+	return 0;
+}
+
+static GEV_STATUS _ReplayFreeTransfer( GEV_CAMERA_HANDLE handle);
+
+static GEV_STATUS _ReplayCloseCamera( GEV_CAMERA_HANDLE *handle)
+{
+	REPLAY_CAMERA *cam = (handle != NULL) ? _Camera( *handle) : NULL;
+
+	if (cam == NULL)
+	{
+		return GEVLIB_ERROR_INVALID_HANDLE;
+	}
+	_ReplayFreeTransfer( cam);
+	pthread_mutex_lock(&s_openLock);
+	cam->open = FALSE;
+	FrameRecord_Close( &cam->recording);
+	pthread_cond_destroy(&cam->wake);
+	pthread_mutex_destroy(&cam->lock);
+	pthread_mutex_unlock(&s_openLock);
+	*handle = NULL;
+	return 0;
+}
+
+static GEV_STATUS _ReplayGetCameraInterfaceOptions( GEV_CAMERA_HANDLE handle, GEV_CAMERA_OPTIONS *options)
+{
+	REPLAY_CAMERA *cam = _Camera( handle);
+
+	if ((cam == NULL) || (options == NULL))
+	{
+		return (cam == NULL) ? GEVLIB_ERROR_INVALID_HANDLE : GEVLIB_ERROR_NULL_PTR;
+	}
+	*options = cam->options;
+	return 0;
+}
+
+static GEV_STATUS _ReplaySetCameraInterfaceOptions( GEV_CAMERA_HANDLE handle, GEV_CAMERA_OPTIONS *options)
+{
+	REPLAY_CAMERA *cam = _Camera( handle);
+
+	if ((cam == NULL) || (options == NULL))
+	{
+		return (cam == NULL) ? GEVLIB_ERROR_INVALID_HANDLE : GEVLIB_ERROR_NULL_PTR;
+	}
+	// (Accepted and kept - there is no network to tune).
+	cam->options = *options;
+	return 0;
+}
+
+// Only the image geometry features are known (as numbers).
+static GEV_STATUS _ReplayGetFeatureValueAsString( GEV_CAMERA_HANDLE handle, const char *name, int *type, int size, char *value)
+{
+	REPLAY_CAMERA *cam = _Camera( handle);
+
+	if (cam == NULL)
+	{
+		return GEVLIB_ERROR_INVALID_HANDLE;
+	}
+	if ((name == NULL) || (value == NULL) || (size <= 0))
+	{
+		return GEVLIB_ERROR_NULL_PTR;
+	}
+	if (strcmp(name, "Width") == 0)
+	{
+		snprintf(value, size, "%u", cam->width);
+	}
+	else if (strcmp(name, "Height") == 0)
+	{
+		snprintf(value, size, "%u", cam->height);
+	}
+	else if (strcmp(name, "PixelFormat") == 0)
+	{
+		snprintf(value, size, "%u", cam->format);
+	}
+	else if (strcmp(name, "PayloadSize") == 0)
+	{
+		snprintf(value, size, "%llu", (unsigned long long)cam->payloadSize);
+	}
+	else if (strcmp(name, "DeviceModelName") == 0)
+	{
+		snprintf(value, size, "Replay");
+	}
+	else
+	{
+		return GEVLIB_ERROR_PARAMETER_INVALID;
+	}
+	return 0;
+}
+
+static GEV_STATUS _ReplayGetFeatureValue( GEV_CAMERA_HANDLE handle, const char *name, int *type, int size, void *value)
+{
+	char text[64];
+	char *rest = NULL;
+	GEV_STATUS status = _ReplayGetFeatureValueAsString( handle, name, type, sizeof(text), text);
+	UINT64 number = 0;
+
+	if ((status != 0) || (value == NULL))
+	{
+		return (status != 0) ? status : GEVLIB_ERROR_NULL_PTR;
+	}
+	number = strtoull(text, &rest, 0);
+	if ((rest == text) || (*rest != '\0'))
+	{
+		return GEVLIB_ERROR_PARAMETER_INVALID;
+	}
+	if (size == sizeof(UINT64))
+	{
+		*(UINT64 *)value = number;
+		return 0;
+	}
+	if (size == sizeof(UINT32))
+	{
+		*(UINT32 *)value = (UINT32)number;
+		return 0;
+	}
+	return GEVLIB_ERROR_PARAMETER_INVALID;
+}
+
+// (The recording can't be changed).
+static GEV_STATUS _ReplaySetFeatureValue( GEV_CAMERA_HANDLE handle, const char *name, int size, void *value)
+{
+	return (_Camera( handle) == NULL) ? GEVLIB_ERROR_INVALID_HANDLE : GEVLIB_ERROR_PARAMETER_INVALID;
+}
+
+static GEV_STATUS _ReplaySetFeatureValueAsString( GEV_CAMERA_HANDLE handle, const char *name, const char *value)
+{
+	return (_Camera( handle) == NULL) ? GEVLIB_ERROR_INVALID_HANDLE : GEVLIB_ERROR_PARAMETER_INVALID;
+}
+
+static GEV_STATUS _ReplayExecuteCommand( GEV_CAMERA_HANDLE handle, const char *name)
+{
+	if (_Camera( handle) == NULL)
+	{
+		return GEVLIB_ERROR_INVALID_HANDLE;
+	}
+	// (The transfer start / stop does the work).
+	if ((name != NULL) && ((strcmp(name, "AcquisitionStart") == 0) || (strcmp(name, "AcquisitionStop") == 0)))
+	{
+		return 0;
+	}
+	return GEVLIB_ERROR_PARAMETER_INVALID;
+}
+
+static GEV_STATUS _ReplayGetImageGeometry( GEV_CAMERA_HANDLE handle, UINT32 *width, UINT32 *height, UINT64 *payloadSize, UINT32 *format)
+{
+	REPLAY_CAMERA *cam = _Camera( handle);
+
+	if (cam == NULL)
+	{
+		return GEVLIB_ERROR_INVALID_HANDLE;
+	}
+	*width = cam->width;
+	*height = cam->height;
+	*payloadSize = cam->payloadSize;
+	*format = cam->format;
+	return 0;
+}
+
+static GEV_STATUS _ReplayInitializeTransfer( GEV_CAMERA_HANDLE handle, GevBufferCyclingMode mode, UINT64 bufSize, UINT32 numBuffers, UINT8 **bufAddress)
+{
+	REPLAY_CAMERA *cam = _Camera( handle);
+	UINT32 i;
+
+	if (cam == NULL)
+	{
+		return GEVLIB_ERROR_INVALID_HANDLE;
+	}
+	if (bufAddress == NULL)
+	{
+		return GEVLIB_ERROR_NULL_PTR;
+	}
+	pthread_mutex_lock(&cam->lock);
+	if (cam->initialized || (numBuffers < 1) || (numBuffers > ACQ_SYNTHETIC_MAX_BUFFERS))
+	{
+		pthread_mutex_unlock(&cam->lock);
+		return GEVLIB_ERROR_PARAMETER_INVALID;
+	}
+	for (i = 0; i < numBuffers; i++)
+	{
+		if (bufAddress[i] == NULL)
+		{
+			pthread_mutex_unlock(&cam->lock);
+			return GEVLIB_ERROR_NULL_PTR;
+		}
+		memset(&cam->images[i], 0, sizeof(GEV_BUFFER_OBJECT));
+		cam->images[i].address = bufAddress[i];
+		cam->images[i].status = GEV_FRAME_STATUS_RELEASED;
+		cam->busy[i] = FALSE;
+	}
+	// (Frames bigger than the buffers are cut short and flagged as an overflow).
+	cam->mode = mode;
+	cam->bufSize = bufSize;
+	cam->numBuffers = numBuffers;
+	cam->queueHead = 0;
+	cam->queueCount = 0;
+	cam->lastOut = -1;
+	cam->next = 0;
+	cam->ended = FALSE;
+	cam->stop = FALSE;
+	cam->initialized = TRUE;
+	pthread_create(&cam->reader, NULL, _ReaderThread, cam);
+	pthread_mutex_unlock(&cam->lock);
+	return 0;
+}
+
+static GEV_STATUS _ReplayStartTransfer( GEV_CAMERA_HANDLE handle, UINT32 numFrames)
+{
+	REPLAY_CAMERA *cam = _Camera( handle);
+
+	if (cam == NULL)
+	{
+		return GEVLIB_ERROR_INVALID_HANDLE;
+	}
+	pthread_mutex_lock(&cam->lock);
+	if (!cam->initialized)
+	{
+		pthread_mutex_unlock(&cam->lock);
+		return GEVLIB_ERROR_PARAMETER_INVALID;
+	}
+	// (Plays to the end whatever numFrames says - a restart carries on from the next frame).
+	cam->running = TRUE;
+	_StartSchedule( cam, _NowNs());
+	pthread_cond_broadcast(&cam->wake);
+	pthread_mutex_unlock(&cam->lock);
+	return 0;
+}
+
+static GEV_STATUS _ReplayAbortTransfer( GEV_CAMERA_HANDLE handle)
+{
+	REPLAY_CAMERA *cam = _Camera( handle);
+	int i;
+
+	if (cam == NULL)
+	{
+		return GEVLIB_ERROR_INVALID_HANDLE;
+	}
+	pthread_mutex_lock(&cam->lock);
+	cam->running = FALSE;
+	cam->generation++;
+	// The frames read ahead (and the one being read) are played again after a restart.
+	if (cam->queueCount > 0)
+	{
+		cam->next = cam->record[cam->queue[cam->queueHead]];
+		cam->ended = FALSE;
+	}
+	else if (cam->reading)
+	{
+		cam->next--;
+	}
+	for (i = 0; i < cam->queueCount; i++)
+	{
+		cam->busy[cam->queue[(cam->queueHead + i) % ACQ_SYNTHETIC_MAX_BUFFERS]] = FALSE;
+	}
+	cam->queueCount = 0;
+	pthread_cond_broadcast(&cam->wake);
+	pthread_mutex_unlock(&cam->lock);
+	return 0;
+}
+
+static GEV_STATUS _ReplayFreeTransfer( GEV_CAMERA_HANDLE handle)
+{
+	REPLAY_CAMERA *cam = _Camera( handle);
+	int started = FALSE;
+
+	if (cam == NULL)
+	{
+		return GEVLIB_ERROR_INVALID_HANDLE;
+	}
+	pthread_mutex_lock(&cam->lock);
+	started = cam->initialized;
+	cam->running = FALSE;
+	cam->stop = TRUE;
+	pthread_cond_broadcast(&cam->wake);
+	pthread_mutex_unlock(&cam->lock);
+	if (started)
+	{
+		pthread_join(cam->reader, NULL);
+	}
+	pthread_mutex_lock(&cam->lock);
+	cam->initialized = FALSE;
+	cam->queueCount = 0;
+	cam->numBuffers = 0;
+	pthread_mutex_unlock(&cam->lock);
+	return 0;
+}
+
+static GEV_STATUS _ReplayWaitForNextImage( GEV_CAMERA_HANDLE handle, GEV_BUFFER_OBJECT **image, UINT32 timeoutMs)
+{
+	REPLAY_CAMERA *cam = _Camera( handle);
+	GEV_STATUS status = GEVLIB_ERROR_TIME_OUT;
+	UINT64 deadline = _NowNs() + ((UINT64)timeoutMs * 1000000ULL);
+	int wasRunning = FALSE;
+
+	if (cam == NULL)
+	{
+		return GEVLIB_ERROR_INVALID_HANDLE;
+	}
+	if (image == NULL)
+	{
+		return GEVLIB_ERROR_NULL_PTR;
+	}
+	*image = NULL;
+
+	pthread_mutex_lock(&cam->lock);
+	wasRunning = cam->running;
+	if ((cam->mode != SynchronousNextEmpty) && (cam->lastOut >= 0))
+	{
+		// Asynchronous : the last frame handed out is done with.
+		cam->busy[cam->lastOut] = FALSE;
+		cam->lastOut = -1;
+		pthread_cond_broadcast(&cam->wake);
+	}
+	for (;;)
+	{
+		UINT64 now = _NowNs();
+		UINT64 wakeAt = deadline;
+		struct timespec ts;
+
+		if (cam->running && (cam->queueCount > 0))
+		{
+			int index = cam->queue[cam->queueHead];
+
+			if (cam->due[index] <= now)
+			{
+				cam->queueHead = (cam->queueHead + 1) % ACQ_SYNTHETIC_MAX_BUFFERS;
+				cam->queueCount--;
+				*image = &cam->images[index];
+				if (cam->mode != SynchronousNextEmpty)
+				{
+					cam->lastOut = index;
+				}
+				status = GEVLIB_OK;
+				break;
+			}
+			wakeAt = (cam->due[index] < deadline) ? cam->due[index] : deadline;
+		}
+		else if (wasRunning && !cam->running)
+		{
+			// Stopped while waiting.
+			break;
+		}
+		if (now >= deadline)
+		{
+			break;
+		}
+		ts.tv_sec = (time_t)(wakeAt / 1000000000ULL);
+		ts.tv_nsec = (long)(wakeAt % 1000000000ULL);
+		pthread_cond_timedwait(&cam->wake, &cam->lock, &ts);
+	}
+	pthread_mutex_unlock(&cam->lock);
+	return status;
+}
+
+static GEV_STATUS _ReplayReleaseImage( GEV_CAMERA_HANDLE handle, GEV_BUFFER_OBJECT *image)
+{
+	REPLAY_CAMERA *cam = _Camera( handle);
+	GEV_STATUS status = GEVLIB_ERROR_PARAMETER_INVALID;
+	long index = 0;
+
+	if (cam == NULL)
+	{
+		return GEVLIB_ERROR_INVALID_HANDLE;
+	}
+	pthread_mutex_lock(&cam->lock);
+	index = (long)(image - &cam->images[0]);
+	if ((index >= 0) && (index < (long)cam->numBuffers))
+	{
+		if ((cam->mode == SynchronousNextEmpty) && cam->busy[index])
+		{
+			cam->busy[index] = FALSE;
+			pthread_cond_broadcast(&cam->wake);
+		}
+		status = 0;
+	}
+	pthread_mutex_unlock(&cam->lock);
+	return status;
+}
+
+// (A recording is always there).
+static GEV_STATUS _ReplayCheckConnection( GEV_CAMERA_HANDLE handle)
+{
+	return (_Camera( handle) == NULL) ? GEVLIB_ERROR_INVALID_HANDLE : 0;
+}
+
+const ACQ_BACKEND AcqBackend_Replay =
+{
+	"replay",
+	_ReplayGetCameraList,
+	_ReplayOpenCamera,
+	_ReplayCloseCamera,
+	_ReplayGetCameraInterfaceOptions,
+	_ReplaySetCameraInterfaceOptions,
+	_ReplayGetFeatureValue,
+	_ReplaySetFeatureValue,
+	_ReplayGetFeatureValueAsString,
+	_ReplaySetFeatureValueAsString,
+	_ReplayExecuteCommand,
+	_ReplayGetImageGeometry,
+	_ReplayInitializeTransfer,
+	_ReplayStartTransfer,
+	_ReplayAbortTransfer,
+	_ReplayFreeTransfer,
+	_ReplayWaitForNextImage,
+	_ReplayReleaseImage,
+	_ReplayCheckConnection
+};
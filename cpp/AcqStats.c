@@ -0,0 +1,238 @@
+/*
+  ---------------------------------------------
+  Acquisition health statistics
+  -----------------------------------------------
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "AcqStats.h"
+
+// GigE Vision 1.x frame (block) ids are 16 bit and skip 0 when they wrap around.
+// An id going back to near 1 from near the top is a wrap (anything else going back is a restart).
+#define ACQ_STATS_ID_WRAP		0xFFFF
+#define ACQ_STATS_WRAP_WINDOW	256
+
+static const char *s_causeNames[ACQ_FRAME_NUM_CAUSES] =
+{
+	"complete", "timeout", "overflow", "bandwidth", "lost", "other"
+};
+
+static inline uint64_t _ns_now( void )
+{
+	struct timespec ts;
+	clock_gettime( CLOCK_MONOTONIC, &ts);
+	return ((uint64_t)ts.tv_sec * 1000000000ULL) + (uint64_t)ts.tv_nsec;
+}
+
+// Open / close an update (odd sequence while it is going on).
+static inline void _BeginUpdate( ACQ_STATS *stats)
+{
+	__atomic_store_n(&stats->sequence, stats->sequence + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+static inline void _EndUpdate( ACQ_STATS *stats)
+{
+	__atomic_store_n(&stats->sequence, stats->sequence + 1, __ATOMIC_RELEASE);
+}
+
+int AcqStats_Init( ACQ_STATS *stats)
+{
+	if (stats == NULL)
+	{
+		return ACQSTATS_ERROR_NULL_PTR;
+	}
+	memset(stats, 0, sizeof(ACQ_STATS));
+	return 0;
+}
+
+// !
+// AcqStats_Frame
+//
+/*!
+	Count a buffer handed over by the transfer (acquisition thread only).
+
+	\param cause    ACQ_FRAME_COMPLETE, or why it is incomplete.
+	\param frameId  Its frame (block) id (0 = unknown - not checked for gaps).
+*/
+void AcqStats_Frame( ACQ_STATS *stats, ACQ_FRAME_CAUSE cause, uint64_t frameId)
+{
+	ACQ_STATS_SNAPSHOT *c = &stats->counters;
+	uint64_t now = _ns_now();
+	uint64_t gap = AcqStats_IdGap( c->lastId, frameId);
+
+	_BeginUpdate( stats);
+	c->frames[((unsigned)cause < ACQ_FRAME_NUM_CAUSES) ? cause : ACQ_FRAME_OTHER]++;
+	if (gap > 0)
+	{
+		c->missed += gap;
+		c->gaps++;
+	}
+	if (frameId != 0)
+	{
+		c->lastId = frameId;
+	}
+	if (c->nsFirst == 0)
+	{
+		c->nsFirst = now;
+	}
+	else
+	{
+		uint64_t interval = now - stats->nsLast;
+
+		c->intervals++;
+		c->nsIntervals += interval;
+		if (interval > c->nsMaxInterval)
+		{
+			c->nsMaxInterval = interval;
+		}
+		if (c->intervals > 1)
+		{
+			// J += (|D| - J) / 16, D = the change from the previous interval.
+			uint64_t d = (interval > stats->nsLastInterval) ? (interval - stats->nsLastInterval) : (stats->nsLastInterval - interval);
+			// (Decayed from the old value : a steady |D| settles at J16 = 16 |D|).
+			stats->jitter16 += d - ((stats->jitter16 + 8) >> 4);
+			c->nsJitter = stats->jitter16 >> 4;
+		}
+		stats->nsLastInterval = interval;
+	}
+	stats->nsLast = now;
+	_EndUpdate( stats);
+}
+
+// Count a wait for the next frame that returned nothing (timed out, or failed).
+void AcqStats_Wait( ACQ_STATS *stats, int timedOut)
+{
+	_BeginUpdate( stats);
+	if (timedOut)
+	{
+		stats->counters.waitTimeouts++;
+	}
+	else
+	{
+		stats->counters.waitErrors++;
+	}
+	_EndUpdate( stats);
+}
+
+// !
+// AcqStats_Read
+//
+/*!
+	Take a consistent copy of the counters (from any thread - never holds up the acquisition).
+
+	\return Error status
+		0   = Success
+*/
+int AcqStats_Read( const ACQ_STATS *stats, ACQ_STATS_SNAPSHOT *snapshot)
+{
+	uint32_t before = 0;
+	uint32_t after = 0;
+
+	if ((stats == NULL) || (snapshot == NULL))
+	{
+		return ACQSTATS_ERROR_NULL_PTR;
+	}
+	do
+	{
+		before = __atomic_load_n(&stats->sequence, __ATOMIC_ACQUIRE);
+		memcpy(snapshot, &stats->counters, sizeof(ACQ_STATS_SNAPSHOT));
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		after = __atomic_load_n(&stats->sequence, __ATOMIC_RELAXED);
+	} while ((before & 1) || (before != after));
+	snapshot->nsTaken = _ns_now();
+	return 0;
+}
+
+// Frame ids skipped between two consecutive ids (0 if either is unknown, or the ids restarted).
+uint64_t AcqStats_IdGap( uint64_t lastId, uint64_t frameId)
+{
+	if ((frameId == 0) || (lastId == 0))
+	{
+		return 0;
+	}
+	if (frameId > lastId)
+	{
+		return frameId - lastId - 1;
+	}
+	if ((lastId > (ACQ_STATS_ID_WRAP - ACQ_STATS_WRAP_WINDOW)) && (frameId < ACQ_STATS_WRAP_WINDOW))
+	{
+		return (ACQ_STATS_ID_WRAP - lastId) + (frameId - 1);
+	}
+	return 0;
+}
+
+// Frames delivered incomplete (any cause).
+uint64_t AcqStats_Incomplete( const ACQ_STATS_SNAPSHOT *snapshot)
+{
+	uint64_t incomplete = 0;
+	int i;
+
+	for (i = ACQ_FRAME_COMPLETE + 1; i < ACQ_FRAME_NUM_CAUSES; i++)
+	{
+		incomplete += snapshot->frames[i];
+	}
+	return incomplete;
+}
+
+// !
+// AcqStats_Print
+//
+/*!
+	Print a snapshot (on stderr) : totals, with the frame rate and mean interval
+	since "prev" (an earlier snapshot, NULL = since the first frame).
+*/
+void AcqStats_Print( const ACQ_STATS_SNAPSHOT *now, const ACQ_STATS_SNAPSHOT *prev, const char *label)
+{
+	ACQ_STATS_SNAPSHOT start;
+	uint64_t complete = now->frames[ACQ_FRAME_COMPLETE];
+	uint64_t nsWindow = 0;
+	uint64_t intervals = 0;
+	int i;
+
+	if (prev != NULL)
+	{
+		start = *prev;
+	}
+	else
+	{
+		memset(&start, 0, sizeof(start));
+		start.nsTaken = now->nsFirst;
+	}
+	nsWindow = ((start.nsTaken != 0) && (now->nsTaken > start.nsTaken)) ? (now->nsTaken - start.nsTaken) : 0;
+	intervals = now->intervals - start.intervals;
+
+	fprintf(stderr, "%s : %llu frames, %.1f fps (%.1f overall), %llu incomplete",
+			(label != NULL) ? label : "acquisition", (unsigned long long)complete,
+			(nsWindow > 0) ? ((double)(complete - start.frames[ACQ_FRAME_COMPLETE]) * 1e9 / nsWindow) : 0.0,
+			((now->nsFirst != 0) && (now->nsTaken > now->nsFirst)) ? ((double)complete * 1e9 / (now->nsTaken - now->nsFirst)) : 0.0,
+			(unsigned long long)AcqStats_Incomplete( now));
+	if (AcqStats_Incomplete( now) > 0)
+	{
+		const char *sep = " (";
+		for (i = ACQ_FRAME_COMPLETE + 1; i < ACQ_FRAME_NUM_CAUSES; i++)
+		{
+			if (now->frames[i] > 0)
+			{
+				fprintf(stderr, "%s%s %llu", sep, s_causeNames[i], (unsigned long long)now->frames[i]);
+				sep = ", ";
+			}
+		}
+		fprintf(stderr, ")");
+	}
+	fprintf(stderr, ", %llu missed in %llu gaps, %llu wait timeouts",
+			(unsigned long long)now->missed, (unsigned long long)now->gaps, (unsigned long long)now->waitTimeouts);
+	if (now->waitErrors > 0)
+	{
+		fprintf(stderr, ", %llu wait errors", (unsigned long long)now->waitErrors);
+	}
+	if (intervals > 0)
+	{
+		fprintf(stderr, ", interval %.2f ms (jitter %.3f ms, max %.2f ms)",
+				(double)(now->nsIntervals - start.nsIntervals) / intervals / 1e6,
+				(double)now->nsJitter / 1e6, (double)now->nsMaxInterval / 1e6);
+	}
+	fprintf(stderr, "\n");
+}
@@ -0,0 +1,79 @@
+#ifndef __ACQ_STATS_H__
+#define __ACQ_STATS_H__
+
+#include <stdint.h>
+#include <stdio.h>
+
+//=============================================================================
+// Acquisition health statistics of one camera.
+//
+// Updated by the acquisition thread for every buffer it is handed (or every
+// wait that times out) and readable from any thread at any time : the
+// counters are published under a sequence count (like the frame slots of
+// FrameShmRing), so the writer never waits and a reader just retries if it
+// caught an update half way. AcqStats_Read gives a consistent snapshot, two
+// snapshots give the rates in between.
+//
+// Frames are counted by cause (complete, or incomplete because of a timeout,
+// an overflow, the bandwidth, lost packets, ...). Gaps in the frame ids count
+// frames the transfer never delivered. The time between deliveries gives the
+// frame interval, its jitter (the RFC 3550 estimator : mean deviation of
+// consecutive intervals) and the longest one.
+//
+
+#define ACQSTATS_ERROR_NULL_PTR	-2200 // A pointer passed in is NULL.
+
+// Why a frame was delivered the way it was.
+typedef enum
+{
+	ACQ_FRAME_COMPLETE = 0,
+	ACQ_FRAME_TIMEOUT,			// Not all the packets came in time.
+	ACQ_FRAME_OVERFLOW,			// Larger than the buffer.
+	ACQ_FRAME_BANDWIDTH,			// Not enough bandwidth / packet memory.
+	ACQ_FRAME_LOST,				// Packets lost (and not recovered by resends).
+	ACQ_FRAME_OTHER,				// Any other incomplete status.
+	ACQ_FRAME_NUM_CAUSES
+} ACQ_FRAME_CAUSE;
+
+typedef struct ACQ_STATS_SNAPSHOT_t
+{
+	uint64_t	nsTaken;						// When the snapshot was taken (CLOCK_MONOTONIC).
+	uint64_t	nsFirst;						// First delivery (0 = none yet).
+	uint64_t	frames[ACQ_FRAME_NUM_CAUSES];	// Deliveries by cause.
+	uint64_t	missed;						// Frames skipped by the frame ids ...
+	uint64_t	gaps;							// ... in this many gaps.
+	uint64_t	waitTimeouts;				// Waits for a frame that timed out.
+	uint64_t	waitErrors;					// Waits that failed otherwise.
+	uint64_t	intervals;					// Delivery intervals measured.
+	uint64_t	nsIntervals;				// Their total.
+	uint64_t	nsMaxInterval;
+	uint64_t	nsJitter;					// Interval jitter (RFC 3550 estimator).
+	uint64_t	lastId;						// Last frame id delivered.
+} ACQ_STATS_SNAPSHOT;
+
+typedef struct ACQ_STATS_t
+{
+	uint32_t	sequence;					// Odd while the counters are being updated.
+	ACQ_STATS_SNAPSHOT	counters;
+	uint64_t	nsLast;						// Last delivery (writer only).
+	uint64_t	nsLastInterval;			// Previous interval (writer only).
+	uint64_t	jitter16;					// Jitter estimate x 16 (writer only).
+} ACQ_STATS;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int AcqStats_Init( ACQ_STATS *stats);
+void AcqStats_Frame( ACQ_STATS *stats, ACQ_FRAME_CAUSE cause, uint64_t frameId);
+void AcqStats_Wait( ACQ_STATS *stats, int timedOut);
+int AcqStats_Read( const ACQ_STATS *stats, ACQ_STATS_SNAPSHOT *snapshot);
+uint64_t AcqStats_Incomplete( const ACQ_STATS_SNAPSHOT *snapshot);
+uint64_t AcqStats_IdGap( uint64_t lastId, uint64_t frameId);
+void AcqStats_Print( const ACQ_STATS_SNAPSHOT *now, const ACQ_STATS_SNAPSHOT *prev, const char *label);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,1024 @@
+/*
+  ---------------------------------------------
+  Acquisition backends - synthetic frame generator
+  -----------------------------------------------
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include "AcqBackend.h"
+
+//=============================================================================
+// A camera without a camera : frames of the configured size and pixel format
+// are "received" at the configured rate, with optional injected losses, so
+// everything after the acquisition (conversion, output, display) can be run
+// and measured on any machine.
+//
+// The buffers get a test pattern (a diagonal ramp) when the transfer is set
+// up. Each frame only stamps its frame id (little-endian, in the first 8
+// bytes) - with a real camera the GEV stream thread fills the buffers on a
+// core of its own, so the acquisition thread should not pay for it here.
+//
+// The buffers behave like a GEV transfer : with Asynchronous cycling the
+// oldest frames not yet waited for are overwritten when the consumer is late,
+// with SynchronousNextEmpty new frames are lost until buffers are released.
+// Either way those frames leave a gap in the frame ids.
+//
+// With a disconnect period, the cameras drop off the "network" for
+// SIM_OUTAGE_MS every period : they are not found, can't be opened, send no
+// frames and fail the connection check, as a camera that lost its link or
+// power would.
+//
+// The camera clock (frame timestamps, GevTimestampValue) counts ns since the
+// camera was opened, on CLOCK_MONOTONIC : mapped to CLOCK_MONOTONIC_RAW it
+// drifts as the host clock is slewed, as a camera clock would.
+//
+
+#define SIM_DEFAULT_WIDTH		640
+#define SIM_DEFAULT_HEIGHT		480
+#define SIM_DEFAULT_FPS			30.0
+#define SIM_WIDTH_INCREMENT	4		// (Whole groups of packed pixels on every line).
+#define SIM_OUTAGE_MS			3000	// How long the cameras are gone at each disconnect.
+
+typedef struct SIM_SETTINGS_t
+{
+	int		numCameras;
+	UINT32	width;
+	UINT32	height;
+	UINT32	format;
+	double	fps;					// 0 = a new frame every time one is waited for.
+	double	dropRate;			// Fraction of the frames that never arrive.
+	double	incompleteRate;	// Fraction of the frames that arrive incomplete.
+	double	disconnect;			// Seconds between disconnects (0 = never).
+	unsigned int	seed;
+} SIM_SETTINGS;
+
+typedef struct SIM_CAMERA_t
+{
+	int		index;
+	int		open;
+	SIM_SETTINGS	settings;
+	GEV_CAMERA_OPTIONS	options;
+	pthread_mutex_t	lock;
+	pthread_cond_t		wake;			// Frame time / transfer started or stopped / buffer released.
+	unsigned int	seed;
+	UINT64	openNs;					// Time base of the frame timestamps.
+	UINT64	latched;					// Camera clock at the last GevTimestampControlLatch.
+
+	// Transfer.
+	int		initialized;
+	int		running;
+	GevBufferCyclingMode	mode;
+	UINT64	bufSize;
+	UINT32	numBuffers;
+	GEV_BUFFER_OBJECT	images[ACQ_SYNTHETIC_MAX_BUFFERS];
+	int		held[ACQ_SYNTHETIC_MAX_BUFFERS];	// Handed out and not released yet (SynchronousNextEmpty).
+	int		numHeld;
+	UINT32	nextBuffer;
+	UINT64	startNs;					// Frame n is due at startNs + n * periodNs.
+	UINT64	periodNs;
+	UINT64	lastFrame;				// Last frame id generated.
+	UINT64	queue[ACQ_SYNTHETIC_MAX_BUFFERS];	// Ids of the frames waiting to be picked up.
+	int		queueHead;
+	int		queueCount;
+} SIM_CAMERA;
+
+typedef struct SIM_FORMAT_t
+{
+	const char	*name;
+	UINT32		format;
+} SIM_FORMAT;
+
+static const SIM_FORMAT s_formats[] =
+{
+	{ "Mono8", fmtMono8 }, { "Mono10", fmtMono10 }, { "Mono10Packed", fmtMono10Packed },
+	{ "Mono12", fmtMono12 }, { "Mono12Packed", fmtMono12Packed }, { "Mono14", fmtMono14 }, { "Mono16", fmtMono16 },
+	{ "BayerGR8", fmtBayerGR8 }, { "BayerRG8", fmtBayerRG8 }, { "BayerGB8", fmtBayerGB8 }, { "BayerBG8", fmtBayerBG8 },
+	{ "BayerGR10", fmtBayerGR10 }, { "BayerRG10", fmtBayerRG10 }, { "BayerGB10", fmtBayerGB10 }, { "BayerBG10", fmtBayerBG10 },
+	{ "BayerGR12", fmtBayerGR12 }, { "BayerRG12", fmtBayerRG12 }, { "BayerGB12", fmtBayerGB12 }, { "BayerBG12", fmtBayerBG12 },
+	{ "BayerGR10Packed", fmtBayerGR10Packed }, { "BayerRG10Packed", fmtBayerRG10Packed },
+	{ "BayerGB10Packed", fmtBayerGB10Packed }, { "BayerBG10Packed", fmtBayerBG10Packed },
+	{ "BayerGR12Packed", fmtBayerGR12Packed }, { "BayerRG12Packed", fmtBayerRG12Packed },
+	{ "BayerGB12Packed", fmtBayerGB12Packed }, { "BayerBG12Packed", fmtBayerBG12Packed },
+	{ "RGB8Packed", fmtRGB8Packed }, { "BGR8Packed", fmtBGR8Packed }, { "RGBA8Packed", fmtRGBA8Packed }, { "BGRA8Packed", fmtBGRA8Packed },
+	{ "RGB10Packed", fmtRGB10Packed }, { "BGR10Packed", fmtBGR10Packed }, { "RGB12Packed", fmtRGB12Packed }, { "BGR12Packed", fmtBGR12Packed },
+	{ "RGB10V1Packed", fmtRGB10V1Packed }, { "RGB10V2Packed", fmtRGB10V2Packed },
+	{ "YUV411Packed", fmtYUV411packed }, { "YUV422Packed", fmtYUV422packed }, { "YUV444Packed", fmtYUV444packed }
+};
+#define SIM_NUM_FORMATS	(sizeof(s_formats) / sizeof(s_formats[0]))
+
+static SIM_SETTINGS s_settings = { 1, SIM_DEFAULT_WIDTH, SIM_DEFAULT_HEIGHT, fmtMono8, SIM_DEFAULT_FPS, 0.0, 0.0, 0.0, 1 };
+static SIM_CAMERA s_cameras[ACQ_SYNTHETIC_MAX_CAMERAS];
+static pthread_mutex_t s_openLock = PTHREAD_MUTEX_INITIALIZER;
+static UINT64 s_configuredNs;		// Time base of the disconnects.
+
+static UINT64 _NowNs( void )
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ((UINT64)ts.tv_sec * 1000000000ULL) + ts.tv_nsec;
+}
+
+// Are the cameras disconnected at "now" ?
+static int _Offline( UINT64 now)
+{
+	UINT64 periodNs = (UINT64)(s_settings.disconnect * 1e9);
+	UINT64 outageNs = (UINT64)SIM_OUTAGE_MS * 1000000ULL;
+
+	if (periodNs == 0)
+	{
+		return FALSE;
+	}
+	return (((now - s_configuredNs) % (periodNs + outageNs)) >= periodNs) ? TRUE : FALSE;
+}
+
+static const char *_FormatName( UINT32 format)
+{
+	UINT32 i;
+	for (i = 0; i < SIM_NUM_FORMATS; i++)
+	{
+		if (s_formats[i].format == format)
+		{
+			return s_formats[i].name;
+		}
+	}
+	return NULL;
+}
+
+static int _ParseFormat( const char *name, UINT32 *format)
+{
+	UINT32 i;
+	for (i = 0; i < SIM_NUM_FORMATS; i++)
+	{
+		if (strcmp(s_formats[i].name, name) == 0)
+		{
+			*format = s_formats[i].format;
+			return 0;
+		}
+	}
+	return GEVLIB_ERROR_PARAMETER_INVALID;
+}
+
+// Bytes of a w x h frame (the effective bits per pixel are in bits 16-23 of a GigE Vision pixel format).
+static UINT64 _PayloadSize( const SIM_SETTINGS *settings)
+{
+	return ((UINT64)settings->width * settings->height * ((settings->format >> 16) & 0xFF)) / 8;
+}
+
+static int _Chance( unsigned int *seed, double rate)
+{
+	return (rate > 0.0) && (((double)rand_r(seed) / ((double)RAND_MAX + 1.0)) < rate);
+}
+
+static SIM_CAMERA *_Camera( GEV_CAMERA_HANDLE handle)
+{
+	SIM_CAMERA *cam = (SIM_CAMERA *)handle;
+	if ((cam < &s_cameras[0]) || (cam >= &s_cameras[ACQ_SYNTHETIC_MAX_CAMERAS]) || !cam->open)
+	{
+		return NULL;
+	}
+	return cam;
+}
+
+// Make the frames due by now available, the way a transfer would (with the lock held).
+static void _GenerateFrames( SIM_CAMERA *cam, UINT64 now)
+{
+	UINT64 latest = 0;
+	UINT64 id = 0;
+	UINT64 first = 0;
+	UINT64 last = 0;
+
+	if (cam->periodNs == 0)
+	{
+		// Free running - a frame is ready whenever the last one was taken.
+		latest = (cam->queueCount == 0) ? (cam->lastFrame + 1) : cam->lastFrame;
+	}
+	else
+	{
+		latest = (now >= cam->startNs) ? ((now - cam->startNs) / cam->periodNs) : 0;
+	}
+	if (latest <= cam->lastFrame)
+	{
+		return;
+	}
+
+	first = cam->lastFrame + 1;
+	last = latest;
+	if (cam->mode == SynchronousNextEmpty)
+	{
+		// Frames are only received into empty buffers - the ones that do not fit are lost.
+		UINT64 space = cam->numBuffers - cam->numHeld - cam->queueCount;
+		if ((last - first + 1) > space)
+		{
+			last = first + space - 1;		// (space = 0 : none received).
+		}
+	}
+	else if ((last - first + 1) > cam->numBuffers)
+	{
+		// Only the most recent ones are still in a buffer.
+		first = last - cam->numBuffers + 1;
+	}
+
+	for (id = first; (id <= last) && (last >= first); id++)
+	{
+		if (_Chance( &cam->seed, cam->settings.dropRate))
+		{
+			continue;
+		}
+		if (cam->queueCount == (int)cam->numBuffers)
+		{
+			// Overwrite the oldest frame (Asynchronous).
+			cam->queueHead = (cam->queueHead + 1) % cam->numBuffers;
+			cam->queueCount--;
+		}
+		cam->queue[(cam->queueHead + cam->queueCount) % cam->numBuffers] = id;
+		cam->queueCount++;
+	}
+	cam->lastFrame = latest;
+}
+
+// Hand out the oldest frame received (with the lock held).
+static GEV_BUFFER_OBJECT *_NextImage( SIM_CAMERA *cam, UINT64 now)
+{
+	GEV_BUFFER_OBJECT *img = NULL;
+	UINT64 id = cam->queue[cam->queueHead];
+	UINT64 timestamp = 0;
+	UINT32 i;
+
+	cam->queueHead = (cam->queueHead + 1) % cam->numBuffers;
+	cam->queueCount--;
+
+	for (i = 0; i < cam->numBuffers; i++)
+	{
+		UINT32 index = (cam->nextBuffer + i) % cam->numBuffers;
+		if (!cam->held[index])
+		{
+			img = &cam->images[index];
+			cam->nextBuffer = (index + 1) % cam->numBuffers;
+			if (cam->mode == SynchronousNextEmpty)
+			{
+				cam->held[index] = TRUE;
+				cam->numHeld++;
+			}
+			break;
+		}
+	}
+	if (img == NULL)
+	{
+		return NULL;
+	}
+
+	timestamp = ((cam->periodNs > 0) ? (cam->startNs + (id * cam->periodNs)) : now) - cam->openNs;
+	img->id = id;
+	img->timestamp = timestamp;
+	img->timestamp_hi = (UINT32)(timestamp >> 32);
+	img->timestamp_lo = (UINT32)(timestamp & 0xFFFFFFFF);
+	img->status = _Chance( &cam->seed, cam->settings.incompleteRate) ? GEV_FRAME_STATUS_TIMEOUT : GEV_FRAME_STATUS_RECVD;
+	img->recv_size = (img->status == GEV_FRAME_STATUS_RECVD) ? _PayloadSize( &cam->settings) : (_PayloadSize( &cam->settings) / 2);
+	if (img->recv_size >= sizeof(UINT64))
+	{
+		memcpy(img->address, &id, sizeof(UINT64));
+	}
+	return img;
+}
+
+// !
+// AcqSynthetic_Configure
+//
+/*!
+	Set up the synthetic cameras (the ones opened afterwards) from a comma separated
+	list of settings :
+
+		cameras=<n>          Number of cameras found (1).
+		width=<w>,height=<h> Image size (640 x 480).
+		format=<name>        Pixel format feature name, eg. Mono8, BayerRG8, Mono12Packed,
+		                     YUV422Packed, RGB8Packed (Mono8).
+		fps=<rate>           Frame rate (30) - 0 runs flat out (a frame whenever one is waited for).
+		drop=<fraction>      Frames that are never received (0).
+		incomplete=<fraction> Frames received incomplete (0).
+		seed=<n>             Seed of the drops (1) - the same seed drops the same frames.
+		disconnect=<s>       Seconds between disconnects of SIM_OUTAGE_MS (0 = never).
+
+	\return Error status
+		0   = Success
+		GEVLIB_ERROR_PARAMETER_INVALID  Unknown setting or bad value (nothing is changed).
+*/
+int AcqSynthetic_Configure( const char *settings)
+{
+	SIM_SETTINGS config = s_settings;
+	const char *p = settings;
+
+	while ((p != NULL) && (*p != '\0'))
+	{
+		char item[64] = {0};
+		const char *end = strchr(p, ',');
+		size_t length = (end != NULL) ? (size_t)(end - p) : strlen(p);
+		char *value = NULL;
+		char *rest = NULL;
+
+		if (length >= sizeof(item))
+		{
+			return GEVLIB_ERROR_PARAMETER_INVALID;
+		}
+		memcpy(item, p, length);
+		p = (end != NULL) ? (end + 1) : NULL;
+		if (length == 0)
+		{
+			continue;
+		}
+		value = strchr(item, '=');
+		if (value == NULL)
+		{
+			return GEVLIB_ERROR_PARAMETER_INVALID;
+		}
+		*value++ = '\0';
+
+		if (strcmp(item, "format") == 0)
+		{
+			if (_ParseFormat( value, &config.format) != 0)
+			{
+				return GEVLIB_ERROR_PARAMETER_INVALID;
+			}
+			continue;
+		}
+		if (strcmp(item, "disconnect") == 0)
+		{
+			double number = strtod(value, &rest);
+			if ((rest == value) || (*rest != '\0') || (number < 0.0))
+			{
+				return GEVLIB_ERROR_PARAMETER_INVALID;
+			}
+			config.disconnect = number;
+			continue;
+		}
+		if ((strcmp(item, "fps") == 0) || (strcmp(item, "drop") == 0) || (strcmp(item, "incomplete") == 0))
+		{
+			double number = strtod(value, &rest);
+			if ((rest == value) || (*rest != '\0') || (number < 0.0) || ((item[0] != 'f') && (number > 1.0)))
+			{
+				return GEVLIB_ERROR_PARAMETER_INVALID;
+			}
+			if (item[0] == 'f')
+			{
+				config.fps = number;
+			}
+			else if (item[0] == 'd')
+			{
+				config.dropRate = number;
+			}
+			else
+			{
+				config.incompleteRate = number;
+			}
+			continue;
+		}
+		{
+			unsigned long number = strtoul(value, &rest, 0);
+			if ((rest == value) || (*rest != '\0'))
+			{
+				return GEVLIB_ERROR_PARAMETER_INVALID;
+			}
+			if ((strcmp(item, "cameras") == 0) && (number >= 1) && (number <= ACQ_SYNTHETIC_MAX_CAMERAS))
+			{
+				config.numCameras = (int)number;
+			}
+			else if ((strcmp(item, "width") == 0) && (number >= SIM_WIDTH_INCREMENT) && (number <= 65536))
+			{
+				config.width = (UINT32)(number - (number % SIM_WIDTH_INCREMENT));
+			}
+			else if ((strcmp(item, "height") == 0) && (number >= 1) && (number <= 65536))
+			{
+				config.height = (UINT32)number;
+			}
+			else if (strcmp(item, "seed") == 0)
+			{
+				config.seed = (unsigned int)number;
+			}
+			else
+			{
+				return GEVLIB_ERROR_PARAMETER_INVALID;
+			}
+		}
+	}
+	s_settings = config;
+	s_configuredNs = _NowNs();
+	return 0;
+}
+
+static GEV_STATUS _SimGetCameraList( GEV_DEVICE_INTERFACE *devices, int maxDevices, int *numDevices)
+{
+	int i;
+
+	if ((devices == NULL) || (numDevices == NULL))
+	{
+		return GEVLIB_ERROR_NULL_PTR;
+	}
+	if (_Offline( _NowNs()))
+	{
+		*numDevices = 0;
+		return 0;
+	}
+	for (i = 0; (i < s_settings.numCameras) && (i < maxDevices); i++)
+	{
+		memset(&devices[i], 0, sizeof(GEV_DEVICE_INTERFACE));
+		devices[i].macLow = (UINT32)i;
+		snprintf(devices[i].manufacturer, sizeof(devices[i].manufacturer), "genicam");
+		snprintf(devices[i].model, sizeof(devices[i].model), "Synthetic");
+		snprintf(devices[i].serial, sizeof(devices[i].serial), "SIM%04d", i);
+		snprintf(devices[i].version, sizeof(devices[i].version), "1.0");
+	}
+	*numDevices = i;
+	return 0;
+}
+
+static GEV_STATUS _SimOpenCamera( GEV_DEVICE_INTERFACE *device, GevAccessMode mode, GEV_CAMERA_HANDLE *handle)
+{
+	SIM_CAMERA *cam = NULL;
+	pthread_condattr_t attr;
+
+	if ((device == NULL) || (handle == NULL))
+	{
+		return GEVLIB_ERROR_NULL_PTR;
+	}
+	if (((int)device->macLow >= s_settings.numCameras) || _Offline( _NowNs()))
+	{
+		return GEVLIB_ERROR_DEVICE_NOT_FOUND;
+	}
+	pthread_mutex_lock(&s_openLock);
+	cam = &s_cameras[device->macLow];
+	if (cam->open)
+	{
+		pthread_mutex_unlock(&s_openLock);
+		return GEVLIB_ERROR_INVALID_HANDLE;
+	}
+	memset(cam, 0, sizeof(SIM_CAMERA));
+	cam->index = (int)device->macLow;
+	cam->settings = s_settings;
+	cam->seed = s_settings.seed + cam->index;
+	cam->openNs = _NowNs();
+	pthread_mutex_init(&cam->lock, NULL);
+	pthread_condattr_init(&attr);
+	pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+	pthread_cond_init(&cam->wake, &attr);
+	pthread_condattr_destroy(&attr);
+	cam->open = TRUE;
+	pthread_mutex_unlock(&s_openLock);
+
+	*handle = (GEV_CAMERA_HANDLE)cam;
+	return 0;
+}
+
+static GEV_STATUS _SimCloseCamera( GEV_CAMERA_HANDLE *handle)
+{
+	SIM_CAMERA *cam = (handle != NULL) ? _Camera( *handle) : NULL;
+
+	if (cam == NULL)
+	{
+		return GEVLIB_ERROR_INVALID_HANDLE;
+	}
+	pthread_mutex_lock(&s_openLock);
+	cam->open = FALSE;
+	pthread_cond_destroy(&cam->wake);
+	pthread_mutex_destroy(&cam->lock);
+	pthread_mutex_unlock(&s_openLock);
+	*handle = NULL;
+	return 0;
+}
+
+static GEV_STATUS _SimGetCameraInterfaceOptions( GEV_CAMERA_HANDLE handle, GEV_CAMERA_OPTIONS *options)
+{
+	SIM_CAMERA *cam = _Camera( handle);
+
+	if ((cam == NULL) || (options == NULL))
+	{
+		return (cam == NULL) ? GEVLIB_ERROR_INVALID_HANDLE : GEVLIB_ERROR_NULL_PTR;
+	}
+	*options = cam->options;
+	return 0;
+}
+
+static GEV_STATUS _SimSetCameraInterfaceOptions( GEV_CAMERA_HANDLE handle, GEV_CAMERA_OPTIONS *options)
+{
+	SIM_CAMERA *cam = _Camera( handle);
+
+	if ((cam == NULL) || (options == NULL))
+	{
+		return (cam == NULL) ? GEVLIB_ERROR_INVALID_HANDLE : GEVLIB_ERROR_NULL_PTR;
+	}
+	// (Accepted and kept - there are no stream threads to tune).
+	cam->options = *options;
+	return 0;
+}
+
+// Apply a new frame rate (the frame ids carry on from the last one generated).
+static void _SetFrameRate( SIM_CAMERA *cam, double fps)
+{
+	cam->settings.fps = fps;
+	cam->periodNs = (fps > 0.0) ? (UINT64)(1e9 / fps) : 0;
+	if ((cam->periodNs > 0) && cam->running)
+	{
+		UINT64 now = _NowNs();
+		cam->startNs = now - (cam->lastFrame * cam->periodNs);
+	}
+	pthread_cond_broadcast(&cam->wake);
+}
+
+static GEV_STATUS _SimGetFeatureValueAsString( GEV_CAMERA_HANDLE handle, const char *name, int *type, int size, char *value)
+{
+	SIM_CAMERA *cam = _Camera( handle);
+	GEV_STATUS status = 0;
+
+	if (cam == NULL)
+	{
+		return GEVLIB_ERROR_INVALID_HANDLE;
+	}
+	if ((name == NULL) || (value == NULL) || (size <= 0))
+	{
+		return GEVLIB_ERROR_NULL_PTR;
+	}
+	// (The feature type is not reported).
+	pthread_mutex_lock(&cam->lock);
+	if (strcmp(name, "Width") == 0)
+	{
+		snprintf(value, size, "%u", cam->settings.width);
+	}
+	else if (strcmp(name, "Height") == 0)
+	{
+		snprintf(value, size, "%u", cam->settings.height);
+	}
+	else if (strcmp(name, "PixelFormat") == 0)
+	{
+		snprintf(value, size, "%s", _FormatName( cam->settings.format));
+	}
+	else if (strcmp(name, "PayloadSize") == 0)
+	{
+		snprintf(value, size, "%llu", (unsigned long long)_PayloadSize( &cam->settings));
+	}
+	else if (strcmp(name, "AcquisitionFrameRate") == 0)
+	{
+		snprintf(value, size, "%g", cam->settings.fps);
+	}
+	else if (strcmp(name, "DeviceVendorName") == 0)
+	{
+		snprintf(value, size, "genicam");
+	}
+	else if (strcmp(name, "DeviceModelName") == 0)
+	{
+		snprintf(value, size, "Synthetic");
+	}
+	else if (strcmp(name, "DeviceSerialNumber") == 0)
+	{
+		snprintf(value, size, "SIM%04d", cam->index);
+	}
+	else if (strcmp(name, "GevTimestampTickFrequency") == 0)
+	{
+		snprintf(value, size, "1000000000");
+	}
+	else if (strcmp(name, "GevTimestampValue") == 0)
+	{
+		snprintf(value, size, "%llu", (unsigned long long)cam->latched);
+	}
+	else
+	{
+		status = GEVLIB_ERROR_PARAMETER_INVALID;
+	}
+	pthread_mutex_unlock(&cam->lock);
+	return status;
+}
+
+static GEV_STATUS _SimSetFeatureValueAsString( GEV_CAMERA_HANDLE handle, const char *name, const char *value)
+{
+	SIM_CAMERA *cam = _Camera( handle);
+	GEV_STATUS status = 0;
+	char *rest = NULL;
+
+	if (cam == NULL)
+	{
+		return GEVLIB_ERROR_INVALID_HANDLE;
+	}
+	if ((name == NULL) || (value == NULL))
+	{
+		return GEVLIB_ERROR_NULL_PTR;
+	}
+	pthread_mutex_lock(&cam->lock);
+	if (strcmp(name, "AcquisitionFrameRate") == 0)
+	{
+		double fps = strtod(value, &rest);
+		if ((rest == value) || (fps < 0.0))
+		{
+			status = GEVLIB_ERROR_PARAMETER_INVALID;
+		}
+		else
+		{
+			_SetFrameRate( cam, fps);
+		}
+	}
+	else if ((strcmp(name, "Width") == 0) || (strcmp(name, "Height") == 0) || (strcmp(name, "PixelFormat") == 0))
+	{
+		if (cam->initialized)
+		{
+			// Locked while a transfer is set up (as on a camera).
+			status = GEVLIB_ERROR_PARAMETER_INVALID;
+		}
+		else if (name[0] == 'P')
+		{
+			status = _ParseFormat( value, &cam->settings.format);
+		}
+		else
+		{
+			unsigned long number = strtoul(value, &rest, 0);
+			if ((rest == value) || (number < ((name[0] == 'W') ? SIM_WIDTH_INCREMENT : 1)) || (number > 65536))
+			{
+				status = GEVLIB_ERROR_PARAMETER_INVALID;
+			}
+			else if (name[0] == 'W')
+			{
+				cam->settings.width = (UINT32)(number - (number % SIM_WIDTH_INCREMENT));
+			}
+			else
+			{
+				cam->settings.height = (UINT32)number;
+			}
+		}
+	}
+	else
+	{
+		status = GEVLIB_ERROR_PARAMETER_INVALID;
+	}
+	pthread_mutex_unlock(&cam->lock);
+	return status;
+}
+
+// Integer features are read / written as UINT32 or UINT64, the frame rate as a float or a double (by size).
+static GEV_STATUS _SimGetFeatureValue( GEV_CAMERA_HANDLE handle, const char *name, int *type, int size, void *value)
+{
+	char text[64];
+	char *rest = NULL;
+	GEV_STATUS status = _SimGetFeatureValueAsString( handle, name, type, sizeof(text), text);
+
+	if ((status != 0) || (value == NULL))
+	{
+		return (status != 0) ? status : GEVLIB_ERROR_NULL_PTR;
+	}
+	if (strcmp(name, "PixelFormat") == 0)
+	{
+		snprintf(text, sizeof(text), "%u", _Camera( handle)->settings.format);
+	}
+	if (strcmp(name, "AcquisitionFrameRate") == 0)
+	{
+		double number = strtod(text, NULL);
+		if (size == sizeof(double))
+		{
+			*(double *)value = number;
+			return 0;
+		}
+		if (size == sizeof(float))
+		{
+			*(float *)value = (float)number;
+			return 0;
+		}
+		return GEVLIB_ERROR_PARAMETER_INVALID;
+	}
+	{
+		UINT64 number = strtoull(text, &rest, 0);
+		if ((rest == text) || (*rest != '\0'))
+		{
+			// (A string feature).
+			return GEVLIB_ERROR_PARAMETER_INVALID;
+		}
+		if (size == sizeof(UINT64))
+		{
+			*(UINT64 *)value = number;
+			return 0;
+		}
+		if (size == sizeof(UINT32))
+		{
+			*(UINT32 *)value = (UINT32)number;
+			return 0;
+		}
+	}
+	return GEVLIB_ERROR_PARAMETER_INVALID;
+}
+
+static GEV_STATUS _SimSetFeatureValue( GEV_CAMERA_HANDLE handle, const char *name, int size, void *value)
+{
+	char text[64];
+
+	if ((name == NULL) || (value == NULL))
+	{
+		return GEVLIB_ERROR_NULL_PTR;
+	}
+	if (strcmp(name, "PixelFormat") == 0)
+	{
+		const char *formatName = (size == sizeof(UINT32)) ? _FormatName( *(UINT32 *)value) : NULL;
+		return (formatName != NULL) ? _SimSetFeatureValueAsString( handle, name, formatName) : GEVLIB_ERROR_PARAMETER_INVALID;
+	}
+	if (strcmp(name, "AcquisitionFrameRate") == 0)
+	{
+		if ((size != sizeof(double)) && (size != sizeof(float)))
+		{
+			return GEVLIB_ERROR_PARAMETER_INVALID;
+		}
+		snprintf(text, sizeof(text), "%.17g", (size == sizeof(double)) ? *(double *)value : (double)*(float *)value);
+	}
+	else if (size == sizeof(UINT64))
+	{
+		snprintf(text, sizeof(text), "%llu", (unsigned long long)*(UINT64 *)value);
+	}
+	else if (size == sizeof(UINT32))
+	{
+		snprintf(text, sizeof(text), "%u", *(UINT32 *)value);
+	}
+	else
+	{
+		return GEVLIB_ERROR_PARAMETER_INVALID;
+	}
+	return _SimSetFeatureValueAsString( handle, name, text);
+}
+
+static GEV_STATUS _SimExecuteCommand( GEV_CAMERA_HANDLE handle, const char *name)
+{
+	SIM_CAMERA *cam = _Camera( handle);
+
+	if (cam == NULL)
+	{
+		return GEVLIB_ERROR_INVALID_HANDLE;
+	}
+	if ((name != NULL) && (strcmp(name, "GevTimestampControlLatch") == 0))
+	{
+		pthread_mutex_lock(&cam->lock);
+		cam->latched = _NowNs() - cam->openNs;
+		pthread_mutex_unlock(&cam->lock);
+		return 0;
+	}
+	// (The transfer start / stop does the work).
+	if ((name != NULL) && ((strcmp(name, "AcquisitionStart") == 0) || (strcmp(name, "AcquisitionStop") == 0)))
+	{
+		return 0;
+	}
+	return GEVLIB_ERROR_PARAMETER_INVALID;
+}
+
+static GEV_STATUS _SimGetImageGeometry( GEV_CAMERA_HANDLE handle, UINT32 *width, UINT32 *height, UINT64 *payloadSize, UINT32 *format)
+{
+	SIM_CAMERA *cam = _Camera( handle);
+
+	if (cam == NULL)
+	{
+		return GEVLIB_ERROR_INVALID_HANDLE;
+	}
+	pthread_mutex_lock(&cam->lock);
+	*width = cam->settings.width;
+	*height = cam->settings.height;
+	*payloadSize = _PayloadSize( &cam->settings);
+	*format = cam->settings.format;
+	pthread_mutex_unlock(&cam->lock);
+	return 0;
+}
+
+static GEV_STATUS _SimInitializeTransfer( GEV_CAMERA_HANDLE handle, GevBufferCyclingMode mode, UINT64 bufSize, UINT32 numBuffers, UINT8 **bufAddress)
+{
+	SIM_CAMERA *cam = _Camera( handle);
+	UINT64 payloadSize = 0;
+	UINT64 stride = 0;
+	UINT32 i;
+	UINT64 x, y;
+
+	if (cam == NULL)
+	{
+		return GEVLIB_ERROR_INVALID_HANDLE;
+	}
+	if (bufAddress == NULL)
+	{
+		return GEVLIB_ERROR_NULL_PTR;
+	}
+	pthread_mutex_lock(&cam->lock);
+	payloadSize = _PayloadSize( &cam->settings);
+	if (cam->initialized || (numBuffers < 1) || (numBuffers > ACQ_SYNTHETIC_MAX_BUFFERS) || (bufSize < payloadSize))
+	{
+		pthread_mutex_unlock(&cam->lock);
+		return GEVLIB_ERROR_PARAMETER_INVALID;
+	}
+	cam->mode = mode;
+	cam->bufSize = bufSize;
+	cam->numBuffers = numBuffers;
+	stride = payloadSize / cam->settings.height;
+	for (i = 0; i < numBuffers; i++)
+	{
+		GEV_BUFFER_OBJECT *img = &cam->images[i];
+
+		if (bufAddress[i] == NULL)
+		{
+			pthread_mutex_unlock(&cam->lock);
+			return GEVLIB_ERROR_NULL_PTR;
+		}
+		// Test pattern (a diagonal ramp of bytes - whatever they mean in this format).
+		for (y = 0; y < cam->settings.height; y++)
+		{
+			for (x = 0; x < stride; x++)
+			{
+				bufAddress[i][(y * stride) + x] = (UINT8)(x + y);
+			}
+		}
+		memset(img, 0, sizeof(GEV_BUFFER_OBJECT));
+		img->address = bufAddress[i];
+		img->w = cam->settings.width;
+		img->h = cam->settings.height;
+		img->format = cam->settings.format;
+		img->d = GetPixelSizeInBytes(cam->settings.format);
+		img->status = GEV_FRAME_STATUS_RELEASED;
+		cam->held[i] = FALSE;
+	}
+	cam->numHeld = 0;
+	cam->nextBuffer = 0;
+	cam->queueHead = 0;
+	cam->queueCount = 0;
+	cam->initialized = TRUE;
+	pthread_mutex_unlock(&cam->lock);
+	return 0;
+}
+
+static GEV_STATUS _SimStartTransfer( GEV_CAMERA_HANDLE handle, UINT32 numFrames)
+{
+	SIM_CAMERA *cam = _Camera( handle);
+
+	if (cam == NULL)
+	{
+		return GEVLIB_ERROR_INVALID_HANDLE;
+	}
+	pthread_mutex_lock(&cam->lock);
+	if (!cam->initialized)
+	{
+		pthread_mutex_unlock(&cam->lock);
+		return GEVLIB_ERROR_PARAMETER_INVALID;
+	}
+	// (Runs until aborted whatever numFrames says - the frame ids carry on after a restart).
+	cam->running = TRUE;
+	_SetFrameRate( cam, cam->settings.fps);
+	pthread_mutex_unlock(&cam->lock);
+	return 0;
+}
+
+static GEV_STATUS _SimAbortTransfer( GEV_CAMERA_HANDLE handle)
+{
+	SIM_CAMERA *cam = _Camera( handle);
+
+	if (cam == NULL)
+	{
+		return GEVLIB_ERROR_INVALID_HANDLE;
+	}
+	pthread_mutex_lock(&cam->lock);
+	cam->running = FALSE;
+	cam->queueCount = 0;
+	pthread_cond_broadcast(&cam->wake);
+	pthread_mutex_unlock(&cam->lock);
+	return 0;
+}
+
+static GEV_STATUS _SimFreeTransfer( GEV_CAMERA_HANDLE handle)
+{
+	SIM_CAMERA *cam = _Camera( handle);
+
+	if (cam == NULL)
+	{
+		return GEVLIB_ERROR_INVALID_HANDLE;
+	}
+	pthread_mutex_lock(&cam->lock);
+	cam->running = FALSE;
+	cam->initialized = FALSE;
+	cam->queueCount = 0;
+	cam->numHeld = 0;
+	cam->numBuffers = 0;
+	pthread_mutex_unlock(&cam->lock);
+	return 0;
+}
+
+static GEV_STATUS _SimWaitForNextImage( GEV_CAMERA_HANDLE handle, GEV_BUFFER_OBJECT **image, UINT32 timeoutMs)
+{
+	SIM_CAMERA *cam = _Camera( handle);
+	GEV_STATUS status = GEVLIB_ERROR_TIME_OUT;
+	UINT64 deadline = _NowNs() + ((UINT64)timeoutMs * 1000000ULL);
+	int wasRunning = FALSE;
+
+	if (cam == NULL)
+	{
+		return GEVLIB_ERROR_INVALID_HANDLE;
+	}
+	if (image == NULL)
+	{
+		return GEVLIB_ERROR_NULL_PTR;
+	}
+	*image = NULL;
+
+	pthread_mutex_lock(&cam->lock);
+	wasRunning = cam->running;
+	for (;;)
+	{
+		UINT64 now = _NowNs();
+		UINT64 wakeAt = deadline;
+		struct timespec ts;
+
+		if (cam->running && _Offline( now))
+		{
+			// Nothing comes in until the wait times out.
+		}
+		else if (cam->running)
+		{
+			UINT64 lastFrame = cam->lastFrame;
+
+			_GenerateFrames( cam, now);
+			if (cam->queueCount > 0)
+			{
+				*image = _NextImage( cam, now);
+				status = (*image != NULL) ? GEVLIB_OK : GEVLIB_ERROR_SOFTWARE;
+				break;
+			}
+			if ((cam->periodNs == 0) && (cam->lastFrame != lastFrame))
+			{
+				// Free running and that one was dropped - on to the next.
+				continue;
+			}
+			if (cam->periodNs > 0)
+			{
+				UINT64 due = cam->startNs + ((cam->lastFrame + 1) * cam->periodNs);
+				wakeAt = (due < deadline) ? due : deadline;
+			}
+		}
+		else if (wasRunning)
+		{
+			// Stopped while waiting.
+			break;
+		}
+		if (now >= deadline)
+		{
+			break;
+		}
+		ts.tv_sec = (time_t)(wakeAt / 1000000000ULL);
+		ts.tv_nsec = (long)(wakeAt % 1000000000ULL);
+		pthread_cond_timedwait(&cam->wake, &cam->lock, &ts);
+	}
+	pthread_mutex_unlock(&cam->lock);
+	return status;
+}
+
+static GEV_STATUS _SimReleaseImage( GEV_CAMERA_HANDLE handle, GEV_BUFFER_OBJECT *image)
+{
+	SIM_CAMERA *cam = _Camera( handle);
+	GEV_STATUS status = GEVLIB_ERROR_PARAMETER_INVALID;
+	long index = 0;
+
+	if (cam == NULL)
+	{
+		return GEVLIB_ERROR_INVALID_HANDLE;
+	}
+	pthread_mutex_lock(&cam->lock);
+	index = (long)(image - &cam->images[0]);
+	if ((index >= 0) && (index < (long)cam->numBuffers))
+	{
+		if (cam->held[index])
+		{
+			cam->held[index] = FALSE;
+			cam->numHeld--;
+			pthread_cond_broadcast(&cam->wake);
+		}
+		status = 0;
+	}
+	pthread_mutex_unlock(&cam->lock);
+	return status;
+}
+
+static GEV_STATUS _SimCheckConnection( GEV_CAMERA_HANDLE handle)
+{
+	if (_Camera( handle) == NULL)
+	{
+		return GEVLIB_ERROR_INVALID_HANDLE;
+	}
+	return _Offline( _NowNs()) ? GEVLIB_ERROR_TIME_OUT : 0;
+}
+
+const ACQ_BACKEND AcqBackend_Synthetic =
+{
+	"synthetic",
+	_SimGetCameraList,
+	_SimOpenCamera,
+	_SimCloseCamera,
+	_SimGetCameraInterfaceOptions,
+	_SimSetCameraInterfaceOptions,
+	_SimGetFeatureValue,
+	_SimSetFeatureValue,
+	_SimGetFeatureValueAsString,
+	_SimSetFeatureValueAsString,
+	_SimExecuteCommand,
+	_SimGetImageGeometry,
+	_SimInitializeTransfer,
+	_SimStartTransfer,
+	_SimAbortTransfer,
+	_SimFreeTransfer,
+	_SimWaitForNextImage,
+	_SimReleaseImage,
+	_SimCheckConnection
+};
@@ -0,0 +1,610 @@
+/*
+  ---------------------------------------------
+  Run time settings
+  -----------------------------------------------
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <ctype.h>
+#include <getopt.h>
+#include "AppConfig.h"
+
+#define CONFIG_GLOBAL		0		// Offset into APP_CONFIG.
+#define CONFIG_CAMERA		1		// Offset into APP_CAMERA_CONFIG.
+
+#define CONFIG_SWITCH		0
+#define CONFIG_NUMBER		1
+#define CONFIG_STRING		2
+
+#ifndef TRUE
+#define TRUE	1
+#define FALSE	0
+#endif
+
+typedef struct CONFIG_OPTION_t
+{
+	const char	*name;
+	int			scope;
+	int			type;
+	size_t		offset;
+	uint32_t		min;
+	uint32_t		max;
+	const char	*env;			// Environment variable that sets it (NULL = none).
+	const char	*help;
+} CONFIG_OPTION;
+
+static const CONFIG_OPTION s_options[] =
+{
+	{ "print", CONFIG_GLOBAL, CONFIG_SWITCH, offsetof(APP_CONFIG, print), 0, 1, NULL,
+		"Print the program state and periodic statistics" },
+	{ "display", CONFIG_GLOBAL, CONFIG_SWITCH, offsetof(APP_CONFIG, display), 0, 1, NULL,
+		"Show the images in a window" },
+	{ "backend", CONFIG_GLOBAL, CONFIG_STRING, offsetof(APP_CONFIG, backend), 0, 0, "GENICAM_BACKEND",
+		"Acquisition backend : gev | synthetic[:settings] | replay:<recording>[,...]" },
+	{ "backpressure", CONFIG_GLOBAL, CONFIG_STRING, offsetof(APP_CONFIG, backpressure), 0, 0, "GENICAM_BACKPRESSURE",
+		"stdout policy : none | block | drop-newest | drop-oldest | latest" },
+	{ "lease-policy", CONFIG_GLOBAL, CONFIG_STRING, offsetof(APP_CONFIG, leasePolicy), 0, 0, NULL,
+		"When the consumers hold every buffer : wait | drop" },
+	{ "calibrate", CONFIG_GLOBAL, CONFIG_NUMBER, offsetof(APP_CONFIG, calibrate), 0, 600, NULL,
+		"Tune the stream settings of each camera (seconds per trial, 0 = off) and save them" },
+	{ "record", CONFIG_GLOBAL, CONFIG_STRING, offsetof(APP_CONFIG, record), 0, 0, "GENICAM_RECORD",
+		"Record the frames received to this file (.<camera> added after the first camera)" },
+	{ "reconnect-interval", CONFIG_GLOBAL, CONFIG_NUMBER, offsetof(APP_CONFIG, reconnectMs), 0, 60000, NULL,
+		"Look for a lost camera every this many ms until it is back (0 = do not reconnect)" },
+	{ "clock-sync", CONFIG_GLOBAL, CONFIG_NUMBER, offsetof(APP_CONFIG, clockSyncMs), 0, 60000, NULL,
+		"Latch the camera clocks against the host clock every this many ms (0 = frames have no exposure time)" },
+	{ "acquisition-threads", CONFIG_GLOBAL, CONFIG_STRING, offsetof(APP_CONFIG, acquisitionThreads), 0, 0, NULL,
+		"Scheduling / CPUs of the acquisition threads : <class>[:<priority>][@<cpus>|auto|any]" },
+	{ "converter-threads", CONFIG_GLOBAL, CONFIG_STRING, offsetof(APP_CONFIG, converterThreads), 0, 0, NULL,
+		"Scheduling / CPUs of the conversion workers (as acquisition-threads)" },
+	{ "output-threads", CONFIG_GLOBAL, CONFIG_STRING, offsetof(APP_CONFIG, outputThreads), 0, 0, NULL,
+		"Scheduling / CPUs of the output writers (as acquisition-threads)" },
+	{ "display-threads", CONFIG_GLOBAL, CONFIG_STRING, offsetof(APP_CONFIG, displayThreads), 0, 0, NULL,
+		"Scheduling / CPUs of the display threads (as acquisition-threads)" },
+	{ "stage-depth", CONFIG_GLOBAL, CONFIG_NUMBER, offsetof(APP_CONFIG, stageDepth), 1, 16, NULL,
+		"Frames waiting between two stages of the pipeline (acquisition, conversion, publication)" },
+	{ "stage-overflow", CONFIG_GLOBAL, CONFIG_STRING, offsetof(APP_CONFIG, stageOverflow), 0, 0, NULL,
+		"When the conversion threads are behind : block | drop-oldest" },
+	{ "convert-threads", CONFIG_GLOBAL, CONFIG_NUMBER, offsetof(APP_CONFIG, convertThreads), 1, 16, NULL,
+		"Conversion threads per camera (frames are dealt out in turn and published in order)" },
+	{ "convert-bands", CONFIG_GLOBAL, CONFIG_NUMBER, offsetof(APP_CONFIG, convertBands), 1, 64, NULL,
+		"Bands of rows a frame is cut into, converted at once (by a pool of convert-bands - 1 threads)" },
+	{ "simd", CONFIG_GLOBAL, CONFIG_STRING, offsetof(APP_CONFIG, simd), 0, 0, NULL,
+		"Instruction set of the pixel conversion kernels : auto | avx2 | sse4.1 | ssse3 | scalar" },
+	{ "buffers", CONFIG_CAMERA, CONFIG_NUMBER, offsetof(APP_CAMERA_CONFIG, numBuffers), 2, APP_CONFIG_MAX_BUFFERS, NULL,
+		"Image buffers of the transfer" },
+	{ "sync-cycling", CONFIG_CAMERA, CONFIG_SWITCH, offsetof(APP_CAMERA_CONFIG, syncCycling), 0, 1, NULL,
+		"Synchronous buffer cycling (buffers are only reused once released)" },
+	{ "turbo-drive", CONFIG_CAMERA, CONFIG_SWITCH, offsetof(APP_CAMERA_CONFIG, turboDrive), 0, 1, NULL,
+		"TurboDrive (when the camera has it)" },
+	{ "tune-streaming", CONFIG_CAMERA, CONFIG_SWITCH, offsetof(APP_CAMERA_CONFIG, tuneStreaming), 0, 1, NULL,
+		"Apply the stream settings below and pin the stream threads" },
+	{ "packet-size", CONFIG_CAMERA, CONFIG_NUMBER, offsetof(APP_CAMERA_CONFIG, packetSize), 576, 16384, NULL,
+		"GVSP packet size (bytes)" },
+	{ "packet-delay", CONFIG_CAMERA, CONFIG_NUMBER, offsetof(APP_CAMERA_CONFIG, packetDelay), 0, 100000, NULL,
+		"Delay between packets (us)" },
+	{ "frames-buffered", CONFIG_CAMERA, CONFIG_NUMBER, offsetof(APP_CAMERA_CONFIG, framesBuffered), 1, 64, NULL,
+		"Frames the library buffers internally" },
+	{ "memory-limit", CONFIG_CAMERA, CONFIG_NUMBER, offsetof(APP_CAMERA_CONFIG, memoryLimit), 1024*1024, 0xFFFFFFFF, NULL,
+		"Packet memory limit of the library (bytes)" },
+	{ "frame-timeout", CONFIG_CAMERA, CONFIG_NUMBER, offsetof(APP_CAMERA_CONFIG, frameTimeoutMs), 1, 60000, NULL,
+		"Time to receive a whole frame (ms)" },
+	{ "heartbeat-timeout", CONFIG_CAMERA, CONFIG_NUMBER, offsetof(APP_CAMERA_CONFIG, heartbeatTimeoutMs), 500, 600000, NULL,
+		"Disconnect detection (ms)" },
+	{ "huge-pages", CONFIG_CAMERA, CONFIG_SWITCH, offsetof(APP_CAMERA_CONFIG, hugePages), 0, 1, NULL,
+		"Back the image / conversion buffers with 2 MB pages when possible" },
+	{ "lock-buffers", CONFIG_CAMERA, CONFIG_SWITCH, offsetof(APP_CAMERA_CONFIG, lockBuffers), 0, 1, NULL,
+		"Lock the buffers in memory (mlock)" },
+	{ "prefault-threads", CONFIG_CAMERA, CONFIG_NUMBER, offsetof(APP_CAMERA_CONFIG, prefaultThreads), 0, 64, NULL,
+		"Threads faulting the buffer pages in up front (0 = on first use)" },
+	{ "numa-bind", CONFIG_CAMERA, CONFIG_SWITCH, offsetof(APP_CAMERA_CONFIG, numaBind), 0, 1, NULL,
+		"Take the buffers from the NUMA node of the camera's NIC" }
+};
+#define CONFIG_NUM_OPTIONS	((int)(sizeof(s_options) / sizeof(s_options[0])))
+
+static const CONFIG_OPTION *_FindOption( const char *name)
+{
+	int i;
+	for (i = 0; i < CONFIG_NUM_OPTIONS; i++)
+	{
+		if (strcmp(s_options[i].name, name) == 0)
+		{
+			return &s_options[i];
+		}
+	}
+	return NULL;
+}
+
+// Parse a switch / number (with a K, M or G suffix) within the option's range.
+static int _ParseNumber( const CONFIG_OPTION *option, const char *value, uint32_t *number)
+{
+	unsigned long long n = 0;
+	char *end = NULL;
+
+	if (option->type == CONFIG_SWITCH)
+	{
+		if (!strcmp(value, "1") || !strcmp(value, "on") || !strcmp(value, "yes") || !strcmp(value, "true"))
+		{
+			*number = 1;
+			return 0;
+		}
+		if (!strcmp(value, "0") || !strcmp(value, "off") || !strcmp(value, "no") || !strcmp(value, "false"))
+		{
+			*number = 0;
+			return 0;
+		}
+		return CONFIG_ERROR_VALUE;
+	}
+	n = strtoull(value, &end, 0);
+	if ((end == value) || (value[0] == '-'))
+	{
+		return CONFIG_ERROR_VALUE;
+	}
+	switch (toupper((unsigned char)*end))
+	{
+		case 'K': n <<= 10; end++; break;
+		case 'M': n <<= 20; end++; break;
+		case 'G': n <<= 30; end++; break;
+		default: break;
+	}
+	if ((*end != '\0') || (n < option->min) || (n > option->max))
+	{
+		return CONFIG_ERROR_VALUE;
+	}
+	*number = (uint32_t)n;
+	return 0;
+}
+
+static int _SetOption( APP_CONFIG *cfg, const CONFIG_OPTION *option, int camera, const char *value)
+{
+	char *base = NULL;
+	uint32_t number = 0;
+	int status = 0;
+
+	if (value == NULL)
+	{
+		return CONFIG_ERROR_VALUE;
+	}
+	if (option->scope == CONFIG_GLOBAL)
+	{
+		if (camera >= 0)
+		{
+			return CONFIG_ERROR_UNKNOWN;
+		}
+		base = (char *)cfg;
+	}
+	else
+	{
+		base = (char *)((camera >= 0) ? &cfg->cameras[camera] : &cfg->camera);
+	}
+
+	if (option->type == CONFIG_STRING)
+	{
+		if (strlen(value) >= APP_CONFIG_MAX_STRING)
+		{
+			return CONFIG_ERROR_VALUE;
+		}
+		strcpy(base + option->offset, value);
+		return 0;
+	}
+	status = _ParseNumber( option, value, &number);
+	if (status == 0)
+	{
+		*(uint32_t *)(base + option->offset) = number;
+		if (camera >= 0)
+		{
+			cfg->overrides[camera] |= (1u << (option - s_options));
+		}
+	}
+	return status;
+}
+
+// !
+// AppConfig_Set
+//
+/*!
+	Set one setting by name ("packet-size", or "cam1.packet-size" for camera 1 only).
+
+	\return Error status
+		0   = Success
+		CONFIG_ERROR_UNKNOWN  No such setting (or camera).
+		CONFIG_ERROR_VALUE    Bad value (the setting is unchanged).
+*/
+int AppConfig_Set( APP_CONFIG *cfg, const char *name, const char *value)
+{
+	const CONFIG_OPTION *option = NULL;
+	int camera = -1;
+
+	if ((cfg == NULL) || (name == NULL))
+	{
+		return CONFIG_ERROR_NULL_PTR;
+	}
+	if ((strncmp(name, "cam", 3) == 0) && isdigit((unsigned char)name[3]))
+	{
+		char *end = NULL;
+		camera = (int)strtol(&name[3], &end, 10);
+		if ((*end != '.') || (camera >= APP_CONFIG_MAX_CAMERAS))
+		{
+			return CONFIG_ERROR_UNKNOWN;
+		}
+		name = end + 1;
+	}
+	option = _FindOption( name);
+	if (option == NULL)
+	{
+		return CONFIG_ERROR_UNKNOWN;
+	}
+	return _SetOption( cfg, option, camera, value);
+}
+
+// Blanks off both ends of s (in place).
+static char *_Trim( char *s)
+{
+	char *end = s + strlen(s);
+
+	while (isspace((unsigned char)*s))
+	{
+		s++;
+	}
+	while ((end > s) && isspace((unsigned char)end[-1]))
+	{
+		*--end = '\0';
+	}
+	return s;
+}
+
+// !
+// AppConfig_Load
+//
+/*!
+	Read a configuration file : "name = value" lines, '#' comments, and [cam<N>]
+	sections for the settings of one camera ([all] goes back to every camera).
+	Errors are reported on stderr with the line number.
+
+	\return Error status
+		0   = Success
+		CONFIG_ERROR_FILE     The file could not be opened.
+		CONFIG_ERROR_UNKNOWN / CONFIG_ERROR_VALUE  of the first bad line (the others are still read).
+*/
+int AppConfig_Load( APP_CONFIG *cfg, const char *path)
+{
+	FILE *fp = NULL;
+	char line[512];
+	char section[16] = {0};
+	int lineNumber = 0;
+	int result = 0;
+
+	if ((cfg == NULL) || (path == NULL))
+	{
+		return CONFIG_ERROR_NULL_PTR;
+	}
+	fp = fopen(path, "r");
+	if (fp == NULL)
+	{
+		fprintf(stderr, "%s : cannot be read\n", path);
+		return CONFIG_ERROR_FILE;
+	}
+	snprintf(cfg->path, sizeof(cfg->path), "%s", path);
+
+	while (fgets(line, sizeof(line), fp) != NULL)
+	{
+		char *text = line;
+		char *value = NULL;
+		char *comment = strchr(line, '#');
+		char name[APP_CONFIG_MAX_STRING + 16];
+		int status = 0;
+
+		lineNumber++;
+		if (comment != NULL)
+		{
+			*comment = '\0';
+		}
+		text = _Trim( text);
+		if (*text == '\0')
+		{
+			continue;
+		}
+		if (*text == '[')
+		{
+			char *end = strchr(text, ']');
+			int camera = -1;
+
+			section[0] = '\0';
+			if ((end != NULL) && (end[1] == '\0'))
+			{
+				*end = '\0';
+				if (strcmp(&text[1], "all") == 0)
+				{
+					continue;
+				}
+				if ((sscanf(&text[1], "cam%d", &camera) == 1) && (camera >= 0) && (camera < APP_CONFIG_MAX_CAMERAS))
+				{
+					snprintf(section, sizeof(section), "cam%d.", camera);
+					continue;
+				}
+			}
+			status = CONFIG_ERROR_UNKNOWN;
+		}
+		else if ((value = strchr(text, '=')) == NULL)
+		{
+			status = CONFIG_ERROR_VALUE;
+		}
+		else
+		{
+			*value++ = '\0';
+			snprintf(name, sizeof(name), "%s%s", section, _Trim( text));
+			status = AppConfig_Set( cfg, name, _Trim( value));
+		}
+		if (status != 0)
+		{
+			fprintf(stderr, "%s:%d : %s\n", path, lineNumber, (status == CONFIG_ERROR_UNKNOWN) ? "unknown setting" : "bad value");
+			result = (result == 0) ? status : result;
+		}
+	}
+	fclose(fp);
+	return result;
+}
+
+// !
+// AppConfig_Parse
+//
+/*!
+	Apply the configuration file (--config <file>, or the GENICAM_CONFIG environment
+	variable), the environment and then the command line options to cfg (which holds
+	the defaults). Errors are reported on stderr.
+
+	\param firstArg  Set to the index of the first argument that is not an option
+	                 (the options are moved ahead of the other arguments).
+
+	\return Error status
+		0   = Success
+		CONFIG_ERROR_HELP  --help was given.
+		Otherwise the error of the first bad setting.
+*/
+int AppConfig_Parse( APP_CONFIG *cfg, int argc, char *argv[], int *firstArg)
+{
+	struct option longOptions[CONFIG_NUM_OPTIONS + 5];
+	const char *path = getenv("GENICAM_CONFIG");
+	int status = 0;
+	int printConfig = FALSE;
+	int c = 0;
+	int index = 0;
+	int i;
+
+	if ((cfg == NULL) || (argv == NULL) || (firstArg == NULL))
+	{
+		return CONFIG_ERROR_NULL_PTR;
+	}
+
+	// The file comes first whatever its place on the command line.
+	for (i = 1; i < argc; i++)
+	{
+		if ((strcmp(argv[i], "--config") == 0) || (strcmp(argv[i], "-c") == 0))
+		{
+			path = (i + 1 < argc) ? argv[i + 1] : NULL;
+		}
+		else if (strncmp(argv[i], "--config=", 9) == 0)
+		{
+			path = &argv[i][9];
+		}
+		else if (strcmp(argv[i], "--") == 0)
+		{
+			break;
+		}
+	}
+	if ((path != NULL) && (path[0] != '\0'))
+	{
+		status = AppConfig_Load( cfg, path);
+		if (status != 0)
+		{
+			return status;
+		}
+	}
+
+	for (i = 0; i < CONFIG_NUM_OPTIONS; i++)
+	{
+		const char *value = (s_options[i].env != NULL) ? getenv(s_options[i].env) : NULL;
+		if ((value != NULL) && (_SetOption( cfg, &s_options[i], -1, value) != 0))
+		{
+			fprintf(stderr, "%s : bad value \"%s\"\n", s_options[i].env, value);
+			return CONFIG_ERROR_VALUE;
+		}
+		longOptions[i].name = s_options[i].name;
+		longOptions[i].has_arg = (s_options[i].type == CONFIG_SWITCH) ? optional_argument : required_argument;
+		longOptions[i].flag = NULL;
+		longOptions[i].val = 0;
+	}
+	longOptions[i++] = (struct option){ "config", required_argument, NULL, 'c' };
+	longOptions[i++] = (struct option){ "option", required_argument, NULL, 'o' };
+	longOptions[i++] = (struct option){ "print-config", no_argument, NULL, 'p' };
+	longOptions[i++] = (struct option){ "help", no_argument, NULL, 'h' };
+	longOptions[i] = (struct option){ NULL, 0, NULL, 0 };
+
+	optind = 1;
+	while ((c = getopt_long(argc, argv, "c:o:ph", longOptions, &index)) != -1)
+	{
+		const char *name = NULL;
+		const char *value = optarg;
+		char setting[APP_CONFIG_MAX_STRING + 16];
+
+		switch (c)
+		{
+			case 0:
+				name = s_options[index].name;
+				value = (optarg != NULL) ? optarg : "1";
+				status = _SetOption( cfg, &s_options[index], -1, value);
+				break;
+			case 'o':
+				{
+					const char *equal = strchr(optarg, '=');
+					if ((equal == NULL) || ((size_t)(equal - optarg) >= sizeof(setting)))
+					{
+						name = optarg;
+						status = CONFIG_ERROR_VALUE;
+						break;
+					}
+					snprintf(setting, sizeof(setting), "%.*s", (int)(equal - optarg), optarg);
+					name = setting;
+					value = equal + 1;
+					status = AppConfig_Set( cfg, name, value);
+				}
+				break;
+			case 'c':
+				// (Read already).
+				break;
+			case 'p':
+				printConfig = TRUE;
+				break;
+			case 'h':
+				AppConfig_Usage( argv[0], stderr);
+				return CONFIG_ERROR_HELP;
+			default:
+				// (getopt has said what is wrong).
+				AppConfig_Usage( argv[0], stderr);
+				return CONFIG_ERROR_UNKNOWN;
+		}
+		if (status != 0)
+		{
+			fprintf(stderr, "%s : %s \"%s\"\n", name, (status == CONFIG_ERROR_UNKNOWN) ? "unknown setting" : "bad value", value);
+			return status;
+		}
+	}
+	if (printConfig)
+	{
+		AppConfig_Write( cfg, stderr);
+	}
+	*firstArg = optind;
+	return 0;
+}
+
+// !
+// AppConfig_GetCamera
+//
+/*!
+	Settings of camera "channel" (the settings of every camera with those given for it).
+*/
+void AppConfig_GetCamera( const APP_CONFIG *cfg, int channel, APP_CAMERA_CONFIG *camera)
+{
+	int i;
+
+	*camera = cfg->camera;
+	if ((channel < 0) || (channel >= APP_CONFIG_MAX_CAMERAS))
+	{
+		return;
+	}
+	for (i = 0; i < CONFIG_NUM_OPTIONS; i++)
+	{
+		if (cfg->overrides[channel] & (1u << i))
+		{
+			memcpy((char *)camera + s_options[i].offset, (const char *)&cfg->cameras[channel] + s_options[i].offset, sizeof(uint32_t));
+		}
+	}
+}
+
+// !
+// AppConfig_SetCamera
+//
+/*!
+	Give camera "channel" its own value for every camera setting.
+*/
+void AppConfig_SetCamera( APP_CONFIG *cfg, int channel, const APP_CAMERA_CONFIG *camera)
+{
+	int i;
+
+	if ((channel < 0) || (channel >= APP_CONFIG_MAX_CAMERAS))
+	{
+		return;
+	}
+	cfg->cameras[channel] = *camera;
+	for (i = 0; i < CONFIG_NUM_OPTIONS; i++)
+	{
+		if (s_options[i].scope == CONFIG_CAMERA)
+		{
+			cfg->overrides[channel] |= (1u << i);
+		}
+	}
+}
+
+static void _WriteValue( const CONFIG_OPTION *option, const char *base, FILE *fp)
+{
+	if (option->type == CONFIG_STRING)
+	{
+		fprintf(fp, "%s = %s\n", option->name, base + option->offset);
+	}
+	else
+	{
+		fprintf(fp, "%s = %u\n", option->name, *(const uint32_t *)(base + option->offset));
+	}
+}
+
+// !
+// AppConfig_Write
+//
+/*!
+	Write the settings in the configuration file format (to keep the ones that work).
+*/
+void AppConfig_Write( const APP_CONFIG *cfg, FILE *fp)
+{
+	int camera;
+	int i;
+
+	fprintf(fp, "# genicam settings%s%s\n", (cfg->path[0] != '\0') ? " - read from " : "", cfg->path);
+	for (i = 0; i < CONFIG_NUM_OPTIONS; i++)
+	{
+		_WriteValue( &s_options[i], (s_options[i].scope == CONFIG_GLOBAL) ? (const char *)cfg : (const char *)&cfg->camera, fp);
+	}
+	for (camera = 0; camera < APP_CONFIG_MAX_CAMERAS; camera++)
+	{
+		if (cfg->overrides[camera] == 0)
+		{
+			continue;
+		}
+		fprintf(fp, "[cam%d]\n", camera);
+		for (i = 0; i < CONFIG_NUM_OPTIONS; i++)
+		{
+			if (cfg->overrides[camera] & (1u << i))
+			{
+				_WriteValue( &s_options[i], (const char *)&cfg->cameras[camera], fp);
+			}
+		}
+	}
+}
+
+void AppConfig_Usage( const char *program, FILE *fp)
+{
+	int i;
+
+	fprintf(fp, "Usage : %s [options] [<camera index> ... | all]\n\n", program);
+	fprintf(fp, "  -c, --config <file>       Read the settings from a file (also GENICAM_CONFIG)\n");
+	fprintf(fp, "  -o, --option [cam<N>.]<setting>=<value>\n");
+	fprintf(fp, "                            Set a setting (for camera N only with cam<N>.)\n");
+	fprintf(fp, "  -p, --print-config        Write the settings (config file format) to stderr\n");
+	fprintf(fp, "  -h, --help                This text\n\n");
+	for (i = 0; i < CONFIG_NUM_OPTIONS; i++)
+	{
+		char arg[48];
+		const CONFIG_OPTION *option = &s_options[i];
+
+		if (option->type == CONFIG_SWITCH)
+		{
+			snprintf(arg, sizeof(arg), "--%s[=0|1]", option->name);
+		}
+		else
+		{
+			snprintf(arg, sizeof(arg), "--%s <%s>", option->name, (option->type == CONFIG_STRING) ? "name" : "n");
+		}
+		fprintf(fp, "  %-26s%s", arg, option->help);
+		if (option->type == CONFIG_NUMBER)
+		{
+			fprintf(fp, " [%u..%u]", option->min, option->max);
+		}
+		if (option->env != NULL)
+		{
+			fprintf(fp, " (also %s)", option->env);
+		}
+		fprintf(fp, "\n");
+	}
+}
@@ -0,0 +1,98 @@
+#ifndef __APP_CONFIG_H__
+#define __APP_CONFIG_H__
+
+#include <stdint.h>
+#include <stdio.h>
+
+//=============================================================================
+// Run time settings (command line, configuration file, environment).
+//
+// Every setting has a name that is used the same way everywhere :
+//
+//	command line     --packet-size 8192  (or --packet-size=8192)
+//	                 -o cam1.packet-size=8192
+//	config file      packet-size = 8192
+//	                 [cam1]
+//	                 packet-size = 8192
+//
+// Camera settings apply to every camera unless given for one camera
+// ("cam<N>." prefix, or a [cam<N>] section in the file). N is the camera's
+// channel (its position on the command line). Sizes take a K / M / G suffix,
+// switches take 0 / 1 / on / off / yes / no / true / false.
+//
+// Precedence (highest first) : command line, environment variable (the
+// settings that have one), configuration file, built-in default.
+//
+
+#define APP_CONFIG_MAX_CAMERAS	8
+#define APP_CONFIG_MAX_BUFFERS	64		// Most image buffers per camera.
+#define APP_CONFIG_MAX_STRING		128
+
+#define CONFIG_ERROR_NULL_PTR		-1800 // A pointer passed in is NULL.
+#define CONFIG_ERROR_UNKNOWN		-1801 // Unknown setting or camera.
+#define CONFIG_ERROR_VALUE			-1802 // Missing value, not a number or out of range.
+#define CONFIG_ERROR_FILE			-1803 // The configuration file could not be read.
+#define CONFIG_ERROR_HELP			-1804 // The usage was asked for (and printed).
+
+// Settings of one camera.
+typedef struct APP_CAMERA_CONFIG_t
+{
+	uint32_t	numBuffers;				// buffers
+	uint32_t	syncCycling;			// sync-cycling
+	uint32_t	turboDrive;				// turbo-drive
+	uint32_t	tuneStreaming;			// tune-streaming
+	uint32_t	packetSize;				// packet-size
+	uint32_t	packetDelay;			// packet-delay
+	uint32_t	framesBuffered;		// frames-buffered
+	uint32_t	memoryLimit;			// memory-limit
+	uint32_t	frameTimeoutMs;		// frame-timeout
+	uint32_t	heartbeatTimeoutMs;	// heartbeat-timeout
+	uint32_t	hugePages;				// huge-pages
+	uint32_t	lockBuffers;			// lock-buffers
+	uint32_t	prefaultThreads;		// prefault-threads
+	uint32_t	numaBind;				// numa-bind
+} APP_CAMERA_CONFIG;
+
+typedef struct APP_CONFIG_t
+{
+	uint32_t	print;								// print
+	uint32_t	display;								// display
+	char		backend[APP_CONFIG_MAX_STRING];		// backend
+	char		backpressure[APP_CONFIG_MAX_STRING];	// backpressure
+	char		leasePolicy[APP_CONFIG_MAX_STRING];	// lease-policy
+	uint32_t	calibrate;							// calibrate
+	char		record[APP_CONFIG_MAX_STRING];		// record
+	uint32_t	reconnectMs;						// reconnect-interval
+	uint32_t	clockSyncMs;						// clock-sync
+	char		acquisitionThreads[APP_CONFIG_MAX_STRING];	// acquisition-threads
+	char		converterThreads[APP_CONFIG_MAX_STRING];	// converter-threads
+	char		outputThreads[APP_CONFIG_MAX_STRING];		// output-threads
+	char		displayThreads[APP_CONFIG_MAX_STRING];		// display-threads
+	uint32_t	stageDepth;							// stage-depth
+	char		stageOverflow[APP_CONFIG_MAX_STRING];	// stage-overflow
+	uint32_t	convertThreads;					// convert-threads
+	uint32_t	convertBands;					// convert-bands
+	char		simd[APP_CONFIG_MAX_STRING];			// simd
+	char		path[APP_CONFIG_MAX_STRING];			// Configuration file read ("" = none).
+	APP_CAMERA_CONFIG	camera;						// Settings of every camera ...
+	APP_CAMERA_CONFIG	cameras[APP_CONFIG_MAX_CAMERAS];	// ... and of each one
+	uint32_t	overrides[APP_CONFIG_MAX_CAMERAS];	// (bit per camera setting given for that camera).
+} APP_CONFIG;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int AppConfig_Parse( APP_CONFIG *cfg, int argc, char *argv[], int *firstArg);
+int AppConfig_Load( APP_CONFIG *cfg, const char *path);
+int AppConfig_Set( APP_CONFIG *cfg, const char *name, const char *value);
+void AppConfig_GetCamera( const APP_CONFIG *cfg, int channel, APP_CAMERA_CONFIG *camera);
+void AppConfig_SetCamera( APP_CONFIG *cfg, int channel, const APP_CAMERA_CONFIG *camera);
+void AppConfig_Write( const APP_CONFIG *cfg, FILE *fp);
+void AppConfig_Usage( const char *program, FILE *fp);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
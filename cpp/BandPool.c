@@ -0,0 +1,258 @@
+/*
+  ---------------------------------------------
+  Band conversion thread pool
+  -----------------------------------------------
+*/
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "BandPool.h"
+
+// An image being converted (on the stack of its caller, posted to the pool until all its bands are done).
+typedef struct
+{
+	BAND_POOL_FUNC	func;
+	void			*arg;
+	uint32_t		rows;
+	uint32_t		bandRows;
+	uint32_t		numBands;
+	uint32_t		nextBand;			// Next band to take ...
+	uint32_t		bandsDone;			// ... and the ones converted (under the pool lock).
+} BAND_JOB;
+
+static struct
+{
+	pthread_mutex_t	lock;
+	pthread_cond_t		work;				// The pool threads wait for bands ...
+	pthread_cond_t		done;				// ... and the callers for the last of theirs.
+	int					numThreads;
+	int					stop;
+	pthread_t			threads[BAND_POOL_MAX_THREADS];
+	BAND_JOB				*jobs[BAND_POOL_MAX_JOBS];
+	BAND_POOL_STATS	stats;
+} s_pool = { PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, PTHREAD_COND_INITIALIZER };
+
+static inline uint64_t _ns_now( void )
+{
+	struct timespec ts;
+	clock_gettime( CLOCK_MONOTONIC, &ts);
+	return ((uint64_t)ts.tv_sec * 1000000000ULL) + (uint64_t)ts.tv_nsec;
+}
+
+// Statistics counters : updated under the lock, read with relaxed loads from any thread.
+static inline void _Count( uint64_t *counter, uint64_t n)
+{
+	__atomic_store_n(counter, *counter + n, __ATOMIC_RELAXED);
+}
+
+// A band still to be converted (lock held) - NULL if none.
+static BAND_JOB *_NextBand( uint32_t *band)
+{
+	int i;
+
+	for (i = 0; i < BAND_POOL_MAX_JOBS; i++)
+	{
+		BAND_JOB *job = s_pool.jobs[i];
+
+		if ((job != NULL) && (job->nextBand < job->numBands))
+		{
+			*band = job->nextBand++;
+			return job;
+		}
+	}
+	return NULL;
+}
+
+// Convert a band (lock held - released meanwhile).
+static void _RunBand( BAND_JOB *job, uint32_t band)
+{
+	uint32_t firstRow = band * job->bandRows;
+	uint32_t numRows = ((job->rows - firstRow) < job->bandRows) ? (job->rows - firstRow) : job->bandRows;
+
+	pthread_mutex_unlock(&s_pool.lock);
+	job->func( job->arg, firstRow, numRows);
+	pthread_mutex_lock(&s_pool.lock);
+	if (++job->bandsDone == job->numBands)
+	{
+		pthread_cond_broadcast(&s_pool.done);
+	}
+}
+
+static void * _PoolThread( void *context)
+{
+	BAND_JOB *job = NULL;
+	uint32_t band = 0;
+
+	pthread_mutex_lock(&s_pool.lock);
+	while (!s_pool.stop)
+	{
+		job = _NextBand( &band);
+		if (job == NULL)
+		{
+			pthread_cond_wait(&s_pool.work, &s_pool.lock);
+			continue;
+		}
+		_Count( &s_pool.stats.poolBands, 1);
+		_RunBand( job, band);
+	}
+	pthread_mutex_unlock(&s_pool.lock);
+	return NULL;
+}
+
+// !
+// BandPool_Init
+//
+/*!
+	Start the pool : an image is cut into up to "numBands" bands, converted by
+	its caller and numBands - 1 pool threads (1 = no pool, images are
+	converted in one go).
+
+	\return Error status
+		0   = Success
+*/
+int BandPool_Init( int numBands)
+{
+	int i;
+
+	if ((numBands < 1) || (numBands > BAND_POOL_MAX_THREADS) || (s_pool.numThreads > 0))
+	{
+		return BANDPOOL_ERROR_PARAMETER;
+	}
+	s_pool.stop = 0;
+	for (i = 0; i < (numBands - 1); i++)
+	{
+		if (pthread_create( &s_pool.threads[i], NULL, _PoolThread, NULL) != 0)
+		{
+			BandPool_Close();
+			return BANDPOOL_ERROR_THREAD;
+		}
+		s_pool.numThreads++;
+	}
+	return 0;
+}
+
+// Stop the pool threads (no image is being converted any more).
+void BandPool_Close( void )
+{
+	int i;
+
+	pthread_mutex_lock(&s_pool.lock);
+	s_pool.stop = 1;
+	pthread_cond_broadcast(&s_pool.work);
+	pthread_mutex_unlock(&s_pool.lock);
+	for (i = 0; i < s_pool.numThreads; i++)
+	{
+		pthread_join( s_pool.threads[i], NULL);
+	}
+	s_pool.numThreads = 0;
+}
+
+// The pool threads (to place them) - returns how many there are.
+int BandPool_Threads( pthread_t *threads, int max)
+{
+	int i;
+
+	for (i = 0; (i < s_pool.numThreads) && (i < max); i++)
+	{
+		threads[i] = s_pool.threads[i];
+	}
+	return s_pool.numThreads;
+}
+
+// !
+// BandPool_Run
+//
+/*!
+	Convert an image of "rows" rows of "width" pixels : calls "func" for every
+	band, on this thread and the pool threads, and returns once they are all
+	done. An image too small to be worth cutting up, or posted while the pool
+	already has BAND_POOL_MAX_JOBS images, is converted here in one go.
+*/
+void BandPool_Run( uint32_t rows, uint32_t width, BAND_POOL_FUNC func, void *arg)
+{
+	BAND_JOB job;
+	uint32_t minRows = (width > 0) ? ((BAND_POOL_MIN_PIXELS + width - 1) / width) : rows;
+	uint32_t maxBands = (minRows > 0) ? (rows / minRows) : rows;
+	uint32_t band = 0;
+	int slot = -1;
+	int i;
+
+	memset(&job, 0, sizeof(job));
+	job.numBands = ((uint32_t)s_pool.numThreads + 1 < maxBands) ? (uint32_t)s_pool.numThreads + 1 : maxBands;
+	if (job.numBands > 1)
+	{
+		job.bandRows = (rows + job.numBands - 1) / job.numBands;
+		job.bandRows = (job.bandRows + BAND_POOL_ROW_ALIGN - 1) & ~(uint32_t)(BAND_POOL_ROW_ALIGN - 1);
+		job.numBands = (rows + job.bandRows - 1) / job.bandRows;
+	}
+	if (job.numBands <= 1)
+	{
+		func( arg, 0, rows);
+		return;
+	}
+	job.func = func;
+	job.arg = arg;
+	job.rows = rows;
+
+	pthread_mutex_lock(&s_pool.lock);
+	for (i = 0; (i < BAND_POOL_MAX_JOBS) && (slot < 0); i++)
+	{
+		slot = (s_pool.jobs[i] == NULL) ? i : -1;
+	}
+	if (slot < 0)
+	{
+		pthread_mutex_unlock(&s_pool.lock);
+		func( arg, 0, rows);
+		return;
+	}
+	s_pool.jobs[slot] = &job;
+	_Count( &s_pool.stats.frames, 1);
+	_Count( &s_pool.stats.bands, job.numBands);
+	pthread_cond_broadcast(&s_pool.work);
+
+	// Take bands of this image (the others' are the pool threads' business) ...
+	while (job.nextBand < job.numBands)
+	{
+		band = job.nextBand++;
+		_RunBand( &job, band);
+	}
+	// ... then wait for the ones taken by the pool threads.
+	if (job.bandsDone < job.numBands)
+	{
+		uint64_t startNs = _ns_now();
+
+		while (job.bandsDone < job.numBands)
+		{
+			pthread_cond_wait(&s_pool.done, &s_pool.lock);
+		}
+		_Count( &s_pool.stats.nsWait, _ns_now() - startNs);
+	}
+	s_pool.jobs[slot] = NULL;
+	pthread_mutex_unlock(&s_pool.lock);
+}
+
+void BandPool_GetStats( BAND_POOL_STATS *stats)
+{
+	if (stats != NULL)
+	{
+		stats->frames = __atomic_load_n(&s_pool.stats.frames, __ATOMIC_RELAXED);
+		stats->bands = __atomic_load_n(&s_pool.stats.bands, __ATOMIC_RELAXED);
+		stats->poolBands = __atomic_load_n(&s_pool.stats.poolBands, __ATOMIC_RELAXED);
+		stats->nsWait = __atomic_load_n(&s_pool.stats.nsWait, __ATOMIC_RELAXED);
+	}
+}
+
+// Print what the pool did (on stderr).
+void BandPool_PrintStats( const char *label)
+{
+	BAND_POOL_STATS stats;
+
+	BandPool_GetStats( &stats);
+	fprintf(stderr, "%s (%d threads): %llu frames in %llu bands, %llu by the pool threads, callers waited %.1f ms for them\n",
+			(label != NULL) ? label : "band pool", s_pool.numThreads,
+			(unsigned long long)stats.frames, (unsigned long long)stats.bands, (unsigned long long)stats.poolBands,
+			(double)stats.nsWait / 1e6);
+}
@@ -0,0 +1,60 @@
+#ifndef __BAND_POOL_H__
+#define __BAND_POOL_H__
+
+#include <stdint.h>
+#include <pthread.h>
+
+//=============================================================================
+// Conversion of one image by horizontal bands on a pool of threads.
+//
+// Converting frames on several threads at once (the conversion threads of
+// the pipeline) raises the frame rate a camera can keep up with, not the
+// time a frame takes. For that, one image is cut into bands of rows that
+// are converted at the same time : the thread converting the frame takes a
+// band itself and the pool threads take the others (BandPool_Run returns
+// once they are all done).
+//
+// The pool is shared by the process (the conversion threads of every camera
+// post their frames to it) and its threads stay up from BandPool_Init to
+// BandPool_Close. Bands are a multiple of BAND_POOL_ROW_ALIGN rows (a band
+// starts on the same Bayer phase and on a whole group of packed pixels) and
+// of at least BAND_POOL_MIN_PIXELS pixels - a smaller image, or no pool, is
+// converted in one go by the caller. A band may read the rows around it (eg.
+// the Bayer neighbourhood) but only writes its own.
+//
+
+#define BAND_POOL_MAX_THREADS		64		// Bands of a frame (the caller and the pool threads).
+#define BAND_POOL_MAX_JOBS			32		// Frames being converted at once (the others are converted by their caller alone).
+#define BAND_POOL_ROW_ALIGN		4
+#define BAND_POOL_MIN_PIXELS		(128*1024)
+
+#define BANDPOOL_ERROR_PARAMETER		-2800 // Invalid number of threads.
+#define BANDPOOL_ERROR_THREAD		-2801 // A pool thread could not be started.
+
+// Converts rows [firstRow, firstRow + numRows) of the image described by "arg".
+typedef void (*BAND_POOL_FUNC)( void *arg, uint32_t firstRow, uint32_t numRows);
+
+typedef struct BAND_POOL_STATS_t
+{
+	uint64_t	frames;					// Images cut into bands ...
+	uint64_t	bands;					// ... the bands ...
+	uint64_t	poolBands;				// ... and the ones converted by the pool threads.
+	uint64_t	nsWait;					// Time the callers waited for the pool threads to finish their bands.
+} BAND_POOL_STATS;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int BandPool_Init( int numBands);
+void BandPool_Close( void );
+int BandPool_Threads( pthread_t *threads, int max);
+void BandPool_Run( uint32_t rows, uint32_t width, BAND_POOL_FUNC func, void *arg);
+void BandPool_GetStats( BAND_POOL_STATS *stats);
+void BandPool_PrintStats( const char *label);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,408 @@
+/*
+  ---------------------------------------------
+  Acquisition / conversion buffer allocator
+  -----------------------------------------------
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <ifaddrs.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/mempolicy.h>
+#include "BufferAlloc.h"
+
+#ifndef MAP_HUGE_2MB
+#define MAP_HUGE_2MB		(21 << 26)		// (log2(2 MB) << MAP_HUGE_SHIFT)
+#endif
+
+#define BUFFER_ALLOC_MAX_THREADS		64
+
+// Every buffer handed out (to unmap it, and for BufferAlloc_GetInfo).
+typedef struct BUFFER_ALLOC_ENTRY_t
+{
+	struct BUFFER_ALLOC_ENTRY_t	*next;
+	void					*address;
+	BUFFER_ALLOC_INFO	info;
+} BUFFER_ALLOC_ENTRY;
+
+static BUFFER_ALLOC_ENTRY *s_buffers = NULL;
+static pthread_mutex_t s_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// Pages of the buffers to fault in by one thread (from page "first" to "last" - 1, counted over all the buffers).
+typedef struct PREFAULT_JOB_t
+{
+	void		**addresses;
+	size_t	size;
+	size_t	pageSize;
+	size_t	pagesPerBuffer;
+	size_t	first;
+	size_t	last;
+} PREFAULT_JOB;
+
+static size_t _RoundUp( size_t size, size_t align)
+{
+	return (size + align - 1) & ~(align - 1);
+}
+
+static BUFFER_ALLOC_ENTRY *_Find( void *address)
+{
+	BUFFER_ALLOC_ENTRY *entry = s_buffers;
+
+	while ((entry != NULL) && (entry->address != address))
+	{
+		entry = entry->next;
+	}
+	return entry;
+}
+
+// Anonymous mapping aligned to "align" (the excess around it is unmapped).
+static void *_MapAligned( size_t size, size_t align)
+{
+	size_t extra = align - (size_t)sysconf(_SC_PAGESIZE);
+	char *base = (char *)mmap(NULL, size + extra, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	char *aligned = NULL;
+
+	if (base == (char *)MAP_FAILED)
+	{
+		return NULL;
+	}
+	aligned = (char *)_RoundUp( (size_t)base, align);
+	if (aligned > base)
+	{
+		munmap(base, aligned - base);
+	}
+	if ((base + size + extra) > (aligned + size))
+	{
+		munmap(aligned + size, (base + size + extra) - (aligned + size));
+	}
+	return aligned;
+}
+
+static void *_PrefaultThread( void *arg)
+{
+	PREFAULT_JOB *job = (PREFAULT_JOB *)arg;
+	size_t page = job->first;
+
+	while (page < job->last)
+	{
+		// Pages left in this buffer (within the job).
+		size_t index = page / job->pagesPerBuffer;
+		size_t offset = (page % job->pagesPerBuffer) * job->pageSize;
+		size_t count = job->pagesPerBuffer - (page % job->pagesPerBuffer);
+		char *start = (char *)job->addresses[index] + offset;
+		size_t length = 0;
+
+		count = (count > (job->last - page)) ? (job->last - page) : count;
+		length = count * job->pageSize;
+		length = ((offset + length) > job->size) ? (job->size - offset) : length;
+#ifdef MADV_POPULATE_WRITE
+		// Fault the pages in writable without touching their contents.
+		if (madvise(start, _RoundUp( length, job->pageSize), MADV_POPULATE_WRITE) != 0)
+#endif
+		{
+			// (Older kernel) : write each page back with its own contents.
+			size_t i;
+			for (i = 0; i < length; i += job->pageSize)
+			{
+				volatile char *p = start + i;
+				*p = *p;
+			}
+		}
+		page += count;
+	}
+	return NULL;
+}
+
+// !
+// BufferAlloc_Get
+//
+/*!
+	Map a buffer (page aligned, zero filled) according to the policy.
+
+	The pages are not faulted in or locked yet - see BufferAlloc_Commit.
+
+	\param size    Bytes needed.
+	\param policy  Huge pages / NUMA node (NULL = plain pages, any node).
+
+	\return The buffer (free it with BufferAlloc_Free), NULL if out of memory.
+*/
+void *BufferAlloc_Get( size_t size, const BUFFER_ALLOC_POLICY *policy)
+{
+	BUFFER_ALLOC_ENTRY *entry = NULL;
+	size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+	void *address = MAP_FAILED;
+
+	if (size == 0)
+	{
+		return NULL;
+	}
+	entry = (BUFFER_ALLOC_ENTRY *)calloc(1, sizeof(BUFFER_ALLOC_ENTRY));
+	if (entry == NULL)
+	{
+		return NULL;
+	}
+	entry->info.numaNode = -1;
+	entry->info.pageSize = pageSize;
+	entry->info.mapped = _RoundUp( size, pageSize);
+
+	if ((policy != NULL) && policy->hugePages)
+	{
+		// Reserved huge pages first (vm.nr_hugepages), then transparent huge pages (for buffers of 2 MB or more).
+		address = mmap(NULL, _RoundUp( size, BUFFER_ALLOC_HUGE_PAGE), PROT_READ | PROT_WRITE,
+							MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | MAP_HUGE_2MB, -1, 0);
+		if (address != MAP_FAILED)
+		{
+			entry->info.pageSize = BUFFER_ALLOC_HUGE_PAGE;
+			entry->info.mapped = _RoundUp( size, BUFFER_ALLOC_HUGE_PAGE);
+		}
+		else if (size >= BUFFER_ALLOC_HUGE_PAGE)
+		{
+			entry->info.mapped = _RoundUp( size, BUFFER_ALLOC_HUGE_PAGE);
+			address = _MapAligned( entry->info.mapped, BUFFER_ALLOC_HUGE_PAGE);
+			if (address == NULL)
+			{
+				address = MAP_FAILED;
+			}
+			else
+			{
+				entry->info.transparentHuge = (madvise(address, entry->info.mapped, MADV_HUGEPAGE) == 0);
+			}
+		}
+	}
+	if (address == MAP_FAILED)
+	{
+		entry->info.mapped = _RoundUp( size, pageSize);
+		address = mmap(NULL, entry->info.mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	}
+	if (address == MAP_FAILED)
+	{
+		free(entry);
+		return NULL;
+	}
+
+	if ((policy != NULL) && (policy->numaNode >= 0) && (policy->numaNode < (int)(8 * sizeof(unsigned long))))
+	{
+		// Preferred (not strict) : memory from another node beats no memory. Must happen before the pages are faulted in.
+		unsigned long nodeMask = 1UL << policy->numaNode;
+		if (syscall(SYS_mbind, address, entry->info.mapped, MPOL_PREFERRED, &nodeMask, 8 * sizeof(nodeMask), 0) == 0)
+		{
+			entry->info.numaNode = policy->numaNode;
+		}
+	}
+
+	entry->address = address;
+	pthread_mutex_lock(&s_lock);
+	entry->next = s_buffers;
+	s_buffers = entry;
+	pthread_mutex_unlock(&s_lock);
+	return address;
+}
+
+// !
+// BufferAlloc_Commit
+//
+/*!
+	Fault in (several threads at once) and lock the pages of a set of buffers,
+	so the transfer never waits for a page. The contents are kept. Buffers that
+	are not from BufferAlloc_Get are fine too, as long as nothing writes them
+	meanwhile.
+
+	\param addresses  Buffers (up to the first NULL one).
+	\param count      Number of buffers.
+	\param size       Size of each buffer.
+	\param policy     Threads to use, locking.
+
+	\return Error status
+		0   = Success
+		BUFFERALLOC_ERROR_LOCK  Some of the memory could not be locked (it is still usable).
+*/
+int BufferAlloc_Commit( void **addresses, int count, size_t size, const BUFFER_ALLOC_POLICY *policy)
+{
+	PREFAULT_JOB jobs[BUFFER_ALLOC_MAX_THREADS];
+	pthread_t tids[BUFFER_ALLOC_MAX_THREADS];
+	size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+	size_t pagesPerBuffer = 0;
+	size_t totalPages = 0;
+	int numThreads = 0;
+	int status = 0;
+	int i;
+
+	if ((addresses == NULL) || (policy == NULL))
+	{
+		return BUFFERALLOC_ERROR_NULL_PTR;
+	}
+	for (i = 0; i < count; i++)
+	{
+		if (addresses[i] == NULL)
+		{
+			// (Keep the work split simple - a missing buffer just has nothing to fault in).
+			count = i;
+			break;
+		}
+	}
+	if ((count == 0) || (size == 0))
+	{
+		return 0;
+	}
+
+	if (policy->prefaultThreads > 0)
+	{
+		// Split the pages of all the buffers evenly over the threads.
+		pagesPerBuffer = _RoundUp( size, pageSize) / pageSize;
+		totalPages = pagesPerBuffer * count;
+		numThreads = (policy->prefaultThreads > BUFFER_ALLOC_MAX_THREADS) ? BUFFER_ALLOC_MAX_THREADS : policy->prefaultThreads;
+		numThreads = ((size_t)numThreads > totalPages) ? (int)totalPages : numThreads;
+		for (i = 0; i < numThreads; i++)
+		{
+			jobs[i].addresses = addresses;
+			jobs[i].size = size;
+			jobs[i].pageSize = pageSize;
+			jobs[i].pagesPerBuffer = pagesPerBuffer;
+			jobs[i].first = (totalPages * i) / numThreads;
+			jobs[i].last = (totalPages * (i + 1)) / numThreads;
+			if ((i == 0) || (pthread_create(&tids[i], NULL, _PrefaultThread, &jobs[i]) != 0))
+			{
+				tids[i] = 0;
+			}
+		}
+		// The calling thread does the first share (and any a thread could not be started for).
+		for (i = 0; i < numThreads; i++)
+		{
+			if (tids[i] == 0)
+			{
+				_PrefaultThread( &jobs[i]);
+			}
+		}
+		for (i = 1; i < numThreads; i++)
+		{
+			if (tids[i] != 0)
+			{
+				pthread_join(tids[i], NULL);
+			}
+		}
+	}
+
+	if (policy->lock)
+	{
+		pthread_mutex_lock(&s_lock);
+		for (i = 0; i < count; i++)
+		{
+			BUFFER_ALLOC_ENTRY *entry = _Find( addresses[i]);
+			size_t length = (entry != NULL) ? entry->info.mapped : size;
+
+			if (mlock(addresses[i], length) == 0)
+			{
+				if (entry != NULL)
+				{
+					entry->info.locked = 1;
+				}
+			}
+			else
+			{
+				status = BUFFERALLOC_ERROR_LOCK;
+			}
+		}
+		pthread_mutex_unlock(&s_lock);
+	}
+	return status;
+}
+
+// Unmap a buffer from BufferAlloc_Get (NULL is fine).
+void BufferAlloc_Free( void *address)
+{
+	BUFFER_ALLOC_ENTRY **link = &s_buffers;
+	BUFFER_ALLOC_ENTRY *entry = NULL;
+
+	if (address == NULL)
+	{
+		return;
+	}
+	pthread_mutex_lock(&s_lock);
+	while ((*link != NULL) && ((*link)->address != address))
+	{
+		link = &(*link)->next;
+	}
+	entry = *link;
+	if (entry != NULL)
+	{
+		*link = entry->next;
+	}
+	pthread_mutex_unlock(&s_lock);
+
+	if (entry != NULL)
+	{
+		// (Unmapping unlocks the pages as well).
+		munmap(entry->address, entry->info.mapped);
+		free(entry);
+	}
+}
+
+// How a buffer from BufferAlloc_Get was mapped (0 = found, BUFFERALLOC_ERROR_NULL_PTR = unknown buffer).
+int BufferAlloc_GetInfo( void *address, BUFFER_ALLOC_INFO *info)
+{
+	BUFFER_ALLOC_ENTRY *entry = NULL;
+
+	if (info == NULL)
+	{
+		return BUFFERALLOC_ERROR_NULL_PTR;
+	}
+	pthread_mutex_lock(&s_lock);
+	entry = _Find( address);
+	if (entry != NULL)
+	{
+		*info = entry->info;
+	}
+	pthread_mutex_unlock(&s_lock);
+	return (entry != NULL) ? 0 : BUFFERALLOC_ERROR_NULL_PTR;
+}
+
+// !
+// BufferAlloc_NicNode
+//
+/*!
+	NUMA node of the network interface that has a given (IPv4) address.
+
+	\param hostIpAddr  Address of the interface, host byte order (eg. the "host"
+	                   interface of a GEV device).
+
+	\return The node, -1 if not known (no such interface, or no NUMA).
+*/
+int BufferAlloc_NicNode( uint32_t hostIpAddr)
+{
+	struct ifaddrs *list = NULL;
+	struct ifaddrs *ifa = NULL;
+	int node = -1;
+
+	if ((hostIpAddr == 0) || (getifaddrs(&list) != 0))
+	{
+		return -1;
+	}
+	for (ifa = list; ifa != NULL; ifa = ifa->ifa_next)
+	{
+		if ((ifa->ifa_addr != NULL) && (ifa->ifa_addr->sa_family == AF_INET) &&
+			 (ntohl(((struct sockaddr_in *)ifa->ifa_addr)->sin_addr.s_addr) == hostIpAddr))
+		{
+			char path[128];
+			FILE *fp = NULL;
+
+			snprintf(path, sizeof(path), "/sys/class/net/%s/device/numa_node", ifa->ifa_name);
+			fp = fopen(path, "r");
+			if (fp != NULL)
+			{
+				if (fscanf(fp, "%d", &node) != 1)
+				{
+					node = -1;
+				}
+				fclose(fp);
+			}
+			break;
+		}
+	}
+	freeifaddrs(list);
+	return node;
+}
@@ -0,0 +1,62 @@
+#ifndef __BUFFER_ALLOC_H__
+#define __BUFFER_ALLOC_H__
+
+#include <stdint.h>
+#include <stdlib.h>
+
+//=============================================================================
+// Acquisition / conversion buffer allocator.
+//
+// Buffers are mapped (page aligned, zero filled) rather than malloc'ed so that
+// they can be :
+//
+//	- backed by 2 MB huge pages (fewer TLB misses when a frame is written or
+//	  read) : reserved huge pages (MAP_HUGETLB) when there are some, otherwise
+//	  a 2 MB aligned mapping marked for transparent huge pages, otherwise
+//	  plain 4 KB pages.
+//	- bound to a NUMA node (eg. the one of the NIC the frames come in on).
+//	- prefaulted by several threads at once (BufferAlloc_Commit) instead of
+//	  being faulted in by the first frames, or by a serial memset.
+//	- locked in memory (mlock) so the receive thread never takes a page fault.
+//
+// BufferAlloc_Commit also works on buffers that come from elsewhere (eg.
+// FrameMemfd regions) - only BufferAlloc_Get buffers go to BufferAlloc_Free.
+//
+
+#define BUFFER_ALLOC_HUGE_PAGE		(2 * 1024 * 1024)
+
+#define BUFFERALLOC_ERROR_NULL_PTR	-2000 // A pointer passed in is NULL.
+#define BUFFERALLOC_ERROR_LOCK		-2001 // The buffers are usable but could not all be locked (see RLIMIT_MEMLOCK).
+
+typedef struct BUFFER_ALLOC_POLICY_t
+{
+	int		hugePages;			// Try 2 MB pages.
+	int		lock;					// mlock the buffers (in BufferAlloc_Commit).
+	int		prefaultThreads;	// Threads faulting the pages in (in BufferAlloc_Commit, 0 = on first use).
+	int		numaNode;			// Node to take the memory from (-1 = any).
+} BUFFER_ALLOC_POLICY;
+
+typedef struct BUFFER_ALLOC_INFO_t
+{
+	size_t	mapped;				// Bytes mapped (the size rounded up to the page size).
+	size_t	pageSize;			// BUFFER_ALLOC_HUGE_PAGE for reserved huge pages, else the system page size.
+	int		transparentHuge;	// Aligned and marked for transparent huge pages.
+	int		locked;
+	int		numaNode;			// Node it is bound to (-1 = none).
+} BUFFER_ALLOC_INFO;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void *BufferAlloc_Get( size_t size, const BUFFER_ALLOC_POLICY *policy);
+int BufferAlloc_Commit( void **addresses, int count, size_t size, const BUFFER_ALLOC_POLICY *policy);
+void BufferAlloc_Free( void *address);
+int BufferAlloc_GetInfo( void *address, BUFFER_ALLOC_INFO *info);
+int BufferAlloc_NicNode( uint32_t hostIpAddr);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,278 @@
+/*
+  ---------------------------------------------
+  Stream settings calibration
+  -----------------------------------------------
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <stddef.h>
+#include <ifaddrs.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include "Calibration.h"
+
+#define CALIBRATION_MAX_CANDIDATES	8
+
+// A setting and the values to try, most wanted first (bigger packets, less delay, less memory).
+// The packet sizes start with the MTU itself (when it is known).
+typedef struct CALIBRATION_STEP_t
+{
+	const char	*name;
+	size_t		offset;				// In APP_CAMERA_CONFIG.
+	int			numCandidates;
+	uint32_t		candidates[CALIBRATION_MAX_CANDIDATES];
+} CALIBRATION_STEP;
+
+static const CALIBRATION_STEP s_steps[] =
+{
+	{ "packet-size", offsetof(APP_CAMERA_CONFIG, packetSize), 5, { 9000, 8192, 6000, 4000, 1500 } },
+	{ "packet-delay", offsetof(APP_CAMERA_CONFIG, packetDelay), 6, { 0, 5, 10, 20, 50, 100 } },
+	{ "frames-buffered", offsetof(APP_CAMERA_CONFIG, framesBuffered), 4, { 2, 4, 8, 16 } },
+	{ "buffers", offsetof(APP_CAMERA_CONFIG, numBuffers), 4, { 4, 8, 16, 32 } }
+};
+#define CALIBRATION_NUM_STEPS	((int)(sizeof(s_steps) / sizeof(s_steps[0])))
+
+static uint32_t *_Setting( APP_CAMERA_CONFIG *config, int step)
+{
+	return (uint32_t *)((char *)config + s_steps[step].offset);
+}
+
+// Is "a" measurably better than "b" ?
+static int _Better( const CALIBRATION_RESULT *a, const CALIBRATION_RESULT *b)
+{
+	double lossA = Calibration_LossRatio( a);
+	double lossB = Calibration_LossRatio( b);
+	double fpsA = (a->seconds > 0) ? (a->frames / a->seconds) : 0.0;
+	double fpsB = (b->seconds > 0) ? (b->frames / b->seconds) : 0.0;
+
+	if ((a->status != 0) || (a->frames == 0))
+	{
+		return 0;
+	}
+	if ((b->status != 0) || (b->frames == 0))
+	{
+		return 1;
+	}
+	if ((lossA + CALIBRATION_LOSS_MARGIN) < lossB)
+	{
+		return 1;
+	}
+	if ((lossB + CALIBRATION_LOSS_MARGIN) < lossA)
+	{
+		return 0;
+	}
+	return (fpsA > (fpsB * (1.0 + CALIBRATION_FPS_MARGIN)));
+}
+
+// !
+// Calibration_Init
+//
+/*!
+	Start a calibration.
+
+	\param start  Settings to start from (the other settings are kept as they are).
+	\param mtu    MTU of the NIC - bigger packet sizes are not tried (0 = unknown).
+
+	\return Error status
+		0   = Success
+*/
+int Calibration_Init( CALIBRATION *cal, const APP_CAMERA_CONFIG *start, uint32_t mtu)
+{
+	if ((cal == NULL) || (start == NULL))
+	{
+		return CALIBRATION_ERROR_NULL_PTR;
+	}
+	memset(cal, 0, sizeof(CALIBRATION));
+	// (Loopback and the like have MTUs no camera takes - see packet-size).
+	cal->mtu = (mtu > 16384) ? 16384 : mtu;
+	cal->best = *start;
+	// (The settings are only applied with streaming tuning on).
+	cal->best.tuneStreaming = 1;
+	return 0;
+}
+
+// !
+// Calibration_Next
+//
+/*!
+	Settings for the next trial : the starting point first, then each candidate
+	value of each setting in turn (skipping the ones already measured and the
+	packet sizes the NIC can't take).
+
+	\return 1 if *trial was set, 0 once the calibration is done.
+*/
+int Calibration_Next( CALIBRATION *cal, APP_CAMERA_CONFIG *trial)
+{
+	if ((cal == NULL) || (trial == NULL) || (cal->numTrials >= CALIBRATION_MAX_TRIALS))
+	{
+		return 0;
+	}
+	*trial = cal->best;
+	if (!cal->started)
+	{
+		return 1;
+	}
+	while (cal->step < CALIBRATION_NUM_STEPS)
+	{
+		const CALIBRATION_STEP *step = &s_steps[cal->step];
+		int first = ((cal->step == 0) && (cal->mtu != 0)) ? -1 : 0;
+
+		while ((cal->candidate + first) < step->numCandidates)
+		{
+			int index = cal->candidate++ + first;
+			uint32_t value = (index < 0) ? cal->mtu : step->candidates[index];
+
+			if ((value == *_Setting( &cal->best, cal->step)) ||
+				 ((cal->step == 0) && (cal->mtu != 0) && (value >= cal->mtu) && (index >= 0)))
+			{
+				continue;
+			}
+			*_Setting( trial, cal->step) = value;
+			return 1;
+		}
+		cal->step++;
+		cal->candidate = 0;
+	}
+	return 0;
+}
+
+// Record the outcome of the trial Calibration_Next gave (the best settings move if it did better).
+void Calibration_Report( CALIBRATION *cal, const CALIBRATION_RESULT *result)
+{
+	CALIBRATION_RESULT *trial = NULL;
+
+	if ((cal == NULL) || (result == NULL) || (cal->numTrials >= CALIBRATION_MAX_TRIALS))
+	{
+		return;
+	}
+	trial = &cal->trials[cal->numTrials++];
+	*trial = *result;
+	trial->step = cal->started ? cal->step : -1;
+	if (!cal->started)
+	{
+		cal->started = 1;
+		cal->bestResult = *trial;
+	}
+	else if (_Better( trial, &cal->bestResult))
+	{
+		// (Take the value read back - the camera may have rounded the one asked for).
+		cal->bestResult = *trial;
+		*_Setting( &cal->best, cal->step) = *_Setting( &trial->applied, cal->step);
+	}
+}
+
+// Frames lost (incomplete or never delivered) out of all the frames the camera sent.
+double Calibration_LossRatio( const CALIBRATION_RESULT *result)
+{
+	uint64_t total = result->frames + result->incomplete + result->missed;
+
+	return (total > 0) ? ((double)(result->incomplete + result->missed) / (double)total) : 1.0;
+}
+
+// One line per trial (also used as a comment in the saved file).
+void Calibration_Print( const CALIBRATION_RESULT *result, FILE *fp)
+{
+	const APP_CAMERA_CONFIG *c = &result->applied;
+
+	fprintf(fp, "packet-size %5u  packet-delay %3u  frames-buffered %2u  buffers %2u : ",
+			c->packetSize, c->packetDelay, c->framesBuffered, c->numBuffers);
+	if (result->status != 0)
+	{
+		fprintf(fp, "failed (%d)\n", result->status);
+	}
+	else
+	{
+		fprintf(fp, "%.1f fps, %llu incomplete, %llu missed (%.3f%% lost)\n",
+				(result->seconds > 0) ? (result->frames / result->seconds) : 0.0,
+				(unsigned long long)result->incomplete, (unsigned long long)result->missed, 100.0 * Calibration_LossRatio( result));
+	}
+}
+
+// !
+// Calibration_Write
+//
+/*!
+	Save the best settings as a configuration file (with the trials as comments).
+
+	\param comment  First comment line (eg. which camera and NIC), NULL = none.
+
+	\return Error status
+		0   = Success
+*/
+int Calibration_Write( CALIBRATION *cal, const char *path, const char *comment)
+{
+	FILE *fp = NULL;
+	int i;
+
+	if ((cal == NULL) || (path == NULL))
+	{
+		return CALIBRATION_ERROR_NULL_PTR;
+	}
+	fp = fopen(path, "w");
+	if (fp == NULL)
+	{
+		return CALIBRATION_ERROR_FILE;
+	}
+	fprintf(fp, "# genicam stream calibration%s%s\n#\n", (comment != NULL) ? " - " : "", (comment != NULL) ? comment : "");
+	for (i = 0; i < cal->numTrials; i++)
+	{
+		fprintf(fp, "# %c ", (memcmp(&cal->trials[i], &cal->bestResult, sizeof(CALIBRATION_RESULT)) == 0) ? '*' : ' ');
+		Calibration_Print( &cal->trials[i], fp);
+	}
+	fprintf(fp, "\ntune-streaming = 1\n");
+	for (i = 0; i < CALIBRATION_NUM_STEPS; i++)
+	{
+		fprintf(fp, "%s = %u\n", s_steps[i].name, *_Setting( &cal->best, i));
+	}
+	return (fclose(fp) == 0) ? 0 : CALIBRATION_ERROR_FILE;
+}
+
+// !
+// Calibration_NicInfo
+//
+/*!
+	Name and MTU of the network interface that has a given (IPv4) address.
+
+	\param hostIpAddr  Address of the interface, host byte order.
+
+	\return 0 if found, -1 if not (name is then "unknown", mtu 0).
+*/
+int Calibration_NicInfo( uint32_t hostIpAddr, char *name, size_t size, uint32_t *mtu)
+{
+	struct ifaddrs *list = NULL;
+	struct ifaddrs *ifa = NULL;
+	int status = -1;
+
+	snprintf(name, size, "unknown");
+	*mtu = 0;
+	if ((hostIpAddr == 0) || (getifaddrs(&list) != 0))
+	{
+		return -1;
+	}
+	for (ifa = list; ifa != NULL; ifa = ifa->ifa_next)
+	{
+		if ((ifa->ifa_addr != NULL) && (ifa->ifa_addr->sa_family == AF_INET) &&
+			 (ntohl(((struct sockaddr_in *)ifa->ifa_addr)->sin_addr.s_addr) == hostIpAddr))
+		{
+			char path[128];
+			FILE *fp = NULL;
+
+			snprintf(name, size, "%s", ifa->ifa_name);
+			snprintf(path, sizeof(path), "/sys/class/net/%s/mtu", ifa->ifa_name);
+			fp = fopen(path, "r");
+			if (fp != NULL)
+			{
+				if (fscanf(fp, "%u", mtu) != 1)
+				{
+					*mtu = 0;
+				}
+				fclose(fp);
+			}
+			status = 0;
+			break;
+		}
+	}
+	freeifaddrs(list);
+	return status;
+}
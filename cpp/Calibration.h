@@ -0,0 +1,73 @@
+#ifndef __CALIBRATION_H__
+#define __CALIBRATION_H__
+
+#include <stdint.h>
+#include <stdio.h>
+#include "AppConfig.h"
+
+//=============================================================================
+// Stream settings calibration.
+//
+// Tunes the settings that decide whether frames make it through the network
+// and the receive thread, one after the other :
+//
+//	packet-size  packet-delay  frames-buffered  buffers
+//
+// Each candidate value is tried with the best values found so far for the
+// others : the caller streams with the settings Calibration_Next gives (for a
+// few seconds) and hands back what it saw with Calibration_Report. A setting
+// only moves away from its current value if a candidate does measurably
+// better : fewer lost frames (incomplete - ie. packets the resends could not
+// recover - or never delivered), then a higher sustained frame rate.
+//
+// Calibration_Write saves the result as a configuration file (see AppConfig).
+//
+
+#define CALIBRATION_MAX_TRIALS		64
+#define CALIBRATION_LOSS_MARGIN		0.001		// Loss ratio difference that counts as better.
+#define CALIBRATION_FPS_MARGIN		0.02		// Frame rate gain (relative) that counts as better.
+
+#define CALIBRATION_ERROR_NULL_PTR	-2100 // A pointer passed in is NULL.
+#define CALIBRATION_ERROR_FILE		-2101 // The result could not be written.
+
+// What one trial measured.
+typedef struct CALIBRATION_RESULT_t
+{
+	APP_CAMERA_CONFIG	applied;		// Settings in effect (as read back from the library / camera).
+	int			status;				// 0 = the camera streamed (else it could not be set up).
+	int			step;					// Setting tuned (index into the steps, -1 = the starting point).
+	double		seconds;				// Time measured.
+	uint64_t		frames;				// Complete frames.
+	uint64_t		incomplete;			// Frames with missing data.
+	uint64_t		missed;				// Frames never delivered (gaps in the frame ids).
+} CALIBRATION_RESULT;
+
+typedef struct CALIBRATION_t
+{
+	uint32_t		mtu;					// Largest packet the NIC takes (0 = unknown).
+	int			step;					// Setting being tuned.
+	int			candidate;			// Next candidate value of that setting.
+	int			started;				// The starting point has been measured.
+	APP_CAMERA_CONFIG	best;
+	CALIBRATION_RESULT	bestResult;
+	int			numTrials;
+	CALIBRATION_RESULT	trials[CALIBRATION_MAX_TRIALS];
+} CALIBRATION;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int Calibration_Init( CALIBRATION *cal, const APP_CAMERA_CONFIG *start, uint32_t mtu);
+int Calibration_Next( CALIBRATION *cal, APP_CAMERA_CONFIG *trial);
+void Calibration_Report( CALIBRATION *cal, const CALIBRATION_RESULT *result);
+double Calibration_LossRatio( const CALIBRATION_RESULT *result);
+void Calibration_Print( const CALIBRATION_RESULT *result, FILE *fp);
+int Calibration_Write( CALIBRATION *cal, const char *path, const char *comment);
+int Calibration_NicInfo( uint32_t hostIpAddr, char *name, size_t size, uint32_t *mtu);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
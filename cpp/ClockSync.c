@@ -0,0 +1,260 @@
+/*
+  ---------------------------------------------
+  Camera to host clock mapping
+  -----------------------------------------------
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "ClockSync.h"
+
+// Samples left out in a row before the round trip limit gives way (the link got slower for good).
+#define CLOCK_SYNC_MAX_REJECTS	8
+
+// Open / close an update of the mapping (odd sequence while it is going on).
+static inline void _BeginUpdate( CLOCK_SYNC *sync)
+{
+	__atomic_store_n(&sync->sequence, sync->sequence + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+static inline void _EndUpdate( CLOCK_SYNC *sync)
+{
+	__atomic_store_n(&sync->sequence, sync->sequence + 1, __ATOMIC_RELEASE);
+}
+
+static inline uint64_t _Map( const CLOCK_SYNC_MODEL *model, uint64_t ticks)
+{
+	return model->hostNs + (uint64_t)llround((double)(int64_t)(ticks - model->ticks) * model->nsPerTick);
+}
+
+// Host clock the camera clock is mapped to (ns).
+uint64_t ClockSync_Now( void )
+{
+	struct timespec ts;
+	clock_gettime( CLOCK_MONOTONIC_RAW, &ts);
+	return ((uint64_t)ts.tv_sec * 1000000000ULL) + (uint64_t)ts.tv_nsec;
+}
+
+// !
+// ClockSync_Init
+//
+/*!
+	Set up an (empty) mapping for a camera clock of "tickFrequency" ticks per second.
+
+	\return Error status
+		0   = Success
+*/
+int ClockSync_Init( CLOCK_SYNC *sync, uint64_t tickFrequency)
+{
+	if (sync == NULL)
+	{
+		return CLOCKSYNC_ERROR_NULL_PTR;
+	}
+	memset(sync, 0, sizeof(CLOCK_SYNC));
+	if (tickFrequency == 0)
+	{
+		return CLOCKSYNC_ERROR_PARAMETER;
+	}
+	sync->tickFrequency = tickFrequency;
+	return 0;
+}
+
+// Forget the samples (the camera clock was restarted) - frames have no host time until the next one.
+void ClockSync_Reset( CLOCK_SYNC *sync)
+{
+	_BeginUpdate( sync);
+	sync->model.samples = 0;
+	sync->model.restarts++;
+	_EndUpdate( sync);
+	sync->count = 0;
+	sync->next = 0;
+}
+
+// Fit the line through the samples in the window and publish it.
+static void _Fit( CLOCK_SYNC *sync, uint32_t rejects)
+{
+	const CLOCK_SYNC_SAMPLE *newest = &sync->samples[(sync->next + CLOCK_SYNC_SAMPLES - 1) % CLOCK_SYNC_SAMPLES];
+	const CLOCK_SYNC_SAMPLE *oldest = &sync->samples[(sync->count < CLOCK_SYNC_SAMPLES) ? 0 : sync->next];
+	double nominal = 1e9 / (double)sync->tickFrequency;
+	double mx = 0.0, my = 0.0, sxx = 0.0, sxy = 0.0, sum = 0.0;
+	double rate = nominal;
+	double offset = 0.0;
+	uint64_t rtt = newest->rttNs;
+	uint32_t i;
+
+	// Relative to the newest sample (keeps the doubles small).
+	for (i = 0; i < sync->count; i++)
+	{
+		mx += (double)(int64_t)(sync->samples[i].ticks - newest->ticks);
+		my += (double)(int64_t)(sync->samples[i].hostNs - newest->hostNs);
+		if (sync->samples[i].rttNs < rtt)
+		{
+			rtt = sync->samples[i].rttNs;
+		}
+	}
+	mx /= sync->count;
+	my /= sync->count;
+	for (i = 0; i < sync->count; i++)
+	{
+		double dx = (double)(int64_t)(sync->samples[i].ticks - newest->ticks) - mx;
+		double dy = (double)(int64_t)(sync->samples[i].hostNs - newest->hostNs) - my;
+		sxx += dx * dx;
+		sxy += dx * dy;
+	}
+	if ((sync->count > 1) && ((newest->hostNs - oldest->hostNs) >= CLOCK_SYNC_MIN_SPAN_NS) && (sxx > 0.0))
+	{
+		rate = sxy / sxx;
+	}
+	offset = my - rate * mx;
+	for (i = 0; i < sync->count; i++)
+	{
+		double x = (double)(int64_t)(sync->samples[i].ticks - newest->ticks);
+		double y = (double)(int64_t)(sync->samples[i].hostNs - newest->hostNs);
+		double e = y - (offset + rate * x);
+		sum += e * e;
+	}
+
+	_BeginUpdate( sync);
+	sync->model.ticks = newest->ticks;
+	sync->model.hostNs = newest->hostNs + (uint64_t)llround(offset);
+	sync->model.nsPerTick = rate;
+	sync->model.driftPpm = (nominal / rate - 1.0) * 1e6;
+	sync->model.residualNs = sqrt(sum / sync->count);
+	sync->model.rttNs = rtt;
+	sync->model.samples = sync->count;
+	sync->model.rejected += rejects;
+	_EndUpdate( sync);
+}
+
+// !
+// ClockSync_AddSample
+//
+/*!
+	Add a latch of the camera clock to the mapping (sampler thread only).
+
+	\param hostBefore  Host time (ClockSync_Now) before the latch command was sent.
+	\param hostAfter   Host time after the latched value was read back.
+	\param ticks       The latched value.
+
+	\return Error status
+		0   = Success
+		CLOCKSYNC_ERROR_SAMPLE = Left out (round trip too long - the mapping is unchanged)
+*/
+int ClockSync_AddSample( CLOCK_SYNC *sync, uint64_t hostBefore, uint64_t hostAfter, uint64_t ticks)
+{
+	CLOCK_SYNC_SAMPLE *sample = NULL;
+	uint64_t rtt = (hostAfter > hostBefore) ? (hostAfter - hostBefore) : 0;
+	uint64_t hostNs = hostBefore + rtt / 2;
+
+	if (sync == NULL)
+	{
+		return CLOCKSYNC_ERROR_NULL_PTR;
+	}
+	if (sync->tickFrequency == 0)
+	{
+		return CLOCKSYNC_ERROR_PARAMETER;
+	}
+	if (sync->count > 0)
+	{
+		const CLOCK_SYNC_SAMPLE *last = &sync->samples[(sync->next + CLOCK_SYNC_SAMPLES - 1) % CLOCK_SYNC_SAMPLES];
+		uint64_t mapped = _Map( &sync->model, ticks);
+		uint64_t error = (mapped > hostNs) ? (mapped - hostNs) : (hostNs - mapped);
+
+		if ((ticks <= last->ticks) || (error > (CLOCK_SYNC_JUMP_NS + rtt)))
+		{
+			ClockSync_Reset( sync);
+		}
+		else if ((rtt > CLOCK_SYNC_RTT_FLOOR_NS) && (rtt > (CLOCK_SYNC_RTT_FACTOR * sync->model.rttNs)) &&
+					(sync->rejects < CLOCK_SYNC_MAX_REJECTS))
+		{
+			sync->rejects++;
+			return CLOCKSYNC_ERROR_SAMPLE;
+		}
+	}
+
+	sample = &sync->samples[sync->next];
+	sample->hostNs = hostNs;
+	sample->ticks = ticks;
+	sample->rttNs = rtt;
+	sync->next = (sync->next + 1) % CLOCK_SYNC_SAMPLES;
+	if (sync->count < CLOCK_SYNC_SAMPLES)
+	{
+		sync->count++;
+	}
+	_Fit( sync, sync->rejects);
+	sync->rejects = 0;
+	return 0;
+}
+
+// !
+// ClockSync_Read
+//
+/*!
+	Take a consistent copy of the mapping (from any thread - never holds up the sampler).
+
+	\return Error status
+		0   = Success
+*/
+int ClockSync_Read( const CLOCK_SYNC *sync, CLOCK_SYNC_MODEL *model)
+{
+	uint32_t before = 0;
+	uint32_t after = 0;
+
+	if ((sync == NULL) || (model == NULL))
+	{
+		return CLOCKSYNC_ERROR_NULL_PTR;
+	}
+	do
+	{
+		before = __atomic_load_n(&sync->sequence, __ATOMIC_ACQUIRE);
+		memcpy(model, &sync->model, sizeof(CLOCK_SYNC_MODEL));
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		after = __atomic_load_n(&sync->sequence, __ATOMIC_RELAXED);
+	} while ((before & 1) || (before != after));
+	return 0;
+}
+
+// !
+// ClockSync_ToHost
+//
+/*!
+	Map a camera timestamp to the host clock (CLOCK_MONOTONIC_RAW ns).
+
+	\return Error status
+		0   = Success
+		CLOCKSYNC_ERROR_NOT_SYNCED = No mapping (yet)
+*/
+int ClockSync_ToHost( const CLOCK_SYNC *sync, uint64_t ticks, uint64_t *hostNs)
+{
+	CLOCK_SYNC_MODEL model;
+	int status = ClockSync_Read( sync, &model);
+
+	if ((status != 0) || (hostNs == NULL))
+	{
+		return (status != 0) ? status : CLOCKSYNC_ERROR_NULL_PTR;
+	}
+	if (model.samples == 0)
+	{
+		return CLOCKSYNC_ERROR_NOT_SYNCED;
+	}
+	*hostNs = _Map( &model, ticks);
+	return 0;
+}
+
+// Print a mapping (on stderr) : where the camera clock starts on the host clock, its drift, and how well the line fits.
+void ClockSync_Print( const CLOCK_SYNC_MODEL *model, const char *label)
+{
+	label = (label != NULL) ? label : "clock";
+	if (model->samples == 0)
+	{
+		fprintf(stderr, "%s : not synchronized (%u restarts)\n", label, model->restarts);
+		return;
+	}
+	fprintf(stderr, "%s : camera 0 = host %+.6f s, drift %+.2f ppm, residual %.1f us, round trip %.1f us (%u samples, %u restarts, %llu left out)\n",
+			label, ((double)model->hostNs - (double)model->ticks * model->nsPerTick) / 1e9, model->driftPpm,
+			model->residualNs / 1e3, (double)model->rttNs / 1e3, model->samples, model->restarts,
+			(unsigned long long)model->rejected);
+}
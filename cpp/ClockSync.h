@@ -0,0 +1,87 @@
+#ifndef __CLOCK_SYNC_H__
+#define __CLOCK_SYNC_H__
+
+#include <stdint.h>
+
+//=============================================================================
+// Camera to host clock mapping.
+//
+// The timestamp of a GEV buffer is in camera ticks, from a free running
+// counter that neither starts nor runs with the host clock. Every so often
+// the camera counter is latched (GevTimestampControlLatch) and read back
+// (GevTimestampValue) between two readings of CLOCK_MONOTONIC_RAW : the
+// middle of the two is taken as the host time of the latch, the round trip
+// bounds the error of the sample. A straight line host = offset + rate x ticks
+// is fitted (least squares) over the last CLOCK_SYNC_SAMPLES samples, the
+// rate giving the drift of the camera clock against the host.
+//
+// Samples with a round trip well above the best one in the window (the
+// command was held up on the way) are left out. A sample far off the line
+// means the camera clock was restarted (camera reset / reconnected) : the
+// window starts again from it.
+//
+// The mapping is published under a sequence count (as AcqStats), so the
+// acquisition thread converts the timestamps of its frames (ClockSync_ToHost)
+// while the sampler (main thread) updates it.
+//
+
+#define CLOCK_SYNC_SAMPLES			32				// Samples the line is fitted over.
+#define CLOCK_SYNC_MIN_SPAN_NS		5000000000ULL	// Shorter windows keep the nominal rate (only the offset is fitted).
+#define CLOCK_SYNC_JUMP_NS			10000000ULL		// Off the line by more than this = the camera clock restarted.
+#define CLOCK_SYNC_RTT_FACTOR		4				// Samples with a round trip this many times the best one are left out ...
+#define CLOCK_SYNC_RTT_FLOOR_NS		100000ULL		// ... unless below this.
+
+#define CLOCKSYNC_ERROR_NULL_PTR		-2400 // A pointer passed in is NULL.
+#define CLOCKSYNC_ERROR_PARAMETER		-2401 // No tick frequency (the camera has no timestamp features).
+#define CLOCKSYNC_ERROR_NOT_SYNCED		-2402 // No sample taken yet.
+#define CLOCKSYNC_ERROR_SAMPLE			-2403 // Sample left out (round trip too long).
+
+// The fitted mapping.
+typedef struct CLOCK_SYNC_MODEL_t
+{
+	uint64_t	ticks;					// Reference point : camera ticks ...
+	uint64_t	hostNs;					// ... and the host time they map to (CLOCK_MONOTONIC_RAW).
+	double	nsPerTick;				// Fitted rate.
+	double	driftPpm;				// Camera clock rate against the host (ppm, positive = camera fast).
+	double	residualNs;				// RMS distance of the samples to the line.
+	uint64_t	rttNs;					// Best round trip in the window.
+	uint32_t	samples;					// Samples in the window (0 = no mapping).
+	uint32_t	restarts;				// Camera clock restarts seen.
+	uint64_t	rejected;				// Samples left out.
+} CLOCK_SYNC_MODEL;
+
+typedef struct CLOCK_SYNC_SAMPLE_t
+{
+	uint64_t	hostNs;
+	uint64_t	ticks;
+	uint64_t	rttNs;
+} CLOCK_SYNC_SAMPLE;
+
+typedef struct CLOCK_SYNC_t
+{
+	uint32_t	sequence;				// Odd while the mapping is being updated.
+	CLOCK_SYNC_MODEL	model;
+	uint64_t	tickFrequency;			// Nominal ticks per second (sampler only).
+	uint32_t	count;					// Samples in the window (sampler only) ...
+	uint32_t	next;						// ... and where the next one goes.
+	uint32_t	rejects;					// Samples left out in a row (sampler only).
+	CLOCK_SYNC_SAMPLE	samples[CLOCK_SYNC_SAMPLES];
+} CLOCK_SYNC;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+uint64_t ClockSync_Now( void );
+int ClockSync_Init( CLOCK_SYNC *sync, uint64_t tickFrequency);
+void ClockSync_Reset( CLOCK_SYNC *sync);
+int ClockSync_AddSample( CLOCK_SYNC *sync, uint64_t hostBefore, uint64_t hostAfter, uint64_t ticks);
+int ClockSync_Read( const CLOCK_SYNC *sync, CLOCK_SYNC_MODEL *model);
+int ClockSync_ToHost( const CLOCK_SYNC *sync, uint64_t ticks, uint64_t *hostNs);
+void ClockSync_Print( const CLOCK_SYNC_MODEL *model, const char *label);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
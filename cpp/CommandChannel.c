@@ -0,0 +1,332 @@
+/*
+  ---------------------------------------------
+  Line based command channel
+  -----------------------------------------------
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <ctype.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include "CommandChannel.h"
+
+static const char *s_verbNames[] = { "", "get", "set", "exec", "restart", "ping" };
+
+// Copy the next blank separated token of *line into out (truncated to size) and advance *line.
+static int _NextToken( const char **line, char *out, size_t size)
+{
+	const char *p = *line;
+	size_t n = 0;
+
+	while (isspace((unsigned char)*p))
+	{
+		p++;
+	}
+	while ((*p != '\0') && !isspace((unsigned char)*p))
+	{
+		if (n < (size - 1))
+		{
+			out[n++] = *p;
+		}
+		p++;
+	}
+	out[n] = '\0';
+	*line = p;
+	return (n > 0);
+}
+
+// !
+// CommandChannel_Open
+//
+/*!
+	Set up a command channel.
+
+	\param inFd   Descriptor the commands are read from (eg. STDIN_FILENO).
+	\param ackFd  Descriptor the replies are written to (eg. STDERR_FILENO).
+
+	\return Error status
+		0   = Success
+		COMMAND_ERROR_SHUTDOWN  No eventfd to shut the channel down with (see errno).
+*/
+int CommandChannel_Open( COMMAND_CHANNEL *ch, int inFd, int ackFd)
+{
+	if (ch == NULL)
+	{
+		return COMMAND_ERROR_NULL_PTR;
+	}
+	memset(ch, 0, sizeof(COMMAND_CHANNEL));
+	ch->inFd = inFd;
+	ch->ackFd = ackFd;
+	ch->stopFd = eventfd(0, EFD_CLOEXEC);
+	pthread_mutex_init(&ch->lock, NULL);
+	return (ch->stopFd >= 0) ? 0 : COMMAND_ERROR_SHUTDOWN;
+}
+
+// !
+// CommandChannel_Parse
+//
+/*!
+	Parse one command line.
+
+	\return Error status
+		0   = Success
+		COMMAND_ERROR_SYNTAX  Unknown verb / missing feature or value (cmd->verb is set
+		                      if the verb was recognized so the reply can name it).
+*/
+int CommandChannel_Parse( const char *line, COMMAND *cmd)
+{
+	char verb[16];
+	int i;
+
+	if ((line == NULL) || (cmd == NULL))
+	{
+		return COMMAND_ERROR_NULL_PTR;
+	}
+	memset(cmd, 0, sizeof(COMMAND));
+	cmd->camera = -1;
+	if (!_NextToken( &line, verb, sizeof(verb)))
+	{
+		return COMMAND_ERROR_SYNTAX;
+	}
+	if (verb[0] == '@')
+	{
+		strncpy(cmd->tag, &verb[1], sizeof(cmd->tag) - 1);
+		if (!_NextToken( &line, verb, sizeof(verb)))
+		{
+			return COMMAND_ERROR_SYNTAX;
+		}
+	}
+	if ((strncmp(verb, "cam", 3) == 0) && isdigit((unsigned char)verb[3]))
+	{
+		cmd->camera = atoi(&verb[3]);
+		if (!_NextToken( &line, verb, sizeof(verb)))
+		{
+			return COMMAND_ERROR_SYNTAX;
+		}
+	}
+	for (i = COMMAND_GET; i <= COMMAND_PING; i++)
+	{
+		if (strcmp(verb, s_verbNames[i]) == 0)
+		{
+			cmd->verb = (COMMAND_VERB)i;
+			break;
+		}
+	}
+
+	switch (cmd->verb)
+	{
+		case COMMAND_GET:
+		case COMMAND_EXEC:
+			return _NextToken( &line, cmd->name, sizeof(cmd->name)) ? 0 : COMMAND_ERROR_SYNTAX;
+		case COMMAND_SET:
+			if (!_NextToken( &line, cmd->name, sizeof(cmd->name)))
+			{
+				return COMMAND_ERROR_SYNTAX;
+			}
+			// The value is the rest of the line (string features can contain blanks).
+			while (isspace((unsigned char)*line))
+			{
+				line++;
+			}
+			strncpy(cmd->value, line, sizeof(cmd->value) - 1);
+			for (i = (int)strlen(cmd->value) - 1; (i >= 0) && isspace((unsigned char)cmd->value[i]); i--)
+			{
+				cmd->value[i] = '\0';
+			}
+			return (cmd->value[0] != '\0') ? 0 : COMMAND_ERROR_SYNTAX;
+		case COMMAND_RESTART:
+		case COMMAND_PING:
+			return 0;
+		default:
+			return COMMAND_ERROR_SYNTAX;
+	}
+}
+
+// !
+// CommandChannel_Read
+//
+/*!
+	Wait for the next command.
+
+	\return Error status
+		0   = Success
+		COMMAND_ERROR_EOF     The input was closed.
+		COMMAND_ERROR_SYNTAX  The line could not be parsed (reply with the error and carry on).
+		COMMAND_ERROR_TOO_LONG  The line was too long and was skipped.
+		COMMAND_ERROR_SHUTDOWN  CommandChannel_Shutdown was called.
+*/
+int CommandChannel_Read( COMMAND_CHANNEL *ch, COMMAND *cmd)
+{
+	if ((ch == NULL) || (cmd == NULL))
+	{
+		return COMMAND_ERROR_NULL_PTR;
+	}
+	for (;;)
+	{
+		char *end = (char *)memchr(ch->line, '\n', ch->used);
+		if (end != NULL)
+		{
+			size_t length = (size_t)(end - ch->line) + 1;
+			char text[COMMAND_MAX_LINE];
+			char *p = text;
+
+			*end = '\0';
+			memcpy(text, ch->line, length);
+			memmove(ch->line, ch->line + length, ch->used - length);
+			ch->used -= length;
+			while (isspace((unsigned char)*p))
+			{
+				p++;
+			}
+			if ((*p == '\0') || (*p == '#'))
+			{
+				continue;
+			}
+			return CommandChannel_Parse( p, cmd);
+		}
+		if (ch->used == sizeof(ch->line))
+		{
+			// No newline in a full buffer - throw the line away.
+			ch->used = 0;
+			memset(cmd, 0, sizeof(COMMAND));
+			cmd->camera = -1;
+			return COMMAND_ERROR_TOO_LONG;
+		}
+		{
+			struct pollfd fds[2];
+			ssize_t n = 0;
+
+			// Wait for input, or to be shut down.
+			fds[0].fd = ch->inFd;
+			fds[0].events = POLLIN;
+			fds[0].revents = 0;
+			fds[1].fd = ch->stopFd;
+			fds[1].events = POLLIN;
+			fds[1].revents = 0;
+			if (poll(fds, 2, -1) < 0)
+			{
+				if (errno == EINTR)
+				{
+					continue;
+				}
+				return COMMAND_ERROR_EOF;
+			}
+			if (fds[1].revents != 0)
+			{
+				return COMMAND_ERROR_SHUTDOWN;
+			}
+			n = read(ch->inFd, ch->line + ch->used, sizeof(ch->line) - ch->used);
+			if (n < 0)
+			{
+				if (errno == EINTR)
+				{
+					continue;
+				}
+				return COMMAND_ERROR_EOF;
+			}
+			if (n == 0)
+			{
+				if (ch->used == 0)
+				{
+					return COMMAND_ERROR_EOF;
+				}
+				// Last line without a newline.
+				ch->line[ch->used++] = '\n';
+				continue;
+			}
+			ch->used += n;
+		}
+	}
+}
+
+const char *CommandChannel_VerbName( COMMAND_VERB verb)
+{
+	return ((verb > COMMAND_NONE) && (verb <= COMMAND_PING)) ? s_verbNames[verb] : "?";
+}
+
+// !
+// CommandChannel_Reply
+//
+/*!
+	Acknowledge a command (one line, written with a single write).
+
+	\param status  0 for "ok", otherwise the error status reported with "err".
+	\param text    Value (ok) or message (err) - can be NULL.
+*/
+void CommandChannel_Reply( COMMAND_CHANNEL *ch, const COMMAND *cmd, int status, const char *text)
+{
+	char reply[2 * COMMAND_MAX_LINE];	// (Tag + verb + name + value always fit).
+	int n = 0;
+
+	if ((ch == NULL) || (cmd == NULL))
+	{
+		return;
+	}
+	if (cmd->tag[0] != '\0')
+	{
+		n += snprintf(reply + n, sizeof(reply) - n, "@%s ", cmd->tag);
+	}
+	if (cmd->camera >= 0)
+	{
+		n += snprintf(reply + n, sizeof(reply) - n, "cam%d ", cmd->camera);
+	}
+	n += snprintf(reply + n, sizeof(reply) - n, "%s %s", (status == 0) ? "ok" : "err", CommandChannel_VerbName(cmd->verb));
+	if (cmd->name[0] != '\0')
+	{
+		n += snprintf(reply + n, sizeof(reply) - n, " %s", cmd->name);
+	}
+	if (status != 0)
+	{
+		n += snprintf(reply + n, sizeof(reply) - n, " %d", status);
+	}
+	if ((text != NULL) && (text[0] != '\0'))
+	{
+		n += snprintf(reply + n, sizeof(reply) - n, " %s", text);
+	}
+	if (n > (int)(sizeof(reply) - 2))
+	{
+		n = sizeof(reply) - 2;
+	}
+	reply[n++] = '\n';
+
+	pthread_mutex_lock(&ch->lock);
+	if (write(ch->ackFd, reply, n) < 0)
+	{
+		errno = 0;
+	}
+	pthread_mutex_unlock(&ch->lock);
+}
+
+// !
+// CommandChannel_Shutdown
+//
+/*!
+	Make CommandChannel_Read return COMMAND_ERROR_SHUTDOWN (now if a thread is waiting in it, else
+	on its next call) - the reading thread can then be joined.
+*/
+void CommandChannel_Shutdown( COMMAND_CHANNEL *ch)
+{
+	if ((ch != NULL) && (ch->stopFd >= 0))
+	{
+		if (eventfd_write( ch->stopFd, 1) != 0)
+		{
+			errno = 0;
+		}
+	}
+}
+
+void CommandChannel_Close( COMMAND_CHANNEL *ch)
+{
+	if (ch != NULL)
+	{
+		if (ch->stopFd >= 0)
+		{
+			close(ch->stopFd);
+			ch->stopFd = -1;
+		}
+		pthread_mutex_destroy(&ch->lock);
+	}
+}
@@ -0,0 +1,87 @@
+#ifndef __COMMAND_CHANNEL_H__
+#define __COMMAND_CHANNEL_H__
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+//=============================================================================
+// Line based command channel (eg. on stdin).
+//
+// One command per line, fields separated by blanks :
+//
+//	[@tag] [cam<N>] get <feature>
+//	[@tag] [cam<N>] set <feature> <value>
+//	[@tag] [cam<N>] exec <command feature>
+//	[@tag] [cam<N>] restart
+//	[@tag] ping
+//
+// Every command is answered with exactly one line on the acknowledge
+// descriptor (kept apart from the frame data stream) :
+//
+//	[@tag] [cam<N>] ok <verb> [<feature> [<value>]]
+//	[@tag] [cam<N>] err <verb> [<feature>] <status> <message>
+//
+// The optional "@tag" is echoed back so a client can match replies to
+// commands. "cam<N>" selects a camera when several are open (the first
+// one otherwise) and is echoed back too. Blank lines and lines starting
+// with '#' are ignored.
+//
+
+#define COMMAND_MAX_TAG		32
+#define COMMAND_MAX_NAME		128
+#define COMMAND_MAX_VALUE		256
+#define COMMAND_MAX_LINE		512
+
+#define COMMAND_ERROR_NULL_PTR		-1700 // A pointer passed in is NULL.
+#define COMMAND_ERROR_EOF				-1701 // The command input was closed.
+#define COMMAND_ERROR_SYNTAX			-1702 // Unknown command or missing argument.
+#define COMMAND_ERROR_TOO_LONG		-1703 // Line longer than COMMAND_MAX_LINE (ignored).
+#define COMMAND_ERROR_SHUTDOWN		-1704 // The channel was shut down (CommandChannel_Shutdown).
+
+typedef enum
+{
+	COMMAND_NONE = 0,
+	COMMAND_GET,
+	COMMAND_SET,
+	COMMAND_EXEC,
+	COMMAND_RESTART,
+	COMMAND_PING
+} COMMAND_VERB;
+
+typedef struct COMMAND_t
+{
+	COMMAND_VERB	verb;
+	char		tag[COMMAND_MAX_TAG];			// Without the '@' ("" = none).
+	int		camera;							// N of "cam<N>" (-1 = not given).
+	char		name[COMMAND_MAX_NAME];			// Feature name.
+	char		value[COMMAND_MAX_VALUE];		// Value (rest of the line for "set").
+} COMMAND;
+
+typedef struct COMMAND_CHANNEL_t
+{
+	int		inFd;
+	int		ackFd;
+	int		stopFd;			// eventfd - wakes up CommandChannel_Read to shut down (-1 = not available).
+	size_t	used;
+	char		line[COMMAND_MAX_LINE];
+	pthread_mutex_t	lock;			// Replies can come from more than one thread.
+} COMMAND_CHANNEL;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int CommandChannel_Open( COMMAND_CHANNEL *ch, int inFd, int ackFd);
+int CommandChannel_Read( COMMAND_CHANNEL *ch, COMMAND *cmd);
+int CommandChannel_Parse( const char *line, COMMAND *cmd);
+const char *CommandChannel_VerbName( COMMAND_VERB verb);
+void CommandChannel_Reply( COMMAND_CHANNEL *ch, const COMMAND *cmd, int status, const char *text);
+void CommandChannel_Shutdown( COMMAND_CHANNEL *ch);
+void CommandChannel_Close( COMMAND_CHANNEL *ch);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
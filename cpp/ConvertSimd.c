@@ -0,0 +1,552 @@
+/*
+  ---------------------------------------------
+  Vector pixel conversion kernels
+  -----------------------------------------------
+*/
+
+#define _GNU_SOURCE
+#include <string.h>
+#include "ConvertSimd.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define CONVERT_SIMD_X86	1
+#else
+#define CONVERT_SIMD_X86	0
+#endif
+
+// (Inlined even without optimisation : the helpers pass vectors around).
+#define SIMD_INLINE		static inline __attribute__((always_inline))
+
+static const char *s_levelNames[] = { "scalar", "ssse3", "sse4.1", "avx2", "auto" };
+
+static int s_level = -1;		// Instruction set in use (-1 = not picked yet).
+
+#if CONVERT_SIMD_X86
+
+//=============================================================================
+// Packed mono : each pair of pixels (3 bytes) is shuffled into two 16 bit
+// lanes, b0:b1 and b2:b1 (high:low), then each lane is
+//	((lane >> s) & m1) | (lane & m2) | ((lane >> 4) & m3)
+// with masks that differ between the even and odd lanes (see _PackedMasks).
+
+static const int8_t s_packedOrder[16] = { 1, 0, 1, 2,  4, 3, 4, 5,  7, 6, 7, 8,  10, 9, 10, 11 };
+static const int8_t s_highOrder[16] = { 0, 2, 3, 5,  6, 8, 9, 11,  -1, -1, -1, -1,  -1, -1, -1, -1 };
+
+// Shift and masks of the lanes (even / odd pixel) for a depth.
+static void _PackedMasks( int inDepth, int *s, uint16_t m1[2], uint16_t m2[2], uint16_t m3[2])
+{
+	if (inDepth == 12)
+	{
+		*s = 4;
+		m1[0] = 0x0FF0; m1[1] = 0x0FFF;
+		m2[0] = 0x000F; m2[1] = 0x0000;
+		m3[0] = 0x0000; m3[1] = 0x0000;
+	}
+	else
+	{
+		*s = 6;
+		m1[0] = 0x03FC; m1[1] = 0x03FC;
+		m2[0] = 0x0003; m2[1] = 0x0000;
+		m3[0] = 0x0000; m3[1] = 0x0003;
+	}
+}
+
+__attribute__((target("ssse3")))
+static int _UnpackMono16_SSSE3( const unsigned char *in, uint16_t *out, int pairs, int inDepth, int shift)
+{
+	const __m128i order = _mm_loadu_si128((const __m128i *)s_packedOrder);
+	uint16_t m1[2], m2[2], m3[2];
+	__m128i mask1, mask2, mask3, count, four;
+	int s = 0;
+	int done = 0;
+
+	_PackedMasks( inDepth, &s, m1, m2, m3);
+	mask1 = _mm_set1_epi32((int)(((uint32_t)m1[1] << 16) | m1[0]));
+	mask2 = _mm_set1_epi32((int)(((uint32_t)m2[1] << 16) | m2[0]));
+	mask3 = _mm_set1_epi32((int)(((uint32_t)m3[1] << 16) | m3[0]));
+	count = _mm_cvtsi32_si128((shift >= 0) ? shift : -shift);
+	four = _mm_cvtsi32_si128(4);
+
+	// 4 pairs (12 bytes) at a time - 16 bytes are loaded, so stop 2 pairs short of the end.
+	for (; (done + 6) <= pairs; done += 4)
+	{
+		__m128i lanes = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(in + 3 * done)), order);
+		__m128i v = _mm_and_si128(_mm_srl_epi16(lanes, _mm_cvtsi32_si128(s)), mask1);
+
+		v = _mm_or_si128(v, _mm_and_si128(lanes, mask2));
+		v = _mm_or_si128(v, _mm_and_si128(_mm_srl_epi16(lanes, four), mask3));
+		v = (shift >= 0) ? _mm_srl_epi16(v, count) : _mm_sll_epi16(v, count);
+		_mm_storeu_si128((__m128i *)(out + 2 * done), v);
+	}
+	return done;
+}
+
+__attribute__((target("avx2")))
+static int _UnpackMono16_AVX2( const unsigned char *in, uint16_t *out, int pairs, int inDepth, int shift)
+{
+	const __m256i order = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)s_packedOrder));
+	uint16_t m1[2], m2[2], m3[2];
+	__m256i mask1, mask2, mask3;
+	__m128i count, four, sCount;
+	int s = 0;
+	int done = 0;
+
+	_PackedMasks( inDepth, &s, m1, m2, m3);
+	mask1 = _mm256_set1_epi32((int)(((uint32_t)m1[1] << 16) | m1[0]));
+	mask2 = _mm256_set1_epi32((int)(((uint32_t)m2[1] << 16) | m2[0]));
+	mask3 = _mm256_set1_epi32((int)(((uint32_t)m3[1] << 16) | m3[0]));
+	count = _mm_cvtsi32_si128((shift >= 0) ? shift : -shift);
+	four = _mm_cvtsi32_si128(4);
+	sCount = _mm_cvtsi32_si128(s);
+
+	// 8 pairs (24 bytes) at a time, 4 in each half - the upper half is loaded 12 bytes on (16 bytes read).
+	for (; (done + 10) <= pairs; done += 8)
+	{
+		const unsigned char *src = in + 3 * done;
+		__m256i lanes = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)src)),
+									_mm_loadu_si128((const __m128i *)(src + 12)), 1);
+		__m256i v;
+
+		lanes = _mm256_shuffle_epi8(lanes, order);
+		v = _mm256_and_si256(_mm256_srl_epi16(lanes, sCount), mask1);
+		v = _mm256_or_si256(v, _mm256_and_si256(lanes, mask2));
+		v = _mm256_or_si256(v, _mm256_and_si256(_mm256_srl_epi16(lanes, four), mask3));
+		v = (shift >= 0) ? _mm256_srl_epi16(v, count) : _mm256_sll_epi16(v, count);
+		_mm256_storeu_si256((__m256i *)(out + 2 * done), v);
+	}
+	return done + _UnpackMono16_SSSE3( in + 3 * done, out + 2 * done, pairs - done, inDepth, shift);
+}
+
+// 8 bit output : the high bytes (b0, b2) of each pair, whatever the depth.
+__attribute__((target("ssse3")))
+static int _UnpackMono8_SSSE3( const unsigned char *in, unsigned char *out, int pairs)
+{
+	const __m128i order = _mm_loadu_si128((const __m128i *)s_highOrder);
+	int done = 0;
+
+	for (; (done + 6) <= pairs; done += 4)
+	{
+		__m128i v = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(in + 3 * done)), order);
+
+		_mm_storel_epi64((__m128i *)(out + 2 * done), v);
+	}
+	return done;
+}
+
+__attribute__((target("avx2")))
+static int _UnpackMono8_AVX2( const unsigned char *in, unsigned char *out, int pairs)
+{
+	const __m256i order = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)s_highOrder));
+	int done = 0;
+
+	for (; (done + 10) <= pairs; done += 8)
+	{
+		const unsigned char *src = in + 3 * done;
+		__m256i v = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)src)),
+									_mm_loadu_si128((const __m128i *)(src + 12)), 1);
+
+		// (8 bytes out of each half, brought together).
+		v = _mm256_permute4x64_epi64(_mm256_shuffle_epi8(v, order), _MM_SHUFFLE(3, 1, 2, 0));
+		_mm_storeu_si128((__m128i *)(out + 2 * done), _mm256_castsi256_si128(v));
+	}
+	return done + _UnpackMono8_SSSE3( in + 3 * done, out + 2 * done, pairs - done);
+}
+
+//=============================================================================
+// YUV : the luma and chroma bytes of each block of pixels are gathered with
+// byte shuffles (_GatherYUV), the same whatever the format, then converted
+// by the same code. Each pixel is one 32 bit lane : the U V it uses are in
+// the two 16 bit halves of the lane (U low) for a multiply-add by the U V
+// coefficients of a colour, to which Y << 14 is added. The 32 bit sums
+// (>> 14) are packed to 16 bits and then 8 bits with saturation, which does
+// the clamping, and the B G R A bytes are interleaved.
+
+static const int8_t s_yuv411Luma[16] = { 1, 2, 4, 5, 7, 8, 10, 11,  -1, -1, -1, -1,  -1, -1, -1, -1 };
+static const int8_t s_yuv411Chroma[16] = { 0, 3, 0, 3, 0, 3, 0, 3,  6, 9, 6, 9, 6, 9, 6, 9 };
+static const int8_t s_yuv422Luma[16] = { 1, 3, 5, 7, 9, 11, 13, 15,  -1, -1, -1, -1,  -1, -1, -1, -1 };
+static const int8_t s_yuv422Chroma[16] = { 0, 2, 0, 2,  4, 6, 4, 6,  8, 10, 8, 10,  12, 14, 12, 14 };
+// (4:4:4 : 8 pixels are 24 bytes, loaded at 0 and 8).
+static const int8_t s_yuv444Luma[2][16] = { { 1, 4, 7, 10, 13, -1, -1, -1,  -1, -1, -1, -1, -1, -1, -1, -1 },
+														{ -1, -1, -1, -1, -1, 8, 11, 14,  -1, -1, -1, -1, -1, -1, -1, -1 } };
+static const int8_t s_yuv444Chroma[2][16] = { { 0, 2, 3, 5, 6, 8, 9, 11, 12, 14,  -1, -1, -1, -1, -1, -1 },
+														  { -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,  7, 9, 10, 12, 13, 15 } };
+// (4:4:4 luma of 16 pixels, 48 bytes loaded at 0, 16 and 32).
+static const int8_t s_yuv444Mono[3][16] = { { 1, 4, 7, 10, 13,  -1, -1, -1, -1, -1, -1,  -1, -1, -1, -1, -1 },
+														{ -1, -1, -1, -1, -1,  0, 3, 6, 9, 12, 15,  -1, -1, -1, -1, -1 },
+														{ -1, -1, -1, -1, -1,  -1, -1, -1, -1, -1, -1,  2, 5, 8, 11, 14 } };
+static const int8_t s_bgraToBgr[16] = { 0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14,  -1, -1, -1, -1 };
+
+// Bytes of 8 pixels, and the pixels to stop short of the end for the bytes loaded past them (4:1:1 : 16 for 12).
+static const int s_yuvBytes[] = { 12, 16, 24 };
+static const int s_yuvOverread[] = { 4, 0, 0 };
+
+#define YUV_SHIFT		14
+#define YUV_COEFFS(u, v)	((int)(((uint32_t)(uint16_t)(v) << 16) | (uint16_t)(u)))
+
+// The Y (8 bytes) and U V (8 pairs of bytes) of 8 pixels.
+__attribute__((target("ssse3")))
+SIMD_INLINE void _GatherYUV( int yuv, const unsigned char *in, __m128i *y, __m128i *uv)
+{
+	__m128i v = _mm_loadu_si128((const __m128i *)in);
+
+	switch (yuv)
+	{
+		case CONVERT_SIMD_YUV411:
+			*y = _mm_shuffle_epi8(v, _mm_loadu_si128((const __m128i *)s_yuv411Luma));
+			*uv = _mm_shuffle_epi8(v, _mm_loadu_si128((const __m128i *)s_yuv411Chroma));
+			break;
+		case CONVERT_SIMD_YUV422:
+			*y = _mm_shuffle_epi8(v, _mm_loadu_si128((const __m128i *)s_yuv422Luma));
+			*uv = _mm_shuffle_epi8(v, _mm_loadu_si128((const __m128i *)s_yuv422Chroma));
+			break;
+		default:
+			{
+				__m128i v1 = _mm_loadu_si128((const __m128i *)(in + 8));
+
+				*y = _mm_or_si128(_mm_shuffle_epi8(v, _mm_loadu_si128((const __m128i *)s_yuv444Luma[0])),
+										_mm_shuffle_epi8(v1, _mm_loadu_si128((const __m128i *)s_yuv444Luma[1])));
+				*uv = _mm_or_si128(_mm_shuffle_epi8(v, _mm_loadu_si128((const __m128i *)s_yuv444Chroma[0])),
+										_mm_shuffle_epi8(v1, _mm_loadu_si128((const __m128i *)s_yuv444Chroma[1])));
+			}
+			break;
+	}
+}
+
+// 8 pixels of B G R A (2 x 4) to 24 bytes of B G R.
+__attribute__((target("sse4.1")))
+SIMD_INLINE void _StoreBGR( unsigned char *out, __m128i bgra0, __m128i bgra1)
+{
+	const __m128i order = _mm_loadu_si128((const __m128i *)s_bgraToBgr);
+	__m128i bgr0 = _mm_shuffle_epi8(bgra0, order);
+	__m128i bgr1 = _mm_shuffle_epi8(bgra1, order);
+
+	_mm_storeu_si128((__m128i *)out, _mm_or_si128(bgr0, _mm_slli_si128(bgr1, 12)));
+	_mm_storel_epi64((__m128i *)(out + 16), _mm_srli_si128(bgr1, 4));
+}
+
+// (The 32 bit sums of 4 pixels).
+__attribute__((target("sse4.1")))
+SIMD_INLINE __m128i _YUVColour_SSE41( __m128i y, __m128i uv, int u, int v)
+{
+	return _mm_srai_epi32(_mm_add_epi32(y, _mm_madd_epi16(uv, _mm_set1_epi32(YUV_COEFFS(u, v)))), YUV_SHIFT);
+}
+
+// Convert 8 gathered pixels.
+__attribute__((target("sse4.1")))
+SIMD_INLINE void _YUVToRGB8x_SSE41( __m128i y, __m128i uv, unsigned char *out, int alpha)
+{
+	const __m128i bias = _mm_set1_epi16(128);
+	__m128i y0 = _mm_slli_epi32(_mm_cvtepu8_epi32(y), YUV_SHIFT);
+	__m128i y1 = _mm_slli_epi32(_mm_cvtepu8_epi32(_mm_srli_si128(y, 4)), YUV_SHIFT);
+	__m128i uv0 = _mm_sub_epi16(_mm_cvtepu8_epi16(uv), bias);
+	__m128i uv1 = _mm_sub_epi16(_mm_cvtepu8_epi16(_mm_srli_si128(uv, 8)), bias);
+	__m128i b, g, r, bg, ra;
+
+	b = _mm_packs_epi32(_YUVColour_SSE41( y0, uv0, 29147, 0), _YUVColour_SSE41( y1, uv1, 29147, 0));
+	g = _mm_packs_epi32(_YUVColour_SSE41( y0, uv0, -5661, -11746), _YUVColour_SSE41( y1, uv1, -5661, -11746));
+	r = _mm_packs_epi32(_YUVColour_SSE41( y0, uv0, 0, 23060), _YUVColour_SSE41( y1, uv1, 0, 23060));
+	bg = _mm_unpacklo_epi8(_mm_packus_epi16(b, b), _mm_packus_epi16(g, g));
+	ra = _mm_unpacklo_epi8(_mm_packus_epi16(r, r), _mm_set1_epi8((char)0xFF));
+	if (alpha)
+	{
+		_mm_storeu_si128((__m128i *)out, _mm_unpacklo_epi16(bg, ra));
+		_mm_storeu_si128((__m128i *)(out + 16), _mm_unpackhi_epi16(bg, ra));
+	}
+	else
+	{
+		_StoreBGR( out, _mm_unpacklo_epi16(bg, ra), _mm_unpackhi_epi16(bg, ra));
+	}
+}
+
+__attribute__((target("sse4.1")))
+static int _YUVToRGB8x_SSE41_Loop( int yuv, const unsigned char *in, unsigned char *out, int pixels, int alpha)
+{
+	int outBytes = alpha ? 4 : 3;
+	int done = 0;
+	__m128i y, uv;
+
+	// 8 pixels at a time.
+	for (; (done + 8 + s_yuvOverread[yuv]) <= pixels; done += 8)
+	{
+		_GatherYUV( yuv, in + (done / 8) * s_yuvBytes[yuv], &y, &uv);
+		_YUVToRGB8x_SSE41( y, uv, out + outBytes * done, alpha);
+	}
+	return done;
+}
+
+// (The 32 bit sums of 8 pixels).
+__attribute__((target("avx2")))
+SIMD_INLINE __m256i _YUVColour_AVX2( __m256i y, __m256i uv, int u, int v)
+{
+	return _mm256_srai_epi32(_mm256_add_epi32(y, _mm256_madd_epi16(uv, _mm256_set1_epi32(YUV_COEFFS(u, v)))), YUV_SHIFT);
+}
+
+// The 16 bit sums of 16 pixels, in order (the packs work within each half).
+__attribute__((target("avx2")))
+SIMD_INLINE __m256i _YUVColour16_AVX2( __m256i y0, __m256i uv0, __m256i y1, __m256i uv1, int u, int v)
+{
+	return _mm256_permute4x64_epi64(_mm256_packs_epi32(_YUVColour_AVX2( y0, uv0, u, v), _YUVColour_AVX2( y1, uv1, u, v)),
+												_MM_SHUFFLE(3, 1, 2, 0));
+}
+
+__attribute__((target("avx2")))
+static int _YUVToRGB8x_AVX2_Loop( int yuv, const unsigned char *in, unsigned char *out, int pixels, int alpha)
+{
+	const __m256i bias = _mm256_set1_epi16(128);
+	int outBytes = alpha ? 4 : 3;
+	int done = 0;
+
+	// 16 pixels at a time, 8 in each half.
+	for (; (done + 16 + s_yuvOverread[yuv]) <= pixels; done += 16)
+	{
+		const unsigned char *src = in + (done / 8) * s_yuvBytes[yuv];
+		unsigned char *dst = out + outBytes * done;
+		__m128i ya, uva, yb, uvb;
+		__m256i y0, y1, uv0, uv1, b, g, r, bg, ra, lo, hi;
+
+		_GatherYUV( yuv, src, &ya, &uva);
+		_GatherYUV( yuv, src + s_yuvBytes[yuv], &yb, &uvb);
+		y0 = _mm256_slli_epi32(_mm256_cvtepu8_epi32(ya), YUV_SHIFT);
+		y1 = _mm256_slli_epi32(_mm256_cvtepu8_epi32(yb), YUV_SHIFT);
+		uv0 = _mm256_sub_epi16(_mm256_cvtepu8_epi16(uva), bias);
+		uv1 = _mm256_sub_epi16(_mm256_cvtepu8_epi16(uvb), bias);
+
+		b = _YUVColour16_AVX2( y0, uv0, y1, uv1, 29147, 0);
+		g = _YUVColour16_AVX2( y0, uv0, y1, uv1, -5661, -11746);
+		r = _YUVColour16_AVX2( y0, uv0, y1, uv1, 0, 23060);
+		bg = _mm256_unpacklo_epi8(_mm256_packus_epi16(b, b), _mm256_packus_epi16(g, g));
+		ra = _mm256_unpacklo_epi8(_mm256_packus_epi16(r, r), _mm256_set1_epi8((char)0xFF));
+		lo = _mm256_unpacklo_epi16(bg, ra);		// Pixels 0 - 3 and 8 - 11 ...
+		hi = _mm256_unpackhi_epi16(bg, ra);		// ... 4 - 7 and 12 - 15.
+		if (alpha)
+		{
+			_mm256_storeu_si256((__m256i *)dst, _mm256_permute2x128_si256(lo, hi, 0x20));
+			_mm256_storeu_si256((__m256i *)(dst + 32), _mm256_permute2x128_si256(lo, hi, 0x31));
+		}
+		else
+		{
+			_StoreBGR( dst, _mm256_castsi256_si128(lo), _mm256_castsi256_si128(hi));
+			_StoreBGR( dst + 24, _mm256_extracti128_si256(lo, 1), _mm256_extracti128_si256(hi, 1));
+		}
+	}
+	return done + _YUVToRGB8x_SSE41_Loop( yuv, in + (done / 8) * s_yuvBytes[yuv], out + outBytes * done, pixels - done, alpha);
+}
+
+// Luma only : the Y of 16 pixels.
+__attribute__((target("ssse3")))
+SIMD_INLINE __m128i _GatherLuma( int yuv, const unsigned char *in)
+{
+	switch (yuv)
+	{
+		case CONVERT_SIMD_YUV411:
+			{
+				const __m128i order = _mm_loadu_si128((const __m128i *)s_yuv411Luma);
+
+				return _mm_unpacklo_epi64(_mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)in), order),
+												_mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(in + 12)), order));
+			}
+		case CONVERT_SIMD_YUV422:
+			{
+				const __m128i order = _mm_loadu_si128((const __m128i *)s_yuv422Luma);
+
+				return _mm_unpacklo_epi64(_mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)in), order),
+												_mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(in + 16)), order));
+			}
+		default:
+			return _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)in), _mm_loadu_si128((const __m128i *)s_yuv444Mono[0])),
+												_mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(in + 16)), _mm_loadu_si128((const __m128i *)s_yuv444Mono[1]))),
+												_mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(in + 32)), _mm_loadu_si128((const __m128i *)s_yuv444Mono[2])));
+	}
+}
+
+__attribute__((target("ssse3")))
+static int _YUVToMono_SSSE3( int yuv, const unsigned char *in, void *out, int pixels, int outDepth)
+{
+	__m128i count = _mm_cvtsi32_si128(outDepth - 8);
+	int done = 0;
+
+	// 16 pixels at a time.
+	for (; (done + 16 + s_yuvOverread[yuv]) <= pixels; done += 16)
+	{
+		__m128i y = _GatherLuma( yuv, in + (done / 8) * s_yuvBytes[yuv]);
+
+		if (outDepth > 8)
+		{
+			uint16_t *dst = (uint16_t *)out + done;
+
+			_mm_storeu_si128((__m128i *)dst, _mm_sll_epi16(_mm_unpacklo_epi8(y, _mm_setzero_si128()), count));
+			_mm_storeu_si128((__m128i *)(dst + 8), _mm_sll_epi16(_mm_unpackhi_epi8(y, _mm_setzero_si128()), count));
+		}
+		else
+		{
+			_mm_storeu_si128((__m128i *)((unsigned char *)out + done), y);
+		}
+	}
+	return done;
+}
+
+#endif
+
+// !
+// ConvertSimd_Init
+//
+/*!
+	Pick the instruction set of the kernels : the best the CPU has, up to
+	"level" (CONVERT_SIMD_AUTO = no limit).
+
+	\return The level picked (CONVERT_SIMD_SCALAR = no kernels)
+*/
+int ConvertSimd_Init( int level)
+{
+	int best = CONVERT_SIMD_SCALAR;
+
+#if CONVERT_SIMD_X86
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("ssse3"))
+	{
+		best = CONVERT_SIMD_SSSE3;
+	}
+	if (__builtin_cpu_supports("sse4.1"))
+	{
+		best = CONVERT_SIMD_SSE41;
+	}
+	if (__builtin_cpu_supports("avx2"))
+	{
+		best = CONVERT_SIMD_AVX2;
+	}
+#endif
+	level = (level < 0) ? CONVERT_SIMD_AUTO : level;
+	__atomic_store_n(&s_level, (level < best) ? level : best, __ATOMIC_RELAXED);
+	return s_level;
+}
+
+int ConvertSimd_Level( void )
+{
+	int level = __atomic_load_n(&s_level, __ATOMIC_RELAXED);
+
+	return (level >= 0) ? level : ConvertSimd_Init( CONVERT_SIMD_AUTO);
+}
+
+int ConvertSimd_ParseLevel( const char *name)
+{
+	int i;
+
+	if (name != NULL)
+	{
+		for (i = 0; i < (int)(sizeof(s_levelNames) / sizeof(s_levelNames[0])); i++)
+		{
+			if (strcmp(name, s_levelNames[i]) == 0)
+			{
+				return i;
+			}
+		}
+	}
+	return -1;
+}
+
+const char *ConvertSimd_LevelName( int level)
+{
+	return ((level >= 0) && (level <= CONVERT_SIMD_AUTO)) ? s_levelNames[level] : "unknown";
+}
+
+// !
+// ConvertSimd_UnpackMono8
+//
+/*!
+	Unpack 10 / 12 bit packed mono to 8 bits (the top 8 bits of each pixel).
+
+	\param pairs  Pairs of pixels (3 bytes each) in "in".
+	\return The pairs done (from the start - the caller does the rest).
+*/
+int ConvertSimd_UnpackMono8( const unsigned char *in, unsigned char *out, int pairs)
+{
+#if CONVERT_SIMD_X86
+	switch (ConvertSimd_Level())
+	{
+		case CONVERT_SIMD_AVX2:		return _UnpackMono8_AVX2( in, out, pairs);
+		case CONVERT_SIMD_SSE41:
+		case CONVERT_SIMD_SSSE3:	return _UnpackMono8_SSSE3( in, out, pairs);
+		default:							break;
+	}
+#endif
+	return 0;
+}
+
+// !
+// ConvertSimd_UnpackMono16
+//
+/*!
+	Unpack 10 / 12 bit packed mono to 16 bit words, shifted right by "shift"
+	bits (left when it is negative).
+
+	\param pairs    Pairs of pixels (3 bytes each) in "in".
+	\param inDepth  12, or 10 (anything else).
+	\return The pairs done (from the start - the caller does the rest).
+*/
+int ConvertSimd_UnpackMono16( const unsigned char *in, uint16_t *out, int pairs, int inDepth, int shift)
+{
+#if CONVERT_SIMD_X86
+	switch (ConvertSimd_Level())
+	{
+		case CONVERT_SIMD_AVX2:		return _UnpackMono16_AVX2( in, out, pairs, inDepth, shift);
+		case CONVERT_SIMD_SSE41:
+		case CONVERT_SIMD_SSSE3:	return _UnpackMono16_SSSE3( in, out, pairs, inDepth, shift);
+		default:							break;
+	}
+#endif
+	return 0;
+}
+
+// !
+// ConvertSimd_YUVToRGB8x
+//
+/*!
+	Convert YUV (CONVERT_SIMD_YUV411 / 422 / 444) to B G R A (alpha != 0) or
+	B G R bytes.
+
+	\param pixels  Pixels in "in" (whole groups of pixels that share U V).
+	\return The pixels done (from the start - the caller does the rest).
+*/
+int ConvertSimd_YUVToRGB8x( int yuv, const unsigned char *in, unsigned char *out, int pixels, int alpha)
+{
+#if CONVERT_SIMD_X86
+	if ((yuv >= CONVERT_SIMD_YUV411) && (yuv <= CONVERT_SIMD_YUV444))
+	{
+		switch (ConvertSimd_Level())
+		{
+			case CONVERT_SIMD_AVX2:		return _YUVToRGB8x_AVX2_Loop( yuv, in, out, pixels, alpha);
+			case CONVERT_SIMD_SSE41:	return _YUVToRGB8x_SSE41_Loop( yuv, in, out, pixels, alpha);
+			default:							break;
+		}
+	}
+#endif
+	return 0;
+}
+
+// !
+// ConvertSimd_YUVToMono
+//
+/*!
+	Extract the luma of YUV (CONVERT_SIMD_YUV411 / 422 / 444) : 8 bit pixels,
+	or 16 bit ones shifted left by outDepth - 8 (outDepth > 8).
+
+	\param pixels  Pixels in "in" (whole groups of pixels that share U V).
+	\return The pixels done (from the start - the caller does the rest).
+*/
+int ConvertSimd_YUVToMono( int yuv, const unsigned char *in, void *out, int pixels, int outDepth)
+{
+#if CONVERT_SIMD_X86
+	if ((yuv >= CONVERT_SIMD_YUV411) && (yuv <= CONVERT_SIMD_YUV444))
+	{
+		switch (ConvertSimd_Level())
+		{
+			case CONVERT_SIMD_AVX2:
+			case CONVERT_SIMD_SSE41:
+			case CONVERT_SIMD_SSSE3:	return _YUVToMono_SSSE3( yuv, in, out, pixels, outDepth);
+			default:							break;
+		}
+	}
+#endif
+	return 0;
+}
@@ -0,0 +1,70 @@
+#ifndef __CONVERT_SIMD_H__
+#define __CONVERT_SIMD_H__
+
+#include <stdint.h>
+
+//=============================================================================
+// Vector kernels for the pixel format converters (GevUtils.c).
+//
+// The kernels do the bulk of a conversion with SSSE3, SSE4.1 or AVX2 code
+// and return how much they did : the caller finishes the rest (the end of
+// the image, or all of it on a CPU without them) with its scalar code, which
+// stays the reference the kernels must match bit for bit.
+//
+// The instruction set is picked once, at startup (ConvertSimd_Init), from
+// what the CPU has (CPUID) - capped by a level from the configuration, eg.
+// "scalar" to check a kernel against the reference. The kernels are built
+// for their instruction set with function attributes, so the program itself
+// needs no -m flags and still runs on any x86.
+//
+// Packed mono (GigE Vision Mono10Packed / Mono12Packed and the packed Bayer
+// formats) : 2 pixels in 3 bytes -
+//	12 bits  p0 = b0 << 4 | (b1 & 0x0F)        p1 = b2 << 4 | b1 >> 4
+//	10 bits  p0 = b0 << 2 | (b1 & 0x03)        p1 = b2 << 2 | (b1 >> 4) & 0x03
+//
+// YUV (GigE Vision YUV411Packed, YUV422Packed, YUV444Packed) : pixels that
+// share U and V -
+//	4:1:1  4 pixels in 6 bytes  U Y0 Y1 V Y2 Y3
+//	4:2:2  2 pixels in 4 bytes  U Y0 V Y1
+//	4:4:4  1 pixel in 3 bytes   U Y V
+// to mono (Y, gathered with byte shuffles) or B G R (A = 0xFF) bytes -
+//	B = (Y << 14 + 29147 U) >> 14
+//	G = (Y << 14 - 5661 U - 11746 V) >> 14      (U, V = byte - 128)
+//	R = (Y << 14 + 23060 V) >> 14
+// clamped to 0 .. 255 (the kernels : 32 bit multiply-adds, saturating packs).
+//
+
+typedef enum
+{
+	CONVERT_SIMD_SCALAR = 0,
+	CONVERT_SIMD_SSSE3,
+	CONVERT_SIMD_SSE41,
+	CONVERT_SIMD_AVX2,
+	CONVERT_SIMD_AUTO					// The best the CPU has.
+} CONVERT_SIMD_LEVEL;
+
+typedef enum
+{
+	CONVERT_SIMD_YUV411 = 0,
+	CONVERT_SIMD_YUV422,
+	CONVERT_SIMD_YUV444
+} CONVERT_SIMD_YUV;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int ConvertSimd_Init( int level);
+int ConvertSimd_Level( void );
+int ConvertSimd_ParseLevel( const char *name);
+const char *ConvertSimd_LevelName( int level);
+int ConvertSimd_UnpackMono8( const unsigned char *in, unsigned char *out, int pairs);
+int ConvertSimd_UnpackMono16( const unsigned char *in, uint16_t *out, int pairs, int inDepth, int shift);
+int ConvertSimd_YUVToRGB8x( int yuv, const unsigned char *in, unsigned char *out, int pixels, int alpha);
+int ConvertSimd_YUVToMono( int yuv, const unsigned char *in, void *out, int pixels, int outDepth);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,64 @@
+#ifndef __FRAME_HEADER_H__
+#define __FRAME_HEADER_H__
+
+#include <stdint.h>
+#include <string.h>
+
+//=============================================================================
+// Self-describing frame header.
+//
+// Every frame sent on an output stream (stdout pipe, shared memory slot)
+// is preceded by this fixed-size header so a consumer never has to
+// hardcode the image geometry :
+//
+//	[FRAME_HEADER][payload_length bytes of pixel data]
+//
+// All fields are little-endian (host order). A consumer that loses
+// alignment (partial read) can scan forward for FRAME_HEADER_MAGIC and
+// re-check the version / header_size to resynchronize.
+//
+// Version 2 added the host times (exposure_ns, arrival_ns) at the end - a
+// version 1 header is the 48 bytes before them.
+//
+
+#define FRAME_HEADER_MAGIC		0x48465647	// "GVFH"
+#define FRAME_HEADER_VERSION	2
+
+// Header flags.
+#define FRAME_HEADER_FLAG_DISCONTINUITY	0x0001	// First frame after the camera was reconnected (the frame ids start again).
+
+typedef struct FRAME_HEADER_t
+{
+	uint32_t	magic;				// FRAME_HEADER_MAGIC
+	uint16_t	version;				// FRAME_HEADER_VERSION
+	uint16_t	header_size;		// sizeof(FRAME_HEADER) - offset of the payload.
+	uint64_t	frame_id;			// Block id from the GEV buffer object.
+	uint64_t	timestamp;			// GEV (camera) timestamp, in camera ticks.
+	uint32_t	width;				// Pixels per line.
+	uint32_t	height;				// Number of lines.
+	uint32_t	pixel_format;		// GigE Vision pixel format of the payload (fmt*).
+	uint32_t	stride;				// Bytes from one line to the next in the payload.
+	uint32_t	payload_length;	// Number of payload bytes following the header.
+	uint16_t	channel;				// Camera the frame comes from (its position on the genicam command line).
+	uint16_t	flags;				// FRAME_HEADER_FLAG_* (zero for an ordinary frame).
+	uint64_t	exposure_ns;		// Camera timestamp mapped to the host clock (CLOCK_MONOTONIC_RAW ns, 0 = clock not synchronized).
+	uint64_t	arrival_ns;			// When the frame was handed over by the transfer (CLOCK_MONOTONIC_RAW ns).
+} FRAME_HEADER, *PFRAME_HEADER;
+
+static inline void FrameHeader_Init( FRAME_HEADER *hdr, uint64_t frame_id, uint64_t timestamp,
+						uint32_t width, uint32_t height, uint32_t pixel_format, uint32_t stride, uint32_t payload_length)
+{
+	memset(hdr, 0, sizeof(FRAME_HEADER));
+	hdr->magic          = FRAME_HEADER_MAGIC;
+	hdr->version        = FRAME_HEADER_VERSION;
+	hdr->header_size    = sizeof(FRAME_HEADER);
+	hdr->frame_id       = frame_id;
+	hdr->timestamp      = timestamp;
+	hdr->width          = width;
+	hdr->height         = height;
+	hdr->pixel_format   = pixel_format;
+	hdr->stride         = stride;
+	hdr->payload_length = payload_length;
+}
+
+#endif
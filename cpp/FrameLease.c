@@ -0,0 +1,328 @@
+/*
+  ---------------------------------------------
+  Reference counted acquisition buffer leases
+  -----------------------------------------------
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "FrameLease.h"
+
+#define FRAME_LEASE_POLL_NS	100000		// Poll interval while waiting for a lease.
+
+static const char *s_policyNames[] = { "wait", "drop" };
+
+static inline uint64_t _ns_now( void )
+{
+	struct timespec ts;
+	clock_gettime( CLOCK_MONOTONIC, &ts);
+	return ((uint64_t)ts.tv_sec * 1000000000ULL) + (uint64_t)ts.tv_nsec;
+}
+
+// !
+// FrameLease_Init
+//
+/*!
+	Set up a lease pool.
+
+	\param pool       Pool object to initialize.
+	\param numLeases  Buffers that can be held at once (1 .. FRAME_LEASE_MAX) -
+	                  keep it below the number of transfer buffers.
+	\param policy     What to do when every lease is held.
+
+	\return Error status
+		0   = Success
+*/
+int FrameLease_Init( FRAME_LEASE_POOL *pool, int numLeases, FRAME_LEASE_POLICY policy)
+{
+	pthread_condattr_t attr;
+	int i;
+
+	if (pool == NULL)
+	{
+		return FRAMELEASE_ERROR_NULL_PTR;
+	}
+	memset(pool, 0, sizeof(FRAME_LEASE_POOL));
+	if ((numLeases < 1) || (numLeases > FRAME_LEASE_MAX) || (policy < FRAME_LEASE_WAIT) || (policy > FRAME_LEASE_DROP))
+	{
+		return FRAMELEASE_ERROR_PARAMETER;
+	}
+	pool->policy = policy;
+	pool->numLeases = numLeases;
+	for (i = numLeases - 1; i >= 0; i--)
+	{
+		pool->leases[i].pool = pool;
+		pool->leases[i].next = pool->freeList;
+		pool->freeList = &pool->leases[i];
+	}
+	pthread_mutex_init(&pool->lock, NULL);
+	pthread_condattr_init(&attr);
+	pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+	pthread_cond_init(&pool->returnedCond, &attr);
+	pthread_condattr_destroy(&attr);
+	return 0;
+}
+
+// Policy from its name ("wait", "drop"), -1 if unknown.
+int FrameLease_ParsePolicy( const char *name)
+{
+	int i;
+
+	if (name != NULL)
+	{
+		for (i = 0; i < (int)(sizeof(s_policyNames) / sizeof(s_policyNames[0])); i++)
+		{
+			if (strcmp(name, s_policyNames[i]) == 0)
+			{
+				return i;
+			}
+		}
+	}
+	return -1;
+}
+
+const char *FrameLease_PolicyName( FRAME_LEASE_POLICY policy)
+{
+	return ((policy >= FRAME_LEASE_WAIT) && (policy <= FRAME_LEASE_DROP)) ? s_policyNames[policy] : "unknown";
+}
+
+// !
+// FrameLease_WaitFree
+//
+/*!
+	Make sure a lease is free before the next frame is taken.
+
+	With FRAME_LEASE_WAIT, waits until a lease has come back. "poll" is called
+	in the meantime (without the pool lock) to pick up the releases that have to
+	be polled for (eg. a drained pipe) and give the returned buffers back (it
+	should call FrameLease_Reclaim). FRAME_LEASE_DROP never waits.
+
+	\param stop  Stop waiting as soon as this is set (NULL = no stop flag).
+
+	\return 1 if a lease is free, 0 if not.
+*/
+int FrameLease_WaitFree( FRAME_LEASE_POOL *pool, void (*poll)(void *), void *arg, volatile int *stop)
+{
+	uint64_t start = 0;
+	int isFree = 0;
+
+	if (pool == NULL)
+	{
+		return 0;
+	}
+	pthread_mutex_lock(&pool->lock);
+	isFree = (pool->freeList != NULL);
+	if (!isFree && !pool->empty)
+	{
+		// (Counted once per run of frames that find every lease held).
+		pool->empty = 1;
+		pool->stats.exhausted++;
+	}
+	if (!isFree && (pool->policy == FRAME_LEASE_WAIT))
+	{
+		start = _ns_now();
+		while (!isFree && ((stop == NULL) || !*stop))
+		{
+			if (pool->returned == NULL)
+			{
+				struct timespec deadline;
+
+				clock_gettime( CLOCK_MONOTONIC, &deadline);
+				deadline.tv_nsec += FRAME_LEASE_POLL_NS;
+				if (deadline.tv_nsec >= 1000000000L)
+				{
+					deadline.tv_sec++;
+					deadline.tv_nsec -= 1000000000L;
+				}
+				pthread_cond_timedwait(&pool->returnedCond, &pool->lock, &deadline);
+			}
+			pthread_mutex_unlock(&pool->lock);
+			if (poll != NULL)
+			{
+				poll(arg);
+			}
+			pthread_mutex_lock(&pool->lock);
+			isFree = (pool->freeList != NULL);
+		}
+		pool->stats.nsWaited += _ns_now() - start;
+	}
+	pthread_mutex_unlock(&pool->lock);
+	return isFree;
+}
+
+// !
+// FrameLease_Acquire
+//
+/*!
+	Lease a received buffer (with one reference, the caller's).
+
+	\return The lease, or NULL if every lease is held : the frame is counted as
+	        dropped and the buffer should go straight back to the transfer.
+*/
+FRAME_LEASE *FrameLease_Acquire( FRAME_LEASE_POOL *pool, void *buffer, void *address, uint64_t frameId)
+{
+	FRAME_LEASE *lease = NULL;
+
+	if (pool == NULL)
+	{
+		return NULL;
+	}
+	pthread_mutex_lock(&pool->lock);
+	lease = pool->freeList;
+	if (lease != NULL)
+	{
+		pool->freeList = lease->next;
+		pool->empty = 0;
+		lease->next = NULL;
+		lease->buffer = buffer;
+		lease->address = address;
+		lease->frameId = frameId;
+		__atomic_store_n(&lease->refs, 1, __ATOMIC_RELAXED);
+		pool->stats.leased++;
+		pool->stats.outstanding++;
+		if (pool->stats.outstanding > pool->stats.maxOutstanding)
+		{
+			pool->stats.maxOutstanding = pool->stats.outstanding;
+		}
+	}
+	else
+	{
+		if (!pool->empty)
+		{
+			pool->empty = 1;
+			pool->stats.exhausted++;
+		}
+		pool->stats.dropped++;
+	}
+	pthread_mutex_unlock(&pool->lock);
+	return lease;
+}
+
+// Add a holder to a lease (returns the lease, for convenience).
+FRAME_LEASE *FrameLease_Ref( FRAME_LEASE *lease)
+{
+	if (lease != NULL)
+	{
+		__atomic_add_fetch(&lease->refs, 1, __ATOMIC_RELAXED);
+	}
+	return lease;
+}
+
+// !
+// FrameLease_Release
+//
+/*!
+	Drop a reference to a lease (from any thread).
+
+	The last one queues the buffer for FrameLease_Reclaim - the caller must not
+	touch the image data afterwards. (Takes a void * so that it can be used as
+	a release callback).
+*/
+void FrameLease_Release( void *ptr)
+{
+	FRAME_LEASE *lease = (FRAME_LEASE *)ptr;
+
+	if ((lease != NULL) && (__atomic_sub_fetch(&lease->refs, 1, __ATOMIC_ACQ_REL) == 0))
+	{
+		FRAME_LEASE_POOL *pool = lease->pool;
+
+		pthread_mutex_lock(&pool->lock);
+		lease->next = pool->returned;
+		pool->returned = lease;
+		pthread_cond_signal(&pool->returnedCond);
+		pthread_mutex_unlock(&pool->lock);
+	}
+}
+
+// !
+// FrameLease_Reclaim
+//
+/*!
+	Get back a buffer whose last holder is done with it (the lease is free again).
+
+	\return 1 if *buffer was set (give it back to the transfer), 0 if nothing can be reclaimed.
+*/
+int FrameLease_Reclaim( FRAME_LEASE_POOL *pool, void **buffer)
+{
+	FRAME_LEASE *lease = NULL;
+
+	if ((pool == NULL) || (buffer == NULL))
+	{
+		return 0;
+	}
+	pthread_mutex_lock(&pool->lock);
+	lease = pool->returned;
+	if (lease != NULL)
+	{
+		pool->returned = lease->next;
+		*buffer = lease->buffer;
+		lease->buffer = NULL;
+		lease->address = NULL;
+		lease->next = pool->freeList;
+		pool->freeList = lease;
+		pool->stats.reclaimed++;
+		pool->stats.outstanding--;
+	}
+	pthread_mutex_unlock(&pool->lock);
+	return (lease != NULL);
+}
+
+// Leases out (held, or returned but not reclaimed yet).
+int FrameLease_Outstanding( FRAME_LEASE_POOL *pool)
+{
+	int count = 0;
+
+	if ((pool != NULL) && (pool->numLeases > 0))
+	{
+		pthread_mutex_lock(&pool->lock);
+		count = (int)pool->stats.outstanding;
+		pthread_mutex_unlock(&pool->lock);
+	}
+	return count;
+}
+
+void FrameLease_GetStats( FRAME_LEASE_POOL *pool, FRAME_LEASE_STATS *stats)
+{
+	if ((pool != NULL) && (stats != NULL))
+	{
+		pthread_mutex_lock(&pool->lock);
+		*stats = pool->stats;
+		pthread_mutex_unlock(&pool->lock);
+	}
+}
+
+void FrameLease_PrintStats( FRAME_LEASE_POOL *pool, const char *label)
+{
+	FRAME_LEASE_STATS stats;
+
+	if ((pool == NULL) || (pool->numLeases == 0))
+	{
+		return;
+	}
+	FrameLease_GetStats( pool, &stats);
+	fprintf(stderr, "%s (%s, %d leases): %llu leased, %llu reclaimed, %u out (max %u), exhausted %llu times",
+			(label != NULL) ? label : "leases", FrameLease_PolicyName(pool->policy), pool->numLeases,
+			(unsigned long long)stats.leased, (unsigned long long)stats.reclaimed, stats.outstanding,
+			stats.maxOutstanding, (unsigned long long)stats.exhausted);
+	if (stats.dropped > 0)
+	{
+		fprintf(stderr, ", %llu frames dropped", (unsigned long long)stats.dropped);
+	}
+	if (stats.nsWaited > 0)
+	{
+		fprintf(stderr, ", waited %.1f ms", (double)stats.nsWaited / 1e6);
+	}
+	fprintf(stderr, "\n");
+}
+
+// (Leases still held are forgotten - only call this once the transfer is gone).
+void FrameLease_Destroy( FRAME_LEASE_POOL *pool)
+{
+	if ((pool != NULL) && (pool->numLeases > 0))
+	{
+		pthread_cond_destroy(&pool->returnedCond);
+		pthread_mutex_destroy(&pool->lock);
+		memset(pool, 0, sizeof(FRAME_LEASE_POOL));
+	}
+}
@@ -0,0 +1,96 @@
+#ifndef __FRAME_LEASE_H__
+#define __FRAME_LEASE_H__
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+//=============================================================================
+// Reference counted leases on acquisition buffers.
+//
+// With synchronous buffer cycling a buffer is only reused once it has been
+// released, so consumers can read it in place (no copy) for as long as they
+// hold it. A lease stands for one received buffer : the acquisition thread
+// takes it (FrameLease_Acquire, one reference), every consumer that keeps the
+// frame past the acquisition loop (stdout pipe, output queue, memfd
+// consumers, ...) adds its own (FrameLease_Ref) and drops it when done
+// (FrameLease_Release), from any thread. When the last reference goes, the
+// lease is queued for the acquisition thread, which gives the buffer back to
+// the transfer (FrameLease_Reclaim, then the Gev release).
+//
+// At most numLeases buffers are out at once (keep at least one for the
+// transfer). When they are all held, the policy decides :
+//
+//	FRAME_LEASE_WAIT  The acquisition thread waits for a lease to come back
+//	                  (the transfer drops frames while no buffer is free).
+//	FRAME_LEASE_DROP  Frames keep coming - the ones that find no lease free
+//	                  are given straight back to the transfer and counted.
+//
+
+#define FRAME_LEASE_MAX		64
+
+#define FRAMELEASE_ERROR_NULL_PTR		-1900 // A pointer passed in is NULL.
+#define FRAMELEASE_ERROR_PARAMETER	-1901 // Invalid number of leases or policy.
+
+typedef enum
+{
+	FRAME_LEASE_WAIT = 0,
+	FRAME_LEASE_DROP
+} FRAME_LEASE_POLICY;
+
+typedef struct FRAME_LEASE_t
+{
+	struct FRAME_LEASE_POOL_t	*pool;
+	struct FRAME_LEASE_t			*next;		// Free / returned list link.
+	void		*buffer;				// Acquisition buffer object (eg. GEV_BUFFER_OBJECT).
+	void		*address;			// Its image data.
+	uint64_t	frameId;
+	int		refs;					// Holders (atomic).
+} FRAME_LEASE;
+
+typedef struct FRAME_LEASE_STATS_t
+{
+	uint64_t	leased;				// Frames handed out.
+	uint64_t	reclaimed;			// Buffers given back once their last holder was done.
+	uint64_t	exhausted;			// Times every lease was held.
+	uint64_t	dropped;				// Frames given straight back for lack of a lease (FRAME_LEASE_DROP).
+	uint64_t	nsWaited;			// Time spent waiting for a lease (FRAME_LEASE_WAIT).
+	uint32_t	outstanding;		// Leases out now.
+	uint32_t	maxOutstanding;	// Most leases ever out at once.
+} FRAME_LEASE_STATS;
+
+typedef struct FRAME_LEASE_POOL_t
+{
+	FRAME_LEASE_POLICY	policy;
+	int		numLeases;
+	int		empty;							// Every lease was held at the last request.
+	FRAME_LEASE			*freeList;
+	FRAME_LEASE			*returned;		// Last holder gone - buffer to give back.
+	pthread_mutex_t	lock;
+	pthread_cond_t		returnedCond;
+	FRAME_LEASE_STATS	stats;
+	FRAME_LEASE			leases[FRAME_LEASE_MAX];
+} FRAME_LEASE_POOL, *PFRAME_LEASE_POOL;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int FrameLease_Init( FRAME_LEASE_POOL *pool, int numLeases, FRAME_LEASE_POLICY policy);
+int FrameLease_ParsePolicy( const char *name);
+const char *FrameLease_PolicyName( FRAME_LEASE_POLICY policy);
+int FrameLease_WaitFree( FRAME_LEASE_POOL *pool, void (*poll)(void *), void *arg, volatile int *stop);
+FRAME_LEASE *FrameLease_Acquire( FRAME_LEASE_POOL *pool, void *buffer, void *address, uint64_t frameId);
+FRAME_LEASE *FrameLease_Ref( FRAME_LEASE *lease);
+void FrameLease_Release( void *lease);
+int FrameLease_Reclaim( FRAME_LEASE_POOL *pool, void **buffer);
+int FrameLease_Outstanding( FRAME_LEASE_POOL *pool);
+void FrameLease_GetStats( FRAME_LEASE_POOL *pool, FRAME_LEASE_STATS *stats);
+void FrameLease_PrintStats( FRAME_LEASE_POOL *pool, const char *label);
+void FrameLease_Destroy( FRAME_LEASE_POOL *pool);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
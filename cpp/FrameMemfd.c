@@ -0,0 +1,525 @@
+/*
+  ---------------------------------------------
+  memfd frame buffer sharing (descriptors passed with SCM_RIGHTS)
+  -----------------------------------------------
+*/
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include "FrameMemfd.h"
+
+// Give back everything a consumer holds and close it.
+static void _DropClient( FRAME_MEMFD_SERVER *srv, int slot)
+{
+	int i;
+
+	for (i = 0; i < srv->numBuffers; i++)
+	{
+		srv->buffers[i].holders &= ~(1u << slot);
+	}
+	close(srv->clients[slot].fd);
+	srv->clients[slot].fd = -1;
+	srv->clients[slot].held = 0;
+	srv->numClients--;
+}
+
+// Send the buffer table and descriptors to a new consumer.
+static int _SendHello( FRAME_MEMFD_SERVER *srv, int fd)
+{
+	FRAME_MEMFD_HELLO hello;
+	struct msghdr msg;
+	struct iovec iov;
+	struct cmsghdr *cmsg;
+	char control[CMSG_SPACE(sizeof(int) * FRAME_MEMFD_MAX_BUFFERS)];
+	int i;
+
+	memset(&hello, 0, sizeof(hello));
+	hello.magic = FRAME_MEMFD_HELLO_MAGIC;
+	hello.version = FRAME_MEMFD_VERSION;
+	hello.num_buffers = srv->numBuffers;
+	for (i = 0; i < srv->numBuffers; i++)
+	{
+		hello.buffer_size[i] = srv->buffers[i].size;
+	}
+
+	memset(&msg, 0, sizeof(msg));
+	memset(control, 0, sizeof(control));
+	iov.iov_base = &hello;
+	iov.iov_len = sizeof(hello);
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	if (srv->numBuffers > 0)
+	{
+		msg.msg_control = control;
+		msg.msg_controllen = CMSG_SPACE(sizeof(int) * srv->numBuffers);
+		cmsg = CMSG_FIRSTHDR(&msg);
+		cmsg->cmsg_level = SOL_SOCKET;
+		cmsg->cmsg_type = SCM_RIGHTS;
+		cmsg->cmsg_len = CMSG_LEN(sizeof(int) * srv->numBuffers);
+		for (i = 0; i < srv->numBuffers; i++)
+		{
+			memcpy(CMSG_DATA(cmsg) + (i * sizeof(int)), &srv->buffers[i].fd, sizeof(int));
+		}
+	}
+	return (sendmsg(fd, &msg, MSG_NOSIGNAL) == (ssize_t)sizeof(hello)) ? 0 : -1;
+}
+
+// !
+// FrameMemfd_Create
+//
+/*!
+	Start listening for buffer sharing consumers on a Unix domain (SOCK_SEQPACKET) socket.
+
+	\param srv         Server object to initialize.
+	\param path        Socket path (an existing socket file at this path is replaced).
+	\param maxClients  Most consumers connected at once (1 .. FRAME_MEMFD_MAX_CLIENTS).
+	\param holdLimit   Most buffers one consumer can hold (not released) at a time.
+
+	\return Error status
+		0   = Success
+*/
+int FrameMemfd_Create( FRAME_MEMFD_SERVER *srv, const char *path, int maxClients, int holdLimit)
+{
+	struct sockaddr_un addr;
+	int i;
+
+	if ((srv == NULL) || (path == NULL))
+	{
+		return FRAMEMEMFD_ERROR_NULL_PTR;
+	}
+	memset(srv, 0, sizeof(FRAME_MEMFD_SERVER));
+	srv->listenFd = -1;
+	if ((strlen(path) == 0) || (strlen(path) >= sizeof(srv->path)) ||
+		 (maxClients < 1) || (maxClients > FRAME_MEMFD_MAX_CLIENTS) || (holdLimit < 1))
+	{
+		return FRAMEMEMFD_ERROR_PARAMETER;
+	}
+	strcpy(srv->path, path);
+	srv->maxClients = maxClients;
+	srv->holdLimit = holdLimit;
+	for (i = 0; i < FRAME_MEMFD_MAX_CLIENTS; i++)
+	{
+		srv->clients[i].fd = -1;
+	}
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	strcpy(addr.sun_path, path);
+	unlink(path);
+	srv->listenFd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	if ((srv->listenFd < 0) ||
+		 (bind(srv->listenFd, (struct sockaddr *)&addr, sizeof(addr)) != 0) ||
+		 (listen(srv->listenFd, maxClients) != 0))
+	{
+		int err = errno;
+		FrameMemfd_Destroy(srv);
+		errno = err;
+		return FRAMEMEMFD_ERROR_SOCKET;
+	}
+	return 0;
+}
+
+// !
+// FrameMemfd_AllocBuffer
+//
+/*!
+	Allocate a shareable (memfd backed, page aligned) buffer.
+
+	Buffers must all be allocated before consumers connect (the descriptors are
+	only passed once, when a consumer connects).
+
+	\param size     Bytes needed (rounded up to the page size).
+	\param address  Returns the address of the buffer in this process.
+
+	\return Buffer index (>= 0) or an error status (< 0).
+*/
+int FrameMemfd_AllocBuffer( FRAME_MEMFD_SERVER *srv, size_t size, void **address)
+{
+	FRAME_MEMFD_BUFFER *buffer = NULL;
+	size_t page = (size_t)sysconf(_SC_PAGESIZE);
+	char name[32];
+
+	if ((srv == NULL) || (address == NULL))
+	{
+		return FRAMEMEMFD_ERROR_NULL_PTR;
+	}
+	if (size == 0)
+	{
+		return FRAMEMEMFD_ERROR_PARAMETER;
+	}
+	if (srv->numBuffers >= FRAME_MEMFD_MAX_BUFFERS)
+	{
+		return FRAMEMEMFD_ERROR_TOO_MANY;
+	}
+	buffer = &srv->buffers[srv->numBuffers];
+	memset(buffer, 0, sizeof(FRAME_MEMFD_BUFFER));
+	buffer->size = ((size + page - 1) / page) * page;
+
+	snprintf(name, sizeof(name), "genicam_buf%d", srv->numBuffers);
+	buffer->fd = memfd_create(name, MFD_CLOEXEC | MFD_ALLOW_SEALING);
+	if (buffer->fd < 0)
+	{
+		return FRAMEMEMFD_ERROR_MEMFD;
+	}
+	if (ftruncate(buffer->fd, buffer->size) != 0)
+	{
+		close(buffer->fd);
+		return FRAMEMEMFD_ERROR_MEMFD;
+	}
+	fcntl(buffer->fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL);
+	buffer->address = mmap(NULL, buffer->size, PROT_READ | PROT_WRITE, MAP_SHARED, buffer->fd, 0);
+	if (buffer->address == MAP_FAILED)
+	{
+		buffer->address = NULL;
+		close(buffer->fd);
+		return FRAMEMEMFD_ERROR_MEMFD;
+	}
+	*address = buffer->address;
+	return srv->numBuffers++;
+}
+
+// Index of the buffer at "address" (eg. a GEV image buffer), -1 if it is not shareable.
+int FrameMemfd_FindBuffer( FRAME_MEMFD_SERVER *srv, const void *address)
+{
+	int i;
+
+	if (srv != NULL)
+	{
+		for (i = 0; i < srv->numBuffers; i++)
+		{
+			if (srv->buffers[i].address == address)
+			{
+				return i;
+			}
+		}
+	}
+	return -1;
+}
+
+void *FrameMemfd_BufferAddress( FRAME_MEMFD_SERVER *srv, int index)
+{
+	if ((srv == NULL) || (index < 0) || (index >= srv->numBuffers))
+	{
+		return NULL;
+	}
+	return srv->buffers[index].address;
+}
+
+// !
+// FrameMemfd_GetFreeBuffer
+//
+/*!
+	Find a buffer in [first, first + count) that no consumer holds (and that
+	nobody claimed).
+
+	\return Buffer index, or FRAMEMEMFD_ERROR_BUSY if they are all held.
+*/
+int FrameMemfd_GetFreeBuffer( FRAME_MEMFD_SERVER *srv, int first, int count)
+{
+	int i;
+
+	if (srv == NULL)
+	{
+		return FRAMEMEMFD_ERROR_NULL_PTR;
+	}
+	for (i = first; (i < (first + count)) && (i < srv->numBuffers); i++)
+	{
+		if ((srv->buffers[i].holders == 0) && !srv->buffers[i].pending && !srv->buffers[i].claimed)
+		{
+			return i;
+		}
+	}
+	return FRAMEMEMFD_ERROR_BUSY;
+}
+
+// !
+// FrameMemfd_ClaimBuffer
+//
+/*!
+	Find a free buffer (as FrameMemfd_GetFreeBuffer) and keep it for the
+	caller : it is not handed out again until the caller publishes it, so it
+	can be written outside of whatever lock serializes the server.
+
+	\return Buffer index, or FRAMEMEMFD_ERROR_BUSY if they are all held.
+*/
+int FrameMemfd_ClaimBuffer( FRAME_MEMFD_SERVER *srv, int first, int count)
+{
+	int index = FrameMemfd_GetFreeBuffer( srv, first, count);
+
+	if (index >= 0)
+	{
+		srv->buffers[index].claimed = 1;
+	}
+	return index;
+}
+
+// !
+// FrameMemfd_Poll
+//
+/*!
+	Accept new consumers and process the releases sent by connected ones.
+	Never blocks - call it regularly from the thread that publishes the frames.
+
+	\return Number of connected consumers.
+*/
+int FrameMemfd_Poll( FRAME_MEMFD_SERVER *srv)
+{
+	int fd;
+	int i;
+
+	if ((srv == NULL) || (srv->listenFd < 0))
+	{
+		return 0;
+	}
+	while ((fd = accept4(srv->listenFd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0)
+	{
+		for (i = 0; i < srv->maxClients; i++)
+		{
+			if (srv->clients[i].fd < 0)
+			{
+				break;
+			}
+		}
+		if ((i == srv->maxClients) || (_SendHello( srv, fd) != 0))
+		{
+			close(fd);
+			continue;
+		}
+		memset(&srv->clients[i], 0, sizeof(FRAME_MEMFD_CLIENT));
+		srv->clients[i].fd = fd;
+		srv->clients[i].id = ++srv->connections;
+		srv->numClients++;
+	}
+
+	for (i = 0; i < srv->maxClients; i++)
+	{
+		FRAME_MEMFD_CLIENT *client = &srv->clients[i];
+		FRAME_MEMFD_RELEASE release;
+		ssize_t n = -1;
+
+		while ((client->fd >= 0) && ((n = recv(client->fd, &release, sizeof(release), MSG_DONTWAIT)) != 0))
+		{
+			if (n < 0)
+			{
+				if ((errno != EAGAIN) && (errno != EWOULDBLOCK) && (errno != EINTR))
+				{
+					_DropClient( srv, i);
+				}
+				break;
+			}
+			if ((n == sizeof(release)) && (release.magic == FRAME_MEMFD_RELEASE_MAGIC) &&
+				 (release.buffer < (uint32_t)srv->numBuffers))
+			{
+				FRAME_MEMFD_BUFFER *buffer = &srv->buffers[release.buffer];
+				// Stale / duplicate releases (sequence mismatch) are ignored.
+				if ((buffer->sequence == release.sequence) && (buffer->holders & (1u << i)))
+				{
+					buffer->holders &= ~(1u << i);
+					client->held--;
+					client->released++;
+				}
+			}
+		}
+		if ((client->fd >= 0) && (n == 0))
+		{
+			// Consumer went away - everything it held is released.
+			_DropClient( srv, i);
+		}
+	}
+	return srv->numClients;
+}
+
+// !
+// FrameMemfd_Publish
+//
+/*!
+	Tell the consumers that buffer "index" holds a new frame.
+
+	\param index      Buffer holding the frame (must not be held by anyone).
+	\param header     Frame header (FRAME_HEADER) sent in the notice (up to 64 bytes).
+	\param offset     Offset of the payload in the buffer.
+	\param cookie     Caller's handle for the buffer, handed back by FrameMemfd_Reclaim once
+	                  every consumer has released it (NULL = nothing to reclaim).
+
+	\return
+		1   = At least one consumer holds the buffer now - do not modify / recycle it yet.
+		0   = Nobody took the frame - the buffer can be reused right away.
+		FRAMEMEMFD_ERROR_BUSY  The buffer is still held from an earlier frame.
+*/
+int FrameMemfd_Publish( FRAME_MEMFD_SERVER *srv, int index, const void *header, size_t headerLen, size_t offset, void *cookie)
+{
+	FRAME_MEMFD_BUFFER *buffer = NULL;
+	FRAME_MEMFD_NOTICE notice;
+	int i;
+
+	if ((srv == NULL) || (header == NULL))
+	{
+		return FRAMEMEMFD_ERROR_NULL_PTR;
+	}
+	if ((index < 0) || (index >= srv->numBuffers) || (headerLen > sizeof(notice.header)))
+	{
+		return FRAMEMEMFD_ERROR_PARAMETER;
+	}
+	buffer = &srv->buffers[index];
+	if ((buffer->holders != 0) || buffer->pending)
+	{
+		return FRAMEMEMFD_ERROR_BUSY;
+	}
+	buffer->claimed = 0;
+
+	memset(&notice, 0, sizeof(notice));
+	notice.magic = FRAME_MEMFD_NOTICE_MAGIC;
+	notice.buffer = index;
+	notice.sequence = ++srv->sequence;
+	notice.offset = offset;
+	notice.header_size = headerLen;
+	memcpy(notice.header, header, headerLen);
+	buffer->sequence = notice.sequence;
+
+	for (i = 0; i < srv->maxClients; i++)
+	{
+		FRAME_MEMFD_CLIENT *client = &srv->clients[i];
+
+		if (client->fd < 0)
+		{
+			continue;
+		}
+		if (client->held >= srv->holdLimit)
+		{
+			client->dropped++;
+			continue;
+		}
+		if (send(client->fd, &notice, sizeof(notice), MSG_NOSIGNAL | MSG_DONTWAIT) == (ssize_t)sizeof(notice))
+		{
+			buffer->holders |= (1u << i);
+			client->held++;
+			client->notified++;
+		}
+		else if ((errno == EAGAIN) || (errno == EWOULDBLOCK))
+		{
+			client->dropped++;
+		}
+		else
+		{
+			_DropClient( srv, i);
+		}
+	}
+
+	if (buffer->holders != 0)
+	{
+		buffer->pending = (cookie != NULL);
+		buffer->cookie = cookie;
+		return 1;
+	}
+	return 0;
+}
+
+// !
+// FrameMemfd_Reclaim
+//
+/*!
+	Get back the cookie of a published buffer that every consumer has released.
+
+	\return 1 if *cookie was set (buffer can be recycled), 0 if nothing can be reclaimed yet.
+*/
+int FrameMemfd_Reclaim( FRAME_MEMFD_SERVER *srv, void **cookie)
+{
+	int i;
+
+	if ((srv == NULL) || (cookie == NULL))
+	{
+		return 0;
+	}
+	for (i = 0; i < srv->numBuffers; i++)
+	{
+		if (srv->buffers[i].pending && (srv->buffers[i].holders == 0))
+		{
+			*cookie = srv->buffers[i].cookie;
+			srv->buffers[i].cookie = NULL;
+			srv->buffers[i].pending = 0;
+			return 1;
+		}
+	}
+	return 0;
+}
+
+int FrameMemfd_PendingCount( FRAME_MEMFD_SERVER *srv)
+{
+	int i;
+	int count = 0;
+
+	if (srv != NULL)
+	{
+		for (i = 0; i < srv->numBuffers; i++)
+		{
+			count += (srv->buffers[i].pending) ? 1 : 0;
+		}
+	}
+	return count;
+}
+
+void FrameMemfd_PrintStats( FRAME_MEMFD_SERVER *srv, const char *label)
+{
+	int i;
+
+	if (srv == NULL)
+	{
+		return;
+	}
+	fprintf(stderr, "%s: %llu frames published, %d buffers, %d consumer(s)\n",
+			(label != NULL) ? label : "memfd", (unsigned long long)srv->sequence, srv->numBuffers, srv->numClients);
+	for (i = 0; i < srv->maxClients; i++)
+	{
+		FRAME_MEMFD_CLIENT *client = &srv->clients[i];
+		if (client->fd >= 0)
+		{
+			fprintf(stderr, "  client %u : holding %d, %llu sent, %llu released, %llu dropped\n",
+					client->id, client->held, (unsigned long long)client->notified,
+					(unsigned long long)client->released, (unsigned long long)client->dropped);
+		}
+	}
+}
+
+// !
+// FrameMemfd_Destroy
+//
+/*!
+	Disconnect all consumers, unmap the buffers and remove the socket file.
+	(Consumers that still have the buffers mapped keep their mappings).
+*/
+void FrameMemfd_Destroy( FRAME_MEMFD_SERVER *srv)
+{
+	int i;
+
+	if (srv == NULL)
+	{
+		return;
+	}
+	for (i = 0; i < srv->maxClients; i++)
+	{
+		if (srv->clients[i].fd >= 0)
+		{
+			_DropClient( srv, i);
+		}
+	}
+	for (i = 0; i < srv->numBuffers; i++)
+	{
+		munmap(srv->buffers[i].address, srv->buffers[i].size);
+		close(srv->buffers[i].fd);
+	}
+	srv->numBuffers = 0;
+	if (srv->listenFd >= 0)
+	{
+		close(srv->listenFd);
+		srv->listenFd = -1;
+		unlink(srv->path);
+	}
+}
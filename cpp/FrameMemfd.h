@@ -0,0 +1,132 @@
+#ifndef __FRAME_MEMFD_H__
+#define __FRAME_MEMFD_H__
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <sys/un.h>
+
+//=============================================================================
+// memfd frame buffer sharing.
+//
+// Frame buffers are allocated from memfd_create regions. Consumers connect
+// to a SOCK_SEQPACKET Unix domain socket and get the descriptors of all the
+// buffers once, with SCM_RIGHTS, in a FRAME_MEMFD_HELLO message. They mmap
+// those descriptors and so see the same physical pages as genicam. After
+// that, every frame is a small FRAME_MEMFD_NOTICE message (buffer index,
+// offset and frame header) - the per-frame IPC cost does not depend on the
+// image size.
+//
+// A consumer owns the buffer named in a notice until it sends back a
+// FRAME_MEMFD_RELEASE for it. A buffer is only reused when every consumer it
+// was sent to has released it. Each consumer can hold at most "holdLimit"
+// buffers : frames published while it is at the limit (or while its socket
+// is full) are dropped for that consumer only, so a stuck consumer cannot
+// take all the buffers away from the camera.
+//
+// Buffers are sealed against resizing (F_SEAL_SHRINK / F_SEAL_GROW), so a
+// consumer can trust the size it maps.
+//
+
+#define FRAME_MEMFD_MAX_BUFFERS		32
+#define FRAME_MEMFD_MAX_CLIENTS		16
+
+#define FRAME_MEMFD_VERSION				1
+#define FRAME_MEMFD_HELLO_MAGIC			0x484D5647	// "GVMH"
+#define FRAME_MEMFD_NOTICE_MAGIC		0x4E4D5647	// "GVMN"
+#define FRAME_MEMFD_RELEASE_MAGIC		0x524D5647	// "GVMR"
+
+#define FRAMEMEMFD_ERROR_NULL_PTR		-1500 // A pointer passed in is NULL.
+#define FRAMEMEMFD_ERROR_PARAMETER		-1501 // Invalid path, client count, size or buffer index.
+#define FRAMEMEMFD_ERROR_SOCKET			-1502 // socket/bind/listen failed (see errno).
+#define FRAMEMEMFD_ERROR_MEMFD			-1503 // memfd_create/ftruncate/mmap failed (see errno).
+#define FRAMEMEMFD_ERROR_TOO_MANY		-1504 // All FRAME_MEMFD_MAX_BUFFERS buffers are allocated.
+#define FRAMEMEMFD_ERROR_BUSY			-1505 // The buffer is still held by a consumer.
+
+// Sent once to each consumer when it connects (with one descriptor per buffer, in order).
+typedef struct FRAME_MEMFD_HELLO_t
+{
+	uint32_t	magic;				// FRAME_MEMFD_HELLO_MAGIC
+	uint32_t	version;				// FRAME_MEMFD_VERSION
+	uint32_t	num_buffers;		// Number of descriptors passed.
+	uint32_t	reserved;
+	uint64_t	buffer_size[FRAME_MEMFD_MAX_BUFFERS];	// Mappable size of each buffer.
+} FRAME_MEMFD_HELLO;
+
+// Sent for every frame.
+typedef struct FRAME_MEMFD_NOTICE_t
+{
+	uint32_t	magic;				// FRAME_MEMFD_NOTICE_MAGIC
+	uint32_t	buffer;				// Buffer index (order of the descriptors in the hello).
+	uint64_t	sequence;			// Publish number - echoed back in the release.
+	uint64_t	offset;				// Offset of the payload in the buffer.
+	uint32_t	header_size;		// Valid bytes in header.
+	uint32_t	reserved;
+	unsigned char	header[64];	// Frame header (FRAME_HEADER) describing the payload.
+} FRAME_MEMFD_NOTICE;
+
+// Sent back by a consumer when it is done with a frame.
+typedef struct FRAME_MEMFD_RELEASE_t
+{
+	uint32_t	magic;				// FRAME_MEMFD_RELEASE_MAGIC
+	uint32_t	buffer;
+	uint64_t	sequence;
+} FRAME_MEMFD_RELEASE;
+
+typedef struct FRAME_MEMFD_BUFFER_t
+{
+	int		fd;
+	void		*address;
+	size_t	size;
+	uint32_t	holders;				// Bit mask of the consumers holding the buffer.
+	int		pending;				// Published with a cookie that was not reclaimed yet.
+	int		claimed;				// Being written by the thread that claimed it, until it publishes it.
+	uint64_t	sequence;
+	void		*cookie;
+} FRAME_MEMFD_BUFFER;
+
+typedef struct FRAME_MEMFD_CLIENT_t
+{
+	int		fd;					// -1 = slot not in use.
+	uint32_t	id;					// Connection number.
+	int		held;					// Buffers held right now.
+	uint64_t	notified;			// Frames sent.
+	uint64_t	dropped;				// Frames skipped (at the hold limit / socket full).
+	uint64_t	released;
+} FRAME_MEMFD_CLIENT;
+
+typedef struct FRAME_MEMFD_SERVER_t
+{
+	int		listenFd;
+	int		maxClients;
+	int		holdLimit;
+	int		numClients;
+	int		numBuffers;
+	uint32_t	connections;
+	uint64_t	sequence;
+	char		path[sizeof(((struct sockaddr_un *)0)->sun_path)];
+	FRAME_MEMFD_BUFFER	buffers[FRAME_MEMFD_MAX_BUFFERS];
+	FRAME_MEMFD_CLIENT	clients[FRAME_MEMFD_MAX_CLIENTS];
+} FRAME_MEMFD_SERVER, *PFRAME_MEMFD_SERVER;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int FrameMemfd_Create( FRAME_MEMFD_SERVER *srv, const char *path, int maxClients, int holdLimit);
+int FrameMemfd_AllocBuffer( FRAME_MEMFD_SERVER *srv, size_t size, void **address);
+int FrameMemfd_FindBuffer( FRAME_MEMFD_SERVER *srv, const void *address);
+void *FrameMemfd_BufferAddress( FRAME_MEMFD_SERVER *srv, int index);
+int FrameMemfd_GetFreeBuffer( FRAME_MEMFD_SERVER *srv, int first, int count);
+int FrameMemfd_ClaimBuffer( FRAME_MEMFD_SERVER *srv, int first, int count);
+int FrameMemfd_Poll( FRAME_MEMFD_SERVER *srv);
+int FrameMemfd_Publish( FRAME_MEMFD_SERVER *srv, int index, const void *header, size_t headerLen, size_t offset, void *cookie);
+int FrameMemfd_Reclaim( FRAME_MEMFD_SERVER *srv, void **cookie);
+int FrameMemfd_PendingCount( FRAME_MEMFD_SERVER *srv);
+void FrameMemfd_PrintStats( FRAME_MEMFD_SERVER *srv, const char *label);
+void FrameMemfd_Destroy( FRAME_MEMFD_SERVER *srv);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
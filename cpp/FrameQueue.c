@@ -0,0 +1,403 @@
+/*
+  ---------------------------------------------
+  Bounded frame queue with backpressure policies
+  -----------------------------------------------
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "FrameQueue.h"
+#include "AcqStats.h"
+
+static const char *s_policyNames[] = { "block", "drop-newest", "drop-oldest", "latest" };
+
+static inline uint64_t _ns_now( void )
+{
+	struct timespec ts;
+	clock_gettime( CLOCK_MONOTONIC, &ts);
+	return ((uint64_t)ts.tv_sec * 1000000000ULL) + (uint64_t)ts.tv_nsec;
+}
+
+// Count a dropped frame and log its id (q->lock held).
+static void _LogDrop( FRAME_QUEUE *q, uint64_t frameId)
+{
+	q->stats.dropped++;
+	if (q->stats.numLogged == FRAME_QUEUE_DROP_LOG)
+	{
+		memmove(&q->stats.droppedIds[0], &q->stats.droppedIds[1], (FRAME_QUEUE_DROP_LOG - 1) * sizeof(uint64_t));
+		q->stats.numLogged--;
+	}
+	q->stats.droppedIds[q->stats.numLogged++] = frameId;
+}
+
+// Let go of the caller's buffer held by an entry (if any).
+static void _ReleaseRef( FRAME_QUEUE_ENTRY *entry)
+{
+	if (entry->ref != NULL)
+	{
+		entry->release( entry->ref);
+		entry->ref = NULL;
+	}
+}
+
+// Drop the oldest queued frame (q->lock held).
+static void _DropOldest( FRAME_QUEUE *q)
+{
+	FRAME_QUEUE_ENTRY *entry = q->queue[q->head];
+
+	q->queue[q->head] = NULL;
+	q->head = (q->head + 1) % FRAME_QUEUE_MAX_DEPTH;
+	q->count--;
+	_LogDrop( q, entry->frameId);
+	_ReleaseRef( entry);
+	entry->next = q->freeList;
+	q->freeList = entry;
+}
+
+// !
+// FrameQueue_Create
+//
+/*!
+	Create a frame queue.
+
+	\param q             Queue object to initialize.
+	\param depth         Frames that can be queued (1 .. FRAME_QUEUE_MAX_DEPTH).
+	\param maxFrameSize  Largest frame (header + payload) that will be pushed.
+	\param policy        What to do when the queue is full.
+
+	\return Error status
+		0   = Success
+*/
+int FrameQueue_Create( FRAME_QUEUE *q, int depth, size_t maxFrameSize, FRAME_QUEUE_POLICY policy)
+{
+	int i;
+
+	if (q == NULL)
+	{
+		return FRAMEQUEUE_ERROR_NULL_PTR;
+	}
+	memset(q, 0, sizeof(FRAME_QUEUE));
+	if ((depth < 1) || (depth > FRAME_QUEUE_MAX_DEPTH) || (maxFrameSize == 0) ||
+		 (policy < FRAME_QUEUE_BLOCK) || (policy > FRAME_QUEUE_LATEST_ONLY))
+	{
+		return FRAMEQUEUE_ERROR_PARAMETER;
+	}
+	q->policy = policy;
+	q->depth = (policy == FRAME_QUEUE_LATEST_ONLY) ? 1 : depth;
+	// One entry per queued frame, plus the one being written out and the one being filled.
+	q->numEntries = q->depth + 2;
+	q->entrySize = (maxFrameSize + 63) & ~(size_t)63;
+	q->entries = (FRAME_QUEUE_ENTRY *)calloc(q->numEntries, sizeof(FRAME_QUEUE_ENTRY));
+	q->memory = (unsigned char *)malloc(q->numEntries * q->entrySize);
+	if ((q->entries == NULL) || (q->memory == NULL))
+	{
+		free(q->entries);
+		free(q->memory);
+		memset(q, 0, sizeof(FRAME_QUEUE));
+		return FRAMEQUEUE_ERROR_NO_MEMORY;
+	}
+	for (i = 0; i < q->numEntries; i++)
+	{
+		q->entries[i].data = q->memory + (i * q->entrySize);
+		q->entries[i].next = q->freeList;
+		q->freeList = &q->entries[i];
+	}
+	pthread_mutex_init(&q->lock, NULL);
+	pthread_cond_init(&q->notEmpty, NULL);
+	pthread_cond_init(&q->notFull, NULL);
+	return 0;
+}
+
+// Policy from its name ("block", "drop-newest", "drop-oldest", "latest"), -1 if unknown.
+int FrameQueue_ParsePolicy( const char *name)
+{
+	int i;
+
+	if (name != NULL)
+	{
+		for (i = 0; i < (int)(sizeof(s_policyNames) / sizeof(s_policyNames[0])); i++)
+		{
+			if (strcmp(name, s_policyNames[i]) == 0)
+			{
+				return i;
+			}
+		}
+	}
+	return -1;
+}
+
+const char *FrameQueue_PolicyName( FRAME_QUEUE_POLICY policy)
+{
+	return ((policy >= FRAME_QUEUE_BLOCK) && (policy <= FRAME_QUEUE_LATEST_ONLY)) ? s_policyNames[policy] : "unknown";
+}
+
+// Queue a frame, copied (ref == NULL) or by reference.
+static int _Push( FRAME_QUEUE *q, uint64_t frameId, const void *header, size_t headerLen, const void *data, size_t length, void *ref, void (*release)(void *))
+{
+	FRAME_QUEUE_ENTRY *entry = NULL;
+
+	if ((headerLen + ((ref == NULL) ? length : 0)) > q->entrySize)
+	{
+		return FRAMEQUEUE_ERROR_TOO_BIG;
+	}
+
+	pthread_mutex_lock(&q->lock);
+	q->stats.pushed++;
+	// (Same rule as the acquisition statistics : 16 bit ids wrap, a restart is not a gap).
+	q->stats.missed += AcqStats_IdGap( q->lastId, frameId);
+	if (frameId != 0)
+	{
+		q->lastId = frameId;
+	}
+
+	if (q->count >= q->depth)
+	{
+		switch (q->policy)
+		{
+			case FRAME_QUEUE_BLOCK:
+				{
+					uint64_t start = _ns_now();
+					q->stats.blocked++;
+					while ((q->count >= q->depth) && !q->shutdown)
+					{
+						pthread_cond_wait(&q->notFull, &q->lock);
+					}
+					q->stats.nsBlocked += _ns_now() - start;
+				}
+				break;
+			case FRAME_QUEUE_DROP_NEWEST:
+				_LogDrop( q, frameId);
+				pthread_mutex_unlock(&q->lock);
+				if (ref != NULL)
+				{
+					release( ref);
+				}
+				return 1;
+			case FRAME_QUEUE_DROP_OLDEST:
+				_DropOldest( q);
+				break;
+			default:
+				// FRAME_QUEUE_LATEST_ONLY : queued frames are replaced when the new one is in.
+				break;
+		}
+	}
+	if (q->shutdown)
+	{
+		pthread_mutex_unlock(&q->lock);
+		if (ref != NULL)
+		{
+			release( ref);
+		}
+		return FRAMEQUEUE_ERROR_SHUTDOWN;
+	}
+	entry = q->freeList;
+	q->freeList = entry->next;
+	pthread_mutex_unlock(&q->lock);
+
+	// Copy without the lock - the entry belongs to this thread until it is queued.
+	entry->next = NULL;
+	entry->frameId = frameId;
+	entry->headerLen = headerLen;
+	entry->length = length;
+	entry->ref = ref;
+	entry->release = release;
+	memcpy(entry->data, header, headerLen);
+	if (ref == NULL)
+	{
+		memcpy(entry->data + headerLen, data, length);
+		entry->payload = entry->data + headerLen;
+	}
+	else
+	{
+		entry->payload = (const unsigned char *)data;
+	}
+
+	pthread_mutex_lock(&q->lock);
+	if (q->policy == FRAME_QUEUE_LATEST_ONLY)
+	{
+		while (q->count > 0)
+		{
+			_DropOldest( q);
+		}
+	}
+	q->queue[(q->head + q->count) % FRAME_QUEUE_MAX_DEPTH] = entry;
+	q->count++;
+	if ((uint32_t)q->count > q->stats.maxDepth)
+	{
+		q->stats.maxDepth = q->count;
+	}
+	pthread_cond_signal(&q->notEmpty);
+	pthread_mutex_unlock(&q->lock);
+	return 0;
+}
+
+// !
+// FrameQueue_Push
+//
+/*!
+	Copy a frame (header + data) into the queue, applying the backpressure policy.
+
+	Only FRAME_QUEUE_BLOCK ever waits. The caller's buffers can be reused as soon
+	as this returns.
+
+	\return
+		0   = Frame queued.
+		1   = Frame dropped (FRAME_QUEUE_DROP_NEWEST with a full queue).
+		FRAMEQUEUE_ERROR_TOO_BIG   The frame does not fit in an entry.
+		FRAMEQUEUE_ERROR_SHUTDOWN  The queue was shut down.
+*/
+int FrameQueue_Push( FRAME_QUEUE *q, uint64_t frameId, const void *header, size_t headerLen, const void *data, size_t length)
+{
+	if ((q == NULL) || (header == NULL) || (data == NULL))
+	{
+		return FRAMEQUEUE_ERROR_NULL_PTR;
+	}
+	return _Push( q, frameId, header, headerLen, data, length, NULL, NULL);
+}
+
+// !
+// FrameQueue_PushRef
+//
+/*!
+	Queue a frame without copying its data : the queue takes over the caller's
+	reference "ref" on the buffer and calls release(ref) once the frame has been
+	written (FrameQueue_Done) or dropped - whatever this returns. The data must
+	stay valid until then.
+
+	\return As FrameQueue_Push.
+*/
+int FrameQueue_PushRef( FRAME_QUEUE *q, uint64_t frameId, const void *header, size_t headerLen, const void *data, size_t length, void *ref, void (*release)(void *))
+{
+	if ((q == NULL) || (header == NULL) || (data == NULL) || (ref == NULL) || (release == NULL))
+	{
+		if ((ref != NULL) && (release != NULL))
+		{
+			release( ref);
+		}
+		return FRAMEQUEUE_ERROR_NULL_PTR;
+	}
+	return _Push( q, frameId, header, headerLen, data, length, ref, release);
+}
+
+// !
+// FrameQueue_Pop
+//
+/*!
+	Wait for the next frame.
+
+	\return The oldest queued entry (give it back with FrameQueue_Done), or NULL
+	        once the queue has been shut down.
+*/
+FRAME_QUEUE_ENTRY *FrameQueue_Pop( FRAME_QUEUE *q)
+{
+	FRAME_QUEUE_ENTRY *entry = NULL;
+
+	if (q == NULL)
+	{
+		return NULL;
+	}
+	pthread_mutex_lock(&q->lock);
+	while ((q->count == 0) && !q->shutdown)
+	{
+		pthread_cond_wait(&q->notEmpty, &q->lock);
+	}
+	if (q->count > 0)
+	{
+		entry = q->queue[q->head];
+		q->queue[q->head] = NULL;
+		q->head = (q->head + 1) % FRAME_QUEUE_MAX_DEPTH;
+		q->count--;
+		q->stats.written++;
+		pthread_cond_signal(&q->notFull);
+	}
+	pthread_mutex_unlock(&q->lock);
+	return entry;
+}
+
+// Give back an entry taken with FrameQueue_Pop (and the buffer it referenced).
+void FrameQueue_Done( FRAME_QUEUE *q, FRAME_QUEUE_ENTRY *entry)
+{
+	if ((q != NULL) && (entry != NULL))
+	{
+		_ReleaseRef( entry);
+		pthread_mutex_lock(&q->lock);
+		entry->next = q->freeList;
+		q->freeList = entry;
+		pthread_mutex_unlock(&q->lock);
+	}
+}
+
+void FrameQueue_GetStats( FRAME_QUEUE *q, FRAME_QUEUE_STATS *stats)
+{
+	if ((q != NULL) && (stats != NULL))
+	{
+		pthread_mutex_lock(&q->lock);
+		*stats = q->stats;
+		pthread_mutex_unlock(&q->lock);
+	}
+}
+
+void FrameQueue_PrintStats( FRAME_QUEUE *q, const char *label)
+{
+	FRAME_QUEUE_STATS stats;
+	uint32_t i;
+
+	if ((q == NULL) || (q->entries == NULL))
+	{
+		return;
+	}
+	FrameQueue_GetStats( q, &stats);
+	fprintf(stderr, "%s (%s, depth %d): %llu pushed, %llu written, %llu dropped, %llu missed upstream, max depth %u",
+			(label != NULL) ? label : "queue", FrameQueue_PolicyName(q->policy), q->depth,
+			(unsigned long long)stats.pushed, (unsigned long long)stats.written,
+			(unsigned long long)stats.dropped, (unsigned long long)stats.missed, stats.maxDepth);
+	if (stats.blocked > 0)
+	{
+		fprintf(stderr, ", blocked %llu times (%.1f ms)", (unsigned long long)stats.blocked, (double)stats.nsBlocked / 1e6);
+	}
+	fprintf(stderr, "\n");
+	if (stats.numLogged > 0)
+	{
+		fprintf(stderr, "  last dropped frame ids :");
+		for (i = 0; i < stats.numLogged; i++)
+		{
+			fprintf(stderr, " %llu", (unsigned long long)stats.droppedIds[i]);
+		}
+		fprintf(stderr, "\n");
+	}
+}
+
+// Wake up everything waiting on the queue - Pop returns NULL once it is empty.
+void FrameQueue_Shutdown( FRAME_QUEUE *q)
+{
+	if ((q != NULL) && (q->entries != NULL))
+	{
+		pthread_mutex_lock(&q->lock);
+		q->shutdown = 1;
+		pthread_cond_broadcast(&q->notEmpty);
+		pthread_cond_broadcast(&q->notFull);
+		pthread_mutex_unlock(&q->lock);
+	}
+}
+
+void FrameQueue_Destroy( FRAME_QUEUE *q)
+{
+	if ((q != NULL) && (q->entries != NULL))
+	{
+		// Frames never written still hold their buffers.
+		while (q->count > 0)
+		{
+			_ReleaseRef( q->queue[q->head]);
+			q->queue[q->head] = NULL;
+			q->head = (q->head + 1) % FRAME_QUEUE_MAX_DEPTH;
+			q->count--;
+		}
+		pthread_cond_destroy(&q->notFull);
+		pthread_cond_destroy(&q->notEmpty);
+		pthread_mutex_destroy(&q->lock);
+		free(q->memory);
+		free(q->entries);
+		memset(q, 0, sizeof(FRAME_QUEUE));
+	}
+}
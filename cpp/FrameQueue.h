@@ -0,0 +1,112 @@
+#ifndef __FRAME_QUEUE_H__
+#define __FRAME_QUEUE_H__
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+//=============================================================================
+// Bounded frame queue with a backpressure policy.
+//
+// Sits between the acquisition thread (FrameQueue_Push) and an output writer
+// thread (FrameQueue_Pop / FrameQueue_Done). Every frame is copied into one of
+// a fixed set of preallocated entries, so the acquisition buffer can go back
+// to the transfer right away - or, with FrameQueue_PushRef, only its header is
+// copied and the queue keeps a reference on the caller's buffer (eg. a frame
+// lease), released once the frame has been written or dropped. What happens
+// when the writer falls behind is the policy :
+//
+//	FRAME_QUEUE_BLOCK        Push waits for room - no frame is lost here (the
+//	                         acquisition thread stalls instead).
+//	FRAME_QUEUE_DROP_NEWEST  A frame that finds the queue full is dropped.
+//	FRAME_QUEUE_DROP_OLDEST  The oldest queued frame makes room for the new one.
+//	FRAME_QUEUE_LATEST_ONLY  Conflate : a new frame replaces everything still
+//	                         queued, the writer always gets the freshest frame.
+//
+// Every dropped frame is counted and its frame id logged. Gaps in the frame
+// ids pushed (frames lost before they reached the queue) are counted too.
+//
+
+#define FRAME_QUEUE_MAX_DEPTH		32
+#define FRAME_QUEUE_DROP_LOG		16		// Most recent dropped frame ids kept.
+
+#define FRAMEQUEUE_ERROR_NULL_PTR		-1600 // A pointer passed in is NULL.
+#define FRAMEQUEUE_ERROR_PARAMETER		-1601 // Invalid depth, size or policy.
+#define FRAMEQUEUE_ERROR_NO_MEMORY		-1602 // Entries could not be allocated.
+#define FRAMEQUEUE_ERROR_TOO_BIG		-1603 // Frame does not fit in an entry.
+#define FRAMEQUEUE_ERROR_SHUTDOWN		-1604 // The queue was shut down.
+
+typedef enum
+{
+	FRAME_QUEUE_BLOCK = 0,
+	FRAME_QUEUE_DROP_NEWEST,
+	FRAME_QUEUE_DROP_OLDEST,
+	FRAME_QUEUE_LATEST_ONLY
+} FRAME_QUEUE_POLICY;
+
+typedef struct FRAME_QUEUE_ENTRY_t
+{
+	struct FRAME_QUEUE_ENTRY_t	*next;	// Free list link.
+	uint64_t	frameId;
+	size_t	headerLen;				// Header bytes at the start of data.
+	size_t	length;					// Payload bytes.
+	unsigned char	*data;				// Header (and copied payload).
+	const unsigned char	*payload;	// The payload (after the header in data, or the caller's buffer).
+	void		*ref;						// Reference on the caller's buffer (NULL = payload copied) ...
+	void		(*release)(void *ref);	// ... and how to drop it.
+} FRAME_QUEUE_ENTRY;
+
+typedef struct FRAME_QUEUE_STATS_t
+{
+	uint64_t	pushed;				// Frames offered to the queue.
+	uint64_t	written;				// Frames taken by the writer.
+	uint64_t	dropped;				// Frames dropped by the policy.
+	uint64_t	missed;				// Frame ids skipped before the queue (gaps in the pushed ids).
+	uint64_t	blocked;				// Pushes that had to wait for room (FRAME_QUEUE_BLOCK).
+	uint64_t	nsBlocked;			// Time spent waiting for room.
+	uint32_t	maxDepth;			// Most frames ever queued.
+	uint32_t	numLogged;			// Valid entries in droppedIds.
+	uint64_t	droppedIds[FRAME_QUEUE_DROP_LOG];	// Most recent dropped frame ids (oldest first).
+} FRAME_QUEUE_STATS;
+
+typedef struct FRAME_QUEUE_t
+{
+	FRAME_QUEUE_POLICY	policy;
+	int		depth;
+	int		head;
+	int		count;
+	int		shutdown;
+	int		numEntries;
+	size_t	entrySize;
+	uint64_t	lastId;
+	FRAME_QUEUE_ENTRY		*queue[FRAME_QUEUE_MAX_DEPTH];
+	FRAME_QUEUE_ENTRY		*freeList;
+	FRAME_QUEUE_ENTRY		*entries;
+	unsigned char			*memory;
+	pthread_mutex_t		lock;
+	pthread_cond_t			notEmpty;
+	pthread_cond_t			notFull;
+	FRAME_QUEUE_STATS		stats;
+} FRAME_QUEUE, *PFRAME_QUEUE;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int FrameQueue_Create( FRAME_QUEUE *q, int depth, size_t maxFrameSize, FRAME_QUEUE_POLICY policy);
+int FrameQueue_ParsePolicy( const char *name);
+const char *FrameQueue_PolicyName( FRAME_QUEUE_POLICY policy);
+int FrameQueue_Push( FRAME_QUEUE *q, uint64_t frameId, const void *header, size_t headerLen, const void *data, size_t length);
+int FrameQueue_PushRef( FRAME_QUEUE *q, uint64_t frameId, const void *header, size_t headerLen, const void *data, size_t length, void *ref, void (*release)(void *));
+FRAME_QUEUE_ENTRY *FrameQueue_Pop( FRAME_QUEUE *q);
+void FrameQueue_Done( FRAME_QUEUE *q, FRAME_QUEUE_ENTRY *entry);
+void FrameQueue_GetStats( FRAME_QUEUE *q, FRAME_QUEUE_STATS *stats);
+void FrameQueue_PrintStats( FRAME_QUEUE *q, const char *label);
+void FrameQueue_Shutdown( FRAME_QUEUE *q);
+void FrameQueue_Destroy( FRAME_QUEUE *q);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,515 @@
+/*
+  ---------------------------------------------
+  Raw frame recordings
+  -----------------------------------------------
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include "FrameRecord.h"
+
+#ifndef TRUE
+#define TRUE	1
+#define FALSE	0
+#endif
+
+static inline uint64_t _ns_now( void )
+{
+	struct timespec ts;
+	clock_gettime( CLOCK_MONOTONIC, &ts);
+	return ((uint64_t)ts.tv_sec * 1000000000ULL) + (uint64_t)ts.tv_nsec;
+}
+
+// Write all of "length" bytes at "offset" (retrying short writes).
+static int _WriteAt( int fd, const void *data, size_t length, uint64_t offset)
+{
+	const char *p = (const char *)data;
+
+	while (length > 0)
+	{
+		ssize_t n = pwrite(fd, p, length, (off_t)offset);
+		if (n < 0)
+		{
+			if (errno == EINTR)
+			{
+				continue;
+			}
+			return -1;
+		}
+		p += n;
+		length -= (size_t)n;
+		offset += (uint64_t)n;
+	}
+	return 0;
+}
+
+static int _ReadAt( int fd, void *data, size_t length, uint64_t offset)
+{
+	char *p = (char *)data;
+
+	while (length > 0)
+	{
+		ssize_t n = pread(fd, p, length, (off_t)offset);
+		if (n <= 0)
+		{
+			if ((n < 0) && (errno == EINTR))
+			{
+				continue;
+			}
+			return -1;
+		}
+		p += n;
+		length -= (size_t)n;
+		offset += (uint64_t)n;
+	}
+	return 0;
+}
+
+static void _InitFileHeader( FRAME_RECORD_FILE *header, const char *magic)
+{
+	struct timeval tv;
+
+	gettimeofday(&tv, NULL);
+	memset(header, 0, sizeof(FRAME_RECORD_FILE));
+	memcpy(header->magic, magic, strlen(magic));
+	header->version = FRAME_RECORD_VERSION;
+	header->headerSize = sizeof(FRAME_RECORD_FILE);
+	header->createdUs = ((uint64_t)tv.tv_sec * 1000000ULL) + (uint64_t)tv.tv_usec;
+}
+
+// Drain the queue to the files : the record, then its index entry.
+// (If an index entry can't be written, no more are : the index stays a prefix of the recording
+// and FrameRecord_Open finds the rest).
+static void *_WriterThread( void *arg)
+{
+	FRAME_RECORDER *rec = (FRAME_RECORDER *)arg;
+	FRAME_QUEUE_ENTRY *entry = NULL;
+	int indexing = TRUE;
+
+	while ((entry = FrameQueue_Pop( &rec->queue)) != NULL)
+	{
+		if ((_WriteAt( rec->fd, entry->data, entry->headerLen, rec->offset) == 0) &&
+			 (_WriteAt( rec->fd, entry->payload, entry->length, rec->offset + entry->headerLen) == 0))
+		{
+			const FRAME_RECORD *record = (const FRAME_RECORD *)entry->data;
+			FRAME_RECORD_INDEX index;
+
+			index.offset = rec->offset;
+			index.hostNs = record->hostNs;
+			index.frameId = record->frameId;
+			index.length = record->length;
+			if (indexing && (write(rec->indexFd, &index, sizeof(index)) != sizeof(index)))
+			{
+				indexing = FALSE;
+			}
+			rec->offset += entry->headerLen + entry->length;
+			rec->stats.records++;
+			rec->stats.bytes += entry->headerLen + entry->length;
+		}
+		else
+		{
+			// (A partly written record is overwritten by the next one).
+			rec->stats.errors++;
+		}
+		FrameQueue_Done( &rec->queue, entry);
+	}
+	return NULL;
+}
+
+// !
+// FrameRecord_Create
+//
+/*!
+	Start a recording (<path> and <path>.idx are replaced if they exist).
+
+	\param depth         Frames queued for the writer thread.
+	\param maxFrameSize  Largest payload recorded.
+
+	\return Error status
+		0   = Success
+*/
+int FrameRecord_Create( FRAME_RECORDER *rec, const char *path, int depth, size_t maxFrameSize)
+{
+	FRAME_RECORD_FILE header;
+	char indexPath[sizeof(rec->path) + sizeof(FRAME_RECORD_INDEX_SUFFIX)];
+	int status = 0;
+
+	if ((rec == NULL) || (path == NULL))
+	{
+		return FRAMERECORD_ERROR_NULL_PTR;
+	}
+	memset(rec, 0, sizeof(FRAME_RECORDER));
+	rec->fd = -1;
+	rec->indexFd = -1;
+	if (strlen(path) >= sizeof(rec->path))
+	{
+		return FRAMERECORD_ERROR_FILE;
+	}
+	snprintf(indexPath, sizeof(indexPath), "%s%s", path, FRAME_RECORD_INDEX_SUFFIX);
+
+	rec->fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	rec->indexFd = open(indexPath, O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0644);
+	_InitFileHeader( &header, FRAME_RECORD_FILE_MAGIC);
+	if ((rec->fd < 0) || (rec->indexFd < 0) || (_WriteAt( rec->fd, &header, sizeof(header), 0) != 0))
+	{
+		status = FRAMERECORD_ERROR_FILE;
+	}
+	else
+	{
+		_InitFileHeader( &header, FRAME_RECORD_INDEX_MAGIC);
+		if (write(rec->indexFd, &header, sizeof(header)) != sizeof(header))
+		{
+			status = FRAMERECORD_ERROR_FILE;
+		}
+	}
+	if (status == 0)
+	{
+		status = FrameQueue_Create( &rec->queue, depth, sizeof(FRAME_RECORD) + maxFrameSize, FRAME_QUEUE_DROP_NEWEST);
+	}
+	if (status != 0)
+	{
+		if (rec->fd >= 0)
+		{
+			close(rec->fd);
+		}
+		if (rec->indexFd >= 0)
+		{
+			close(rec->indexFd);
+		}
+		rec->fd = -1;
+		rec->indexFd = -1;
+		return status;
+	}
+	rec->offset = sizeof(FRAME_RECORD_FILE);
+	snprintf(rec->path, sizeof(rec->path), "%s", path);
+	pthread_create(&rec->writer, NULL, _WriterThread, rec);
+	return 0;
+}
+
+// !
+// FrameRecord_Add
+//
+/*!
+	Queue a frame for the recording (copied - the buffer can be reused on return).
+	The magic and header size are filled in, and the arrival time if it is 0.
+
+	\return As FrameQueue_Push (0 = queued, 1 = dropped - the writer is behind).
+*/
+int FrameRecord_Add( FRAME_RECORDER *rec, FRAME_RECORD *record, const void *data)
+{
+	if ((rec == NULL) || (record == NULL) || (data == NULL))
+	{
+		return FRAMERECORD_ERROR_NULL_PTR;
+	}
+	record->magic = FRAME_RECORD_MAGIC;
+	record->headerSize = sizeof(FRAME_RECORD);
+	if (record->hostNs == 0)
+	{
+		record->hostNs = _ns_now();
+	}
+	return FrameQueue_Push( &rec->queue, record->frameId, record, sizeof(FRAME_RECORD), data, record->length);
+}
+
+void FrameRecord_PrintStats( FRAME_RECORDER *rec, const char *label)
+{
+	FRAME_RECORDER_STATS stats;
+
+	if ((rec == NULL) || (rec->path[0] == '\0'))
+	{
+		return;
+	}
+	stats = rec->stats;
+	if (rec->fd >= 0)
+	{
+		// (Still recording).
+		FRAME_QUEUE_STATS queueStats;
+		FrameQueue_GetStats( &rec->queue, &queueStats);
+		stats.dropped = queueStats.dropped;
+	}
+	fprintf(stderr, "%s : %llu frames recorded (%.1f MB), %llu left out", (label != NULL) ? label : rec->path,
+			(unsigned long long)stats.records, (double)stats.bytes / (1024.0 * 1024.0), (unsigned long long)stats.dropped);
+	if (stats.errors > 0)
+	{
+		fprintf(stderr, ", %llu could not be written", (unsigned long long)stats.errors);
+	}
+	fprintf(stderr, "\n");
+}
+
+// Write out the frames still queued and close the recording (the statistics are kept).
+void FrameRecord_Destroy( FRAME_RECORDER *rec)
+{
+	FRAME_QUEUE_STATS queueStats;
+
+	if ((rec == NULL) || (rec->path[0] == '\0') || (rec->fd < 0))
+	{
+		return;
+	}
+	FrameQueue_Shutdown( &rec->queue);
+	pthread_join( rec->writer, NULL);
+	FrameQueue_GetStats( &rec->queue, &queueStats);
+	rec->stats.dropped = queueStats.dropped;
+	FrameQueue_Destroy( &rec->queue);
+	close(rec->fd);
+	close(rec->indexFd);
+	rec->fd = -1;
+	rec->indexFd = -1;
+}
+
+// Index entries for the records after "offset" that the index does not have yet (found by walking
+// the record headers, up to the last complete record). Returns how many (*entries is malloc'ed).
+static uint64_t _ScanRecords( FRAME_RECORDING *recording, uint64_t offset, FRAME_RECORD_INDEX **entries)
+{
+	uint64_t count = 0;
+	uint64_t capacity = 0;
+	FRAME_RECORD record;
+
+	*entries = NULL;
+	while ((offset + sizeof(FRAME_RECORD)) <= recording->size)
+	{
+		if ((_ReadAt( recording->fd, &record, sizeof(record), offset) != 0) || (record.magic != FRAME_RECORD_MAGIC) ||
+			 (record.headerSize < sizeof(FRAME_RECORD)) || ((offset + record.headerSize + record.length) > recording->size))
+		{
+			break;
+		}
+		if (count == capacity)
+		{
+			FRAME_RECORD_INDEX *grown = NULL;
+
+			capacity = (capacity == 0) ? 1024 : (capacity * 2);
+			grown = (FRAME_RECORD_INDEX *)realloc(*entries, capacity * sizeof(FRAME_RECORD_INDEX));
+			if (grown == NULL)
+			{
+				break;
+			}
+			*entries = grown;
+		}
+		(*entries)[count].offset = offset;
+		(*entries)[count].hostNs = record.hostNs;
+		(*entries)[count].frameId = record.frameId;
+		(*entries)[count].length = record.length;
+		count++;
+		offset += record.headerSize + record.length;
+	}
+	return count;
+}
+
+// !
+// FrameRecord_Open
+//
+/*!
+	Open a recording for reading (completing its index first if needed).
+
+	\return Error status
+		0   = Success
+*/
+int FrameRecord_Open( FRAME_RECORDING *recording, const char *path)
+{
+	char indexPath[512];
+	struct stat st;
+	FRAME_RECORD_FILE indexHeader;
+	FRAME_RECORD_INDEX *found = NULL;
+	uint64_t numFound = 0;
+	uint64_t indexed = 0;
+	uint64_t next = 0;
+	int indexFd = -1;
+	int writable = TRUE;
+
+	if ((recording == NULL) || (path == NULL))
+	{
+		return FRAMERECORD_ERROR_NULL_PTR;
+	}
+	memset(recording, 0, sizeof(FRAME_RECORDING));
+	recording->fd = open(path, O_RDONLY | O_CLOEXEC);
+	if ((recording->fd < 0) || (fstat(recording->fd, &st) != 0))
+	{
+		FrameRecord_Close( recording);
+		return FRAMERECORD_ERROR_FILE;
+	}
+	recording->size = (uint64_t)st.st_size;
+	if ((_ReadAt( recording->fd, &recording->header, sizeof(FRAME_RECORD_FILE), 0) != 0) ||
+		 (memcmp(recording->header.magic, FRAME_RECORD_FILE_MAGIC, sizeof(FRAME_RECORD_FILE_MAGIC)) != 0) ||
+		 (recording->header.version != FRAME_RECORD_VERSION))
+	{
+		FrameRecord_Close( recording);
+		return FRAMERECORD_ERROR_FORMAT;
+	}
+
+	// The index as it is (a missing or bad one is started again).
+	snprintf(indexPath, sizeof(indexPath), "%s%s", path, FRAME_RECORD_INDEX_SUFFIX);
+	indexFd = open(indexPath, O_RDWR | O_CLOEXEC);
+	if (indexFd < 0)
+	{
+		indexFd = open(indexPath, O_RDONLY | O_CLOEXEC);
+		writable = FALSE;
+	}
+	if ((indexFd >= 0) && (fstat(indexFd, &st) == 0) && ((uint64_t)st.st_size >= sizeof(FRAME_RECORD_FILE)) &&
+		 (_ReadAt( indexFd, &indexHeader, sizeof(indexHeader), 0) == 0) &&
+		 (memcmp(indexHeader.magic, FRAME_RECORD_INDEX_MAGIC, sizeof(FRAME_RECORD_INDEX_MAGIC)) == 0))
+	{
+		indexed = ((uint64_t)st.st_size - sizeof(FRAME_RECORD_FILE)) / sizeof(FRAME_RECORD_INDEX);
+	}
+	else
+	{
+		if (indexFd >= 0)
+		{
+			close(indexFd);
+		}
+		indexFd = open(indexPath, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+		writable = (indexFd >= 0);
+		_InitFileHeader( &indexHeader, FRAME_RECORD_INDEX_MAGIC);
+		if (writable && (_WriteAt( indexFd, &indexHeader, sizeof(indexHeader), 0) != 0))
+		{
+			writable = FALSE;
+		}
+		indexed = 0;
+	}
+
+	// Records written after the last index entry (the recorder stopped short).
+	next = recording->header.headerSize;
+	if (indexed > 0)
+	{
+		FRAME_RECORD_INDEX last;
+		if (_ReadAt( indexFd, &last, sizeof(last), sizeof(FRAME_RECORD_FILE) + ((indexed - 1) * sizeof(FRAME_RECORD_INDEX))) == 0)
+		{
+			next = last.offset + sizeof(FRAME_RECORD) + last.length;
+		}
+	}
+	numFound = _ScanRecords( recording, next, &found);
+	if ((numFound > 0) && writable)
+	{
+		uint64_t end = sizeof(FRAME_RECORD_FILE) + (indexed * sizeof(FRAME_RECORD_INDEX));
+		if ((ftruncate(indexFd, (off_t)end) == 0) && (_WriteAt( indexFd, found, numFound * sizeof(FRAME_RECORD_INDEX), end) == 0))
+		{
+			indexed += numFound;
+			numFound = 0;
+		}
+	}
+	recording->count = indexed + numFound;
+
+	if ((numFound == 0) && (indexed > 0))
+	{
+		// Complete in the file : map it.
+		recording->mappingSize = sizeof(FRAME_RECORD_FILE) + (indexed * sizeof(FRAME_RECORD_INDEX));
+		recording->mapping = mmap(NULL, recording->mappingSize, PROT_READ, MAP_SHARED, indexFd, 0);
+		if (recording->mapping == MAP_FAILED)
+		{
+			recording->mapping = NULL;
+		}
+		else
+		{
+			recording->index = (FRAME_RECORD_INDEX *)((char *)recording->mapping + sizeof(FRAME_RECORD_FILE));
+		}
+	}
+	if ((recording->index == NULL) && (recording->count > 0))
+	{
+		// (The index can't be completed in place - it is put together in memory).
+		recording->index = (FRAME_RECORD_INDEX *)malloc(recording->count * sizeof(FRAME_RECORD_INDEX));
+		if ((recording->index == NULL) ||
+			 ((indexed > 0) && (_ReadAt( indexFd, recording->index, indexed * sizeof(FRAME_RECORD_INDEX), sizeof(FRAME_RECORD_FILE)) != 0)))
+		{
+			free(recording->index);
+			recording->index = NULL;
+			recording->count = 0;
+		}
+		else if (numFound > 0)
+		{
+			memcpy(&recording->index[indexed], found, numFound * sizeof(FRAME_RECORD_INDEX));
+		}
+	}
+	free(found);
+	if (indexFd >= 0)
+	{
+		close(indexFd);
+	}
+	return 0;
+}
+
+uint64_t FrameRecord_Count( FRAME_RECORDING *recording)
+{
+	return (recording != NULL) ? recording->count : 0;
+}
+
+// First record that arrived at or after "hostNs" (FrameRecord_Count if none did).
+uint64_t FrameRecord_Find( FRAME_RECORDING *recording, uint64_t hostNs)
+{
+	uint64_t low = 0;
+	uint64_t high = FrameRecord_Count( recording);
+
+	while (low < high)
+	{
+		uint64_t mid = low + ((high - low) / 2);
+		if (recording->index[mid].hostNs < hostNs)
+		{
+			low = mid + 1;
+		}
+		else
+		{
+			high = mid;
+		}
+	}
+	return low;
+}
+
+// !
+// FrameRecord_Read
+//
+/*!
+	Read record n (0 based) : its header and up to "size" bytes of its payload.
+
+	\return The payload bytes read (less than record->length if the buffer is too small), < 0 error.
+*/
+int FrameRecord_Read( FRAME_RECORDING *recording, uint64_t n, FRAME_RECORD *record, void *buffer, size_t size)
+{
+	const FRAME_RECORD_INDEX *entry = NULL;
+	size_t length = 0;
+
+	if ((recording == NULL) || (record == NULL) || ((buffer == NULL) && (size > 0)))
+	{
+		return FRAMERECORD_ERROR_NULL_PTR;
+	}
+	if (n >= recording->count)
+	{
+		return FRAMERECORD_ERROR_RANGE;
+	}
+	entry = &recording->index[n];
+	if ((_ReadAt( recording->fd, record, sizeof(FRAME_RECORD), entry->offset) != 0) || (record->magic != FRAME_RECORD_MAGIC))
+	{
+		return FRAMERECORD_ERROR_FORMAT;
+	}
+	length = (record->length < size) ? (size_t)record->length : size;
+	if ((length > 0) && (_ReadAt( recording->fd, buffer, length, entry->offset + record->headerSize) != 0))
+	{
+		return FRAMERECORD_ERROR_FILE;
+	}
+	return (int)length;
+}
+
+void FrameRecord_Close( FRAME_RECORDING *recording)
+{
+	if (recording == NULL)
+	{
+		return;
+	}
+	if (recording->mapping != NULL)
+	{
+		munmap(recording->mapping, recording->mappingSize);
+	}
+	else
+	{
+		free(recording->index);
+	}
+	if (recording->fd >= 0)
+	{
+		close(recording->fd);
+	}
+	memset(recording, 0, sizeof(FRAME_RECORDING));
+	recording->fd = -1;
+}
@@ -0,0 +1,128 @@
+#ifndef __FRAME_RECORD_H__
+#define __FRAME_RECORD_H__
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include "FrameQueue.h"
+
+//=============================================================================
+// Raw frame recordings.
+//
+// A recording is the stream of buffers the transfer handed over, as they
+// came (complete or not) : the payload and what describes it (frame id,
+// camera timestamp, arrival time, status, pixel format, size). It is made of
+// two append-only files :
+//
+//	<path>      File header, then one record (FRAME_RECORD + payload) per frame.
+//	<path>.idx  Index header, then one FRAME_RECORD_INDEX per record - fixed
+//	            size entries, so frame n (or the frame at a given time) is
+//	            found without reading the recording.
+//
+// Recording (FrameRecord_Create / Add / Destroy) : frames are copied into a
+// queue drained by a writer thread of the recorder, so a slow disk never
+// holds up the acquisition - a frame that finds the queue full is dropped
+// (counted, as by FrameQueue). The index entry of a record is only written
+// once the record is, so a recording cut short (crash, full disk) is still
+// readable up to its last indexed frame.
+//
+// Reading (FrameRecord_Open / Read / Find / Close) : the index is mapped. If
+// it is missing or shorter than the recording, the records after the last
+// indexed one are found by walking their headers and added to the index.
+//
+
+#define FRAME_RECORD_MAGIC			0x43455246		// "FREC" - every record starts with it.
+#define FRAME_RECORD_FILE_MAGIC		"GCAMREC"
+#define FRAME_RECORD_INDEX_MAGIC		"GCAMIDX"
+#define FRAME_RECORD_VERSION			1
+#define FRAME_RECORD_INDEX_SUFFIX	".idx"
+
+#define FRAMERECORD_ERROR_NULL_PTR		-2300 // A pointer passed in is NULL.
+#define FRAMERECORD_ERROR_FILE			-2301 // A file could not be created / opened / written.
+#define FRAMERECORD_ERROR_FORMAT			-2302 // Not a recording (or an unknown version).
+#define FRAMERECORD_ERROR_RANGE			-2303 // No such record.
+
+// File header (first bytes of the recording and, with the index magic, of the index).
+typedef struct FRAME_RECORD_FILE_t
+{
+	char		magic[8];
+	uint32_t	version;
+	uint32_t	headerSize;				// sizeof(FRAME_RECORD_FILE).
+	uint64_t	createdUs;				// Wall clock time the recording was started (us since the epoch).
+} FRAME_RECORD_FILE;
+
+// Record header (followed by "length" bytes of payload).
+typedef struct FRAME_RECORD_t
+{
+	uint32_t	magic;					// FRAME_RECORD_MAGIC.
+	uint32_t	headerSize;				// sizeof(FRAME_RECORD).
+	uint64_t	frameId;
+	uint64_t	timestamp;				// Camera timestamp.
+	uint64_t	hostNs;					// Arrival (CLOCK_MONOTONIC).
+	int32_t	status;					// Transfer status of the buffer (0 = complete).
+	uint32_t	format;					// GigE Vision pixel format.
+	uint32_t	width;
+	uint32_t	height;
+	uint32_t	depth;					// Bytes per pixel.
+	uint32_t	reserved;
+	uint64_t	length;					// Payload bytes.
+} FRAME_RECORD;
+
+typedef struct FRAME_RECORD_INDEX_t
+{
+	uint64_t	offset;					// Of the record in the recording.
+	uint64_t	hostNs;
+	uint64_t	frameId;
+	uint64_t	length;
+} FRAME_RECORD_INDEX;
+
+typedef struct FRAME_RECORDER_STATS_t
+{
+	uint64_t	records;					// Frames written.
+	uint64_t	bytes;					// Bytes written (records and headers).
+	uint64_t	errors;					// Frames that could not be written.
+	uint64_t	dropped;					// Frames left out (queue full - the writer was behind).
+} FRAME_RECORDER_STATS;
+
+typedef struct FRAME_RECORDER_t
+{
+	int		fd;
+	int		indexFd;
+	uint64_t	offset;					// Where the next record goes.
+	pthread_t	writer;
+	FRAME_QUEUE	queue;
+	FRAME_RECORDER_STATS	stats;
+	char		path[256];
+} FRAME_RECORDER;
+
+typedef struct FRAME_RECORDING_t
+{
+	int		fd;
+	uint64_t	size;						// Of the recording (when opened).
+	uint64_t	count;					// Records.
+	FRAME_RECORD_INDEX	*index;		// Mapped index (entries after the header).
+	void		*mapping;
+	size_t	mappingSize;
+	FRAME_RECORD_FILE	header;
+} FRAME_RECORDING;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int FrameRecord_Create( FRAME_RECORDER *rec, const char *path, int depth, size_t maxFrameSize);
+int FrameRecord_Add( FRAME_RECORDER *rec, FRAME_RECORD *record, const void *data);
+void FrameRecord_PrintStats( FRAME_RECORDER *rec, const char *label);
+void FrameRecord_Destroy( FRAME_RECORDER *rec);
+
+int FrameRecord_Open( FRAME_RECORDING *recording, const char *path);
+uint64_t FrameRecord_Count( FRAME_RECORDING *recording);
+uint64_t FrameRecord_Find( FRAME_RECORDING *recording, uint64_t hostNs);
+int FrameRecord_Read( FRAME_RECORDING *recording, uint64_t n, FRAME_RECORD *record, void *buffer, size_t size);
+void FrameRecord_Close( FRAME_RECORDING *recording);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
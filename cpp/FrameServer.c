@@ -0,0 +1,504 @@
+/*
+  ---------------------------------------------
+  Unix domain socket frame server (one camera, many subscribers)
+  -----------------------------------------------
+*/
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include "FrameServer.h"
+
+// Drop a queue reference to a frame (srv->lock held). Idle frames are kept for reuse.
+static void _ReleaseFrame( FRAME_SERVER *srv, FRAME_SERVER_FRAME *frame)
+{
+	if (--frame->refs <= 0)
+	{
+		if (srv->numFree < (srv->maxClients * srv->queueDepth + 2))
+		{
+			frame->next = srv->freeList;
+			srv->freeList = frame;
+			srv->numFree++;
+		}
+		else
+		{
+			free(frame);
+		}
+	}
+}
+
+// Get a frame buffer for "length" bytes (srv->lock held).
+static FRAME_SERVER_FRAME *_GetFrame( FRAME_SERVER *srv, size_t length)
+{
+	FRAME_SERVER_FRAME *frame = srv->freeList;
+
+	if (frame != NULL)
+	{
+		srv->freeList = frame->next;
+		srv->numFree--;
+		if (frame->capacity < length)
+		{
+			// Geometry changed - the pooled buffer is too small.
+			free(frame);
+			frame = NULL;
+		}
+	}
+	if (frame == NULL)
+	{
+		frame = (FRAME_SERVER_FRAME *)malloc(sizeof(FRAME_SERVER_FRAME) + length);
+		if (frame == NULL)
+		{
+			return NULL;
+		}
+		frame->capacity = length;
+		frame->data = (unsigned char *)(frame + 1);
+	}
+	frame->next = NULL;
+	frame->refs = 0;
+	frame->length = length;
+	return frame;
+}
+
+// Close a client and let go of everything still queued for it (srv->lock held).
+static void _DropClient( FRAME_SERVER *srv, FRAME_SERVER_CLIENT *client)
+{
+	while (client->count > 0)
+	{
+		_ReleaseFrame( srv, client->queue[client->head]);
+		client->head = (client->head + 1) % FRAME_SERVER_MAX_QUEUE;
+		client->count--;
+	}
+	close(client->fd);
+	client->fd = -1;
+	client->sent = 0;
+	client->busy = 0;
+	srv->numClients--;
+}
+
+static void _AcceptClients( FRAME_SERVER *srv)
+{
+	int fd;
+
+	while ((fd = accept4(srv->listenFd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0)
+	{
+		int i;
+
+		pthread_mutex_lock(&srv->lock);
+		for (i = 0; i < srv->maxClients; i++)
+		{
+			if (srv->clients[i].fd < 0)
+			{
+				FRAME_SERVER_CLIENT *client = &srv->clients[i];
+				memset(client, 0, sizeof(FRAME_SERVER_CLIENT));
+				client->fd = fd;
+				client->stats.id = ++srv->connections;
+				srv->numClients++;
+				break;
+			}
+		}
+		pthread_mutex_unlock(&srv->lock);
+		if (i == srv->maxClients)
+		{
+			// No room for another subscriber.
+			close(fd);
+		}
+	}
+}
+
+// Send as much of the client's queue as the socket will take without blocking.
+// Returns -1 if the client went away.
+static int _SendQueued( FRAME_SERVER *srv, FRAME_SERVER_CLIENT *client)
+{
+	for (;;)
+	{
+		FRAME_SERVER_FRAME *frame = NULL;
+		size_t sent = 0;
+		ssize_t n;
+
+		pthread_mutex_lock(&srv->lock);
+		if (client->count == 0)
+		{
+			pthread_mutex_unlock(&srv->lock);
+			return 0;
+		}
+		frame = client->queue[client->head];
+		sent = client->sent;
+		client->busy = 1;
+		pthread_mutex_unlock(&srv->lock);
+
+		// The frame data is never modified while it is queued - send it without the lock.
+		n = send(client->fd, frame->data + sent, frame->length - sent, MSG_NOSIGNAL | MSG_DONTWAIT);
+
+		pthread_mutex_lock(&srv->lock);
+		client->busy = 0;
+		if (n < 0)
+		{
+			pthread_mutex_unlock(&srv->lock);
+			return ((errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == EINTR)) ? 0 : -1;
+		}
+		client->sent += n;
+		client->stats.bytesSent += n;
+		if (client->sent == frame->length)
+		{
+			client->queue[client->head] = NULL;
+			client->head = (client->head + 1) % FRAME_SERVER_MAX_QUEUE;
+			client->count--;
+			client->sent = 0;
+			client->stats.framesSent++;
+			_ReleaseFrame( srv, frame);
+		}
+		pthread_mutex_unlock(&srv->lock);
+	}
+}
+
+static void *_ServerThread( void *context)
+{
+	FRAME_SERVER *srv = (FRAME_SERVER *)context;
+	struct pollfd pfd[FRAME_SERVER_MAX_CLIENTS + 2];
+	int index[FRAME_SERVER_MAX_CLIENTS + 2];
+
+	while (!srv->exit)
+	{
+		int nfds = 2;
+		int i;
+
+		pfd[0].fd = srv->wakeFd[0];
+		pfd[0].events = POLLIN;
+		pfd[1].fd = srv->listenFd;
+		pfd[1].events = POLLIN;
+
+		pthread_mutex_lock(&srv->lock);
+		for (i = 0; i < srv->maxClients; i++)
+		{
+			if (srv->clients[i].fd >= 0)
+			{
+				pfd[nfds].fd = srv->clients[i].fd;
+				pfd[nfds].events = POLLIN | ((srv->clients[i].count > 0) ? POLLOUT : 0);
+				index[nfds] = i;
+				nfds++;
+			}
+		}
+		pthread_mutex_unlock(&srv->lock);
+
+		if (poll(pfd, nfds, 1000) <= 0)
+		{
+			continue;
+		}
+		if (pfd[0].revents & POLLIN)
+		{
+			char drain[64];
+			while (read(srv->wakeFd[0], drain, sizeof(drain)) > 0);
+		}
+		if (pfd[1].revents & POLLIN)
+		{
+			_AcceptClients( srv);
+		}
+		for (i = 2; i < nfds; i++)
+		{
+			FRAME_SERVER_CLIENT *client = &srv->clients[index[i]];
+			int gone = ((pfd[i].revents & (POLLERR | POLLNVAL)) != 0);
+
+			if (!gone && (pfd[i].revents & (POLLIN | POLLHUP)))
+			{
+				// Subscribers don't send anything - input is discarded, EOF means they left.
+				char discard[256];
+				ssize_t n = recv(client->fd, discard, sizeof(discard), MSG_DONTWAIT);
+				gone = ((n == 0) || ((n < 0) && (errno != EAGAIN) && (errno != EWOULDBLOCK) && (errno != EINTR)));
+			}
+			if (!gone && (pfd[i].revents & POLLOUT))
+			{
+				gone = (_SendQueued( srv, client) < 0);
+			}
+			if (gone)
+			{
+				pthread_mutex_lock(&srv->lock);
+				_DropClient( srv, client);
+				pthread_mutex_unlock(&srv->lock);
+			}
+		}
+	}
+	return NULL;
+}
+
+// !
+// FrameServer_Create
+//
+/*!
+	Start listening for frame subscribers on a Unix domain socket.
+
+	\param srv         Server object to initialize.
+	\param path        Socket path (an existing socket file at this path is replaced).
+	\param maxClients  Most subscribers connected at once (1 .. FRAME_SERVER_MAX_CLIENTS).
+	\param queueDepth  Frames queued per subscriber before frames are dropped
+	                   (1 .. FRAME_SERVER_MAX_QUEUE).
+
+	\return Error status
+		0   = Success
+*/
+int FrameServer_Create( FRAME_SERVER *srv, const char *path, int maxClients, int queueDepth)
+{
+	struct sockaddr_un addr;
+	int i;
+
+	if ((srv == NULL) || (path == NULL))
+	{
+		return FRAMESERVER_ERROR_NULL_PTR;
+	}
+	memset(srv, 0, sizeof(FRAME_SERVER));
+	srv->listenFd = -1;
+	srv->wakeFd[0] = srv->wakeFd[1] = -1;
+	if ((strlen(path) == 0) || (strlen(path) >= sizeof(srv->path)) ||
+		 (maxClients < 1) || (maxClients > FRAME_SERVER_MAX_CLIENTS) ||
+		 (queueDepth < 1) || (queueDepth > FRAME_SERVER_MAX_QUEUE))
+	{
+		return FRAMESERVER_ERROR_PARAMETER;
+	}
+	strcpy(srv->path, path);
+	srv->maxClients = maxClients;
+	srv->queueDepth = queueDepth;
+	for (i = 0; i < FRAME_SERVER_MAX_CLIENTS; i++)
+	{
+		srv->clients[i].fd = -1;
+	}
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	strcpy(addr.sun_path, path);
+	unlink(path);
+	srv->listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	if ((srv->listenFd < 0) ||
+		 (bind(srv->listenFd, (struct sockaddr *)&addr, sizeof(addr)) != 0) ||
+		 (listen(srv->listenFd, maxClients) != 0) ||
+		 (pipe2(srv->wakeFd, O_NONBLOCK | O_CLOEXEC) != 0))
+	{
+		int err = errno;
+		FrameServer_Destroy(srv);
+		errno = err;
+		return FRAMESERVER_ERROR_SOCKET;
+	}
+
+	pthread_mutex_init(&srv->lock, NULL);
+	if (pthread_create(&srv->thread, NULL, _ServerThread, srv) != 0)
+	{
+		pthread_mutex_destroy(&srv->lock);
+		FrameServer_Destroy(srv);
+		return FRAMESERVER_ERROR_THREAD;
+	}
+	srv->running = 1;
+	return 0;
+}
+
+// !
+// FrameServer_Publish
+//
+/*!
+	Queue a frame (header + data) for every connected subscriber.
+
+	The frame is copied once and shared by all the subscriber queues, so the
+	caller can reuse its buffers as soon as this returns. Never blocks on a
+	subscriber : if a queue is full its oldest unsent frame is dropped.
+
+	\return Error status
+		0   = Success (also when nobody is connected)
+*/
+int FrameServer_Publish( FRAME_SERVER *srv, const void *header, size_t headerLen, const void *data, size_t length)
+{
+	FRAME_SERVER_FRAME *frame = NULL;
+	int i;
+
+	if ((srv == NULL) || (header == NULL) || (data == NULL))
+	{
+		return FRAMESERVER_ERROR_NULL_PTR;
+	}
+	srv->published++;
+	if (srv->numClients == 0)
+	{
+		// Nobody listening - skip the copy.
+		return 0;
+	}
+
+	pthread_mutex_lock(&srv->lock);
+	frame = _GetFrame( srv, headerLen + length);
+	pthread_mutex_unlock(&srv->lock);
+	if (frame == NULL)
+	{
+		return FRAMESERVER_ERROR_NO_MEMORY;
+	}
+	memcpy(frame->data, header, headerLen);
+	memcpy(frame->data + headerLen, data, length);
+
+	pthread_mutex_lock(&srv->lock);
+	frame->refs = 1;	// Held here until it is queued everywhere.
+	for (i = 0; i < srv->maxClients; i++)
+	{
+		FRAME_SERVER_CLIENT *client = &srv->clients[i];
+
+		if (client->fd < 0)
+		{
+			continue;
+		}
+		if (client->count >= srv->queueDepth)
+		{
+			// Queue full - drop the oldest frame that is not being sent yet.
+			int inFlight = (client->busy || (client->sent > 0)) ? 1 : 0;
+			int k;
+
+			client->stats.framesDropped++;
+			if (client->count <= inFlight)
+			{
+				// Only the frame being sent is queued - drop the new one instead.
+				continue;
+			}
+			_ReleaseFrame( srv, client->queue[(client->head + inFlight) % FRAME_SERVER_MAX_QUEUE]);
+			for (k = inFlight; k < (client->count - 1); k++)
+			{
+				client->queue[(client->head + k) % FRAME_SERVER_MAX_QUEUE] =
+						client->queue[(client->head + k + 1) % FRAME_SERVER_MAX_QUEUE];
+			}
+			client->count--;
+		}
+		client->queue[(client->head + client->count) % FRAME_SERVER_MAX_QUEUE] = frame;
+		client->count++;
+		frame->refs++;
+		if ((uint32_t)client->count > client->stats.maxDepth)
+		{
+			client->stats.maxDepth = client->count;
+		}
+	}
+	_ReleaseFrame( srv, frame);
+	pthread_mutex_unlock(&srv->lock);
+
+	// Wake the server thread to start sending (a full pipe already means a wakeup is pending).
+	if (write(srv->wakeFd[1], "", 1) < 0)
+	{
+		errno = 0;
+	}
+	return 0;
+}
+
+int FrameServer_ClientCount( FRAME_SERVER *srv)
+{
+	return (srv != NULL) ? srv->numClients : 0;
+}
+
+// !
+// FrameServer_GetStats
+//
+/*!
+	Get the per-subscriber statistics (queue depth, frames sent / dropped).
+
+	\param stats       Array filled with one entry per connected subscriber.
+	\param maxEntries  Number of entries in the array.
+
+	\return Number of entries filled in.
+*/
+int FrameServer_GetStats( FRAME_SERVER *srv, FRAME_SERVER_CLIENT_STATS *stats, int maxEntries)
+{
+	int i;
+	int n = 0;
+
+	if ((srv == NULL) || (stats == NULL) || !srv->running)
+	{
+		return 0;
+	}
+	pthread_mutex_lock(&srv->lock);
+	for (i = 0; (i < srv->maxClients) && (n < maxEntries); i++)
+	{
+		if (srv->clients[i].fd >= 0)
+		{
+			stats[n] = srv->clients[i].stats;
+			stats[n].depth = srv->clients[i].count;
+			n++;
+		}
+	}
+	pthread_mutex_unlock(&srv->lock);
+	return n;
+}
+
+void FrameServer_PrintStats( FRAME_SERVER *srv, const char *label)
+{
+	FRAME_SERVER_CLIENT_STATS stats[FRAME_SERVER_MAX_CLIENTS];
+	int n = FrameServer_GetStats( srv, stats, FRAME_SERVER_MAX_CLIENTS);
+	int i;
+
+	if (srv == NULL)
+	{
+		return;
+	}
+	fprintf(stderr, "%s: %llu frames published, %d subscriber(s)\n",
+			(label != NULL) ? label : "server", (unsigned long long)srv->published, n);
+	for (i = 0; i < n; i++)
+	{
+		fprintf(stderr, "  client %u : depth %u (max %u), %llu sent, %llu dropped, %llu KB\n",
+				stats[i].id, stats[i].depth, stats[i].maxDepth,
+				(unsigned long long)stats[i].framesSent,
+				(unsigned long long)stats[i].framesDropped,
+				(unsigned long long)(stats[i].bytesSent / 1024));
+	}
+}
+
+// !
+// FrameServer_Destroy
+//
+/*!
+	Stop the server thread, disconnect all subscribers and remove the socket file.
+*/
+void FrameServer_Destroy( FRAME_SERVER *srv)
+{
+	int i;
+
+	if (srv == NULL)
+	{
+		return;
+	}
+	if (srv->running)
+	{
+		srv->exit = 1;
+		if (write(srv->wakeFd[1], "", 1) < 0)
+		{
+			errno = 0;
+		}
+		pthread_join(srv->thread, NULL);
+		srv->running = 0;
+
+		pthread_mutex_lock(&srv->lock);
+		for (i = 0; i < srv->maxClients; i++)
+		{
+			if (srv->clients[i].fd >= 0)
+			{
+				_DropClient( srv, &srv->clients[i]);
+			}
+		}
+		pthread_mutex_unlock(&srv->lock);
+		pthread_mutex_destroy(&srv->lock);
+	}
+	if (srv->listenFd >= 0)
+	{
+		close(srv->listenFd);
+		srv->listenFd = -1;
+		unlink(srv->path);
+	}
+	for (i = 0; i < 2; i++)
+	{
+		if (srv->wakeFd[i] >= 0)
+		{
+			close(srv->wakeFd[i]);
+			srv->wakeFd[i] = -1;
+		}
+	}
+	while (srv->freeList != NULL)
+	{
+		FRAME_SERVER_FRAME *frame = srv->freeList;
+		srv->freeList = frame->next;
+		free(frame);
+	}
+	srv->numFree = 0;
+}
@@ -0,0 +1,101 @@
+#ifndef __FRAME_SERVER_H__
+#define __FRAME_SERVER_H__
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <sys/un.h>
+
+//=============================================================================
+// Multi-subscriber Unix domain socket frame server.
+//
+// The server listens on a SOCK_STREAM Unix domain socket and sends every
+// published frame to each connected client, in the same format as the stdout
+// stream :
+//
+//	[FRAME_HEADER][payload_length bytes of pixel data]...
+//
+// FrameServer_Publish copies the frame once into a reference counted buffer
+// and queues that buffer on every client. It never blocks on a client : each
+// client has its own bounded queue and, when it is full, the oldest frame that
+// has not started sending yet is dropped (and counted). A server thread does
+// all the (non-blocking) socket I/O, so a slow subscriber only loses frames -
+// it cannot stall the caller or the other subscribers.
+//
+// A client joining mid-stream always starts on a frame boundary.
+//
+
+#define FRAME_SERVER_MAX_CLIENTS		16
+#define FRAME_SERVER_MAX_QUEUE		16
+
+#define FRAMESERVER_ERROR_NULL_PTR		-1400 // A pointer passed in is NULL.
+#define FRAMESERVER_ERROR_PARAMETER	-1401 // Invalid path, client count or queue depth.
+#define FRAMESERVER_ERROR_SOCKET		-1402 // socket/bind/listen failed (see errno).
+#define FRAMESERVER_ERROR_THREAD		-1403 // The server thread could not be started.
+#define FRAMESERVER_ERROR_NO_MEMORY	-1404 // No memory for the frame buffer.
+
+typedef struct FRAME_SERVER_FRAME_t
+{
+	struct FRAME_SERVER_FRAME_t	*next;	// Free list link.
+	int		refs;						// Client queues holding the frame.
+	size_t	capacity;				// Bytes allocated at data.
+	size_t	length;					// Bytes to send (header + payload).
+	unsigned char	*data;
+} FRAME_SERVER_FRAME;
+
+typedef struct FRAME_SERVER_CLIENT_STATS_t
+{
+	uint32_t	id;					// Connection number (1 = first client since start).
+	uint32_t	depth;				// Frames queued right now.
+	uint32_t	maxDepth;			// Most frames ever queued.
+	uint64_t	framesSent;			// Frames completely sent.
+	uint64_t	framesDropped;		// Frames dropped because the queue was full.
+	uint64_t	bytesSent;
+} FRAME_SERVER_CLIENT_STATS;
+
+typedef struct FRAME_SERVER_CLIENT_t
+{
+	int		fd;						// -1 = slot not in use.
+	int		head;
+	int		count;
+	int		busy;						// Server thread is sending queue[head] (it can't be dropped).
+	size_t	sent;						// Bytes of queue[head] already sent.
+	FRAME_SERVER_FRAME			*queue[FRAME_SERVER_MAX_QUEUE];
+	FRAME_SERVER_CLIENT_STATS	stats;
+} FRAME_SERVER_CLIENT;
+
+typedef struct FRAME_SERVER_t
+{
+	int		listenFd;
+	int		wakeFd[2];				// Self-pipe used to wake the server thread.
+	int		maxClients;
+	int		queueDepth;
+	int		numClients;
+	int		numFree;
+	int		running;					// Server thread started.
+	volatile int	exit;
+	uint32_t	connections;		// Clients accepted so far.
+	uint64_t	published;			// Frames published so far.
+	char		path[sizeof(((struct sockaddr_un *)0)->sun_path)];
+	pthread_t			thread;
+	pthread_mutex_t	lock;
+	FRAME_SERVER_FRAME	*freeList;
+	FRAME_SERVER_CLIENT	clients[FRAME_SERVER_MAX_CLIENTS];
+} FRAME_SERVER, *PFRAME_SERVER;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int FrameServer_Create( FRAME_SERVER *srv, const char *path, int maxClients, int queueDepth);
+int FrameServer_Publish( FRAME_SERVER *srv, const void *header, size_t headerLen, const void *data, size_t length);
+int FrameServer_ClientCount( FRAME_SERVER *srv);
+int FrameServer_GetStats( FRAME_SERVER *srv, FRAME_SERVER_CLIENT_STATS *stats, int maxEntries);
+void FrameServer_PrintStats( FRAME_SERVER *srv, const char *label);
+void FrameServer_Destroy( FRAME_SERVER *srv);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,329 @@
+/*
+  ---------------------------------------------
+  POSIX Shared Memory Frame Ring
+  -----------------------------------------------
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "FrameShmRing.h"
+
+#define _ALIGN_UP(x, a)	(((x) + ((a) - 1)) & ~((size_t)(a) - 1))
+
+static inline FRAME_SHM_SLOT_HEADER *_GetSlot( FRAME_SHM_RING *ring, uint64_t publishNumber)
+{
+	uint64_t index = (publishNumber - 1) % ring->hdr->num_slots;
+	return (FRAME_SHM_SLOT_HEADER *)((char *)ring->base + ring->hdr->header_size + index * ring->hdr->slot_stride);
+}
+
+static int _MapRing( FRAME_SHM_RING *ring, size_t size, int prot)
+{
+	ring->base = mmap( NULL, size, prot, MAP_SHARED, ring->fd, 0);
+	if (ring->base == MAP_FAILED)
+	{
+		ring->base = NULL;
+		return FRAMESHM_ERROR_MAP;
+	}
+	ring->mapSize = size;
+	ring->hdr = (FRAME_SHM_RING_HEADER *)ring->base;
+	return 0;
+}
+
+// !
+// FrameShm_Create
+//
+/*!
+	Create (or re-create) the named shared memory frame ring and map it for writing.
+
+	\param ring       Ring object to initialize.
+	\param name       Name of the shared memory object (eg "/genicam_frames").
+	\param numSlots   Number of frame slots in the ring (>= 2).
+	\param slotSize   Maximum size (in bytes) of a frame stored in a slot.
+
+	\return Error status
+		0   = Success
+		FRAMESHM_ERROR_* (see FrameShmRing.h)
+*/
+int FrameShm_Create( FRAME_SHM_RING *ring, const char *name, uint32_t numSlots, size_t slotSize)
+{
+	size_t stride = 0;
+	size_t total = 0;
+	int status = 0;
+
+	if ((ring == NULL) || (name == NULL))
+	{
+		return FRAMESHM_ERROR_NULL_PTR;
+	}
+	if ((numSlots < 2) || (slotSize == 0))
+	{
+		return FRAMESHM_ERROR_PARAMETER;
+	}
+	memset(ring, 0, sizeof(FRAME_SHM_RING));
+	ring->fd = -1;
+	strncpy(ring->name, name, sizeof(ring->name) - 1);
+
+	stride = sizeof(FRAME_SHM_SLOT_HEADER) + _ALIGN_UP(slotSize, FRAMESHM_ALIGNMENT);
+	total  = sizeof(FRAME_SHM_RING_HEADER) + (numSlots * stride);
+	total  = _ALIGN_UP(total, (size_t)sysconf(_SC_PAGESIZE));
+
+	// Remove any stale ring left behind by a previous run.
+	shm_unlink(ring->name);
+	ring->fd = shm_open(ring->name, O_RDWR | O_CREAT | O_EXCL, 0666);
+	if (ring->fd < 0)
+	{
+		return FRAMESHM_ERROR_SHM_OPEN;
+	}
+	ring->owner = 1;
+
+	if ( ftruncate(ring->fd, total) != 0)
+	{
+		FrameShm_Destroy(ring);
+		return FRAMESHM_ERROR_MAP;
+	}
+	status = _MapRing( ring, total, PROT_READ | PROT_WRITE);
+	if (status != 0)
+	{
+		FrameShm_Destroy(ring);
+		return status;
+	}
+
+	// Fill in the ring geometry. The magic goes in last so a reader never
+	// sees a partially initialized header.
+	ring->hdr->version     = FRAMESHM_VERSION;
+	ring->hdr->num_slots   = numSlots;
+	ring->hdr->header_size = sizeof(FRAME_SHM_RING_HEADER);
+	ring->hdr->slot_size   = _ALIGN_UP(slotSize, FRAMESHM_ALIGNMENT);
+	ring->hdr->slot_stride = stride;
+	ring->hdr->publish_count = 0;
+	ring->hdr->writer_pid  = (uint32_t)getpid();
+	__atomic_store_n(&ring->hdr->magic, FRAMESHM_MAGIC, __ATOMIC_RELEASE);
+	return 0;
+}
+
+// !
+// FrameShm_BeginWrite
+//
+/*!
+	Claim the next slot in the ring for writing a frame of "length" bytes.
+	The slot is marked as being written (odd sequence number) so readers
+	still holding it can detect the overwrite.
+	Must be followed by FrameShm_CommitWrite.
+
+	\return Pointer to the slot data area (NULL if the frame does not fit).
+*/
+void *FrameShm_BeginWrite( FRAME_SHM_RING *ring, size_t length)
+{
+	FRAME_SHM_SLOT_HEADER *slot = NULL;
+
+	if ((ring == NULL) || (ring->hdr == NULL) || (length > ring->hdr->slot_size))
+	{
+		return NULL;
+	}
+	ring->writing = ring->hdr->publish_count + 1;
+	slot = _GetSlot(ring, ring->writing);
+
+	__atomic_store_n(&slot->sequence, (2 * ring->writing) - 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	return (void *)(slot + 1);
+}
+
+// !
+// FrameShm_CommitWrite
+//
+/*!
+	Complete the frame started with FrameShm_BeginWrite and make it visible to readers.
+*/
+void FrameShm_CommitWrite( FRAME_SHM_RING *ring, size_t length)
+{
+	FRAME_SHM_SLOT_HEADER *slot = NULL;
+
+	if ((ring == NULL) || (ring->hdr == NULL) || (ring->writing == 0))
+	{
+		return;
+	}
+	slot = _GetSlot(ring, ring->writing);
+	slot->length = length;
+	__atomic_store_n(&slot->sequence, 2 * ring->writing, __ATOMIC_RELEASE);
+	__atomic_store_n(&ring->hdr->publish_count, ring->writing, __ATOMIC_RELEASE);
+	ring->writing = 0;
+}
+
+// !
+// FrameShm_Publish
+//
+/*!
+	Copy a frame into the next slot of the ring.
+
+	\return Error status
+		0   = Success
+		FRAMESHM_ERROR_TOO_BIG  The frame is larger than the slot size.
+*/
+int FrameShm_Publish( FRAME_SHM_RING *ring, const void *data, size_t length)
+{
+	void *dst = NULL;
+
+	if ((ring == NULL) || (data == NULL))
+	{
+		return FRAMESHM_ERROR_NULL_PTR;
+	}
+	dst = FrameShm_BeginWrite(ring, length);
+	if (dst == NULL)
+	{
+		return FRAMESHM_ERROR_TOO_BIG;
+	}
+	memcpy(dst, data, length);
+	FrameShm_CommitWrite(ring, length);
+	return 0;
+}
+
+void FrameShm_Destroy( FRAME_SHM_RING *ring)
+{
+	if (ring != NULL)
+	{
+		FrameShm_Close(ring);
+		if (ring->owner)
+		{
+			shm_unlink(ring->name);
+			ring->owner = 0;
+		}
+	}
+}
+
+// !
+// FrameShm_Open
+//
+/*!
+	Map an existing frame ring (created by another process) for reading.
+
+	\return Error status
+		0   = Success
+		FRAMESHM_ERROR_* (see FrameShmRing.h)
+*/
+int FrameShm_Open( FRAME_SHM_RING *ring, const char *name)
+{
+	struct stat st;
+	int status = 0;
+
+	if ((ring == NULL) || (name == NULL))
+	{
+		return FRAMESHM_ERROR_NULL_PTR;
+	}
+	memset(ring, 0, sizeof(FRAME_SHM_RING));
+	ring->fd = -1;
+	strncpy(ring->name, name, sizeof(ring->name) - 1);
+
+	ring->fd = shm_open(ring->name, O_RDONLY, 0);
+	if (ring->fd < 0)
+	{
+		return FRAMESHM_ERROR_SHM_OPEN;
+	}
+	if ((fstat(ring->fd, &st) != 0) || (st.st_size < (off_t)sizeof(FRAME_SHM_RING_HEADER)))
+	{
+		FrameShm_Close(ring);
+		return FRAMESHM_ERROR_BAD_RING;
+	}
+	status = _MapRing( ring, st.st_size, PROT_READ);
+	if (status != 0)
+	{
+		FrameShm_Close(ring);
+		return status;
+	}
+	if ( (__atomic_load_n(&ring->hdr->magic, __ATOMIC_ACQUIRE) != FRAMESHM_MAGIC) ||
+		  (ring->hdr->version != FRAMESHM_VERSION) )
+	{
+		FrameShm_Close(ring);
+		return FRAMESHM_ERROR_BAD_RING;
+	}
+	return 0;
+}
+
+uint64_t FrameShm_GetPublishCount( FRAME_SHM_RING *ring)
+{
+	if ((ring == NULL) || (ring->hdr == NULL))
+	{
+		return 0;
+	}
+	return __atomic_load_n(&ring->hdr->publish_count, __ATOMIC_ACQUIRE);
+}
+
+// !
+// FrameShm_Acquire
+//
+/*!
+	Get a pointer to the frame with the given publish number (1 based) directly
+	in the shared memory (no copy). The data may be overwritten by the writer at
+	any time - call FrameShm_Validate after using it to see if it is still intact.
+
+	\return Error status
+		0   = Success
+		FRAMESHM_ERROR_NO_DATA      The frame has not been published yet.
+		FRAMESHM_ERROR_OVERWRITTEN  The frame was already overwritten.
+*/
+int FrameShm_Acquire( FRAME_SHM_RING *ring, uint64_t publishNumber, void **data, size_t *length)
+{
+	FRAME_SHM_SLOT_HEADER *slot = NULL;
+	uint64_t seq = 0;
+
+	if ((ring == NULL) || (ring->hdr == NULL) || (data == NULL) || (length == NULL))
+	{
+		return FRAMESHM_ERROR_NULL_PTR;
+	}
+	if ((publishNumber == 0) || (publishNumber > FrameShm_GetPublishCount(ring)))
+	{
+		return FRAMESHM_ERROR_NO_DATA;
+	}
+	slot = _GetSlot(ring, publishNumber);
+	seq = __atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE);
+	if (seq != (2 * publishNumber))
+	{
+		return FRAMESHM_ERROR_OVERWRITTEN;
+	}
+	*data = (void *)(slot + 1);
+	*length = (size_t)slot->length;
+	return 0;
+}
+
+// !
+// FrameShm_Validate
+//
+/*!
+	Check that the frame obtained with FrameShm_Acquire was not touched by
+	the writer in the meantime.
+
+	\return 0 if the frame is intact, FRAMESHM_ERROR_OVERWRITTEN otherwise.
+*/
+int FrameShm_Validate( FRAME_SHM_RING *ring, uint64_t publishNumber)
+{
+	FRAME_SHM_SLOT_HEADER *slot = NULL;
+
+	if ((ring == NULL) || (ring->hdr == NULL) || (publishNumber == 0))
+	{
+		return FRAMESHM_ERROR_NULL_PTR;
+	}
+	__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	slot = _GetSlot(ring, publishNumber);
+	return (__atomic_load_n(&slot->sequence, __ATOMIC_RELAXED) == (2 * publishNumber)) ? 0 : FRAMESHM_ERROR_OVERWRITTEN;
+}
+
+void FrameShm_Close( FRAME_SHM_RING *ring)
+{
+	if (ring != NULL)
+	{
+		if (ring->base != NULL)
+		{
+			munmap(ring->base, ring->mapSize);
+			ring->base = NULL;
+			ring->hdr = NULL;
+		}
+		if (ring->fd >= 0)
+		{
+			close(ring->fd);
+		}
+		ring->fd = -1;
+	}
+}
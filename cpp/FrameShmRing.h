@@ -0,0 +1,90 @@
+#ifndef __FRAME_SHM_RING_H__
+#define __FRAME_SHM_RING_H__
+
+#include <stdint.h>
+#include <stdlib.h>
+
+//=============================================================================
+// POSIX shared memory frame ring.
+//
+// The ring is a single shm_open/mmap region laid out as :
+//
+//	[FRAME_SHM_RING_HEADER][slot 0][slot 1]...[slot N-1]
+//
+// Each slot is a FRAME_SHM_SLOT_HEADER followed by "slot_size" bytes of frame
+// data. Slots are written round-robin. Every slot carries a sequence number
+// that works like a seqlock : it is odd while the writer owns the slot and is
+// set to (2 * publish_count) once the frame is complete. A reader can use the
+// frame data in place and then re-check the sequence number to find out if
+// the slot was overwritten while it was being used.
+//
+// All offsets are 64 byte aligned and all fields are little-endian (host order).
+//
+
+#define FRAMESHM_MAGIC				0x52465647	// "GVFR"
+#define FRAMESHM_VERSION			1
+#define FRAMESHM_ALIGNMENT			64
+
+#define FRAMESHM_ERROR_NULL_PTR			-1200 // A pointer passed in is NULL.
+#define FRAMESHM_ERROR_PARAMETER		-1201 // Invalid number of slots or slot size.
+#define FRAMESHM_ERROR_SHM_OPEN			-1202 // shm_open failed (see errno).
+#define FRAMESHM_ERROR_MAP				-1203 // ftruncate/mmap failed (see errno).
+#define FRAMESHM_ERROR_BAD_RING			-1204 // Mapped region is not a frame ring (magic / version).
+#define FRAMESHM_ERROR_TOO_BIG			-1205 // Frame does not fit in a slot.
+#define FRAMESHM_ERROR_NO_DATA			-1206 // No frame is available (yet).
+#define FRAMESHM_ERROR_OVERWRITTEN		-1207 // The requested frame was overwritten by the writer.
+
+typedef struct FRAME_SHM_RING_HEADER_t
+{
+	uint32_t	magic;				// FRAMESHM_MAGIC
+	uint32_t	version;				// FRAMESHM_VERSION
+	uint32_t	num_slots;			// Number of slots in the ring.
+	uint32_t	header_size;		// sizeof(FRAME_SHM_RING_HEADER) - offset of slot 0.
+	uint64_t	slot_size;			// Usable data bytes per slot.
+	uint64_t	slot_stride;		// Bytes from one slot header to the next.
+	volatile uint64_t	publish_count;	// Number of frames published so far (slot = (count-1) % num_slots).
+	uint32_t	writer_pid;			// Process id of the writer.
+	uint32_t	pad[5];
+} FRAME_SHM_RING_HEADER, *PFRAME_SHM_RING_HEADER;
+
+typedef struct FRAME_SHM_SLOT_HEADER_t
+{
+	volatile uint64_t	sequence;	// Odd = being written, Even = 2 * publish number of the frame in the slot.
+	uint64_t	length;				// Number of valid data bytes in the slot.
+	uint64_t	pad[6];
+} FRAME_SHM_SLOT_HEADER, *PFRAME_SHM_SLOT_HEADER;
+
+typedef struct FRAME_SHM_RING_t
+{
+	int		fd;
+	int		owner;				// TRUE if this process created the region (and unlinks it).
+	char		name[128];
+	void		*base;
+	size_t	mapSize;
+	FRAME_SHM_RING_HEADER	*hdr;
+	uint64_t	writing;				// Publish number of the slot currently owned by the writer (0 = none).
+} FRAME_SHM_RING, *PFRAME_SHM_RING;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Writer side.
+int FrameShm_Create( FRAME_SHM_RING *ring, const char *name, uint32_t numSlots, size_t slotSize);
+void *FrameShm_BeginWrite( FRAME_SHM_RING *ring, size_t length);
+void FrameShm_CommitWrite( FRAME_SHM_RING *ring, size_t length);
+int FrameShm_Publish( FRAME_SHM_RING *ring, const void *data, size_t length);
+void FrameShm_Destroy( FRAME_SHM_RING *ring);
+
+// Reader side.
+int FrameShm_Open( FRAME_SHM_RING *ring, const char *name);
+uint64_t FrameShm_GetPublishCount( FRAME_SHM_RING *ring);
+int FrameShm_Acquire( FRAME_SHM_RING *ring, uint64_t publishNumber, void **data, size_t *length);
+int FrameShm_Validate( FRAME_SHM_RING *ring, uint64_t publishNumber);
+void FrameShm_Close( FRAME_SHM_RING *ring);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
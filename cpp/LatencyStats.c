@@ -0,0 +1,218 @@
+/*
+  ---------------------------------------------
+  Frame latency distributions
+  -----------------------------------------------
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include "LatencyStats.h"
+
+static const char *s_stageNames[LATENCY_NUM_STAGES] =
+{
+	"wire", "convert", "publish", "total"
+};
+
+// Open / close an update (odd sequence while it is going on).
+static inline void _BeginUpdate( LATENCY_STATS *stats)
+{
+	__atomic_store_n(&stats->sequence, stats->sequence + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+static inline void _EndUpdate( LATENCY_STATS *stats)
+{
+	__atomic_store_n(&stats->sequence, stats->sequence + 1, __ATOMIC_RELEASE);
+}
+
+// Bucket of a value : the power of two it is in, and which quarter of it.
+static inline int _Bucket( uint64_t ns)
+{
+	int msb = 0;
+	int bucket = 0;
+
+	if (ns < LATENCY_SUB_BUCKETS)
+	{
+		return (int)ns;
+	}
+	msb = 63 - __builtin_clzll(ns);
+	bucket = (msb - 1) * LATENCY_SUB_BUCKETS + (int)((ns >> (msb - 2)) & (LATENCY_SUB_BUCKETS - 1));
+	return (bucket < LATENCY_BUCKETS) ? bucket : (LATENCY_BUCKETS - 1);
+}
+
+// Smallest value of a bucket.
+static inline uint64_t _BucketStart( int bucket)
+{
+	if (bucket < LATENCY_SUB_BUCKETS)
+	{
+		return (uint64_t)bucket;
+	}
+	return (uint64_t)(LATENCY_SUB_BUCKETS + (bucket % LATENCY_SUB_BUCKETS)) << (bucket / LATENCY_SUB_BUCKETS - 1);
+}
+
+static void _Add( LATENCY_HISTOGRAM *h, uint64_t start, uint64_t end)
+{
+	uint64_t ns = end - start;
+
+	if (end < start)
+	{
+		h->negative++;
+		return;
+	}
+	h->count++;
+	h->nsTotal += ns;
+	if (ns > h->nsMax)
+	{
+		h->nsMax = ns;
+	}
+	h->buckets[_Bucket( ns)]++;
+}
+
+int LatencyStats_Init( LATENCY_STATS *stats)
+{
+	if (stats == NULL)
+	{
+		return LATENCYSTATS_ERROR_NULL_PTR;
+	}
+	memset(stats, 0, sizeof(LATENCY_STATS));
+	return 0;
+}
+
+// !
+// LatencyStats_Frame
+//
+/*!
+	Count the latencies of a frame (publication thread only). All the times are
+	on the host clock (ClockSync_Now).
+
+	\param exposureNs   Camera timestamp of the frame mapped to the host (0 = unknown).
+	\param arrivalNs    When the transfer handed the buffer over.
+	\param convertedNs  When the output image was ready.
+	\param publishedNs  When it was written to its output.
+*/
+void LatencyStats_Frame( LATENCY_STATS *stats, uint64_t exposureNs, uint64_t arrivalNs, uint64_t convertedNs, uint64_t publishedNs)
+{
+	LATENCY_HISTOGRAM *stages = stats->histograms.stages;
+
+	_BeginUpdate( stats);
+	if (exposureNs != 0)
+	{
+		_Add( &stages[LATENCY_WIRE], exposureNs, arrivalNs);
+		_Add( &stages[LATENCY_TOTAL], exposureNs, publishedNs);
+	}
+	_Add( &stages[LATENCY_CONVERT], arrivalNs, convertedNs);
+	_Add( &stages[LATENCY_PUBLISH], convertedNs, publishedNs);
+	_EndUpdate( stats);
+}
+
+// !
+// LatencyStats_Read
+//
+/*!
+	Take a consistent copy of the histograms (from any thread - never holds up the acquisition).
+
+	\return Error status
+		0   = Success
+*/
+int LatencyStats_Read( const LATENCY_STATS *stats, LATENCY_SNAPSHOT *snapshot)
+{
+	uint32_t before = 0;
+	uint32_t after = 0;
+
+	if ((stats == NULL) || (snapshot == NULL))
+	{
+		return LATENCYSTATS_ERROR_NULL_PTR;
+	}
+	do
+	{
+		before = __atomic_load_n(&stats->sequence, __ATOMIC_ACQUIRE);
+		memcpy(snapshot, &stats->histograms, sizeof(LATENCY_SNAPSHOT));
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		after = __atomic_load_n(&stats->sequence, __ATOMIC_RELAXED);
+	} while ((before & 1) || (before != after));
+	return 0;
+}
+
+// !
+// LatencyStats_Percentile
+//
+/*!
+	Latency below which "fraction" (0..1) of the values since "prev" (an earlier
+	snapshot of the same stage, NULL = since the start) fall - the middle of the
+	bucket it is in.
+
+	\return The latency in ns (0 = no values)
+*/
+uint64_t LatencyStats_Percentile( const LATENCY_HISTOGRAM *now, const LATENCY_HISTOGRAM *prev, double fraction)
+{
+	uint64_t count = now->count - ((prev != NULL) ? prev->count : 0);
+	uint64_t rank = 0;
+	uint64_t seen = 0;
+	int i;
+
+	if (count == 0)
+	{
+		return 0;
+	}
+	fraction = (fraction < 0.0) ? 0.0 : ((fraction > 1.0) ? 1.0 : fraction);
+	rank = (uint64_t)(fraction * (double)count + 0.5);
+	rank = (rank < 1) ? 1 : rank;
+	for (i = 0; i < LATENCY_BUCKETS; i++)
+	{
+		seen += now->buckets[i] - ((prev != NULL) ? prev->buckets[i] : 0);
+		if (seen >= rank)
+		{
+			break;
+		}
+	}
+	i = (i < LATENCY_BUCKETS) ? i : (LATENCY_BUCKETS - 1);
+	return (_BucketStart( i) + _BucketStart( i + 1)) / 2;
+}
+
+// !
+// LatencyStats_Print
+//
+/*!
+	Print the distributions (on stderr) : p50 / p90 / p99 / max of every stage
+	since "prev" (an earlier snapshot, NULL = since the start - the max is then exact).
+*/
+void LatencyStats_Print( const LATENCY_SNAPSHOT *now, const LATENCY_SNAPSHOT *prev, const char *label)
+{
+	const char *sep = " :";
+	uint64_t frames = 0;
+	int i;
+
+	frames = now->stages[LATENCY_CONVERT].count - ((prev != NULL) ? prev->stages[LATENCY_CONVERT].count : 0);
+	fprintf(stderr, "%s latency (%llu frames, ms p50/p90/p99/max)", (label != NULL) ? label : "frame", (unsigned long long)frames);
+	for (i = 0; i < LATENCY_NUM_STAGES; i++)
+	{
+		const LATENCY_HISTOGRAM *h = &now->stages[i];
+		const LATENCY_HISTOGRAM *p = (prev != NULL) ? &prev->stages[i] : NULL;
+		uint64_t negative = h->negative - ((p != NULL) ? p->negative : 0);
+
+		if (h->count == ((p != NULL) ? p->count : 0))
+		{
+			if (negative > 0)
+			{
+				fprintf(stderr, "%s %s %llu below 0", sep, s_stageNames[i], (unsigned long long)negative);
+				sep = ",";
+			}
+			continue;
+		}
+		fprintf(stderr, "%s %s %.3f/%.3f/%.3f/%.3f", sep, s_stageNames[i],
+				(double)LatencyStats_Percentile( h, p, 0.50) / 1e6,
+				(double)LatencyStats_Percentile( h, p, 0.90) / 1e6,
+				(double)LatencyStats_Percentile( h, p, 0.99) / 1e6,
+				(double)((p != NULL) ? LatencyStats_Percentile( h, p, 1.0) : h->nsMax) / 1e6);
+		if (negative > 0)
+		{
+			fprintf(stderr, " (%llu below 0)", (unsigned long long)negative);
+		}
+		sep = ",";
+	}
+	if (frames == 0)
+	{
+		fprintf(stderr, "%s none", sep);
+	}
+	fprintf(stderr, "\n");
+}
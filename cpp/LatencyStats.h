@@ -0,0 +1,77 @@
+#ifndef __LATENCY_STATS_H__
+#define __LATENCY_STATS_H__
+
+#include <stdint.h>
+
+//=============================================================================
+// Frame latency distributions of one camera.
+//
+// Each frame passes four points in time, all on the host clock the camera
+// clock is mapped to (ClockSync, CLOCK_MONOTONIC_RAW) :
+//
+//	exposure   Camera timestamp of the frame, mapped to the host.
+//	arrival    The transfer handed the buffer over.
+//	converted  The output image is ready (converted / copied, or the buffer itself).
+//	published  The frame was written to its output stream.
+//
+// and so three stages (wire = exposure to arrival, convert, publish) and
+// their total. Every stage has a histogram with four buckets per power of
+// two (a value is known to within 25%), from which the percentiles come.
+// Frames with no exposure time (clock not synchronized) only count in the
+// stages after the arrival. A wire latency below zero (the mapping is off)
+// is counted apart.
+//
+// Written by the thread that publishes the frames (one per camera) under a
+// sequence count (as AcqStats) : LatencyStats_Read gives a consistent snapshot from any thread,
+// two snapshots the distributions in between.
+//
+
+#define LATENCY_SUB_BUCKETS	4
+#define LATENCY_BUCKETS		(LATENCY_SUB_BUCKETS * 40)	// Up to 2^40 ns (18 minutes).
+
+#define LATENCYSTATS_ERROR_NULL_PTR	-2500 // A pointer passed in is NULL.
+
+typedef enum
+{
+	LATENCY_WIRE = 0,				// Exposure to arrival.
+	LATENCY_CONVERT,				// Arrival to converted.
+	LATENCY_PUBLISH,				// Converted to published.
+	LATENCY_TOTAL,					// Exposure to published.
+	LATENCY_NUM_STAGES
+} LATENCY_STAGE;
+
+typedef struct LATENCY_HISTOGRAM_t
+{
+	uint64_t	count;
+	uint64_t	nsTotal;
+	uint64_t	nsMax;
+	uint64_t	negative;					// Values below zero (not in the buckets).
+	uint64_t	buckets[LATENCY_BUCKETS];
+} LATENCY_HISTOGRAM;
+
+typedef struct LATENCY_SNAPSHOT_t
+{
+	LATENCY_HISTOGRAM	stages[LATENCY_NUM_STAGES];
+} LATENCY_SNAPSHOT;
+
+typedef struct LATENCY_STATS_t
+{
+	uint32_t	sequence;					// Odd while the histograms are being updated.
+	LATENCY_SNAPSHOT	histograms;
+} LATENCY_STATS;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int LatencyStats_Init( LATENCY_STATS *stats);
+void LatencyStats_Frame( LATENCY_STATS *stats, uint64_t exposureNs, uint64_t arrivalNs, uint64_t convertedNs, uint64_t publishedNs);
+int LatencyStats_Read( const LATENCY_STATS *stats, LATENCY_SNAPSHOT *snapshot);
+uint64_t LatencyStats_Percentile( const LATENCY_HISTOGRAM *now, const LATENCY_HISTOGRAM *prev, double fraction);
+void LatencyStats_Print( const LATENCY_SNAPSHOT *now, const LATENCY_SNAPSHOT *prev, const char *label);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
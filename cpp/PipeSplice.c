@@ -0,0 +1,223 @@
+/*
+  ---------------------------------------------
+  Zero-copy (vmsplice) frame output to a pipe
+  -----------------------------------------------
+*/
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <time.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include "PipeSplice.h"
+
+static inline uint64_t _ns_now( void )
+{
+	struct timespec ts;
+	clock_gettime( CLOCK_MONOTONIC, &ts);
+	return ((uint64_t)ts.tv_sec * 1000000000ULL) + (uint64_t)ts.tv_nsec;
+}
+
+// Push the whole iovec out with writev or vmsplice (both can return short counts).
+static int _WriteAll( PIPE_SPLICE *ps, struct iovec *iov, int iovcnt, int splice)
+{
+	while (iovcnt > 0)
+	{
+		ssize_t n = (splice) ? vmsplice(ps->fd, iov, iovcnt, 0) : writev(ps->fd, iov, iovcnt);
+		ps->stats.syscalls++;
+		if (n < 0)
+		{
+			if (errno == EINTR)
+			{
+				continue;
+			}
+			return PIPESPLICE_ERROR_WRITE;
+		}
+		ps->bytesWritten += n;
+		if (splice)
+		{
+			ps->stats.bytesSpliced += n;
+		}
+		else
+		{
+			ps->stats.bytesCopied += n;
+		}
+		while ((iovcnt > 0) && ((size_t)n >= iov->iov_len))
+		{
+			n -= iov->iov_len;
+			iov++;
+			iovcnt--;
+		}
+		if (iovcnt > 0)
+		{
+			iov->iov_base = (char *)iov->iov_base + n;
+			iov->iov_len -= n;
+		}
+	}
+	return 0;
+}
+
+// !
+// PipeSplice_Init
+//
+/*!
+	Set up frame output on a file descriptor.
+
+	\param ps           Output object to initialize.
+	\param fd           Output file descriptor (eg STDOUT_FILENO).
+	\param useVmsplice  Hand frames to the pipe by reference (only if fd is a pipe).
+	\param pipeSize     Requested pipe capacity in bytes (0 = leave as is). A bigger pipe lets
+	                    more frames be queued before vmsplice blocks. The request is capped
+	                    by /proc/sys/fs/pipe-max-size.
+
+	\return Error status
+		0   = Success
+*/
+int PipeSplice_Init( PIPE_SPLICE *ps, int fd, int useVmsplice, size_t pipeSize)
+{
+	struct stat st;
+
+	if (ps == NULL)
+	{
+		return PIPESPLICE_ERROR_NULL_PTR;
+	}
+	memset(ps, 0, sizeof(PIPE_SPLICE));
+	ps->fd = fd;
+	ps->isPipe = ((fstat(fd, &st) == 0) && S_ISFIFO(st.st_mode));
+	ps->useVmsplice = (useVmsplice && ps->isPipe);
+
+	if (ps->isPipe && (pipeSize > 0))
+	{
+		// Ask for the size - then back off to what the system allows.
+		while ((fcntl(fd, F_SETPIPE_SZ, (int)pipeSize) < 0) && (pipeSize > 65536))
+		{
+			pipeSize /= 2;
+		}
+	}
+	return 0;
+}
+
+// !
+// PipeSplice_WriteFrame
+//
+/*!
+	Write a frame (header + data) to the output.
+
+	When vmsplice is enabled and a cookie is supplied, the data is handed to the pipe by
+	reference and the buffer stays pending until PipeSplice_Reclaim returns its cookie.
+	Otherwise the header and data are copied with one writev call.
+
+	\return
+		0   = Written by copy - the data buffer can be reused right away.
+		1   = Written by reference - the buffer is pending (do not modify / recycle it yet).
+		PIPESPLICE_ERROR_FULL   Too many frames pending - reclaim some first.
+		PIPESPLICE_ERROR_WRITE  The write failed (eg. the reader went away).
+*/
+int PipeSplice_WriteFrame( PIPE_SPLICE *ps, const void *header, size_t headerLen, const void *data, size_t length, void *cookie)
+{
+	struct iovec iov[2];
+	uint64_t start = 0;
+	int status = 0;
+
+	if ((ps == NULL) || (header == NULL) || (data == NULL))
+	{
+		return PIPESPLICE_ERROR_NULL_PTR;
+	}
+
+	start = _ns_now();
+	if (ps->useVmsplice && (cookie != NULL) && (headerLen <= sizeof(ps->pending[0].header)))
+	{
+		PIPE_SPLICE_PENDING *entry = NULL;
+
+		if (ps->count >= PIPE_SPLICE_MAX_PENDING)
+		{
+			return PIPESPLICE_ERROR_FULL;
+		}
+		// The header is spliced from the pending entry so it stays put until it is read.
+		entry = &ps->pending[(ps->head + ps->count) % PIPE_SPLICE_MAX_PENDING];
+		memcpy(entry->header, header, headerLen);
+		iov[0].iov_base = entry->header;
+		iov[0].iov_len  = headerLen;
+		iov[1].iov_base = (void *)data;
+		iov[1].iov_len  = length;
+		status = _WriteAll( ps, iov, 2, 1);
+		if (status == 0)
+		{
+			entry->end = ps->bytesWritten;
+			entry->cookie = cookie;
+			ps->count++;
+			status = 1;
+		}
+	}
+	else
+	{
+		iov[0].iov_base = (void *)header;
+		iov[0].iov_len  = headerLen;
+		iov[1].iov_base = (void *)data;
+		iov[1].iov_len  = length;
+		status = _WriteAll( ps, iov, 2, 0);
+	}
+	ps->stats.nsWriting += _ns_now() - start;
+	ps->stats.frames++;
+	return status;
+}
+
+// !
+// PipeSplice_Reclaim
+//
+/*!
+	Get back the cookie of the oldest pending frame if the reader has consumed it.
+
+	\return 1 if *cookie was set (buffer can be recycled), 0 if nothing can be reclaimed yet.
+*/
+int PipeSplice_Reclaim( PIPE_SPLICE *ps, void **cookie)
+{
+	int unread = 0;
+	uint64_t consumed = 0;
+
+	if ((ps == NULL) || (cookie == NULL) || (ps->count == 0))
+	{
+		return 0;
+	}
+	if (ioctl(ps->fd, FIONREAD, &unread) != 0)
+	{
+		// (Unknown : the pipe may still reference every page written).
+		return 0;
+	}
+	consumed = ps->bytesWritten - (uint64_t)unread;
+	if (ps->pending[ps->head].end <= consumed)
+	{
+		*cookie = ps->pending[ps->head].cookie;
+		ps->pending[ps->head].cookie = NULL;
+		ps->head = (ps->head + 1) % PIPE_SPLICE_MAX_PENDING;
+		ps->count--;
+		return 1;
+	}
+	return 0;
+}
+
+int PipeSplice_PendingCount( PIPE_SPLICE *ps)
+{
+	return (ps != NULL) ? ps->count : 0;
+}
+
+void PipeSplice_PrintStats( PIPE_SPLICE *ps, const char *label)
+{
+	if ((ps != NULL) && (ps->stats.frames > 0))
+	{
+		fprintf(stderr, "%s: %llu frames, %.2f syscalls/frame, %.1f us/frame in output, %llu KB copied, %llu KB spliced\n",
+				(label != NULL) ? label : "output",
+				(unsigned long long)ps->stats.frames,
+				(double)ps->stats.syscalls / (double)ps->stats.frames,
+				((double)ps->stats.nsWriting / 1000.0) / (double)ps->stats.frames,
+				(unsigned long long)(ps->stats.bytesCopied / 1024),
+				(unsigned long long)(ps->stats.bytesSpliced / 1024));
+	}
+}
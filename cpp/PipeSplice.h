@@ -0,0 +1,69 @@
+#ifndef __PIPE_SPLICE_H__
+#define __PIPE_SPLICE_H__
+
+#include <stdint.h>
+#include <stdlib.h>
+
+//=============================================================================
+// Zero-copy frame output to a pipe.
+//
+// Frames are handed to the pipe with vmsplice(2) : the pipe references the
+// pages of the caller's buffer instead of copying them. The buffer must not
+// be modified until the reader has drained those bytes, so every frame
+// written this way stays "pending" (with a caller supplied cookie, eg. the
+// GEV buffer object) until the unread byte count of the pipe (FIONREAD) shows
+// it was consumed. PipeSplice_Reclaim hands the cookies back in order.
+//
+// If the output is not a pipe (or vmsplice is not wanted) frames are written
+// with a single writev(2) instead (one copy, no stdio buffering).
+//
+
+#define PIPE_SPLICE_MAX_PENDING		64
+
+#define PIPESPLICE_ERROR_NULL_PTR		-1300 // A pointer passed in is NULL.
+#define PIPESPLICE_ERROR_WRITE		-1301 // write/vmsplice failed (see errno).
+#define PIPESPLICE_ERROR_FULL			-1302 // Too many frames pending (call PipeSplice_Reclaim).
+
+typedef struct PIPE_SPLICE_PENDING_t
+{
+	uint64_t	end;				// Stream offset just past the frame.
+	void		*cookie;			// Caller's handle for the buffer.
+	unsigned char	header[64];	// Copy of the frame header (spliced from here).
+} PIPE_SPLICE_PENDING;
+
+typedef struct PIPE_SPLICE_STATS_t
+{
+	uint64_t	frames;			// Frames written.
+	uint64_t	syscalls;		// write/writev/vmsplice calls made.
+	uint64_t	bytesSpliced;	// Bytes handed over by reference.
+	uint64_t	bytesCopied;	// Bytes copied into the pipe.
+	uint64_t	nsWriting;		// Time spent in the output calls.
+} PIPE_SPLICE_STATS;
+
+typedef struct PIPE_SPLICE_t
+{
+	int		fd;
+	int		isPipe;
+	int		useVmsplice;
+	uint64_t	bytesWritten;
+	int		head;
+	int		count;
+	PIPE_SPLICE_PENDING	pending[PIPE_SPLICE_MAX_PENDING];
+	PIPE_SPLICE_STATS		stats;
+} PIPE_SPLICE, *PPIPE_SPLICE;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int PipeSplice_Init( PIPE_SPLICE *ps, int fd, int useVmsplice, size_t pipeSize);
+int PipeSplice_WriteFrame( PIPE_SPLICE *ps, const void *header, size_t headerLen, const void *data, size_t length, void *cookie);
+int PipeSplice_Reclaim( PIPE_SPLICE *ps, void **cookie);
+int PipeSplice_PendingCount( PIPE_SPLICE *ps);
+void PipeSplice_PrintStats( PIPE_SPLICE *ps, const char *label);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
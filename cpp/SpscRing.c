@@ -0,0 +1,362 @@
+/*
+  ---------------------------------------------
+  Lock-free single producer / single consumer ring
+  -----------------------------------------------
+*/
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include "SpscRing.h"
+
+static const char *s_policyNames[] = { "block", "drop-oldest" };
+
+static inline uint64_t _ns_now( void )
+{
+	struct timespec ts;
+	clock_gettime( CLOCK_MONOTONIC, &ts);
+	return ((uint64_t)ts.tv_sec * 1000000000ULL) + (uint64_t)ts.tv_nsec;
+}
+
+// Let the other hyperthread of the core run while spinning.
+static inline void _Pause( void )
+{
+#if defined(__x86_64__) || defined(__i386__)
+	__builtin_ia32_pause();
+#elif defined(__aarch64__)
+	__asm__ __volatile__("yield");
+#endif
+}
+
+// Statistics counters : one writer, read with relaxed loads from any thread.
+static inline void _Count( uint64_t *counter, uint64_t n)
+{
+	__atomic_store_n(counter, *counter + n, __ATOMIC_RELAXED);
+}
+
+// Wait until "word" moves off "value" (or the ring is shut down) : spin, then sleep on the
+// futex "signal" once "waiting" tells the other side to wake us up.
+static void _WaitChange( SPSC_RING *ring, const uint32_t *word, uint32_t value, uint32_t *signal, uint32_t *waiting)
+{
+	static int s_spin = -1;
+	uint32_t seen = 0;
+	int i;
+
+	if (s_spin < 0)
+	{
+		// (Spinning on the only CPU just delays the other side).
+		s_spin = (sysconf(_SC_NPROCESSORS_ONLN) > 1) ? SPSC_RING_SPIN : 0;
+	}
+	for (i = 0; i < s_spin; i++)
+	{
+		if ((__atomic_load_n(word, __ATOMIC_ACQUIRE) != value) || __atomic_load_n(&ring->shutdown, __ATOMIC_ACQUIRE))
+		{
+			return;
+		}
+		_Pause();
+	}
+	seen = __atomic_load_n(signal, __ATOMIC_ACQUIRE);
+	__atomic_store_n(waiting, 1, __ATOMIC_SEQ_CST);
+	// (Checked again after raising the flag : the other side either sees it or we see its update).
+	if ((__atomic_load_n(word, __ATOMIC_SEQ_CST) == value) && !__atomic_load_n(&ring->shutdown, __ATOMIC_SEQ_CST))
+	{
+		syscall(SYS_futex, signal, FUTEX_WAIT_PRIVATE, seen, NULL, NULL, 0);
+	}
+	__atomic_store_n(waiting, 0, __ATOMIC_RELAXED);
+}
+
+// Wake up the other side if it is asleep (after an update of the word it waits on).
+static inline void _Wake( uint32_t *signal, uint32_t *waiting)
+{
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	if (__atomic_load_n(waiting, __ATOMIC_RELAXED))
+	{
+		__atomic_add_fetch(signal, 1, __ATOMIC_RELEASE);
+		syscall(SYS_futex, signal, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+	}
+}
+
+// !
+// SpscRing_Create
+//
+/*!
+	Set up a ring of "size" handles (rounded up to a power of two).
+
+	\return Error status
+		0   = Success
+*/
+int SpscRing_Create( SPSC_RING *ring, uint32_t size, SPSC_RING_POLICY policy)
+{
+	uint32_t slots = SpscRing_Slots( size);
+
+	if (ring == NULL)
+	{
+		return SPSCRING_ERROR_NULL_PTR;
+	}
+	if ((size == 0) || (size > SPSC_RING_MAX_SIZE) || (policy < SPSC_RING_BLOCK) || (policy > SPSC_RING_DROP_OLDEST))
+	{
+		return SPSCRING_ERROR_PARAMETER;
+	}
+	memset(ring, 0, sizeof(SPSC_RING));
+	ring->slots = (void **)calloc( slots, sizeof(void *));
+	if (ring->slots == NULL)
+	{
+		return SPSCRING_ERROR_NO_MEMORY;
+	}
+	ring->size = slots;
+	ring->mask = slots - 1;
+	ring->policy = policy;
+	return 0;
+}
+
+// Slots of a ring asked for "size" handles.
+uint32_t SpscRing_Slots( uint32_t size)
+{
+	uint32_t slots = 1;
+
+	while ((slots < size) && (slots < SPSC_RING_MAX_SIZE))
+	{
+		slots <<= 1;
+	}
+	return slots;
+}
+
+void SpscRing_Destroy( SPSC_RING *ring)
+{
+	if (ring != NULL)
+	{
+		free(ring->slots);
+		ring->slots = NULL;
+	}
+}
+
+// !
+// SpscRing_Push
+//
+/*!
+	Add a handle (producer thread only). When the ring is full, a blocking ring
+	waits for room, a drop-oldest one takes out the oldest handle and returns it
+	in "dropped" - the caller releases it (NULL = nothing dropped).
+
+	\return Error status
+		0   = Success
+		SPSCRING_ERROR_SHUTDOWN = the ring was shut down (the handle was not added)
+*/
+int SpscRing_Push( SPSC_RING *ring, void *item, void **dropped)
+{
+	uint32_t head = ring->head;
+	uint32_t tail = 0;
+	uint32_t depth = 0;
+	uint64_t start = 0;
+
+	if (dropped != NULL)
+	{
+		*dropped = NULL;
+	}
+	for (;;)
+	{
+		if (__atomic_load_n(&ring->shutdown, __ATOMIC_ACQUIRE))
+		{
+			return SPSCRING_ERROR_SHUTDOWN;
+		}
+		tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+		if ((head - tail) < ring->size)
+		{
+			break;
+		}
+		if ((ring->policy == SPSC_RING_DROP_OLDEST) && (dropped != NULL))
+		{
+			// Take the oldest handle from under the consumer (it retries if it was reading it).
+			void *oldest = __atomic_load_n(&ring->slots[tail & ring->mask], __ATOMIC_RELAXED);
+
+			if (__atomic_compare_exchange_n(&ring->tail, &tail, tail + 1, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+			{
+				*dropped = oldest;
+				_Count( &ring->dropped, 1);
+				tail++;
+				break;
+			}
+			continue;
+		}
+		if (start == 0)
+		{
+			start = _ns_now();
+			_Count( &ring->full, 1);
+		}
+		_WaitChange( ring, &ring->tail, tail, &ring->producerSignal, &ring->producerWaiting);
+	}
+	if (start != 0)
+	{
+		_Count( &ring->nsFull, _ns_now() - start);
+	}
+
+	__atomic_store_n(&ring->slots[head & ring->mask], item, __ATOMIC_RELAXED);
+	__atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+	_Wake( &ring->consumerSignal, &ring->consumerWaiting);
+
+	depth = head + 1 - tail;
+	_Count( &ring->pushed, 1);
+	_Count( &ring->depthTotal, depth);
+	if (depth > ring->maxDepth)
+	{
+		__atomic_store_n(&ring->maxDepth, depth, __ATOMIC_RELAXED);
+	}
+	return 0;
+}
+
+// !
+// SpscRing_Pop
+//
+/*!
+	Take the oldest handle (consumer thread only), waiting for one if the ring
+	is empty. The handles still in a ring that was shut down are handed out
+	before it reports the shutdown.
+
+	\return Error status
+		0   = Success
+		SPSCRING_ERROR_SHUTDOWN = the ring was shut down and is empty
+*/
+int SpscRing_Pop( SPSC_RING *ring, void **item)
+{
+	uint32_t head = 0;
+	uint32_t tail = 0;
+	uint64_t start = 0;
+
+	for (;;)
+	{
+		tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+		head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+		if (head != tail)
+		{
+			void *value = __atomic_load_n(&ring->slots[tail & ring->mask], __ATOMIC_RELAXED);
+
+			// (Fails if the producer dropped this one meanwhile - try the next).
+			if (__atomic_compare_exchange_n(&ring->tail, &tail, tail + 1, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+			{
+				*item = value;
+				break;
+			}
+			continue;
+		}
+		if (__atomic_load_n(&ring->shutdown, __ATOMIC_ACQUIRE))
+		{
+			*item = NULL;
+			return SPSCRING_ERROR_SHUTDOWN;
+		}
+		if (start == 0)
+		{
+			start = _ns_now();
+			_Count( &ring->empty, 1);
+		}
+		_WaitChange( ring, &ring->head, head, &ring->consumerSignal, &ring->consumerWaiting);
+	}
+	_Wake( &ring->producerSignal, &ring->producerWaiting);
+
+	if (start != 0)
+	{
+		_Count( &ring->nsEmpty, _ns_now() - start);
+	}
+	_Count( &ring->popped, 1);
+	return 0;
+}
+
+// Stop the ring : pushes fail, pops hand out what is left then fail, the waiters are woken up.
+void SpscRing_Shutdown( SPSC_RING *ring)
+{
+	if (ring != NULL)
+	{
+		__atomic_store_n(&ring->shutdown, 1, __ATOMIC_SEQ_CST);
+		__atomic_add_fetch(&ring->consumerSignal, 1, __ATOMIC_RELEASE);
+		syscall(SYS_futex, &ring->consumerSignal, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+		__atomic_add_fetch(&ring->producerSignal, 1, __ATOMIC_RELEASE);
+		syscall(SYS_futex, &ring->producerSignal, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+	}
+}
+
+// Open a ring that was shut down (and drained) again - its statistics go on (no thread may be using it).
+void SpscRing_Restart( SPSC_RING *ring)
+{
+	if (ring != NULL)
+	{
+		__atomic_store_n(&ring->shutdown, 0, __ATOMIC_SEQ_CST);
+	}
+}
+
+// Handles in the ring right now.
+uint32_t SpscRing_Depth( const SPSC_RING *ring)
+{
+	return __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+}
+
+void SpscRing_GetStats( const SPSC_RING *ring, SPSC_RING_STATS *stats)
+{
+	stats->pushed = __atomic_load_n(&ring->pushed, __ATOMIC_RELAXED);
+	stats->dropped = __atomic_load_n(&ring->dropped, __ATOMIC_RELAXED);
+	stats->full = __atomic_load_n(&ring->full, __ATOMIC_RELAXED);
+	stats->nsFull = __atomic_load_n(&ring->nsFull, __ATOMIC_RELAXED);
+	stats->depthTotal = __atomic_load_n(&ring->depthTotal, __ATOMIC_RELAXED);
+	stats->maxDepth = __atomic_load_n(&ring->maxDepth, __ATOMIC_RELAXED);
+	stats->popped = __atomic_load_n(&ring->popped, __ATOMIC_RELAXED);
+	stats->empty = __atomic_load_n(&ring->empty, __ATOMIC_RELAXED);
+	stats->nsEmpty = __atomic_load_n(&ring->nsEmpty, __ATOMIC_RELAXED);
+}
+
+// !
+// SpscRing_PrintStats
+//
+/*!
+	Print the traffic through a ring since "prev" (an earlier snapshot, NULL =
+	since the start) on stderr : mean and max occupancy, drops, and the time
+	each side waited (for room / for work).
+*/
+void SpscRing_PrintStats( const SPSC_RING *ring, const SPSC_RING_STATS *now, const SPSC_RING_STATS *prev, const char *label)
+{
+	SPSC_RING_STATS zero;
+	uint64_t pushed = 0;
+
+	if ((ring == NULL) || (now == NULL))
+	{
+		return;
+	}
+	if (prev == NULL)
+	{
+		memset(&zero, 0, sizeof(zero));
+		prev = &zero;
+	}
+	pushed = now->pushed - prev->pushed;
+	fprintf(stderr, "%s (%s, %u slots): %llu in, %llu out, depth %.2f mean / %u max, %llu dropped, "
+					"producer waited %.1f ms (%llu times), consumer waited %.1f ms (%llu times)\n",
+			(label != NULL) ? label : "ring", SpscRing_PolicyName( ring->policy), ring->size,
+			(unsigned long long)pushed, (unsigned long long)(now->popped - prev->popped),
+			(pushed > 0) ? (double)(now->depthTotal - prev->depthTotal) / (double)pushed : 0.0, now->maxDepth,
+			(unsigned long long)(now->dropped - prev->dropped),
+			(double)(now->nsFull - prev->nsFull) / 1e6, (unsigned long long)(now->full - prev->full),
+			(double)(now->nsEmpty - prev->nsEmpty) / 1e6, (unsigned long long)(now->empty - prev->empty));
+}
+
+int SpscRing_ParsePolicy( const char *name)
+{
+	int i;
+
+	if (name != NULL)
+	{
+		for (i = 0; i < (int)(sizeof(s_policyNames) / sizeof(s_policyNames[0])); i++)
+		{
+			if (strcmp(name, s_policyNames[i]) == 0)
+			{
+				return i;
+			}
+		}
+	}
+	return -1;
+}
+
+const char *SpscRing_PolicyName( SPSC_RING_POLICY policy)
+{
+	return ((policy >= SPSC_RING_BLOCK) && (policy <= SPSC_RING_DROP_OLDEST)) ? s_policyNames[policy] : "unknown";
+}
@@ -0,0 +1,113 @@
+#ifndef __SPSC_RING_H__
+#define __SPSC_RING_H__
+
+#include <stdint.h>
+
+//=============================================================================
+// Bounded lock-free single producer / single consumer ring of handles.
+//
+// Links two stages of the frame pipeline (acquisition -> conversion ->
+// publication) : one thread pushes pointers to its frames, the next one pops
+// them, in order. The ring is a power of two of slots indexed by two free
+// running counters - head (written by the producer only) and tail - each on
+// its own cache line (padded apart). No lock is taken on either side : a push or a pop is a
+// couple of atomic loads and one release store.
+//
+// A side that has to wait (empty ring for the consumer, full ring for a
+// blocking producer) spins for a little while, then sleeps on a futex. The
+// other side only makes the wake up system call when a waiter said it was
+// going to sleep. What a push does when the ring is full is the policy :
+//
+//	SPSC_RING_BLOCK        Wait for room - nothing is lost here (the producer
+//	                       stage stalls instead).
+//	SPSC_RING_DROP_OLDEST  The oldest handle in the ring makes room for the new
+//	                       one and is handed back to the producer (to release
+//	                       what it holds). The producer takes it by moving the
+//	                       tail on with a compare and swap, which is why the
+//	                       consumer moves the tail with one too.
+//
+// Each side keeps its own statistics (single writer, read from any thread) :
+// the occupancy of the ring at every push, how long the producer waited for
+// room and how long the consumer waited for work. A stage whose input ring is
+// full and that never waits for work is the bottleneck.
+//
+
+#define SPSC_RING_MAX_SIZE		1024
+#define SPSC_RING_SPIN			256		// Checks before going to sleep.
+#define SPSC_RING_CACHE_LINE	64
+
+#define SPSCRING_ERROR_NULL_PTR		-2700 // A pointer passed in is NULL.
+#define SPSCRING_ERROR_PARAMETER		-2701 // Invalid size or policy.
+#define SPSCRING_ERROR_NO_MEMORY		-2702 // Slots could not be allocated.
+#define SPSCRING_ERROR_SHUTDOWN		-2703 // The ring was shut down (and is empty, for a pop).
+
+typedef enum
+{
+	SPSC_RING_BLOCK = 0,
+	SPSC_RING_DROP_OLDEST
+} SPSC_RING_POLICY;
+
+typedef struct SPSC_RING_STATS_t
+{
+	uint64_t	pushed;
+	uint64_t	dropped;					// Oldest handles dropped to make room.
+	uint64_t	full;						// Pushes that found the ring full ...
+	uint64_t	nsFull;					// ... and the time the producer waited for room.
+	uint64_t	depthTotal;				// Sum of the handles in the ring at every push (mean = depthTotal / pushed).
+	uint32_t	maxDepth;
+	uint64_t	popped;
+	uint64_t	empty;					// Pops that found the ring empty ...
+	uint64_t	nsEmpty;					// ... and the time the consumer waited for work.
+} SPSC_RING_STATS;
+
+typedef struct SPSC_RING_t
+{
+	// Producer side.
+	uint32_t	head;						// Next slot written.
+	uint32_t	producerSignal;		// Futex word the producer sleeps on (bumped to wake it) ...
+	uint32_t	producerWaiting;		// ... when it said so.
+	uint64_t	pushed;
+	uint64_t	dropped;
+	uint64_t	full;
+	uint64_t	nsFull;
+	uint64_t	depthTotal;
+	uint32_t	maxDepth;
+	char		producerPad[SPSC_RING_CACHE_LINE];	// (Whatever the alignment, the two sides never share a line).
+	// Consumer side.
+	uint32_t	tail;						// Next slot read.
+	uint32_t	consumerSignal;
+	uint32_t	consumerWaiting;
+	uint64_t	popped;
+	uint64_t	empty;
+	uint64_t	nsEmpty;
+	char		consumerPad[SPSC_RING_CACHE_LINE];
+	// Fixed.
+	uint32_t	size;
+	uint32_t	mask;
+	SPSC_RING_POLICY	policy;
+	int		shutdown;
+	void		**slots;
+} SPSC_RING;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int SpscRing_Create( SPSC_RING *ring, uint32_t size, SPSC_RING_POLICY policy);
+uint32_t SpscRing_Slots( uint32_t size);
+void SpscRing_Destroy( SPSC_RING *ring);
+int SpscRing_Push( SPSC_RING *ring, void *item, void **dropped);
+int SpscRing_Pop( SPSC_RING *ring, void **item);
+void SpscRing_Shutdown( SPSC_RING *ring);
+void SpscRing_Restart( SPSC_RING *ring);
+uint32_t SpscRing_Depth( const SPSC_RING *ring);
+void SpscRing_GetStats( const SPSC_RING *ring, SPSC_RING_STATS *stats);
+void SpscRing_PrintStats( const SPSC_RING *ring, const SPSC_RING_STATS *now, const SPSC_RING_STATS *prev, const char *label);
+int SpscRing_ParsePolicy( const char *name);
+const char *SpscRing_PolicyName( SPSC_RING_POLICY policy);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
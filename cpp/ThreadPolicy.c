@@ -0,0 +1,419 @@
+/*
+  ---------------------------------------------
+  Scheduling and CPU placement of the pipeline threads
+  -----------------------------------------------
+*/
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include "ThreadPolicy.h"
+
+static const char *s_roleNames[THREAD_NUM_ROLES] =
+{
+	"acquisition", "converter", "output", "display"
+};
+
+static const struct
+{
+	const char	*name;
+	int			policy;				// (-1 = inherit).
+} s_classes[] =
+{
+	{ "inherit", -1 },
+	{ "other", SCHED_OTHER },
+	{ "batch", SCHED_BATCH },
+	{ "idle", SCHED_IDLE },
+	{ "rr", SCHED_RR },
+	{ "fifo", SCHED_FIFO },
+};
+
+// Topology (read once).
+static pthread_once_t s_once = PTHREAD_ONCE_INIT;
+static pthread_mutex_t s_lock = PTHREAD_MUTEX_INITIALIZER;
+static cpu_set_t s_allowed;		// CPUs the process may use (when first asked).
+static cpu_set_t s_reserved;		// CPUs of the GEV threads and their SMT siblings.
+
+static void _ReadTopology( void )
+{
+	CPU_ZERO(&s_reserved);
+	if (sched_getaffinity( 0, sizeof(s_allowed), &s_allowed) != 0)
+	{
+		int i;
+		long numCpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+		CPU_ZERO(&s_allowed);
+		for (i = 0; (i < numCpus) && (i < CPU_SETSIZE); i++)
+		{
+			CPU_SET(i, &s_allowed);
+		}
+	}
+}
+
+// CPU list ("0-3,8,10-11") to a set (adds to it).
+static int _ParseCpuList( const char *text, cpu_set_t *set)
+{
+	const char *p = text;
+
+	while ((*p != '\0') && (*p != '\n'))
+	{
+		char *end = NULL;
+		long first = strtol(p, &end, 10);
+		long last = first;
+
+		if ((end == p) || (first < 0))
+		{
+			return -1;
+		}
+		p = end;
+		if (*p == '-')
+		{
+			last = strtol(p + 1, &end, 10);
+			if ((end == p + 1) || (last < first))
+			{
+				return -1;
+			}
+			p = end;
+		}
+		for (; (first <= last) && (first < CPU_SETSIZE); first++)
+		{
+			CPU_SET((int)first, set);
+		}
+		if (*p == ',')
+		{
+			p++;
+		}
+		else if ((*p != '\0') && (*p != '\n'))
+		{
+			return -1;
+		}
+	}
+	return 0;
+}
+
+// CPU list file from /sys (adds to the set - nothing when it can't be read).
+static int _ReadCpuList( const char *path, cpu_set_t *set)
+{
+	char text[1024];
+	FILE *fp = fopen(path, "r");
+	int status = -1;
+
+	if (fp != NULL)
+	{
+		if (fgets(text, sizeof(text), fp) != NULL)
+		{
+			cpu_set_t read;
+
+			CPU_ZERO(&read);
+			status = _ParseCpuList( text, &read);
+			if (status == 0)
+			{
+				CPU_OR(set, set, &read);
+			}
+		}
+		fclose(fp);
+	}
+	return status;
+}
+
+static void _FormatCpuList( const cpu_set_t *set, char *text, size_t size)
+{
+	size_t used = 0;
+	int i = 0;
+
+	text[0] = '\0';
+	while ((i < CPU_SETSIZE) && (used < size))
+	{
+		int first = i;
+
+		if (!CPU_ISSET(i, set))
+		{
+			i++;
+			continue;
+		}
+		while ((i + 1 < CPU_SETSIZE) && CPU_ISSET(i + 1, set))
+		{
+			i++;
+		}
+		used += snprintf(text + used, size - used, (first == i) ? "%s%d" : "%s%d-%d", (used > 0) ? "," : "", first, i);
+		i++;
+	}
+}
+
+// !
+// ThreadPolicy_Parse
+//
+/*!
+	Read a policy : <class>[:<priority>][@<cpus>] (see above).
+
+	\return Error status
+		0   = Success
+		THREADPOLICY_ERROR_PARSE = Unknown class, priority out of range or bad CPU list
+*/
+int ThreadPolicy_Parse( const char *text, THREAD_POLICY *policy)
+{
+	char copy[256];
+	char *cpus = NULL;
+	char *priority = NULL;
+	size_t i;
+
+	if ((text == NULL) || (policy == NULL))
+	{
+		return THREADPOLICY_ERROR_NULL_PTR;
+	}
+	memset(policy, 0, sizeof(THREAD_POLICY));
+	policy->inherit = 1;
+	snprintf(copy, sizeof(copy), "%s", text);
+	cpus = strchr(copy, '@');
+	if (cpus != NULL)
+	{
+		*cpus++ = '\0';
+	}
+	priority = strchr(copy, ':');
+	if (priority != NULL)
+	{
+		*priority++ = '\0';
+	}
+
+	if (copy[0] != '\0')
+	{
+		for (i = 0; i < sizeof(s_classes) / sizeof(s_classes[0]); i++)
+		{
+			if (strcmp(copy, s_classes[i].name) == 0)
+			{
+				break;
+			}
+		}
+		if (i == sizeof(s_classes) / sizeof(s_classes[0]))
+		{
+			return THREADPOLICY_ERROR_PARSE;
+		}
+		policy->inherit = (s_classes[i].policy < 0);
+		policy->policy = policy->inherit ? SCHED_OTHER : s_classes[i].policy;
+	}
+	if ((policy->policy == SCHED_RR) || (policy->policy == SCHED_FIFO))
+	{
+		char *end = NULL;
+
+		policy->priority = sched_get_priority_min( policy->policy);
+		if (priority != NULL)
+		{
+			long value = strtol(priority, &end, 10);
+			if ((end == priority) || (*end != '\0') ||
+				 (value < sched_get_priority_min( policy->policy)) || (value > sched_get_priority_max( policy->policy)))
+			{
+				return THREADPOLICY_ERROR_PARSE;
+			}
+			policy->priority = (int)value;
+		}
+	}
+	else if (priority != NULL)
+	{
+		// (Only the real time classes have a priority).
+		return THREADPOLICY_ERROR_PARSE;
+	}
+
+	if ((cpus == NULL) || (cpus[0] == '\0'))
+	{
+		policy->cpuMode = THREAD_CPUS_INHERIT;
+	}
+	else if (strcmp(cpus, "auto") == 0)
+	{
+		policy->cpuMode = THREAD_CPUS_AUTO;
+	}
+	else if (strcmp(cpus, "any") == 0)
+	{
+		policy->cpuMode = THREAD_CPUS_ANY;
+	}
+	else
+	{
+		policy->cpuMode = THREAD_CPUS_LIST;
+		CPU_ZERO(&policy->cpus);
+		if ((_ParseCpuList( cpus, &policy->cpus) != 0) || (CPU_COUNT(&policy->cpus) == 0))
+		{
+			return THREADPOLICY_ERROR_PARSE;
+		}
+	}
+	return 0;
+}
+
+const char *ThreadPolicy_RoleName( THREAD_ROLE role)
+{
+	return ((unsigned)role < THREAD_NUM_ROLES) ? s_roleNames[role] : "unknown";
+}
+
+// !
+// ThreadPolicy_Reserve
+//
+/*!
+	Keep the "auto" threads off a CPU and off its SMT siblings (eg. the CPU the
+	GEV stream thread of a camera is pinned to). Reserve before placing threads.
+*/
+void ThreadPolicy_Reserve( int cpu)
+{
+	char path[128];
+
+	if ((cpu < 0) || (cpu >= CPU_SETSIZE))
+	{
+		return;
+	}
+	pthread_once( &s_once, _ReadTopology);
+	pthread_mutex_lock(&s_lock);
+	CPU_SET(cpu, &s_reserved);
+	snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/core_cpus_list", cpu);
+	if (_ReadCpuList( path, &s_reserved) != 0)
+	{
+		// (Older kernels).
+		snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/thread_siblings_list", cpu);
+		_ReadCpuList( path, &s_reserved);
+	}
+	pthread_mutex_unlock(&s_lock);
+}
+
+// !
+// ThreadPolicy_CpuSet
+//
+/*!
+	The CPUs a policy places a thread on.
+
+	\param numaNode  Node the thread's data comes from (-1 = any) - "auto" prefers its CPUs.
+	\param cpus      The set (empty = the CPUs are left as they are).
+
+	\return Error status
+		0   = Success
+		THREADPOLICY_ERROR_CPUS = None of the CPUs listed can be used
+*/
+int ThreadPolicy_CpuSet( const THREAD_POLICY *policy, int numaNode, cpu_set_t *cpus)
+{
+	cpu_set_t node;
+	int i;
+
+	if ((policy == NULL) || (cpus == NULL))
+	{
+		return THREADPOLICY_ERROR_NULL_PTR;
+	}
+	pthread_once( &s_once, _ReadTopology);
+	CPU_ZERO(cpus);
+	switch (policy->cpuMode)
+	{
+		case THREAD_CPUS_INHERIT:
+			return 0;
+		case THREAD_CPUS_ANY:
+			*cpus = s_allowed;
+			return 0;
+		case THREAD_CPUS_LIST:
+			CPU_AND(cpus, &policy->cpus, &s_allowed);
+			return (CPU_COUNT(cpus) > 0) ? 0 : THREADPOLICY_ERROR_CPUS;
+		case THREAD_CPUS_AUTO:
+		default:
+			break;
+	}
+
+	pthread_mutex_lock(&s_lock);
+	for (i = 0; i < CPU_SETSIZE; i++)
+	{
+		if (CPU_ISSET(i, &s_allowed) && !CPU_ISSET(i, &s_reserved))
+		{
+			CPU_SET(i, cpus);
+		}
+	}
+	pthread_mutex_unlock(&s_lock);
+	if (CPU_COUNT(cpus) == 0)
+	{
+		// (Everything is reserved - share).
+		*cpus = s_allowed;
+	}
+	if (numaNode >= 0)
+	{
+		char path[128];
+
+		CPU_ZERO(&node);
+		snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", numaNode);
+		if (_ReadCpuList( path, &node) == 0)
+		{
+			CPU_AND(&node, &node, cpus);
+			if (CPU_COUNT(&node) > 0)
+			{
+				*cpus = node;
+			}
+		}
+	}
+	return 0;
+}
+
+// !
+// ThreadPolicy_Apply
+//
+/*!
+	Place a running thread : its CPUs, then its scheduling class.
+
+	\return Error status
+		0   = Success
+		THREADPOLICY_ERROR_CPUS  = The CPUs could not be set (the class still was)
+		THREADPOLICY_ERROR_SCHED = The class was refused (the thread keeps its own)
+*/
+int ThreadPolicy_Apply( pthread_t thread, const THREAD_POLICY *policy, int numaNode)
+{
+	cpu_set_t cpus;
+	int status = 0;
+
+	if (policy == NULL)
+	{
+		return THREADPOLICY_ERROR_NULL_PTR;
+	}
+	status = ThreadPolicy_CpuSet( policy, numaNode, &cpus);
+	if ((status == 0) && (CPU_COUNT(&cpus) > 0) && (pthread_setaffinity_np( thread, sizeof(cpus), &cpus) != 0))
+	{
+		status = THREADPOLICY_ERROR_CPUS;
+	}
+	if (!policy->inherit)
+	{
+		struct sched_param param;
+
+		memset(&param, 0, sizeof(param));
+		param.sched_priority = policy->priority;
+		if (pthread_setschedparam( thread, policy->policy, &param) != 0)
+		{
+			status = THREADPOLICY_ERROR_SCHED;
+		}
+	}
+	return status;
+}
+
+// A policy as applied, eg. "rr:20 on CPUs 2-5" (for the logs).
+void ThreadPolicy_Describe( const THREAD_POLICY *policy, int numaNode, char *text, size_t size)
+{
+	char list[256];
+	const char *name = "inherit";
+	cpu_set_t cpus;
+	size_t i;
+	int used = 0;
+
+	for (i = 0; !policy->inherit && (i < sizeof(s_classes) / sizeof(s_classes[0])); i++)
+	{
+		if (s_classes[i].policy == policy->policy)
+		{
+			name = s_classes[i].name;
+			break;
+		}
+	}
+	used = snprintf(text, size, "%s", name);
+	if ((policy->policy == SCHED_RR) || (policy->policy == SCHED_FIFO))
+	{
+		used += snprintf(text + used, (used < (int)size) ? size - used : 0, ":%d", policy->priority);
+	}
+	if ((ThreadPolicy_CpuSet( policy, numaNode, &cpus) == 0) && (CPU_COUNT(&cpus) > 0))
+	{
+		_FormatCpuList( &cpus, list, sizeof(list));
+		snprintf(text + used, (used < (int)size) ? size - used : 0, " on CPUs %s", list);
+	}
+	else
+	{
+		snprintf(text + used, (used < (int)size) ? size - used : 0, ", CPUs as created");
+	}
+}
@@ -0,0 +1,84 @@
+#ifndef __THREAD_POLICY_H__
+#define __THREAD_POLICY_H__
+
+#include <sched.h>
+#include <stddef.h>
+#include <pthread.h>
+
+//=============================================================================
+// Scheduling and CPU placement of the pipeline threads.
+//
+// Each kind of thread (role) has a policy : a scheduling class (with its
+// priority for the real time ones) and the CPUs it may run on, written as
+//
+//	<class>[:<priority>][@<cpus>]
+//
+//	class     inherit (left as created) | other | batch | idle | rr | fifo
+//	priority  1..99, rr and fifo only
+//	cpus      auto  - the CPUs this process may use, less the ones reserved
+//	                  for the GEV stream / server threads and their SMT
+//	                  siblings (the hyperthreads sharing their core),
+//	                  narrowed to the NUMA node of the camera's NIC when it
+//	                  has some of them
+//	          any   - every CPU this process may use
+//	          list  - eg. 2-5,8 (as in /sys and taskset -c)
+//	                  (default : left as created)
+//
+// eg. "rr:20@auto", "other@4-7", "fifo:5". The topology (online CPUs,
+// SMT siblings, NUMA node CPUs) is read from /sys the first time it is
+// needed. CPUs are reserved (ThreadPolicy_Reserve) before the threads
+// are placed.
+//
+// A policy is applied to a running thread (ThreadPolicy_Apply) : the CPU
+// set first, then the class. A real time class needs CAP_SYS_NICE or an
+// RLIMIT_RTPRIO limit - when it is refused the thread keeps its class (and
+// its CPUs).
+//
+
+#define THREADPOLICY_ERROR_NULL_PTR	-2600 // A pointer passed in is NULL.
+#define THREADPOLICY_ERROR_PARSE		-2601 // Not a policy.
+#define THREADPOLICY_ERROR_SCHED		-2602 // The scheduling class / priority was refused (permissions).
+#define THREADPOLICY_ERROR_CPUS		-2603 // None of the CPUs can be used (or the affinity was refused).
+
+typedef enum
+{
+	THREAD_ROLE_ACQUISITION = 0,	// Waits for the frames and hands them on to the pipeline.
+	THREAD_ROLE_CONVERTER,			// Conversion threads (and the band pool).
+	THREAD_ROLE_OUTPUT,				// Publication stage and output writers (stdout queue, socket server, recorder).
+	THREAD_ROLE_DISPLAY,				// X11 display threads.
+	THREAD_NUM_ROLES
+} THREAD_ROLE;
+
+typedef enum
+{
+	THREAD_CPUS_INHERIT = 0,		// Left as created.
+	THREAD_CPUS_AUTO,
+	THREAD_CPUS_ANY,
+	THREAD_CPUS_LIST
+} THREAD_CPUS;
+
+typedef struct THREAD_POLICY_t
+{
+	int		inherit;				// Leave the scheduling class alone.
+	int		policy;				// SCHED_OTHER / SCHED_BATCH / SCHED_IDLE / SCHED_RR / SCHED_FIFO.
+	int		priority;			// Real time priority (rr / fifo).
+	THREAD_CPUS	cpuMode;
+	cpu_set_t	cpus;				// THREAD_CPUS_LIST.
+} THREAD_POLICY;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int ThreadPolicy_Parse( const char *text, THREAD_POLICY *policy);
+const char *ThreadPolicy_RoleName( THREAD_ROLE role);
+void ThreadPolicy_Reserve( int cpu);
+int ThreadPolicy_CpuSet( const THREAD_POLICY *policy, int numaNode, cpu_set_t *cpus);
+int ThreadPolicy_Apply( pthread_t thread, const THREAD_POLICY *policy, int numaNode);
+void ThreadPolicy_Describe( const THREAD_POLICY *policy, int numaNode, char *text, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
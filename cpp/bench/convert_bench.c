@@ -0,0 +1,398 @@
+/*
+  ---------------------------------------------
+  Pixel conversion benchmark : scalar code vs vector kernels.
+  -----------------------------------------------
+
+  Converts synthetic frames of each format at each resolution with the scalar
+  code alone (the reference, as in GevUtils.c), then with the vector kernels
+  of every instruction set the CPU has (ConvertSimd.c - the scalar code
+  finishes the end of the frame, as in GevUtils.c), checks that the output is
+  the same and prints a table of the time per frame and the speedup.
+  Formats :
+	mono10p-8      Mono10Packed to 8 bit mono.
+	mono10p-16     Mono10Packed to 16 bit mono (<< 6, as for a 16 bit display).
+	mono12p-8      Mono12Packed to 8 bit mono.
+	mono12p-16     Mono12Packed to 16 bit mono (<< 4).
+	yuv411-mono    YUV411Packed to 8 bit mono (the luma).
+	yuv422-mono    YUV422Packed to 8 bit mono.
+	yuv444-mono    YUV444Packed to 8 bit mono.
+	yuv411-mono16, yuv422-mono16, yuv444-mono16  ... to 16 bit mono (<< 8).
+	yuv411-rgb888  YUV411Packed to RGB888 (B G R).
+	yuv411-rgb8888 YUV411Packed to RGB8888 (B G R A).
+	yuv422-rgb888, yuv422-rgb8888, yuv444-rgb888, yuv444-rgb8888
+	all            all of the above.
+
+  Usage : convert_bench [format|all] [frames] [width height]
+  (no size = 640x480, 1920x1080 and 2448x2048).
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include "ConvertSimd.h"
+
+#define BENCH_FRAMES		50
+#define BENCH_MAX_LEVELS	(CONVERT_SIMD_AUTO + 1)
+#define BENCH_POISON		0xA5
+
+// A conversion : the kernel does what it can from the start (returns the pixels done), the scalar code the rest.
+typedef int (*KERNEL_FUNC)( const unsigned char *in, unsigned char *out, int pixels);
+typedef void (*SCALAR_FUNC)( const unsigned char *in, unsigned char *out, int pixels);
+
+typedef struct
+{
+	const char	*name;
+	int			inBits;					// Per pixel.
+	int			outBytes;				// Per pixel.
+	int			group;					// Pixels that go together (a pair of packed pixels, the pixels that share U V).
+	KERNEL_FUNC	kernel;
+	SCALAR_FUNC	scalar;
+} BENCH_FORMAT;
+
+static double _now_sec( void )
+{
+	struct timespec ts;
+	clock_gettime( CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + ((double)ts.tv_nsec * 1e-9);
+}
+
+//=============================================================================
+// Scalar code (as in GevUtils.c).
+
+// Packed mono to 8 bits, or to 16 bits shifted left by "lshift".
+static void _MonoPacked( int depth, const unsigned char *in, unsigned char *out, int pixels, int lshift)
+{
+	uint16_t *pOut = (uint16_t *)out;
+	int i;
+	for (i = 0; i < pixels; i += 2)
+	{
+		uint16_t p0 = (depth == 12) ? (uint16_t)((in[0] << 4) | (in[1] & 0x0F)) : (uint16_t)((in[0] << 2) | (in[1] & 0x03));
+		uint16_t p1 = (depth == 12) ? (uint16_t)((in[2] << 4) | (in[1] >> 4)) : (uint16_t)((in[2] << 2) | ((in[1] >> 4) & 0x03));
+
+		if (lshift < 0)
+		{
+			*out++ = (unsigned char)(p0 >> (depth - 8));
+			*out++ = (unsigned char)(p1 >> (depth - 8));
+		}
+		else
+		{
+			*pOut++ = (uint16_t)(p0 << lshift);
+			*pOut++ = (uint16_t)(p1 << lshift);
+		}
+		in += 3;
+	}
+}
+
+static void _Mono10pTo8( const unsigned char *in, unsigned char *out, int pixels) { _MonoPacked( 10, in, out, pixels, -1); }
+static void _Mono10pTo16( const unsigned char *in, unsigned char *out, int pixels) { _MonoPacked( 10, in, out, pixels, 6); }
+static void _Mono12pTo8( const unsigned char *in, unsigned char *out, int pixels) { _MonoPacked( 12, in, out, pixels, -1); }
+static void _Mono12pTo16( const unsigned char *in, unsigned char *out, int pixels) { _MonoPacked( 12, in, out, pixels, 4); }
+
+static void _YUV411ToMono( const unsigned char *in, unsigned char *out, int pixels)
+{
+	int i;
+	for (i = 0; i < pixels; i += 4)
+	{
+		*out++ = in[1];
+		*out++ = in[2];
+		*out++ = in[4];
+		*out++ = in[5];
+		in += 6;
+	}
+}
+
+static void _YUV422ToMono( const unsigned char *in, unsigned char *out, int pixels)
+{
+	int i;
+	for (i = 0; i < pixels; i += 2)
+	{
+		*out++ = in[1];
+		*out++ = in[3];
+		in += 4;
+	}
+}
+
+static void _YUV444ToMono( const unsigned char *in, unsigned char *out, int pixels)
+{
+	int i;
+	for (i = 0; i < pixels; i++)
+	{
+		*out++ = in[1];
+		in += 3;
+	}
+}
+
+// 16 bit mono : the luma << 8.
+static void _YUV411ToMono16( const unsigned char *in, unsigned char *out, int pixels)
+{
+	uint16_t *pOut = (uint16_t *)out;
+	int i;
+	for (i = 0; i < pixels; i += 4)
+	{
+		*pOut++ = (uint16_t)(in[1] << 8);
+		*pOut++ = (uint16_t)(in[2] << 8);
+		*pOut++ = (uint16_t)(in[4] << 8);
+		*pOut++ = (uint16_t)(in[5] << 8);
+		in += 6;
+	}
+}
+
+static void _YUV422ToMono16( const unsigned char *in, unsigned char *out, int pixels)
+{
+	uint16_t *pOut = (uint16_t *)out;
+	int i;
+	for (i = 0; i < pixels; i += 2)
+	{
+		*pOut++ = (uint16_t)(in[1] << 8);
+		*pOut++ = (uint16_t)(in[3] << 8);
+		in += 4;
+	}
+}
+
+static void _YUV444ToMono16( const unsigned char *in, unsigned char *out, int pixels)
+{
+	uint16_t *pOut = (uint16_t *)out;
+	int i;
+	for (i = 0; i < pixels; i++)
+	{
+		*pOut++ = (uint16_t)(in[1] << 8);
+		in += 3;
+	}
+}
+
+// One pixel to B G R (A) - returns the next output pixel.
+static inline unsigned char *_YUVPixel( int32_t Y, int32_t U, int32_t V, unsigned char *out, int alpha)
+{
+	int32_t c;
+
+	c = (Y * 16384 + 29147 * U) >> 14;
+	*out++ = (c < 0) ? 0 : ((c > 255) ? 255 : (unsigned char)c);
+	c = (Y * 16384 - 5661 * U - 11746 * V) >> 14;
+	*out++ = (c < 0) ? 0 : ((c > 255) ? 255 : (unsigned char)c);
+	c = (Y * 16384 + 23060 * V) >> 14;
+	*out++ = (c < 0) ? 0 : ((c > 255) ? 255 : (unsigned char)c);
+	if (alpha)
+	{
+		*out++ = 0xff;
+	}
+	return out;
+}
+
+static void _YUVToRGB8x( int yuv, const unsigned char *in, unsigned char *out, int pixels, int alpha)
+{
+	int i;
+
+	switch (yuv)
+	{
+		case CONVERT_SIMD_YUV411:
+			for (i = 0; i < pixels; i += 4)
+			{
+				out = _YUVPixel( in[1], in[0] - 128, in[3] - 128, out, alpha);
+				out = _YUVPixel( in[2], in[0] - 128, in[3] - 128, out, alpha);
+				out = _YUVPixel( in[4], in[0] - 128, in[3] - 128, out, alpha);
+				out = _YUVPixel( in[5], in[0] - 128, in[3] - 128, out, alpha);
+				in += 6;
+			}
+			break;
+		case CONVERT_SIMD_YUV422:
+			for (i = 0; i < pixels; i += 2)
+			{
+				out = _YUVPixel( in[1], in[0] - 128, in[2] - 128, out, alpha);
+				out = _YUVPixel( in[3], in[0] - 128, in[2] - 128, out, alpha);
+				in += 4;
+			}
+			break;
+		default:
+			for (i = 0; i < pixels; i++)
+			{
+				out = _YUVPixel( in[1], in[0] - 128, in[2] - 128, out, alpha);
+				in += 3;
+			}
+			break;
+	}
+}
+
+static void _YUV411ToRGB888( const unsigned char *in, unsigned char *out, int pixels) { _YUVToRGB8x( CONVERT_SIMD_YUV411, in, out, pixels, 0); }
+static void _YUV411ToRGB8888( const unsigned char *in, unsigned char *out, int pixels) { _YUVToRGB8x( CONVERT_SIMD_YUV411, in, out, pixels, 1); }
+static void _YUV422ToRGB888( const unsigned char *in, unsigned char *out, int pixels) { _YUVToRGB8x( CONVERT_SIMD_YUV422, in, out, pixels, 0); }
+static void _YUV422ToRGB8888( const unsigned char *in, unsigned char *out, int pixels) { _YUVToRGB8x( CONVERT_SIMD_YUV422, in, out, pixels, 1); }
+static void _YUV444ToRGB888( const unsigned char *in, unsigned char *out, int pixels) { _YUVToRGB8x( CONVERT_SIMD_YUV444, in, out, pixels, 0); }
+static void _YUV444ToRGB8888( const unsigned char *in, unsigned char *out, int pixels) { _YUVToRGB8x( CONVERT_SIMD_YUV444, in, out, pixels, 1); }
+
+//=============================================================================
+// Kernels.
+
+static int _KMono10pTo8( const unsigned char *in, unsigned char *out, int pixels) { return 2 * ConvertSimd_UnpackMono8( in, out, pixels / 2); }
+static int _KMono10pTo16( const unsigned char *in, unsigned char *out, int pixels) { return 2 * ConvertSimd_UnpackMono16( in, (uint16_t *)out, pixels / 2, 10, -6); }
+static int _KMono12pTo8( const unsigned char *in, unsigned char *out, int pixels) { return 2 * ConvertSimd_UnpackMono8( in, out, pixels / 2); }
+static int _KMono12pTo16( const unsigned char *in, unsigned char *out, int pixels) { return 2 * ConvertSimd_UnpackMono16( in, (uint16_t *)out, pixels / 2, 12, -4); }
+static int _KYUV411ToMono( const unsigned char *in, unsigned char *out, int pixels) { return ConvertSimd_YUVToMono( CONVERT_SIMD_YUV411, in, out, pixels, 8); }
+static int _KYUV422ToMono( const unsigned char *in, unsigned char *out, int pixels) { return ConvertSimd_YUVToMono( CONVERT_SIMD_YUV422, in, out, pixels, 8); }
+static int _KYUV444ToMono( const unsigned char *in, unsigned char *out, int pixels) { return ConvertSimd_YUVToMono( CONVERT_SIMD_YUV444, in, out, pixels, 8); }
+static int _KYUV411ToMono16( const unsigned char *in, unsigned char *out, int pixels) { return ConvertSimd_YUVToMono( CONVERT_SIMD_YUV411, in, out, pixels, 16); }
+static int _KYUV422ToMono16( const unsigned char *in, unsigned char *out, int pixels) { return ConvertSimd_YUVToMono( CONVERT_SIMD_YUV422, in, out, pixels, 16); }
+static int _KYUV444ToMono16( const unsigned char *in, unsigned char *out, int pixels) { return ConvertSimd_YUVToMono( CONVERT_SIMD_YUV444, in, out, pixels, 16); }
+static int _KYUV411ToRGB888( const unsigned char *in, unsigned char *out, int pixels) { return ConvertSimd_YUVToRGB8x( CONVERT_SIMD_YUV411, in, out, pixels, 0); }
+static int _KYUV411ToRGB8888( const unsigned char *in, unsigned char *out, int pixels) { return ConvertSimd_YUVToRGB8x( CONVERT_SIMD_YUV411, in, out, pixels, 1); }
+static int _KYUV422ToRGB888( const unsigned char *in, unsigned char *out, int pixels) { return ConvertSimd_YUVToRGB8x( CONVERT_SIMD_YUV422, in, out, pixels, 0); }
+static int _KYUV422ToRGB8888( const unsigned char *in, unsigned char *out, int pixels) { return ConvertSimd_YUVToRGB8x( CONVERT_SIMD_YUV422, in, out, pixels, 1); }
+static int _KYUV444ToRGB888( const unsigned char *in, unsigned char *out, int pixels) { return ConvertSimd_YUVToRGB8x( CONVERT_SIMD_YUV444, in, out, pixels, 0); }
+static int _KYUV444ToRGB8888( const unsigned char *in, unsigned char *out, int pixels) { return ConvertSimd_YUVToRGB8x( CONVERT_SIMD_YUV444, in, out, pixels, 1); }
+
+static const BENCH_FORMAT s_formats[] =
+{
+	{ "mono10p-8",      12, 1, 2, _KMono10pTo8,      _Mono10pTo8 },
+	{ "mono10p-16",     12, 2, 2, _KMono10pTo16,     _Mono10pTo16 },
+	{ "mono12p-8",      12, 1, 2, _KMono12pTo8,      _Mono12pTo8 },
+	{ "mono12p-16",     12, 2, 2, _KMono12pTo16,     _Mono12pTo16 },
+	{ "yuv411-mono",    12, 1, 4, _KYUV411ToMono,    _YUV411ToMono },
+	{ "yuv422-mono",    16, 1, 2, _KYUV422ToMono,    _YUV422ToMono },
+	{ "yuv444-mono",    24, 1, 1, _KYUV444ToMono,    _YUV444ToMono },
+	{ "yuv411-mono16",  12, 2, 4, _KYUV411ToMono16,  _YUV411ToMono16 },
+	{ "yuv422-mono16",  16, 2, 2, _KYUV422ToMono16,  _YUV422ToMono16 },
+	{ "yuv444-mono16",  24, 2, 1, _KYUV444ToMono16,  _YUV444ToMono16 },
+	{ "yuv411-rgb888",  12, 3, 4, _KYUV411ToRGB888,  _YUV411ToRGB888 },
+	{ "yuv411-rgb8888", 12, 4, 4, _KYUV411ToRGB8888, _YUV411ToRGB8888 },
+	{ "yuv422-rgb888",  16, 3, 2, _KYUV422ToRGB888,  _YUV422ToRGB888 },
+	{ "yuv422-rgb8888", 16, 4, 2, _KYUV422ToRGB8888, _YUV422ToRGB8888 },
+	{ "yuv444-rgb888",  24, 3, 1, _KYUV444ToRGB888,  _YUV444ToRGB888 },
+	{ "yuv444-rgb8888", 24, 4, 1, _KYUV444ToRGB8888, _YUV444ToRGB8888 },
+};
+#define BENCH_NUM_FORMATS	(int)(sizeof(s_formats) / sizeof(s_formats[0]))
+
+// Convert a frame with the kernels of the current level (none at CONVERT_SIMD_SCALAR) and the scalar code.
+static int _Convert( const BENCH_FORMAT *format, const unsigned char *in, unsigned char *out, int pixels)
+{
+	int done = (ConvertSimd_Level() > CONVERT_SIMD_SCALAR) ? format->kernel( in, out, pixels) : 0;
+
+	format->scalar( in + ((size_t)done * format->inBits) / 8, out + (size_t)done * format->outBytes, pixels - done);
+	return done;
+}
+
+// Best time per frame (ms) over "frames" conversions.
+static double _Time( const BENCH_FORMAT *format, const unsigned char *in, unsigned char *out, int pixels, int frames, int *done)
+{
+	double best = 0.0;
+	int i;
+
+	for (i = 0; i < frames; i++)
+	{
+		double t0 = _now_sec();
+		double t;
+
+		*done = _Convert( format, in, out, pixels);
+		t = (_now_sec() - t0) * 1e3;
+		best = ((i == 0) || (t < best)) ? t : best;
+	}
+	return best;
+}
+
+static void RunFormat( const BENCH_FORMAT *format, int width, int height, int frames, int best)
+{
+	int pixels = ((width * height) / format->group) * format->group;
+	size_t inSize = ((size_t)pixels * format->inBits) / 8;
+	size_t outSize = (size_t)pixels * format->outBytes;
+	unsigned char *in = (unsigned char *)malloc(inSize);
+	unsigned char *ref = (unsigned char *)malloc(outSize);
+	unsigned char *out = (unsigned char *)malloc(outSize);
+	double scalarMs = 0.0;
+	double bestMs = 0.0;
+	char size[32];
+	int level, done;
+	size_t i;
+
+	if ((in == NULL) || (ref == NULL) || (out == NULL))
+	{
+		fprintf(stderr, "%s %dx%d : out of memory\n", format->name, width, height);
+		free(in);
+		free(ref);
+		free(out);
+		return;
+	}
+	srand(1);
+	for (i = 0; i < inSize; i++)
+	{
+		in[i] = (unsigned char)rand();
+	}
+	snprintf(size, sizeof(size), "%dx%d", width, height);
+	printf("%-15s %-10s", format->name, size);
+
+	for (level = CONVERT_SIMD_SCALAR; level <= best; level++)
+	{
+		double ms;
+
+		// (Poisoned first : a kernel that claims pixels it did not write shows as a mismatch).
+		ConvertSimd_Init( level);
+		memset((level == CONVERT_SIMD_SCALAR) ? ref : out, BENCH_POISON, outSize);
+		ms = _Time( format, in, (level == CONVERT_SIMD_SCALAR) ? ref : out, pixels, frames, &done);
+		if (level == CONVERT_SIMD_SCALAR)
+		{
+			scalarMs = ms;
+			bestMs = ms;
+			printf(" %9.3f", ms);
+		}
+		else if (done == 0)
+		{
+			printf(" %9s", "-");			// (No kernel for this instruction set).
+		}
+		else
+		{
+			bestMs = (ms < bestMs) ? ms : bestMs;
+			printf(" %9.3f%s", ms, (memcmp(ref, out, outSize) == 0) ? "" : " MISMATCH");
+		}
+	}
+	printf(" %7.1fx %8.1f\n", (bestMs > 0.0) ? scalarMs / bestMs : 0.0, (bestMs > 0.0) ? (double)pixels / (bestMs * 1e3) : 0.0);
+	free(in);
+	free(ref);
+	free(out);
+}
+
+int main( int argc, char *argv[])
+{
+	static const int sizes[][2] = { { 640, 480 }, { 1920, 1080 }, { 2448, 2048 } };
+	const char *name = (argc > 1) ? argv[1] : "all";
+	int frames = (argc > 2) ? atoi(argv[2]) : BENCH_FRAMES;
+	int numSizes = (int)(sizeof(sizes) / sizeof(sizes[0]));
+	int width = 0;
+	int height = 0;
+	int best, level, f, s;
+	int found = 0;
+
+	if (argc > 4)
+	{
+		width = atoi(argv[3]);
+		height = atoi(argv[4]);
+		numSizes = 1;
+	}
+	frames = (frames > 0) ? frames : BENCH_FRAMES;
+	best = ConvertSimd_Init( CONVERT_SIMD_AUTO);
+
+	printf("Best of %d frames, ms per frame (\"-\" = no kernel for that instruction set, the scalar code does it all).\n", frames);
+	printf("%-15s %-10s", "format", "size");
+	for (level = CONVERT_SIMD_SCALAR; level <= best; level++)
+	{
+		printf(" %9s", ConvertSimd_LevelName( level));
+	}
+	printf(" %8s %8s\n", "speedup", "Mpix/s");
+
+	for (f = 0; f < BENCH_NUM_FORMATS; f++)
+	{
+		if ((strcmp(name, "all") != 0) && (strcmp(name, s_formats[f].name) != 0))
+		{
+			continue;
+		}
+		found = 1;
+		for (s = 0; s < numSizes; s++)
+		{
+			RunFormat( &s_formats[f], (width > 0) ? width : sizes[s][0], (height > 0) ? height : sizes[s][1], frames, best);
+		}
+	}
+	if (!found)
+	{
+		fprintf(stderr, "Unknown format \"%s\"\n", name);
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,344 @@
+/*
+  ---------------------------------------------
+  Frame transport benchmark : stdout pipe vs shared memory ring.
+  -----------------------------------------------
+
+  Pushes synthetic frames (header + payload) from a producer process to a
+  consumer process and reports frames/s and CPU time per frame for each side.
+  Transports :
+	pipe     - fwrite/fflush of each frame to a pipe (the original stdout path).
+	writev   - one writev per frame straight to the pipe descriptor.
+	vmsplice - pages handed to the pipe by reference (buffers held until drained).
+	shm      - POSIX shared memory frame ring.
+	all      - run all of the above.
+
+  Usage : transport_bench [pipe|writev|vmsplice|shm|all] [width] [height] [bytes_per_pixel] [frames] [fps]
+  (fps = 0 runs the producer flat out, otherwise frames are paced like a camera).
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include "FrameShmRing.h"
+#include "FrameHeader.h"
+#include "PipeSplice.h"
+
+#define BENCH_SHM_NAME		"/genicam_transport_bench"
+#define BENCH_SHM_SLOTS		8
+#define BENCH_NUM_BUF		8		// Rotating (page aligned) source buffers, like the GEV buffers.
+#define BENCH_PIPE_FRAMES	4		// Pipe capacity requested (in frames).
+
+static double s_framePeriod = 0.0;	// Producer pacing (seconds per frame, 0 = unpaced).
+
+static double _now_sec( void )
+{
+	struct timespec ts;
+	clock_gettime( CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + ((double)ts.tv_nsec * 1e-9);
+}
+
+static double _cpu_sec( int who )
+{
+	struct rusage ru;
+	getrusage( who, &ru);
+	return (double)(ru.ru_utime.tv_sec + ru.ru_stime.tv_sec) +
+			 ((double)(ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) * 1e-6);
+}
+
+// Touch every byte of a frame (stands in for the consumer doing real work).
+static uint32_t _checksum( const unsigned char *data, size_t length)
+{
+	const uint64_t *p = (const uint64_t *)data;
+	uint64_t sum = 0;
+	size_t i;
+	for (i = 0; i < (length / 8); i++)
+	{
+		sum += p[i];
+	}
+	return (uint32_t)(sum ^ (sum >> 32));
+}
+
+static void _report( const char *mode, const char *side, uint64_t frames, uint64_t missed, double wall, double cpu)
+{
+	fprintf(stderr, "%-8s %-8s frames=%-7llu missed=%-6llu fps=%9.1f  cpu/frame=%8.1f us  cpu=%5.1f%%\n",
+			mode, side, (unsigned long long)frames, (unsigned long long)missed,
+			(wall > 0.0) ? (double)frames / wall : 0.0,
+			(frames > 0) ? (cpu * 1e6) / (double)frames : 0.0,
+			(wall > 0.0) ? 100.0 * cpu / wall : 0.0);
+}
+
+// Wait until frame "index" is due (when pacing like a camera).
+static void _pace( double t0, uint64_t index)
+{
+	if (s_framePeriod > 0.0)
+	{
+		double due = t0 + ((double)index * s_framePeriod);
+		double now = _now_sec();
+		if (due > now)
+		{
+			struct timespec ts;
+			ts.tv_sec  = (time_t)(due - now);
+			ts.tv_nsec = (long)(((due - now) - (double)ts.tv_sec) * 1e9);
+			nanosleep(&ts, NULL);
+		}
+	}
+}
+
+static void _fill_frame( unsigned char *frame, size_t length, uint64_t index)
+{
+	// Cheap pattern change per frame so the data is not constant.
+	memset(frame, (int)(index & 0xFF), 64);
+	frame[length - 1] = (unsigned char)index;
+}
+
+static int RunPipe( const char *method, unsigned char **frames, size_t length, uint64_t numFrames)
+{
+	int fds[2];
+	pid_t pid;
+	uint64_t i;
+	double t0, cpu0;
+	size_t total = sizeof(FRAME_HEADER) + length;
+
+	if (pipe(fds) != 0)
+	{
+		perror("pipe");
+		return -1;
+	}
+
+	pid = fork();
+	if (pid == 0)
+	{
+		// Consumer : read whole frames from the pipe.
+		unsigned char *buf = (unsigned char *)malloc(total);
+		uint64_t frames = 0;
+		uint32_t sum = 0;
+		size_t got = 0;
+		ssize_t n;
+		double c0 = _cpu_sec(RUSAGE_SELF);
+		double w0 = _now_sec();
+
+		close(fds[1]);
+		while ((n = read(fds[0], buf + got, total - got)) > 0)
+		{
+			got += n;
+			if (got == total)
+			{
+				sum += _checksum(buf + sizeof(FRAME_HEADER), length);
+				frames++;
+				got = 0;
+			}
+		}
+		_report(method, "consumer", frames, numFrames - frames, _now_sec() - w0, _cpu_sec(RUSAGE_SELF) - c0);
+		free(buf);
+		_exit(sum == 0xFFFFFFFF);
+	}
+
+	close(fds[0]);
+	t0 = _now_sec();
+	cpu0 = _cpu_sec(RUSAGE_SELF);
+	if (strcmp(method, "pipe") == 0)
+	{
+		// Producer : the fwrite / fflush sequence genicam originally used for stdout.
+		FILE *out = fdopen(fds[1], "w");
+		for (i = 0; i < numFrames; i++)
+		{
+			unsigned char *frame = frames[i % BENCH_NUM_BUF];
+			FRAME_HEADER hdr;
+
+			_pace(t0, i);
+			_fill_frame(frame, length, i);
+			FrameHeader_Init( &hdr, i, 0, length, 1, 0, length, length);
+			fwrite(&hdr, sizeof(FRAME_HEADER), 1, out);
+			fwrite(frame, length, 1, out);
+			fflush(out);
+		}
+		fclose(out);
+	}
+	else
+	{
+		// Producer : PipeSplice (writev, or vmsplice with buffers held until drained).
+		PIPE_SPLICE ps;
+		int busy[BENCH_NUM_BUF] = {0};
+		int splice = (strcmp(method, "vmsplice") == 0);
+
+		PipeSplice_Init( &ps, fds[1], splice, BENCH_PIPE_FRAMES * total);
+		for (i = 0; i < numFrames; i++)
+		{
+			int index = (int)(i % BENCH_NUM_BUF);
+			unsigned char *frame = frames[index];
+			FRAME_HEADER hdr;
+			void *cookie = NULL;
+
+			// Wait for the reader to drain the buffer before it is refilled.
+			while (busy[index])
+			{
+				while (PipeSplice_Reclaim( &ps, &cookie))
+				{
+					busy[(intptr_t)cookie - 1] = 0;
+				}
+				if (busy[index])
+				{
+					struct timespec ts = {0, 20000};
+					nanosleep(&ts, NULL);
+				}
+			}
+			_pace(t0, i);
+			_fill_frame(frame, length, i);
+			FrameHeader_Init( &hdr, i, 0, length, 1, 0, length, length);
+			if (PipeSplice_WriteFrame( &ps, &hdr, sizeof(FRAME_HEADER), frame, length, (void *)(intptr_t)(index + 1)) == 1)
+			{
+				busy[index] = 1;
+			}
+		}
+		close(fds[1]);
+		PipeSplice_PrintStats( &ps, method);
+	}
+	_report(method, "producer", numFrames, 0, _now_sec() - t0, _cpu_sec(RUSAGE_SELF) - cpu0);
+	waitpid(pid, NULL, 0);
+	return 0;
+}
+
+static int RunShm( unsigned char **frames, size_t length, uint64_t numFrames)
+{
+	FRAME_SHM_RING ring;
+	pid_t pid;
+	uint64_t i;
+	double t0, cpu0;
+	int status;
+
+	status = FrameShm_Create( &ring, BENCH_SHM_NAME, BENCH_SHM_SLOTS, length);
+	if (status != 0)
+	{
+		fprintf(stderr, "FrameShm_Create failed : %d\n", status);
+		return -1;
+	}
+
+	pid = fork();
+	if (pid == 0)
+	{
+		// Consumer : follow the ring in order, using the frames in place (no copy).
+		FRAME_SHM_RING reader;
+		uint64_t next = 1;
+		uint64_t frames = 0;
+		uint64_t missed = 0;
+		uint32_t sum = 0;
+		double c0 = _cpu_sec(RUSAGE_SELF);
+		double w0 = _now_sec();
+
+		if (FrameShm_Open( &reader, BENCH_SHM_NAME) != 0)
+		{
+			_exit(1);
+		}
+		while (next <= numFrames)
+		{
+			void *data = NULL;
+			size_t len = 0;
+			uint64_t count = FrameShm_GetPublishCount(&reader);
+
+			if (count < next)
+			{
+				// Nothing new yet - sleep rather than spin so the CPU figures only show the transport.
+				struct timespec ts = {0, 50000};
+				nanosleep(&ts, NULL);
+				continue;
+			}
+			if ((count - next) >= BENCH_SHM_SLOTS)
+			{
+				// Fell behind - skip to the oldest frame still in the ring.
+				missed += (count - next) - (BENCH_SHM_SLOTS - 1);
+				next = count - (BENCH_SHM_SLOTS - 1);
+			}
+			if (FrameShm_Acquire( &reader, next, &data, &len) == 0)
+			{
+				sum += _checksum((unsigned char *)data, len);
+				if (FrameShm_Validate( &reader, next) == 0)
+				{
+					frames++;
+				}
+				else
+				{
+					missed++;
+				}
+			}
+			else
+			{
+				missed++;
+			}
+			next++;
+		}
+		_report("shm", "consumer", frames, missed, _now_sec() - w0, _cpu_sec(RUSAGE_SELF) - c0);
+		FrameShm_Close(&reader);
+		_exit(sum == 0xFFFFFFFF);
+	}
+
+	// Producer.
+	t0 = _now_sec();
+	cpu0 = _cpu_sec(RUSAGE_SELF);
+	for (i = 0; i < numFrames; i++)
+	{
+		unsigned char *frame = frames[i % BENCH_NUM_BUF];
+		_pace(t0, i);
+		_fill_frame(frame, length, i);
+		FrameShm_Publish( &ring, frame, length);
+	}
+	_report("shm", "producer", numFrames, 0, _now_sec() - t0, _cpu_sec(RUSAGE_SELF) - cpu0);
+	waitpid(pid, NULL, 0);
+	FrameShm_Destroy(&ring);
+	return 0;
+}
+
+int main(int argc, char* argv[])
+{
+	const char *mode = (argc > 1) ? argv[1] : "all";
+	const char *methods[] = { "pipe", "writev", "vmsplice" };
+	size_t width  = (argc > 2) ? strtoul(argv[2], NULL, 0) : 1280;
+	size_t height = (argc > 3) ? strtoul(argv[3], NULL, 0) : 1024;
+	size_t depth  = (argc > 4) ? strtoul(argv[4], NULL, 0) : 1;
+	uint64_t numFrames = (argc > 5) ? strtoull(argv[5], NULL, 0) : 2000;
+	double fps = (argc > 6) ? strtod(argv[6], NULL) : 0.0;
+	size_t length = width * height * depth;
+	unsigned char *frames[BENCH_NUM_BUF] = {0};
+	int i;
+
+	if ((length < 64) || (numFrames == 0))
+	{
+		fprintf(stderr, "Usage : %s [pipe|writev|vmsplice|shm|all] [width] [height] [bytes_per_pixel] [frames] [fps]\n", argv[0]);
+		return 1;
+	}
+	s_framePeriod = (fps > 0.0) ? (1.0 / fps) : 0.0;
+	for (i = 0; i < BENCH_NUM_BUF; i++)
+	{
+		void *buf = NULL;
+		if (posix_memalign(&buf, sysconf(_SC_PAGESIZE), length) != 0)
+		{
+			return 1;
+		}
+		memset(buf, 0, length);
+		frames[i] = (unsigned char *)buf;
+	}
+
+	fprintf(stderr, "%zux%zu x %zu bytes/pixel (%zu bytes/frame), %llu frames\n",
+			width, height, depth, length, (unsigned long long)numFrames);
+	for (i = 0; i < 3; i++)
+	{
+		if ((strcmp(mode, methods[i]) == 0) || (strcmp(mode, "all") == 0))
+		{
+			RunPipe(methods[i], frames, length, numFrames);
+		}
+	}
+	if ((strcmp(mode, "shm") == 0) || (strcmp(mode, "all") == 0))
+	{
+		RunShm(frames, length, numFrames);
+	}
+	for (i = 0; i < BENCH_NUM_BUF; i++)
+	{
+		free(frames[i]);
+	}
+	return 0;
+}
@@ -8,6 +8,8 @@
 #include "gevapi.h"
 #include "PFNC.h"
 #include "FileUtil.h"
+#include "BandPool.h"
+#include "ConvertSimd.h"
 
 //=============================================================================
 // Translation of pixel format information between GigE-Vision formats and
@@ -378,7 +380,11 @@ static void Convert_YUV411_To_Mono(int pixelCount, void *in, int outDepth, void
 					unsigned char *pIn = (unsigned char *)in;
 					unsigned short *pOut = (unsigned short *)out;
 					int lshift = outDepth - 8;
-					for (i = 0; i < pixelCount; i+= 4)
+
+					i = ConvertSimd_YUVToMono( CONVERT_SIMD_YUV411, pIn, pOut, pixelCount, outDepth);
+					pIn  += (i/4)*6;
+					pOut += i;
+					for (; i < pixelCount; i+= 4)
 					{
 						pIn++;				// Skip U
 						*pOut++ = ((unsigned short)*pIn++) << lshift;	// Store Y0
@@ -394,7 +400,11 @@ static void Convert_YUV411_To_Mono(int pixelCount, void *in, int outDepth, void
 				{
 					unsigned char *pIn = (unsigned char *)in;
 					unsigned char *pOut = (unsigned char *)out;
-					for (i = 0; i < pixelCount; i+= 4)
+
+					i = ConvertSimd_YUVToMono( CONVERT_SIMD_YUV411, pIn, pOut, pixelCount, 8);
+					pIn  += (i/4)*6;
+					pOut += i;
+					for (; i < pixelCount; i+= 4)
 					{
 						pIn++;				// Skip U
 						*pOut++ = *pIn++;	// Store Y0
@@ -423,7 +433,11 @@ static void Convert_YUV422_To_Mono(int pixelCount, void *in, int outDepth, void
 					unsigned char *pIn = (unsigned char *)in;
 					unsigned short *pOut = (unsigned short *)out;
 					int lshift = outDepth - 8;
-					for (i = 0; i < pixelCount; i+= 4)
+
+					i = ConvertSimd_YUVToMono( CONVERT_SIMD_YUV422, pIn, pOut, pixelCount, outDepth);
+					pIn  += 2*i;
+					pOut += i;
+					for (; i < pixelCount; i+= 2)
 					{
 						pIn++;				// Skip U
 						*pOut++ = ((unsigned short)*pIn++) << lshift;	// Store Y0
@@ -437,7 +451,11 @@ static void Convert_YUV422_To_Mono(int pixelCount, void *in, int outDepth, void
 				{
 					unsigned char *pIn = (unsigned char *)in;
 					unsigned char *pOut = (unsigned char *)out;
-					for (i = 0; i < pixelCount; i+= 4)
+
+					i = ConvertSimd_YUVToMono( CONVERT_SIMD_YUV422, pIn, pOut, pixelCount, 8);
+					pIn  += 2*i;
+					pOut += i;
+					for (; i < pixelCount; i+= 2)
 					{
 						pIn++;				// Skip U0
 						*pOut++ = *pIn++;	// Store Y0
@@ -464,7 +482,11 @@ static void Convert_YUV444_To_Mono(int pixelCount, void *in, int outDepth, void
 					unsigned char *pIn = (unsigned char *)in;
 					unsigned short *pOut = (unsigned short *)out;
 					int lshift = outDepth - 8;
-					for (i = 0; i < pixelCount; i+= 3)
+
+					i = ConvertSimd_YUVToMono( CONVERT_SIMD_YUV444, pIn, pOut, pixelCount, outDepth);
+					pIn  += 3*i;
+					pOut += i;
+					for (; i < pixelCount; i++)
 					{
 						pIn++;				// Skip U
 						*pOut++ = ((unsigned short)*pIn++) << lshift;	// Store Y
@@ -477,7 +499,11 @@ static void Convert_YUV444_To_Mono(int pixelCount, void *in, int outDepth, void
 				{
 					unsigned char *pIn = (unsigned char *)in;
 					unsigned char *pOut = (unsigned char *)out;
-					for (i = 0; i < pixelCount; i+= 3)
+
+					i = ConvertSimd_YUVToMono( CONVERT_SIMD_YUV444, pIn, pOut, pixelCount, 8);
+					pIn  += 3*i;
+					pOut += i;
+					for (; i < pixelCount; i++)
 					{
 						pIn++;				// Skip U
 						*pOut++ = *pIn++;	// Store Y
@@ -493,9 +519,10 @@ static void Convert_YUV444_To_Mono(int pixelCount, void *in, int outDepth, void
 
 static void Convert_YUV411_To_RGB8x(int alpha_channel, int pixelCount, void *in, int outDepth, void *out)
 {
+	// (The vector kernels do the bulk of it, this loop the rest - and all of it as the reference).
 	unsigned char *pIn = (unsigned char *)in;
 	unsigned char *pOut = (unsigned char *)out;
-	int i;
+	int i = 0;
 	uint32_t iPixel;
 	int32_t	lCValue;
 	int32_t 	Y[4];	
@@ -505,7 +532,10 @@ static void Convert_YUV411_To_RGB8x(int alpha_channel, int pixelCount, void *in,
 	
 	if ( (pIn != NULL) && (pOut != NULL))
 	{
-		for (i = 0; i < pixelCount; i+=4)
+		i = ConvertSimd_YUVToRGB8x( CONVERT_SIMD_YUV411, pIn, pOut, pixelCount, alpha_channel);
+		pIn  += (i/4)*6;
+		pOut += (alpha_channel ? 4 : 3)*i;
+		for (; i < pixelCount; i+=4)
 		{
 			U0 = (int32_t) *pIn++ - 128;
 			Y[0] = (int32_t) *pIn++;
@@ -514,7 +544,7 @@ static void Convert_YUV411_To_RGB8x(int alpha_channel, int pixelCount, void *in,
 			Y[2] = (int32_t) *pIn++;
 			Y[3] = (int32_t) *pIn++;
 
-			for (iPixel = 0; iPixel < 4; i++)
+			for (iPixel = 0; iPixel < 4; iPixel++)
 			{
 				// Blue conversion.
 				lCValue = (Y[iPixel]*Const16384 + 29147*U0) >> YUV_SCALE_FACTOR;
@@ -539,21 +569,12 @@ static void Convert_YUV411_To_RGB8x(int alpha_channel, int pixelCount, void *in,
 }
 
 
-static void Convert_YUV411_To_RGB888(int pixelCount, void *in, int inDepth, void *out)
-{
-	Convert_YUV411_To_RGB8x(FALSE, pixelCount, in, inDepth, out);
-}
-static void Convert_YUV411_To_RGB8888(int pixelCount, void *in, int inDepth, void *out)
-{
-	Convert_YUV411_To_RGB8x(TRUE, pixelCount, in, inDepth, out);
-}
-
-
 static void Convert_YUV422_To_RGB8x(int alpha_channel, int pixelCount, void *in, int outDepth, void *out)
 {
+	// (The vector kernels do the bulk of it, this loop the rest - and all of it as the reference).
 	unsigned char *pIn = (unsigned char *)in;
 	unsigned char *pOut = (unsigned char *)out;
-	int i;
+	int i = 0;
 	int32_t	lCValue;
 	int32_t 	Y0;	
 	int32_t 	Y1;	
@@ -563,7 +584,10 @@ static void Convert_YUV422_To_RGB8x(int alpha_channel, int pixelCount, void *in,
 	
 	if ( (pIn != NULL) && (pOut != NULL))
 	{
-		for (i = 0; i < pixelCount; i+=2)
+		i = ConvertSimd_YUVToRGB8x( CONVERT_SIMD_YUV422, pIn, pOut, pixelCount, alpha_channel);
+		pIn  += 2*i;
+		pOut += (alpha_channel ? 4 : 3)*i;
+		for (; i < pixelCount; i+=2)
 		{
 			U0 = (int32_t) *pIn++ - 128;
 			Y0 = (int32_t) *pIn++;
@@ -583,7 +607,10 @@ static void Convert_YUV422_To_RGB8x(int alpha_channel, int pixelCount, void *in,
 			*pOut++ = (lCValue < 0) ? 0 : ( (lCValue > 255) ? 255 : (unsigned char)lCValue);
 		
 			// Pad (alpha channel)
-			pOut++;
+			if (alpha_channel)
+			{
+				*pOut++ = 0xff;
+			}
 
 			// Blue conversion.
 			lCValue = (Y1*Const16384 + 29147*U0) >> YUV_SCALE_FACTOR;
@@ -606,21 +633,12 @@ static void Convert_YUV422_To_RGB8x(int alpha_channel, int pixelCount, void *in,
 	}
 }
 
-static void Convert_YUV422_To_RGB888(int pixelCount, void *in, int inDepth, void *out)
-{
-	Convert_YUV422_To_RGB8x(FALSE, pixelCount, in, inDepth, out);
-}
-static void Convert_YUV422_To_RGB8888(int pixelCount, void *in, int inDepth, void *out)
-{
-	Convert_YUV422_To_RGB8x(TRUE, pixelCount, in, inDepth, out);
-}
-
-
 static void Convert_YUV444_To_RGB8x(int alpha_channel, int pixelCount, void *in, int outDepth, void *out)
 {
+	// (The vector kernels do the bulk of it, this loop the rest - and all of it as the reference).
 	unsigned char *pIn = (unsigned char *)in;
 	unsigned char *pOut = (unsigned char *)out;
-	int i;
+	int i = 0;
 	int32_t	lCValue;
 	int32_t 	Y0;	
 	int32_t 	V0;	
@@ -629,11 +647,14 @@ static void Convert_YUV444_To_RGB8x(int alpha_channel, int pixelCount, void *in,
 	
 	if ( (pIn != NULL) && (pOut != NULL))
 	{
-		for (i = 0; i < pixelCount; i++)
+		i = ConvertSimd_YUVToRGB8x( CONVERT_SIMD_YUV444, pIn, pOut, pixelCount, alpha_channel);
+		pIn  += 3*i;
+		pOut += (alpha_channel ? 4 : 3)*i;
+		for (; i < pixelCount; i++)
 		{
+			U0 = (int32_t) *pIn++ - 128;
 			Y0 = (int32_t) *pIn++;
 			V0 = (int32_t) *pIn++ - 128;
-			U0 = (int32_t) *pIn++ - 128;
 
 			// Blue conversion.
 			lCValue = (Y0*Const16384 + 29147*U0) >> YUV_SCALE_FACTOR;
@@ -656,14 +677,6 @@ static void Convert_YUV444_To_RGB8x(int alpha_channel, int pixelCount, void *in,
 	}
 }
 
-static void Convert_YUV444_To_RGB888(int pixelCount, void *in, int inDepth, void *out)
-{
-	Convert_YUV444_To_RGB8x(FALSE, pixelCount, in, inDepth, out);
-}
-static void Convert_YUV444_To_RGB8888(int pixelCount, void *in, int inDepth, void *out)
-{
-	Convert_YUV444_To_RGB8x(TRUE, pixelCount, in, inDepth, out);
-}
 
 
 static void Convert_RGBPacked_To_RGB8x(int alpha_channel, int pixelCount, void *in, int inDepth, void *out)
@@ -680,7 +693,7 @@ static void Convert_RGBPacked_To_RGB8x(int alpha_channel, int pixelCount, void *
 				{
 					int shift = inDepth - 8;
 					unsigned short *pIn = (unsigned short *)in;
-					for (i = 0; i < pixelCount; i+=3)
+					for (i = 0; i < pixelCount; i++)
 					{
 						*pOut++ = (unsigned char) ((*pIn++) >> shift); // R
 						*pOut++ = (unsigned char) ((*pIn++) >> shift); // G
@@ -696,7 +709,7 @@ static void Convert_RGBPacked_To_RGB8x(int alpha_channel, int pixelCount, void *
 			default:
 				{
 					unsigned char *pIn = (unsigned char *)in;
-					for (i = 0; i < pixelCount; i+=3)
+					for (i = 0; i < pixelCount; i++)
 					{
 						*pOut++ = (*pIn++); // R
 						*pOut++ = (*pIn++); // G
@@ -712,14 +725,6 @@ static void Convert_RGBPacked_To_RGB8x(int alpha_channel, int pixelCount, void *
 	}
 }
 
-static void Convert_RGBPacked_To_RGB888(int pixelCount, void *in, int inDepth, void *out)
-{
-	Convert_RGBPacked_To_RGB8x(FALSE, pixelCount, in, inDepth, out);
-}
-static void Convert_RGBPacked_To_RGB8888(int pixelCount, void *in, int inDepth, void *out)
-{
-	Convert_RGBPacked_To_RGB8x(TRUE, pixelCount, in, inDepth, out);
-}
 
 
 
@@ -741,7 +746,7 @@ static void Convert_BGRPacked_To_RGB8x(int alpha_channel, int pixelCount, void *
 				{
 					int shift = inDepth - 8;
 					unsigned short *pIn = (unsigned short *)in;
-					for (i = 0; i < pixelCount; i+=3)
+					for (i = 0; i < pixelCount; i++)
 					{
 						blue  = (unsigned char) ((*pIn++) >> shift); // B
 						green = (unsigned char) ((*pIn++) >> shift); // G
@@ -760,7 +765,7 @@ static void Convert_BGRPacked_To_RGB8x(int alpha_channel, int pixelCount, void *
 			default:
 				{
 					unsigned char *pIn = (unsigned char *)in;
-					for (i = 0; i < pixelCount; i+=3)
+					for (i = 0; i < pixelCount; i++)
 					{
 						blue  = *pIn++; // B
 						green = *pIn++; // G
@@ -779,14 +784,6 @@ static void Convert_BGRPacked_To_RGB8x(int alpha_channel, int pixelCount, void *
 	}
 }
 
-static void Convert_BGRPacked_To_RGB888(int pixelCount, void *in, int inDepth, void *out)
-{
-	Convert_BGRPacked_To_RGB8x(FALSE, pixelCount, in, inDepth, out);
-}
-static void Convert_BGRPacked_To_RGB8888(int pixelCount, void *in, int inDepth, void *out)
-{
-	Convert_BGRPacked_To_RGB8x(TRUE, pixelCount, in, inDepth, out);
-}
 
 static void Convert_RGBPacked_To_RGB101010(int pixelCount, void *in, int inDepth, void *out)
 {
@@ -879,210 +876,120 @@ static void Convert_BGRPacked_To_RGB101010(int pixelCount, void *in, int inDepth
 
 
 
+// Packed mono (10 or 12 bits) : 2 pixels in 3 bytes (see ConvertSimd.h).
+static inline unsigned short _UnpackPixel0( const unsigned char *pIn, int inDepth)
+{
+	return (inDepth == 12) ? (unsigned short)((pIn[0] << 4) | (pIn[1] & 0x0F)) : (unsigned short)((pIn[0] << 2) | (pIn[1] & 0x03));
+}
+
+static inline unsigned short _UnpackPixel1( const unsigned char *pIn, int inDepth)
+{
+	return (inDepth == 12) ? (unsigned short)((pIn[2] << 4) | (pIn[1] >> 4)) : (unsigned short)((pIn[2] << 2) | ((pIn[1] >> 4) & 0x03));
+}
+
+static inline unsigned short _ShiftPixel( unsigned short value, int shift)
+{
+	return (shift >= 0) ? (unsigned short)(value >> shift) : (unsigned short)(value << -shift);
+}
+
 static void Convert_MonoPacked_To_Mono(int pixelCount, void *in, int inDepth, int outDepth, void *out)
 {
-	// 10 or 12 bit in (packed) -> 8, 10, or 12 bit out byte aligned).
+	// 10 or 12 bit in (packed) -> 8 bit, or 10 to 16 bit (in 16 bits) out.
+	// (The vector kernels do the bulk of it, this loop the rest - and all of it as the reference).
 	unsigned char *pIn = (unsigned char *)in;
-	unsigned short input[4];
-	int i, j;
+	int pairs = pixelCount / 2;
 	int shift = 0;
-	int remainder = 0;
+	int i;
 	
 	if ( (in != NULL) && (out != NULL))
 	{
-		shift = inDepth - outDepth;
-		remainder = pixelCount % 2;
-		switch(outDepth)
+		inDepth = (inDepth == 12) ? 12 : 10;
+		if (outDepth > 8)
 		{
-			case 10:
-			case 12:
-				{
-					unsigned short *pOut = (unsigned short *)out;
-					switch(inDepth)
-					{
-						case 12:
-							{
-								// 3 input bytes for 2 output pixels.
-								for (i = 0; i < pixelCount; i+= 2)
-								{
-									for (j = 0; j < 3; j++)
-									{
-										input[j] = (unsigned short)*pIn++;
-									}
-									*pOut++ = ( (input[1] && 0x0F) | (input[0] << 4) ) >> shift;
-									*pOut++ = (((input[1] && 0xF0) >> 4) | (input[2] << 4) ) >> shift;
-								}
-								// Handle the remainder.
-								if (remainder != 0)
-								{
-									// There is one more output pixel to be extracted.
-									*pOut = ( (pIn[1] && 0x0F) | (pIn[0] << 4) ) >> shift;
-								}
-							}
-							break;
-						default:
-						case 10:
-							{
-								// 3 input bytes for 2 output pixels.
-								for (i = 0; i < pixelCount; i+= 2)
-								{
-									for (j = 0; j < 3; j++)
-									{
-										input[j] = (unsigned short)*pIn++;
-									}
-									*pOut++ = ( (input[1] && 0x03) | (input[0] << 2) ) >> shift;
-									*pOut++ = (((input[1] && 0x30) >> 4) | (input[2] << 2) ) >> shift;
-								}						
-								// Handle the remainder.
-								if (remainder != 0)
-								{
-									// There is one more output pixel to be extracted.
-									*pOut = ( (pIn[1] && 0x03) | (pIn[0] << 2) ) >> shift;
-								}
-							}
-							break;
-					}
-				}
-				break;
-			case 8:
-			default:
-				{
-					unsigned char *pOut = (unsigned char *)out;
-					switch (inDepth)
-					{
-						case 12:
-							// 3 input bytes for 2 output pixels.
-							for (i = 0; i < pixelCount; i+= 2)
-							{
-								for (j = 0; j < 3; j++)
-								{
-									input[j] = (unsigned short)*pIn++;
-								}							
-								*pOut++ = (unsigned char)( (input[1] && 0x0F) | (input[0] << 4) ) >> shift;
-								*pOut++ = (unsigned char)(((input[1] && 0xF0) >> 4) | (input[2] << 4 ) ) >> shift;
-							}
-							// Handle the remainder.
-							if (remainder != 0)
-							{
-								// There is one more output pixel to be extracted.
-								*pOut = (unsigned char)( (pIn[1] && 0x0F) | (pIn[0] << 4) ) >> shift;
-							}
-							break;
-						default:
-						case 10:
-							// 3 input bytes for 2 output pixels.
-							for (i = 0; i < pixelCount; i+= 2)
-							{
-								for (j = 0; j < 3; j++)
-								{
-									input[j] = (unsigned short)*pIn++;
-								}							
-								*pOut++ = (unsigned char)( (input[1] && 0x03) | (input[0] << 2) ) >> shift;
-								*pOut++ = (unsigned char)(((input[1] && 0x30) >> 4) | (input[2] << 2 ) ) >> shift;
-							}							
-							// Handle the remainder.
-							if (remainder != 0)
-							{
-								// There is one more output pixel to be extracted.
-								*pOut = (unsigned char)( (pIn[1] && 0x03) | (pIn[0] << 2) ) >> shift;
-							}
-							break;
-					}
-				}
-				break;
+			unsigned short *pOut = (unsigned short *)out;
+
+			shift = inDepth - outDepth;
+			i = ConvertSimd_UnpackMono16( pIn, pOut, pairs, inDepth, shift);
+			pIn  += 3*i;
+			pOut += 2*i;
+			for (; i < pairs; i++)
+			{
+				*pOut++ = _ShiftPixel( _UnpackPixel0( pIn, inDepth), shift);
+				*pOut++ = _ShiftPixel( _UnpackPixel1( pIn, inDepth), shift);
+				pIn += 3;
+			}
+			// Handle the remainder (one more output pixel).
+			if (pixelCount % 2)
+			{
+				*pOut = _ShiftPixel( _UnpackPixel0( pIn, inDepth), shift);
+			}
+		}
+		else
+		{
+			unsigned char *pOut = (unsigned char *)out;
+
+			shift = inDepth - 8;
+			i = ConvertSimd_UnpackMono8( pIn, pOut, pairs);
+			pIn  += 3*i;
+			pOut += 2*i;
+			for (; i < pairs; i++)
+			{
+				*pOut++ = (unsigned char)(_UnpackPixel0( pIn, inDepth) >> shift);
+				*pOut++ = (unsigned char)(_UnpackPixel1( pIn, inDepth) >> shift);
+				pIn += 3;
+			}
+			// Handle the remainder (one more output pixel).
+			if (pixelCount % 2)
+			{
+				*pOut = (unsigned char)(_UnpackPixel0( pIn, inDepth) >> shift);
+			}
 		}
 	}
 }
 
-// Expand a mono8 value into and RGB triple with optional alpha_channel.
-static inline void _expand_mono_to_rgb( unsigned char value, unsigned char *rgb_data, int alpha_channel)
+// Expand a mono8 value into and RGB triple with optional alpha_channel (returns the next output pixel).
+static inline unsigned char *_expand_mono_to_rgb( unsigned char value, unsigned char *rgb_data, int alpha_channel)
 {
-	if ( rgb_data != NULL)
+	*rgb_data++ = value;
+	*rgb_data++ = value;
+	*rgb_data++ = value;
+	if (alpha_channel)
 	{
-		*rgb_data++ = value;
-		*rgb_data++ = value;
-		*rgb_data++ = value;
-		if (alpha_channel)
-		{
-			*rgb_data++ = 0xFF;
-		}
+		*rgb_data++ = 0xFF;
 	}
+	return rgb_data;
 }
 
 static void Convert_MonoPacked_To_RGB8x(int alpha_channel, int pixelCount, void *in, int inDepth, void *out)
 {
 	// 10 or 12 bit in (packed) -> truncate to 8bpp and output as RGB888.
-	unsigned short *pIn = (unsigned short *)in;
-	unsigned short input[5];
-	int i, j;
+	unsigned char *pIn = (unsigned char *)in;
+	int pairs = pixelCount / 2;
 	int shift = 0;
-	int remainder = 0;
+	int i;
 	
 	if ( (in != NULL) && (out != NULL))
 	{
 		unsigned char *pOut = (unsigned char *)out;
-		unsigned short val = 0;
+
+		inDepth = (inDepth == 12) ? 12 : 10;
 		shift = inDepth - 8;
-		remainder = pixelCount % 2;
-		switch (inDepth)
+		// 3 input bytes for 2 output pixels.
+		for (i = 0; i < pairs; i++)
 		{
-			case 12:
-				// 3 input bytes for 2 output pixels.
-				for (i = 0; i < pixelCount; i+= 2)
-				{
-					for (j = 0; j < 3; j++)
-					{
-						input[j] = (unsigned short)*pIn++;
-					}
-					val = ( (input[1] && 0x0F) | (input[0] << 4) ) >> shift;
-					_expand_mono_to_rgb( (unsigned char) val, pOut, alpha_channel);
-
-					val = (((input[1] && 0xF0) >> 4) | (input[2] << 4) ) >> shift;
-					_expand_mono_to_rgb( (unsigned char) val, pOut, alpha_channel);
-				}
-				// Handle the remainder.
-				if (remainder != 0)
-				{
-					// There is one more output pixel to be extracted.
-					val = ( (pIn[1] && 0x0F) | (pIn[0] << 4) ) >> shift;
-					_expand_mono_to_rgb( (unsigned char) val, pOut, alpha_channel);
-				}
-				break;
-			default:
-			case 10:
-				// 3 input bytes for 2 output pixels.
-				for (i = 0; i < pixelCount; i+= 2)
-				{
-					for (j = 0; j < 3; j++)
-					{
-						input[j] = (unsigned short)*pIn++;
-					}
-					val = ( (input[1] && 0x03) | (input[0] << 2) ) >> shift;
-					_expand_mono_to_rgb( (unsigned char) val, pOut, alpha_channel);
-
-					val = (((input[1] && 0x30) >> 4) | (input[2] << 2) ) >> shift;
-					_expand_mono_to_rgb( (unsigned char) val, pOut, alpha_channel);
-				}
-				// Handle the remainder.
-				if (remainder != 0)
-				{
-					// There is one more output pixel to be extracted.
-					val = ( (pIn[1] && 0x03) | (pIn[0] << 2) ) >> shift;
-					_expand_mono_to_rgb( (unsigned char) val, pOut, alpha_channel);
-				}
-				break;
+			pOut = _expand_mono_to_rgb( (unsigned char)(_UnpackPixel0( pIn, inDepth) >> shift), pOut, alpha_channel);
+			pOut = _expand_mono_to_rgb( (unsigned char)(_UnpackPixel1( pIn, inDepth) >> shift), pOut, alpha_channel);
+			pIn += 3;
+		}
+		// Handle the remainder.
+		if (pixelCount % 2)
+		{
+			// There is one more output pixel to be extracted.
+			_expand_mono_to_rgb( (unsigned char)(_UnpackPixel0( pIn, inDepth) >> shift), pOut, alpha_channel);
 		}
 	}
 }
 
-static void Convert_MonoPacked_To_RGB888(int pixelCount, void *in, int inDepth, void *out)
-{
-	Convert_MonoPacked_To_RGB8x(FALSE, pixelCount, in, inDepth, out);
-}
-static void Convert_MonoPacked_To_RGB8888(int pixelCount, void *in, int inDepth, void *out)
-{
-	Convert_MonoPacked_To_RGB8x(TRUE, pixelCount, in, inDepth, out);
-}
 
 
 static void Convert_Mono_To_RGB8x(int alpha_channel, int pixelCount, void *in, int inDepth, void *out)
@@ -1097,7 +1004,7 @@ static void Convert_Mono_To_RGB8x(int alpha_channel, int pixelCount, void *in, i
 		if (inDepth == 8)
 		{
 			unsigned char *pIn = (unsigned char *)in;
-			for (i = 0; i < pixelCount; i+= 4)
+			for (i = 0; i < pixelCount; i++)
 			{
 				*pOut++ = *pIn;
 				*pOut++ = *pIn;
@@ -1112,7 +1019,7 @@ static void Convert_Mono_To_RGB8x(int alpha_channel, int pixelCount, void *in, i
 		{
 			unsigned short *pIn = (unsigned short *)in;
 			unsigned short val = 0;
-			for (i = 0; i < pixelCount; i+= 4)
+			for (i = 0; i < pixelCount; i++)
 			{
 				val = (*pIn++ >> shift) & 0xff;
 				*pOut++ = (unsigned char)val;
@@ -1127,15 +1034,6 @@ static void Convert_Mono_To_RGB8x(int alpha_channel, int pixelCount, void *in, i
 	}
 }
 
-static void Convert_Mono_To_RGB888(int pixelCount, void *in, int inDepth, void *out)
-{
-	Convert_Mono_To_RGB8x(FALSE, pixelCount, in, inDepth, out);
-}
-
-static void Convert_Mono_To_RGB8888(int pixelCount, void *in, int inDepth, void *out)
-{
-	Convert_Mono_To_RGB8x(TRUE, pixelCount, in, inDepth, out);
-}
 
 
 static void Convert_RGB10V1Packed_To_RGB8x(int alpha_channel, int pixelCount, void *in, void *out)
@@ -1712,6 +1610,90 @@ void Convert_BiColor1616toRGB8888( int w, int h, void *in, void *out, UINT32 ran
 
 
 
+//======================================================================
+// Conversion by bands of rows (see BandPool.h) for the converters that
+// take "pixelCount" pixels from "in" to "out" : a band is the same call
+// on its own rows.
+typedef void (*CONVERT_RGB8X_FUNC)(int alpha_channel, int pixelCount, void *in, int depth, void *out);
+
+typedef struct
+{
+	CONVERT_RGB8X_FUNC	convert;
+	int	alpha_channel;
+	int	depth;
+	int	w;
+	int	inBitsPerPixel;
+	int	outBytesPerPixel;
+	unsigned char *in;
+	unsigned char *out;
+} CONVERT_RGB8X_BANDS;
+
+static void _ConvertRGB8xBand( void *arg, uint32_t firstRow, uint32_t numRows)
+{
+	CONVERT_RGB8X_BANDS *bands = (CONVERT_RGB8X_BANDS *)arg;
+	size_t firstPixel = (size_t)firstRow * bands->w;
+
+	bands->convert( bands->alpha_channel, (int)numRows * bands->w, bands->in + (firstPixel * bands->inBitsPerPixel) / 8, 
+							bands->depth, bands->out + firstPixel * bands->outBytesPerPixel);
+}
+
+static void Convert_RGB8x_Bands( CONVERT_RGB8X_FUNC convert, int alpha_channel, int w, int h, void *in, int inBitsPerPixel, int depth, void *out)
+{
+	CONVERT_RGB8X_BANDS bands;
+
+	bands.convert = convert;
+	bands.alpha_channel = alpha_channel;
+	bands.depth = depth;
+	bands.w = w;
+	bands.inBitsPerPixel = inBitsPerPixel;
+	bands.outBytesPerPixel = alpha_channel ? 4 : 3;
+	bands.in = (unsigned char *)in;
+	bands.out = (unsigned char *)out;
+	BandPool_Run( h, w, _ConvertRGB8xBand, &bands);
+}
+
+// Packed mono (3 bytes for 2 pixels) by bands (a band starts on a whole pair - see BAND_POOL_ROW_ALIGN).
+typedef struct
+{
+	int	inDepth;
+	int	outDepth;
+	int	w;
+	unsigned char *in;
+	unsigned char *out;
+} MONO_PACKED_BANDS;
+
+static void _MonoPackedBand( void *arg, uint32_t firstRow, uint32_t numRows)
+{
+	MONO_PACKED_BANDS *bands = (MONO_PACKED_BANDS *)arg;
+	size_t firstPixel = (size_t)firstRow * bands->w;
+
+	Convert_MonoPacked_To_Mono( (int)numRows * bands->w, bands->in + (firstPixel * 3) / 2, bands->inDepth, bands->outDepth, 
+											bands->out + firstPixel * ((bands->outDepth > 8) ? 2 : 1));
+}
+
+static void Convert_MonoPacked_Bands( int w, int h, void *in, int inDepth, int outDepth, void *out)
+{
+	MONO_PACKED_BANDS bands;
+
+	bands.inDepth = inDepth;
+	bands.outDepth = outDepth;
+	bands.w = w;
+	bands.in = (unsigned char *)in;
+	bands.out = (unsigned char *)out;
+	BandPool_Run( h, w, _MonoPackedBand, &bands);
+}
+
+// Input bits per pixel, as the converters read them.
+static int _MonoBits( int inDepth)
+{
+	return (inDepth == 8) ? 8 : 16;
+}
+
+static int _RGBPackedBits( int inDepth)
+{
+	return ((inDepth == 10) || (inDepth == 12)) ? 48 : 24;
+}
+
 //======================================================================
 // Generic converter for Display
 void ConvertGevImageToX11Format( int w, int h, int gev_depth, int gev_format, void *gev_input_data, 
@@ -1738,19 +1720,18 @@ void ConvertGevImageToX11Format( int w, int h, int gev_depth, int gev_format, vo
 						case fmtBayerRG12Packed:
 						case fmtMono10Packed:
 						case fmtMono12Packed:
-							numPixels =  w*h;
-							Convert_MonoPacked_To_Mono(numPixels, gev_input_data, gev_depth, x11_depth, x11_output_data);
+							Convert_MonoPacked_Bands( w, h, gev_input_data, gev_depth, x11_depth, x11_output_data);
 							break;
 						case fmtYUV411packed:
 							numPixels =  w*h;
 							Convert_YUV411_To_Mono(numPixels, gev_input_data, x11_depth, x11_output_data);
 							break;
 						case fmtYUV422packed:
-							numPixels = w*h*2;
+							numPixels = w*h;
 							Convert_YUV422_To_Mono(numPixels, gev_input_data, x11_depth, x11_output_data);
 							break;
 						case fmtYUV444packed:
-							numPixels = w*h*3;
+							numPixels = w*h;
 							Convert_YUV444_To_Mono(numPixels, gev_input_data, x11_depth, x11_output_data);
 							break;
 						default:
@@ -1766,24 +1747,24 @@ void ConvertGevImageToX11Format( int w, int h, int gev_depth, int gev_format, vo
 					switch(gev_format)
 					{
 						case fmtYUV411packed:
-							Convert_YUV411_To_RGB8888(numPixels, gev_input_data, x11_depth, x11_output_data);
+							Convert_RGB8x_Bands( Convert_YUV411_To_RGB8x, TRUE, w, h, gev_input_data, 12, x11_depth, x11_output_data);
 							break;
 						case fmtYUV422packed:
-							Convert_YUV422_To_RGB8888(numPixels, gev_input_data, x11_depth, x11_output_data);
+							Convert_RGB8x_Bands( Convert_YUV422_To_RGB8x, TRUE, w, h, gev_input_data, 16, x11_depth, x11_output_data);
 							break;
 						case fmtYUV444packed:
-							Convert_YUV444_To_RGB8888(numPixels, gev_input_data, x11_depth, x11_output_data);
+							Convert_RGB8x_Bands( Convert_YUV444_To_RGB8x, TRUE, w, h, gev_input_data, 24, x11_depth, x11_output_data);
 							break;
 
 						case fmtRGB8Packed:
-								Convert_RGBPacked_To_RGB8888(numPixels, gev_input_data, gev_depth, x11_output_data);
+								Convert_RGB8x_Bands( Convert_RGBPacked_To_RGB8x, TRUE, w, h, gev_input_data, _RGBPackedBits(gev_depth), gev_depth, x11_output_data);
 								break;
 						case fmtRGB10Packed:
 						case fmtRGB12Packed:
 								Convert_RGBPacked_To_RGB101010(numPixels, gev_input_data, gev_depth, x11_output_data);
 								break;
 						case fmtBGR8Packed:
-								Convert_BGRPacked_To_RGB8888(numPixels, gev_input_data, gev_depth, x11_output_data);
+								Convert_RGB8x_Bands( Convert_BGRPacked_To_RGB8x, TRUE, w, h, gev_input_data, _RGBPackedBits(gev_depth), gev_depth, x11_output_data);
 								break;
 						case fmtBGR10Packed:
 						case fmtBGR12Packed:
@@ -1869,7 +1850,7 @@ void ConvertGevImageToRGB8888Format( int w, int h, int gev_depth, int gev_format
 			case fmtBayerGB12:	/* 12-bit Bayer   */
 			case fmtBayerBG12:	/* 12-bit Bayer   */
 				/* For Now : treat the bayer formats as monochrome - add bayer decoding later */
-				Convert_Mono_To_RGB8888(numPixels, gev_input_data, gev_depth, rgb_output_data);
+				Convert_RGB8x_Bands( Convert_Mono_To_RGB8x, TRUE, w, h, gev_input_data, _MonoBits(gev_depth), gev_depth, rgb_output_data);
 				break;
 			case fmtMono8:
 			case fmtMono8Signed:
@@ -1877,30 +1858,30 @@ void ConvertGevImageToRGB8888Format( int w, int h, int gev_depth, int gev_format
 			case fmtMono12:
 			case fmtMono14:
 			case fmtMono16:
-				Convert_Mono_To_RGB8888(numPixels, gev_input_data, gev_depth, rgb_output_data);
+				Convert_RGB8x_Bands( Convert_Mono_To_RGB8x, TRUE, w, h, gev_input_data, _MonoBits(gev_depth), gev_depth, rgb_output_data);
 				break;
 			case fmtMono10Packed:
 			case fmtMono12Packed:
-				Convert_MonoPacked_To_RGB8888(numPixels, gev_input_data, gev_depth, rgb_output_data);
+				Convert_RGB8x_Bands( Convert_MonoPacked_To_RGB8x, TRUE, w, h, gev_input_data, 12, gev_depth, rgb_output_data);
 				break;
 			case fmtYUV411packed:
-				Convert_YUV411_To_RGB8888(numPixels, gev_input_data, outdepth, rgb_output_data);
+				Convert_RGB8x_Bands( Convert_YUV411_To_RGB8x, TRUE, w, h, gev_input_data, 12, outdepth, rgb_output_data);
 				break;
 			case fmtYUV422packed:
-				Convert_YUV422_To_RGB8888(numPixels, gev_input_data, outdepth, rgb_output_data);
+				Convert_RGB8x_Bands( Convert_YUV422_To_RGB8x, TRUE, w, h, gev_input_data, 16, outdepth, rgb_output_data);
 				break;
 			case fmtYUV444packed:
-				Convert_YUV444_To_RGB8888(numPixels, gev_input_data, outdepth, rgb_output_data);
+				Convert_RGB8x_Bands( Convert_YUV444_To_RGB8x, TRUE, w, h, gev_input_data, 24, outdepth, rgb_output_data);
 				break;
 			case fmtRGB8Packed:
 			case fmtRGB10Packed:
 			case fmtRGB12Packed:
-				Convert_RGBPacked_To_RGB8888(numPixels, gev_input_data, outdepth, rgb_output_data);
+				Convert_RGB8x_Bands( Convert_RGBPacked_To_RGB8x, TRUE, w, h, gev_input_data, _RGBPackedBits(gev_depth), gev_depth, rgb_output_data);
 				break;
 			case fmtBGR8Packed:
 			case fmtBGR10Packed:
 			case fmtBGR12Packed:
-				Convert_BGRPacked_To_RGB8888(numPixels, gev_input_data, outdepth, rgb_output_data);
+				Convert_RGB8x_Bands( Convert_BGRPacked_To_RGB8x, TRUE, w, h, gev_input_data, _RGBPackedBits(gev_depth), gev_depth, rgb_output_data);
 				break;
 		case fmtRGB10V1Packed:
 				Convert_RGB10V1Packed_To_RGB8888(numPixels, gev_input_data, rgb_output_data);
@@ -1940,7 +1921,7 @@ void ConvertGevImageToRGB888Format( int w, int h, int gev_depth, int gev_format,
 			case fmtBayerGB12:	/* 12-bit Bayer   */
 			case fmtBayerBG12:	/* 12-bit Bayer   */
 				/* For Now : treat the bayer formats as monochrome - add bayer decoding later */
-				Convert_Mono_To_RGB888(numPixels, gev_input_data, gev_depth, rgb_output_data);
+				Convert_RGB8x_Bands( Convert_Mono_To_RGB8x, FALSE, w, h, gev_input_data, _MonoBits(gev_depth), gev_depth, rgb_output_data);
 				break;
 			case fmtMono8:
 			case fmtMono8Signed:
@@ -1948,30 +1929,30 @@ void ConvertGevImageToRGB888Format( int w, int h, int gev_depth, int gev_format,
 			case fmtMono12:
 			case fmtMono14:
 			case fmtMono16:
-				Convert_Mono_To_RGB888(numPixels, gev_input_data, gev_depth, rgb_output_data);
+				Convert_RGB8x_Bands( Convert_Mono_To_RGB8x, FALSE, w, h, gev_input_data, _MonoBits(gev_depth), gev_depth, rgb_output_data);
 				break;
 			case fmtMono10Packed:
 			case fmtMono12Packed:
-				Convert_MonoPacked_To_RGB888(numPixels, gev_input_data, gev_depth, rgb_output_data);
+				Convert_RGB8x_Bands( Convert_MonoPacked_To_RGB8x, FALSE, w, h, gev_input_data, 12, gev_depth, rgb_output_data);
 				break;
 			case fmtYUV411packed:
-				Convert_YUV411_To_RGB888(numPixels, gev_input_data, outdepth, rgb_output_data);
+				Convert_RGB8x_Bands( Convert_YUV411_To_RGB8x, FALSE, w, h, gev_input_data, 12, outdepth, rgb_output_data);
 				break;
 			case fmtYUV422packed:
-				Convert_YUV422_To_RGB888(numPixels, gev_input_data, outdepth, rgb_output_data);
+				Convert_RGB8x_Bands( Convert_YUV422_To_RGB8x, FALSE, w, h, gev_input_data, 16, outdepth, rgb_output_data);
 				break;
 			case fmtYUV444packed:
-				Convert_YUV444_To_RGB888(numPixels, gev_input_data, outdepth, rgb_output_data);
+				Convert_RGB8x_Bands( Convert_YUV444_To_RGB8x, FALSE, w, h, gev_input_data, 24, outdepth, rgb_output_data);
 				break;
 			case fmtRGB8Packed:
 			case fmtRGB10Packed:
 			case fmtRGB12Packed:
-				Convert_RGBPacked_To_RGB888(numPixels, gev_input_data, outdepth, rgb_output_data);
+				Convert_RGB8x_Bands( Convert_RGBPacked_To_RGB8x, FALSE, w, h, gev_input_data, _RGBPackedBits(gev_depth), gev_depth, rgb_output_data);
 				break;
 			case fmtBGR8Packed:
 			case fmtBGR10Packed:
 			case fmtBGR12Packed:
-				Convert_BGRPacked_To_RGB888(numPixels, gev_input_data, outdepth, rgb_output_data);
+				Convert_RGB8x_Bands( Convert_BGRPacked_To_RGB8x, FALSE, w, h, gev_input_data, _RGBPackedBits(gev_depth), gev_depth, rgb_output_data);
 				break;
 		case fmtRGB10V1Packed:
 				Convert_RGB10V1Packed_To_RGB888(numPixels, gev_input_data, rgb_output_data);
@@ -37,6 +37,7 @@ OF THE POSSIBILITY OF SUCH DAMAGE.
 
 */
 #include "gevapi.h"
+#include "BandPool.h"
 
 // bayerAlignment: 0=B1G1,  1=B1G0,  2=B0G0,  3=B0G1  
 // bayerAlignemnt: 0=GB_RG, 1=BG_GR, 2=RG_GB, 3=GR_BG
@@ -597,7 +598,66 @@ static void _convBayer16ToRGB8_2x2( void* pSrcLine0, void* pSrcLine1, unsigned i
 
 
 
+// Rows of an image being converted (a band - see BandPool.h).
+typedef struct
+{
+	uint32_t h;
+	uint32_t w;
+	uint32_t inDepth;
+	uint32_t dstDepth;
+	uint32_t dstInc;
+	uint32_t bayerAlign;					// Of the first row.
+	uint32_t bytesPerInputLine;
+	uint32_t bytesPerOutputLine;
+	unsigned char *pSrc;
+	unsigned char *pDstRed;
+	unsigned char *pDstGreen;
+	unsigned char *pDstBlue;
+} BAYER_BANDS;
+
+// Convert rows [firstRow, firstRow + numRows) : each row is done with the one below it, the last row
+// of the image with the one above it (bIsLastLine). Those are read across the edges of the band.
+static void _convBayerBand( void *arg, uint32_t firstRow, uint32_t numRows)
+{
+	BAYER_BANDS *bands = (BAYER_BANDS *)arg;
+	uint32_t i;
+
+	for (i = firstRow; i < (firstRow + numRows); i++)
+	{
+		unsigned char *pSrcLine0 = bands->pSrc + (size_t)i * bands->bytesPerInputLine;
+		unsigned char *pSrcLine1 = pSrcLine0 + bands->bytesPerInputLine;
+		size_t dstOffset = (size_t)i * bands->bytesPerOutputLine;
+		uint32_t bayerAlign = bands->bayerAlign ^ ((i & 1) ? 2 : 0);
+		int bIsLastLine = (i == (bands->h - 1));
+
+		if (bIsLastLine)
+		{
+			// (A single row is its own neighbour).
+			pSrcLine1 = (i > 0) ? (pSrcLine0 - bands->bytesPerInputLine) : pSrcLine0;
+		}
+		if ( (bands->inDepth == 8) && (bands->dstDepth == 8) )
+		{
+			//  8 bit components in / out.
+			_convBayer8ToRGB8_2x2( (void *)pSrcLine0, (void *)pSrcLine1, (void *)(bands->pDstRed + dstOffset), (void *)(bands->pDstGreen + dstOffset), 
+											(void *)(bands->pDstBlue + dstOffset), bands->dstInc, bands->w, bayerAlign, bIsLastLine, 1 );
+		}
+		else if ( (bands->inDepth > 8) && (bands->dstDepth == 8) )
+		{
+			// Use 16-bit input components to 8 bit RGB output (Usefull for conversions for display on-the-fly)
+			_convBayer16ToRGB8_2x2( (void *)pSrcLine0, (void *)pSrcLine1, bands->inDepth, (void *)(bands->pDstRed + dstOffset), (void *)(bands->pDstGreen + dstOffset), 
+											(void *)(bands->pDstBlue + dstOffset), bands->dstInc, bands->w, bayerAlign, bIsLastLine, 1 );
+		}
+		else
+		{
+			// Use 16-bit components.
+			_convBayer16ToRGB16_2x2( (void *)pSrcLine0, (void *)pSrcLine1, bands->inDepth, (void *)(bands->pDstRed + dstOffset), (void *)(bands->pDstGreen + dstOffset), 
+											(void *)(bands->pDstBlue + dstOffset), bands->dstInc, bands->dstDepth, bands->w, bayerAlign, bIsLastLine, 1 );
+		}
+	}
+}
+
 // A simple / naive 2x2 neighborhood Bayer to RGB converter.
+// (The image is converted by bands of rows, on the band pool threads when there are some).
 // (Assume the caller got the output image allocated to the correct size - otherwise this will end badly).
 GEV_STATUS ConvertBayerToRGB( int convAlgorithm, UINT32 h, UINT32 w, UINT32 inFormat, void *inImage, UINT32 outFormat, void *outImage)
 {
@@ -806,80 +866,21 @@ GEV_STATUS ConvertBayerToRGB( int convAlgorithm, UINT32 h, UINT32 w, UINT32 inFo
 			// if ( convAlgorithm == BAYER_CONVERSION_2X2 )  
 			if ( 1 )
 			{
-				int i;
-				unsigned char *pSrcLine0 = (unsigned char *)inImage;
-				unsigned char *pSrcLine1 = (unsigned char *)inImage + bytesPerInputLine;
-				
-				if ( (inDepth == 8) && (dstDepth == 8) )
-				{
-					
-					//  8 bit components in / out.
-					for (i = 0; i < (h-1); i++)
-					{
-						_convBayer8ToRGB8_2x2( (void *)pSrcLine0, (void *)pSrcLine1, (void *)pDstRed, (void *)pDstGreen, (void *)pDstBlue, 
-														dstInc, w, bayerAlign, 0, 1 );
-						
-						pSrcLine0 += bytesPerInputLine;
-						pSrcLine1 += bytesPerInputLine;
-						pDstRed   += bytesPerOutputLine;
-						pDstGreen += bytesPerOutputLine;
-						pDstBlue  += bytesPerOutputLine;
-						
-						bayerAlign ^= 2;
-					}
-					
-					// Do the last line;
-					pSrcLine1 -= 2*bytesPerInputLine;
-					_convBayer8ToRGB8_2x2( (void *)pSrcLine0, (void *)pSrcLine1, (void *)pDstRed, (void *)pDstGreen, (void *)pDstBlue, 
-													dstInc, w, bayerAlign, 1, 1 );
-					
-				}
-				else if ( (inDepth > 8) && (dstDepth == 8) )
-				{
-					// Use 16-bit input components to 8 bit RGB output (Usefull for conversions for display on-the-fly)
-					for (i = 0; i < (h-1); i++)
-					{
-						_convBayer16ToRGB8_2x2( (void *)pSrcLine0, (void *)pSrcLine1, inDepth, (void *)pDstRed, (void *)pDstGreen, (void *)pDstBlue, 
-														dstInc, w, bayerAlign, 0, 1 );
-																		
-						pSrcLine0 += bytesPerInputLine;
-						pSrcLine1 += bytesPerInputLine;
-						pDstRed   += bytesPerOutputLine;
-						pDstGreen += bytesPerOutputLine;
-						pDstBlue  += bytesPerOutputLine;
-						
-						bayerAlign ^= 2;
-					}
-					
-					// Do the last line;
-					pSrcLine1 -= 2*bytesPerInputLine;
-					_convBayer16ToRGB8_2x2( (void *)pSrcLine0, (void *)pSrcLine1, inDepth, (void *)pDstRed, (void *)pDstGreen, (void *)pDstBlue, 
-														dstInc, w, bayerAlign, 1, 1 );
-					
-				}
-				else
-				{
-					// Use 16-bit components.
-					for (i = 0; i < (h-1); i++)
-					{
-						_convBayer16ToRGB16_2x2( (void *)pSrcLine0, (void *)pSrcLine1, inDepth, (void *)pDstRed, (void *)pDstGreen, (void *)pDstBlue, 
-														dstInc, dstDepth, w, bayerAlign, 0, 1 );
-																		
-						pSrcLine0 += bytesPerInputLine;
-						pSrcLine1 += bytesPerInputLine;
-						pDstRed   += bytesPerOutputLine;
-						pDstGreen += bytesPerOutputLine;
-						pDstBlue  += bytesPerOutputLine;
-						
-						bayerAlign ^= 2;
-					}
-					
-					// Do the last line;
-					pSrcLine1 -= 2*bytesPerInputLine;
-						_convBayer16ToRGB16_2x2( (void *)pSrcLine0, (void *)pSrcLine1, inDepth, (void *)pDstRed, (void *)pDstGreen, (void *)pDstBlue, 
-														dstInc, dstDepth, w, bayerAlign, 1, 1 );
-					
-				}
+				BAYER_BANDS bands;
+
+				bands.h = h;
+				bands.w = w;
+				bands.inDepth = inDepth;
+				bands.dstDepth = dstDepth;
+				bands.dstInc = dstInc;
+				bands.bayerAlign = bayerAlign;
+				bands.bytesPerInputLine = bytesPerInputLine;
+				bands.bytesPerOutputLine = bytesPerOutputLine;
+				bands.pSrc = (unsigned char *)inImage;
+				bands.pDstRed = pDstRed;
+				bands.pDstGreen = pDstGreen;
+				bands.pDstBlue = pDstBlue;
+				BandPool_Run( h, w, _convBayerBand, &bands);
 			}
 			else
 			{
@@ -6,21 +6,112 @@
 #include "SapX11Util.h"
 #include "X_Display_utils.h"
 #include "FileUtil.h"
+#include "FrameShmRing.h"
+#include "FrameHeader.h"
+#include "PipeSplice.h"
+#include "FrameServer.h"
+#include "FrameMemfd.h"
+#include "FrameQueue.h"
+#include "FrameLease.h"
+#include "BufferAlloc.h"
+#include "CommandChannel.h"
+#include "AcqBackend.h"
+#include "AppConfig.h"
+#include "Calibration.h"
+#include "AcqStats.h"
+#include "FrameRecord.h"
+#include "ClockSync.h"
+#include "LatencyStats.h"
+#include "ThreadPolicy.h"
+#include "SpscRing.h"
+#include "BandPool.h"
+#include "ConvertSimd.h"
 #include <sched.h>
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/signalfd.h>
+#include <sys/timerfd.h>
+#include <sys/eventfd.h>
 
 //using namespace std;
 //using namespace GenICam;
 //using namespace GenApi;
 
-// print statements
+// The settings marked (--<name>) below are only the defaults : they can be changed at run time
+// on the command line (genicam --help) or in a configuration file, for every camera or for one
+// (see AppConfig.h) - no need to recompile.
+
+// print statements (--print)
 #define PRINT_STATEMENTS 0
 
-// Turbo Drive mode https://www.teledynedalsa.com/en/learn/knowledge-center/turbodrive/
+// Turbo Drive mode https://www.teledynedalsa.com/en/learn/knowledge-center/turbodrive/ (--turbo-drive)
 #define TURBO_DRIVE	0
 
-// Display camera view in display window
+// Display camera view in display window (--display)
 #define DISPLAY_WINDOW 0
 
+// Frame output transport.
+// OUTPUT_TRANSPORT_PIPE : raw frames are written to stdout (read through a pipe).
+// OUTPUT_TRANSPORT_SHM  : frames are published to a POSIX shared memory ring (SHM_RING_NAME)
+//                         of SHM_RING_SLOTS slots. Falls back to stdout if the ring can't be created.
+// OUTPUT_TRANSPORT_SOCKET : frames are sent to every subscriber connected to the Unix domain socket
+//                         FRAME_SERVER_PATH. Each subscriber has its own queue of FRAME_SERVER_QUEUE
+//                         frames - a slow one loses frames instead of holding up the camera.
+// OUTPUT_TRANSPORT_MEMFD : the image buffers are memfd regions whose descriptors are passed (once, with
+//                         SCM_RIGHTS) to the consumers connected to FRAME_MEMFD_PATH. They map the same
+//                         pages, so each frame is only a small notice naming the buffer to read.
+#define OUTPUT_TRANSPORT_PIPE	0
+#define OUTPUT_TRANSPORT_SHM	1
+#define OUTPUT_TRANSPORT_SOCKET	2
+#define OUTPUT_TRANSPORT_MEMFD	3
+#define OUTPUT_TRANSPORT	OUTPUT_TRANSPORT_PIPE
+#define SHM_RING_NAME		"/genicam_frames"
+#define SHM_RING_SLOTS		8
+#define FRAME_SERVER_PATH		"/tmp/genicam_frames.sock"
+#define FRAME_SERVER_CLIENTS	8
+#define FRAME_SERVER_QUEUE		4
+#define FRAME_MEMFD_PATH		"/tmp/genicam_buffers.sock"
+#define FRAME_MEMFD_CLIENTS	4
+#define FRAME_MEMFD_HOLD		1		// Buffers each consumer can hold at once (CLIENTS * HOLD must be < buffers - 1).
+#define FRAME_MEMFD_SLOTS		((FRAME_MEMFD_CLIENTS * FRAME_MEMFD_HOLD) + 1)	// Shared buffers for converted / copied frames.
+
+// Hand raw (unconverted) frames to the stdout pipe by reference with vmsplice instead of copying them.
+// The GEV buffer is held (not released) until the reader has drained it from the pipe, so this 
+// needs synchronous buffer cycling (--sync-cycling). Otherwise (and for converted frames) a single writev is used.
+#define PIPE_OUTPUT_VMSPLICE	1
+#define PIPE_OUTPUT_FRAMES		4		// Pipe capacity requested (in frames).
+
+// What to do when the stdout reader falls behind (--backpressure, or the GENICAM_BACKPRESSURE
+// environment variable) :
+//   "none"        : frames are written from the acquisition thread - a stalled reader stalls acquisition
+//                   (and with asynchronous cycling the transfer then silently overwrites frames).
+//   "block"       : never lose a frame here - the acquisition thread waits for room in the queue.
+//   "drop-newest" : a frame that finds the queue full is dropped.
+//   "drop-oldest" : the oldest queued frame is dropped to make room.
+//   "latest"      : conflate - the writer always gets the freshest frame.
+// All but "none" copy the frames into a queue of OUTPUT_QUEUE_DEPTH frames drained by a writer thread,
+// and count (and log the frame id of) every frame dropped.
+#define OUTPUT_BACKPRESSURE	"none"
+#define OUTPUT_QUEUE_DEPTH		4
+
+// Take feature commands on stdin while streaming (get / set / exec / restart - see CommandChannel.h).
+// Every command is answered with one line on stderr (or on the descriptor in the GENICAM_ACK_FD
+// environment variable) so the frame stream stays clean. Settings that change the image size or format
+// (Width, Height, PixelFormat, ...) stop the transfer, reallocate the buffers if needed and restart it.
+#define COMMAND_INPUT	1
+
+// Where the frames come from (--backend, or the GENICAM_BACKEND environment variable) :
+//   "gev"                  : GigE-V cameras on the network.
+//   "synthetic[:settings]" : generated frames, no camera needed (settings : see AcqSynthetic_Configure),
+//                            eg. GENICAM_BACKEND=synthetic:width=1920,height=1080,format=BayerRG8,fps=60,drop=0.001
+//   "replay:<settings>"    : recordings (see --record) played back (settings : see AcqReplay_Configure),
+//                            eg. GENICAM_BACKEND=replay:capture.rec,speed=0
+#define ACQ_BACKEND_NAME	"gev"
+
+// Interval of the frame rate / output statistics printed to stderr (with --print).
+#define STATS_INTERVAL_MS	5000
+
 
 #define MAX_NETIF					8
 #define MAX_CAMERAS_PER_NETIF	32
@@ -30,14 +121,164 @@
 // (If disabled - Bayer format will be treated as Monochrome).
 #define ENABLE_BAYER_CONVERSION 1
 
-// Enable/disable buffer FULL/EMPTY handling (cycling)
-#define USE_SYNCHRONOUS_BUFFER_CYCLING	0
+// Enable/disable buffer FULL/EMPTY handling (cycling) (--sync-cycling)
+// With it, a received buffer is leased to the consumers (display, outputs) and only goes back to the
+// transfer once the last of them is done, so frames are used in place and never overwritten while read.
+// Without it the transfer reuses the buffers on its own schedule : frames still being read can be torn.
+#define USE_SYNCHRONOUS_BUFFER_CYCLING	1
+
+// What to do when every buffer is held by the consumers (--lease-policy) :
+//   "wait" : stop taking frames until one comes back (the transfer drops the frames it has no room for).
+//   "drop" : keep taking frames, give the ones that find no lease free straight back (counted).
+#define BUFFER_LEASE_POLICY	"wait"
 
-// Enable/disable transfer tuning (buffering, timeouts, thread affinity).
+// Enable/disable transfer tuning (buffering, timeouts, thread affinity) (--tune-streaming).
 #define TUNE_STREAMING_THREADS 1
+#define STREAM_PACKET_SIZE			9180					// GVSP packet size (--packet-size).
+#define STREAM_PACKET_DELAY		10						// usecs between packets to pace arrival at NIC (--packet-delay).
+#define STREAM_FRAMES_BUFFERED	4						// Frames buffered internally (--frames-buffered).
+#define STREAM_MEMORY_LIMIT		(64*1024*1024)		// Packet memory buffering limit (--memory-limit).
+#define STREAM_FRAME_TIMEOUT_MS	1001					// Internal timeout for frame reception (--frame-timeout).
+#define HEARTBEAT_TIMEOUT_MS		10000					// Disconnect detection (--heartbeat-timeout).
 
+// Reconnection (--reconnect-interval, 0 = off) : a camera that sent nothing for a heartbeat timeout (sooner when
+// the waits for a frame fail) and no longer answers is closed, then looked for on the network (by MAC address or
+// serial number) every RECONNECT_INTERVAL_MS. Once back it is opened again with the same settings and streams
+// into the buffers it had, to the same outputs : the consumers stay connected, and the first frame after the
+// reconnection has FRAME_HEADER_FLAG_DISCONTINUITY set (the frame ids start again).
+#define RECONNECT_INTERVAL_MS		500
+#define RECONNECT_CHECK_MS			100		// Connection checks while the waits for a frame fail.
+
+// Image buffers per camera (--buffers).
 #define NUM_BUF	8
-void *m_latestBuffer = NULL;
+
+// Image and conversion buffers : 2 MB pages when possible (--huge-pages), locked in memory (--lock-buffers),
+// faulted in up front by several threads (--prefault-threads, 0 = on first use) and taken from the NUMA
+// node of the camera's NIC (--numa-bind).
+#define BUFFER_HUGE_PAGES			1
+#define BUFFER_LOCK					1
+#define BUFFER_PREFAULT_THREADS	4
+#define BUFFER_NUMA_BIND			1
+
+// Stream calibration (--calibrate=<seconds per trial>, 0 = off) : each camera streams with a range of packet
+// sizes, packet delays, internal frame buffering and buffer counts (after a warm up), the settings that lose
+// the fewest frames are saved to CALIBRATION_FILE (camera MAC address, NIC name) and the program stops.
+// Run with --config <file> to use them.
+#define CALIBRATE_SECONDS			0
+#define CALIBRATE_WARMUP_MS		1000
+#define CALIBRATION_FILE			"genicam_%04x%08x_%s.conf"
+
+// Recording (--record=<file>, "" = off) : every frame received (complete or not) is saved as it came, with
+// its frame id, timestamp and status, to be played back later with the replay backend. Frames are copied to
+// a queue of RECORD_QUEUE_DEPTH frames written by a thread of their own - if the disk falls behind, frames
+// are left out of the recording (counted), the acquisition is never held up.
+#define RECORD_PATH					""
+#define RECORD_QUEUE_DEPTH			8
+
+// Clock synchronization (--clock-sync=<ms>, 0 = off) : the camera clock is latched against the host clock
+// (CLOCK_MONOTONIC_RAW) every CLOCK_SYNC_INTERVAL_MS (CLOCK_SYNC_START_SAMPLES times in a row when the camera is
+// started) to map the frame timestamps to the host. Each frame header then carries its exposure time on the host
+// clock, and the latency of each stage (exposure -> arrival -> converted -> published) is measured (with --print).
+#define CLOCK_SYNC_INTERVAL_MS		1000
+#define CLOCK_SYNC_START_SAMPLES	4
+
+// Thread placement (--acquisition-threads, --converter-threads, --output-threads, --display-threads) :
+// <class>[:<priority>][@<cpus>] for each kind of thread (see ThreadPolicy.h). "auto" keeps the threads off
+// the cores of the GEV stream / server threads (and their SMT siblings) and on the NUMA node of the camera's
+// NIC. A real time class that is not permitted is reported once, the threads then run as they were created.
+#define THREAD_POLICY_ACQUISITION	"rr:10@auto"
+#define THREAD_POLICY_CONVERTER		"other@auto"
+#define THREAD_POLICY_OUTPUT			"other@auto"
+#define THREAD_POLICY_DISPLAY		"other@auto"
+
+// Frame pipeline : the frames of a camera go through an acquisition thread (waits for them, counts and records
+// them, leases their buffers), PIPELINE_CONVERT_WORKERS conversion threads (--convert-threads) (convert them, or
+// pass them on as they are) and a publication thread (sends them to the output and the display, in the order they
+// came in, then lets go of their buffers). The frames are dealt out to the conversion threads in turn, through a
+// lock-free ring of PIPELINE_STAGE_DEPTH frames each (--stage-depth, rounded up to a power of two), so several
+// frames are converted at once on as many cores. The publication thread takes them back in the same turn from
+// their rings to it (PIPELINE_STAGE_DEPTH frames shared between them), a frame converted ahead of its turn waits
+// for the ones before it. Each conversion thread writes to as many conversion buffers as its ring to the
+// publication thread holds + 2, in turn (with a single one, frames are converted straight into the shared
+// memory / memfd output when there is one - those are then sent by the conversion thread).
+// When a conversion thread's ring is full (--stage-overflow) :
+//   "block"       : the acquisition thread waits (and so back to the transfer) - no frame is lost here.
+//   "drop-oldest" : the oldest frame waiting is dropped (counted) - the acquisition never stalls.
+// (A conversion thread always waits for room in its ring to the publication thread : what is in it is in its
+// conversion buffers). With --print, the occupancy of each ring, the time each side waited (for room / for work),
+// how busy each conversion thread was and how many converted frames were waiting for their turn are reported :
+// the stage whose input ring stays full and that never waits for work is the bottleneck.
+#define PIPELINE_STAGE_DEPTH		4
+#define PIPELINE_STAGE_OVERFLOW	"block"
+#define PIPELINE_CONVERT_WORKERS	2
+#define PIPELINE_MAX_DEPTH			16
+#define PIPELINE_MAX_WORKERS		16
+#define PIPELINE_MAX_BUFFERS		(PIPELINE_MAX_DEPTH + 2)
+
+// A frame itself can be converted faster : cut into up to PIPELINE_CONVERT_BANDS bands of rows (--convert-bands)
+// converted at once by its conversion thread and a pool of PIPELINE_CONVERT_BANDS - 1 threads shared by the
+// cameras (placed as the conversion threads). Only frames of more than BAND_POOL_MIN_PIXELS pixels per band are cut up.
+// (1 = no pool).
+#define PIPELINE_CONVERT_BANDS	1
+
+// Instruction set of the pixel conversion kernels (--simd) : "auto" (the best the CPU has), "avx2", "sse4.1",
+// "ssse3" or "scalar" (the reference code only).
+#define CONVERT_SIMD					"auto"
+
+// Most cameras opened at once (genicam <index> <index> ... or genicam all).
+#define MAX_STREAMS	8
+static const ACQ_BACKEND *s_acq = &AcqBackend_Gev;	// Camera calls (GigE-V or synthetic).
+static APP_CONFIG s_config;								// Run time settings.
+static THREAD_POLICY s_threadPolicies[THREAD_NUM_ROLES];	// Placement of our threads (by role).
+
+// A frame on its way through the pipeline (acquisition -> conversion -> publication).
+typedef struct tagFRAME_JOB
+{
+	GEV_BUFFER_OBJECT	*img;
+	FRAME_LEASE			*lease;			// Hold on the image buffer (NULL = not leased).
+	uint16_t				flags;			// Frame header flags (taken when the frame came in).
+	uint64_t				exposureNs;		// Host times (0 = exposure unknown) (CLOCK_MONOTONIC_RAW).
+	uint64_t				arrivalNs;
+	uint64_t				convertedNs;
+	uint64_t				publishedNs;
+	FRAME_HEADER		hdr;				// Set by the conversion stage ...
+	void					*data;			// ... with the payload to send.
+	BOOL					inOutput;		// Converted straight into the output (shm slot / memfd buffer) - published as it is.
+	uint32_t				sequence;		// Order the frames came in (and go out) ...
+	int					busy;				// ... in the pipeline (the handle is free again once this is cleared).
+}FRAME_JOB;
+
+struct tagMY_CONTEXT;
+
+// A conversion thread of the pipeline.
+typedef struct tagCONVERT_WORKER
+{
+	struct tagMY_CONTEXT	*context;
+	int					index;
+	pthread_t			tid;
+	SPSC_RING			input;			// Frames from the acquisition thread ...
+	SPSC_RING			output;			// ... converted, to the publication thread.
+	void 					*buffers[PIPELINE_MAX_BUFFERS];	// Converted frames (used in turn).
+	int					numBuffers;
+	uint64_t				frames;			// Frames converted ...
+	uint64_t				nsBusy;			// ... and the time it took (read by the stats).
+	uint64_t				finished;		// (Publication thread) frames of this thread it is done with.
+	FRAME_JOB			*pending;		// (Publication thread) frame that came out ahead of its turn.
+	BOOL					done;				// (Publication thread) nothing more will come out.
+}CONVERT_WORKER;
+
+// Counters of the pipeline of a camera (as of a stats report).
+typedef struct tagPIPELINE_STATS
+{
+	uint64_t				nsTaken;			// When (host clock).
+	SPSC_RING_STATS	input[PIPELINE_MAX_WORKERS];
+	SPSC_RING_STATS	output[PIPELINE_MAX_WORKERS];
+	uint64_t				frames[PIPELINE_MAX_WORKERS];
+	uint64_t				nsBusy[PIPELINE_MAX_WORKERS];
+	uint64_t				published;		// Frames published ...
+	uint64_t				reorderTotal;	// ... and the sum of the converted frames waiting for their turn behind each.
+	uint32_t				reorderMax;
+}PIPELINE_STATS;
 
 typedef struct tagMY_CONTEXT
 {
@@ -45,11 +286,83 @@ typedef struct tagMY_CONTEXT
 	GEV_CAMERA_HANDLE camHandle;
 	int					depth;
 	int 					format;
-	void 					*convertBuffer;
 	BOOL					convertFormat;
 	BOOL              exit;
+	UINT32				outputFormat;	// GigE Vision pixel format of the converted output.
+	FRAME_SHM_RING		*shmRing;		// Shared memory output (NULL = write to stdout).
+	PIPE_SPLICE			*pipeOut;		// stdout output.
+	FRAME_SERVER		*frameServer;	// Socket subscribers (NULL = not serving).
+	FRAME_MEMFD_SERVER	*memfdServer;	// Shared (memfd) buffers (NULL = not sharing).
+	pthread_mutex_t	memfdLock;		// Serializes the memfd server (polled by the acquisition thread, published to by the others).
+	int					memfdSlot;		// Index of the first memfd output buffer (after the image buffers) ...
+	int					memfdSlots;		// ... and how many there are.
+	FRAME_QUEUE			*outputQueue;	// Queue to the stdout writer thread (NULL = write directly).
+	FRAME_LEASE_POOL	*leases;			// Leases on the image buffers (NULL = asynchronous cycling, nothing held).
+	BUFFER_ALLOC_POLICY	alloc;		// How the image / conversion buffers are allocated.
+	int					nicNode;			// NUMA node of the camera's NIC (-1 = unknown) - its threads run there.
+	pthread_mutex_t	*pipeLock;		// Serializes the writes to stdout (shared by the cameras).
+	ACQ_STATS			stats;			// Frames received by cause, gaps, timing (read by the stats timer).
+	FRAME_RECORDER		*recorder;		// Recording of the frames received (NULL = not recording).
+	CLOCK_SYNC			clock;			// Camera clock to host clock mapping (updated by the main loop).
+	LATENCY_STATS		latency;			// Exposure / arrival / conversion / output latencies.
+	CONVERT_WORKER		workers[PIPELINE_MAX_WORKERS];	// Conversion threads.
+	int					numWorkers;
+	FRAME_JOB			*jobs;			// Frames in the pipeline (the next free one is taken).
+	int					numJobs;
+	uint32_t				nextJob;
+	uint32_t				nextSequence;
+	uint64_t				pipelineStartNs;	// When the pipeline first started (host clock).
+	uint64_t				published;		// (Publication thread) frames published ...
+	uint64_t				reorderTotal;	// ... converted frames of the other conversion threads waiting behind each ...
+	uint32_t				reorderMax;		// ... and the most.
+	int					lostFd;			// eventfd - wakes up the main loop when the camera is lost (-1 = not watched).
+	BOOL					lost;				// The camera stopped answering (its acquisition thread has stopped).
+	BOOL					discontinuity;	// Flag the next frame sent (the first after a reconnection).
+	BOOL					calibrating;	// Only count the frames (no display, no output).
+	int					channel;			// Camera number sent in the frame header.
+	const APP_CAMERA_CONFIG	*config;	// Settings of the camera.
 }MY_CONTEXT, *PMY_CONTEXT;
 
+// Everything one camera needs : its context, transfer buffers, threads and output.
+typedef struct tagMY_CAMERA
+{
+	MY_CONTEXT			context;
+	GEV_CAMERA_HANDLE handle;			// NULL = not open.
+	int					numBuffers;
+	PUINT8				bufAddress[APP_CONFIG_MAX_BUFFERS];
+	UINT64				size;				// Size of each buffer.
+	pthread_t			tid;
+	pthread_t			writerTid;
+	ACQ_STATS_SNAPSHOT	lastStats;	// Counters at the last stats report.
+	LATENCY_SNAPSHOT	lastLatency;	// Latencies at the last stats report.
+	PIPELINE_STATS		lastPipeline;	// Pipeline counters at the last stats report.
+	GEV_DEVICE_INTERFACE	device;		// As found (to find the camera again after a disconnect).
+	UINT32				reconnects;
+	APP_CAMERA_CONFIG	config;
+	char					uniqueName[128];
+	FRAME_SHM_RING		shmRing;
+	FRAME_SERVER		frameServer;
+	FRAME_MEMFD_SERVER	memfdServer;
+	FRAME_QUEUE			outputQueue;
+	FRAME_LEASE_POOL	leasePool;
+	FRAME_RECORDER		recorder;
+}MY_CAMERA, *PMY_CAMERA;
+
+typedef struct tagMY_CONTROL
+{
+	MY_CAMERA			*cameras;
+	int					numCameras;
+	COMMAND_CHANNEL	channel;
+	pthread_mutex_t	lock;
+	pthread_cond_t		cond;
+	int					wakeFd;			// eventfd - wakes up the main loop when a request is pending.
+	const COMMAND		*request;		// Transfer change handed to the main thread (NULL = none pending).
+	MY_CAMERA			*target;			// Camera the request is for.
+	GEV_STATUS			status;			// Result of the request.
+	char					reply[COMMAND_MAX_VALUE];
+	BOOL					shutdown;		// The main loop has stopped (requests are failed).
+}MY_CONTROL, *PMY_CONTROL;
+
 static unsigned long us_timer_init( void )
 {
    struct timeval tm;
@@ -120,478 +433,2667 @@ static void _GetUniqueFilename( char *filename, size_t size, char *basename)
 }
 
 
-void * ImageDisplayThread( void *context)
+// Flags of the next frame header (a discontinuity is only flagged once).
+static uint16_t NextHeaderFlags( MY_CONTEXT *context)
 {
-	MY_CONTEXT *displayContext = (MY_CONTEXT *)context;
+	uint16_t flags = context->discontinuity ? FRAME_HEADER_FLAG_DISCONTINUITY : 0;
 
-	if (displayContext != NULL)
-	{
-		unsigned long prev_time = 0;
-		//unsigned long cur_time = 0;
-		//unsigned long deltatime = 0;
-		prev_time = us_timer_init();
+	context->discontinuity = FALSE;
+	return flags;
+}
 
-		// While we are still running.
-		while(!displayContext->exit)
+// Fill in the frame header for an acquired image and its output payload (flags and host times from the frame).
+static void SetFrameHeader( FRAME_HEADER *hdr, const FRAME_JOB *job, UINT32 pixel_format, UINT32 bytesPerPixel, int channel)
+{
+	GEV_BUFFER_OBJECT *img = job->img;
+	UINT64 timestamp = ((UINT64)img->timestamp_hi << 32) | (UINT64)img->timestamp_lo;
+	FrameHeader_Init( hdr, img->id, timestamp, img->w, img->h, pixel_format, 
+						img->w * bytesPerPixel, img->w * img->h * bytesPerPixel);
+	hdr->channel = (uint16_t)channel;
+	hdr->flags = job->flags;
+	hdr->exposure_ns = job->exposureNs;
+	hdr->arrival_ns = job->arrivalNs;
+}
+
+// Send one frame (header + payload) to the configured output transport.
+// "lease" is the image buffer the data is in (NULL = a buffer of ours, or not leased) : outputs that keep
+// the frame past this call take a reference on it instead of a copy.
+static void OutputFrame( MY_CONTEXT *displayContext, FRAME_HEADER *hdr, void *data, FRAME_LEASE *lease)
+{
+	if (displayContext->shmRing != NULL)
+	{
+		char *slot = (char *)FrameShm_BeginWrite( displayContext->shmRing, sizeof(FRAME_HEADER) + hdr->payload_length);
+		if (slot != NULL)
 		{
-			GEV_BUFFER_OBJECT *img = NULL;
-			GEV_STATUS status = 0;
-	
-			// Wait for images to be received
-			status = GevWaitForNextImage(displayContext->camHandle, &img, 1000);
+			memcpy(slot, hdr, sizeof(FRAME_HEADER));
+			memcpy(slot + sizeof(FRAME_HEADER), data, hdr->payload_length);
+			FrameShm_CommitWrite( displayContext->shmRing, sizeof(FRAME_HEADER) + hdr->payload_length);
+		}
+	}
+	else if (displayContext->memfdServer != NULL)
+	{
+		FRAME_MEMFD_SERVER *srv = displayContext->memfdServer;
+		int index = -1;
 
-			if ((img != NULL) && (status == GEVLIB_OK))
+		pthread_mutex_lock(&displayContext->memfdLock);
+		index = FrameMemfd_FindBuffer( srv, data);
+
+		if ((lease == NULL) && (index < displayContext->memfdSlot))
+		{
+			// The transfer reuses its buffers on its own schedule - share a copy instead.
+			index = -1;
+		}
+		if ((index < 0) && (srv->numClients > 0))
+		{
+			index = FrameMemfd_GetFreeBuffer( srv, displayContext->memfdSlot, displayContext->memfdSlots);
+			if (index >= 0)
 			{
-				if (img->status == 0)
-				{
-					m_latestBuffer = img->address;
-					// Can the acquired buffer be displayed?
-					if ( IsGevPixelTypeX11Displayable(img->format) || displayContext->convertFormat )
-					{
-						// Convert the image format if required.
-						if (displayContext->convertFormat)
-						{
-							int gev_depth = GevGetPixelDepthInBits(img->format);
-							// Convert the image to a displayable format.
-							//(Note : Not all formats can be displayed properly at this time (planar, YUV*, 10/12 bit packed).
-							ConvertGevImageToX11Format( img->w, img->h, gev_depth, img->format, img->address, \
-													displayContext->depth, displayContext->format, displayContext->convertBuffer);
-					
-							// Display the image in the (supported) converted format. 
-#if DISPLAY_WINDOW
-							Display_Image( displayContext->View, displayContext->depth, img->w, img->h, displayContext->convertBuffer );				
-#endif
-							// write the file to stdout for communication with other programs
-							fwrite(displayContext->convertBuffer, displayContext->depth * img->w * img->h, 1, stdout);
-							fflush(stdout);  // flush buffer after writing file 
-						}
-						else
-						{
-#if DISPLAY_WINDOW
-							// Display the image in the (supported) received format. 
-							Display_Image( displayContext->View, img->d,  img->w, img->h, img->address );
-#endif 
-							// print depth width and height for debugging purposes
-							// printf("Width %d\n", img->w);
-							// printf("Height %d\n", img->h);
-							// printf("Depth %d\n", img->d);
-							// write the file to stdout for communication with other programs
-							fwrite(img->address, img->d * img->w * img->h, 1, stdout);
-							fflush(stdout);
-						}
-					}
-					else
-					{
-#if PRINT_STATEMENTS
-						printf("Not displayable\n");
-#endif
-					}
-				}
-				else
-				{
-					// Image had an error (incomplete (timeout/overflow/lost)).
-					// Do any handling of this condition necessary.
-					// printf("Image had an error and is incomplete (timeout/overflow/lost).\n");
-				}
+				memcpy(FrameMemfd_BufferAddress( srv, index), data, hdr->payload_length);
 			}
-#if USE_SYNCHRONOUS_BUFFER_CYCLING
-			if (img != NULL)
+		}
+		if (index >= 0)
+		{
+			// Image buffers are held until every consumer has released them (output buffers just stay busy).
+			FRAME_LEASE *ref = (index < displayContext->memfdSlot) ? FrameLease_Ref( lease) : NULL;
+			if ((FrameMemfd_Publish( srv, index, hdr, sizeof(FRAME_HEADER), 0, ref) != 1) && (ref != NULL))
 			{
-				// Release the buffer back to the image transfer process.
-				GevReleaseImage( displayContext->camHandle, img);
+				FrameLease_Release( ref);
 			}
-#endif
 		}
+		pthread_mutex_unlock(&displayContext->memfdLock);
 	}
-	pthread_exit(0);	
-}
-
-int IsTurboDriveAvailable(GEV_CAMERA_HANDLE handle)
-{
-	int type;
-	UINT32 val = 0;
-	
-	if ( 0 == GevGetFeatureValue( handle, "transferTurboCurrentlyAbailable",  &type, sizeof(UINT32), &val) )
+	else if (displayContext->frameServer != NULL)
 	{
-		// Current / Standard method present - this feature indicates if TurboMode is available.
-		// (Yes - it is spelled that odd way on purpose).
-		return (val != 0);
+		// Copied once for all the subscribers - the buffer can be released right away.
+		FrameServer_Publish( displayContext->frameServer, hdr, sizeof(FRAME_HEADER), data, hdr->payload_length);
 	}
-	else
+	else if (displayContext->outputQueue != NULL)
 	{
-		// Legacy mode check - standard feature is not there try it manually.
-		char pxlfmt_str[64] = {0};
-
-		// Mandatory feature (always present).
-		GevGetFeatureValueAsString( handle, "PixelFormat", &type, sizeof(pxlfmt_str), pxlfmt_str);
-
-		// Set the "turbo" capability selector for this format.
-		if ( 0 != GevSetFeatureValueAsString( handle, "transferTurboCapabilitySelector", pxlfmt_str) )
+		// Hand the frame to the stdout writer thread (the policy decides what happens if it is behind).
+		// A leased buffer is queued by reference - the queue drops its reference once written or dropped.
+		if (lease != NULL)
 		{
-			// Either the capability selector is not present or the pixel format is not part of the 
-			// capability set.
-			// Either way - TurboMode is NOT AVAILABLE.....
-			return 0; 
+			FrameQueue_PushRef( displayContext->outputQueue, hdr->frame_id, hdr, sizeof(FRAME_HEADER), data, hdr->payload_length, 
+										FrameLease_Ref( lease), FrameLease_Release);
 		}
 		else
 		{
-			// The capabilty set exists so TurboMode is AVAILABLE.
-			// It is up to the camera to send TurboMode data if it can - so we let it.
-			return 1;
+			FrameQueue_Push( displayContext->outputQueue, hdr->frame_id, hdr, sizeof(FRAME_HEADER), data, hdr->payload_length);
 		}
 	}
-	return 0;
-}
-
-int main(int argc, char* argv[])
-{	
-	// Setup Gev
-	GEV_DEVICE_INTERFACE  pCamera[MAX_CAMERAS] = {0};
-	GEV_STATUS status;
-	int numCamera = 0;
-	int camIndex = 0;
-#if DISPLAY_WINDOW
-   X_VIEW_HANDLE  View = NULL;
-#endif
-	MY_CONTEXT context = {0};
-   pthread_t  tid;
-	int done = FALSE;
-	int turboDriveAvailable = 0;
-	char uniqueName[128];
-	uint32_t macLow = 0; // Low 32-bits of the mac address (for file naming).
-
-// Helper info
-#if PRINT_STATEMENTS
-#if DISPLAY_WINDOW
-	printf("*** DISPLAY WINDOW ENABLED, TO DISABLE SET DISPLAY_WINDOW VARIABLE TO 0 IN GENICAM.CPP ***\n");
-#else
-	printf("*** DISPLAY WINDOW DISABLED, TO DISABLE SET DISPLAY_WINDOW VARIABLE TO 1 IN GENICAM.CPP ***\n");
-#endif
-#endif
-
-	// Boost application RT response (not too high since GEV library boosts data receive thread to max allowed)
-	// SCHED_FIFO can cause many unintentional side effects.
-	// SCHED_RR has fewer side effects.
-	// SCHED_OTHER (normal default scheduler) is not too bad afer all.
-	if (0)
+	else
 	{
-		//int policy = SCHED_FIFO;
-		int policy = SCHED_RR;
-		pthread_attr_t attrib;
-		int inherit_sched = 0;
-		struct sched_param param = {0};
-
-		// Set an average RT priority (increase/decrease to tuner performance).
-		param.sched_priority = (sched_get_priority_max(policy) - sched_get_priority_min(policy)) / 2;
-		
-		// Set scheduler policy
-		pthread_setschedparam( pthread_self(), policy, &param); // Don't care if it fails since we can't do anyting about it.
-		
-		// Make sure all subsequent threads use the same policy.
-		pthread_attr_init(&attrib);
-		pthread_attr_getinheritsched( &attrib, &inherit_sched);
-		if (inherit_sched != PTHREAD_INHERIT_SCHED)
+		// write the file to stdout for communication with other programs
+		// (writev or vmsplice straight to the descriptor - no stdio buffering).
+		FRAME_LEASE *ref = FrameLease_Ref( lease);
+		pthread_mutex_lock(displayContext->pipeLock);
+		if ((PipeSplice_WriteFrame( displayContext->pipeOut, hdr, sizeof(FRAME_HEADER), data, hdr->payload_length, ref) != 1) && (ref != NULL))
 		{
-			inherit_sched = PTHREAD_INHERIT_SCHED;
-			pthread_attr_setinheritsched(&attrib, inherit_sched);
+			FrameLease_Release( ref);
 		}
+		pthread_mutex_unlock(displayContext->pipeLock);
 	}
-	
+}
 
-	// Set default options for the library.
-	{
-		GEVLIB_CONFIG_OPTIONS options = {0};
+// Place a thread of a camera as its role says (a placement that is refused is reported once per role).
+static void PlaceThread( THREAD_ROLE role, pthread_t thread, MY_CONTEXT *context)
+{
+	static int s_refused[THREAD_NUM_ROLES];
+	int status = ThreadPolicy_Apply( thread, &s_threadPolicies[role], context->nicNode);
 
-		GevGetLibraryConfigOptions( &options);
-		//options.logLevel = GEV_LOG_LEVEL_OFF;
-		//options.logLevel = GEV_LOG_LEVEL_TRACE;
-		options.logLevel = GEV_LOG_LEVEL_NORMAL;
-		GevSetLibraryConfigOptions( &options);
+	if ((status != 0) && (__atomic_exchange_n(&s_refused[role], 1, __ATOMIC_RELAXED) == 0))
+	{
+		fprintf(stderr, "%s threads : %s - left as created\n", ThreadPolicy_RoleName( role), 
+					(status == THREADPOLICY_ERROR_SCHED) ? "scheduling class not permitted (needs CAP_SYS_NICE or an rtprio limit)" : "CPUs not usable");
 	}
+	if (s_config.print)
+	{
+		char text[256];
 
-	//====================================================================================
-	// DISCOVER Cameras
-	//
-	// Get all the IP addresses of attached network cards.
+		ThreadPolicy_Describe( &s_threadPolicies[role], context->nicNode, text, sizeof(text));
+		printf("Camera %d %s thread : %s\n", context->channel, ThreadPolicy_RoleName( role), text);
+	}
+}
 
-	status = GevGetCameraList( pCamera, MAX_CAMERAS, &numCamera);
+// Place the threads of a camera's display window.
+static void PlaceDisplayThreads( MY_CONTEXT *context)
+{
+	if (context->View != NULL)
+	{
+		PlaceThread( THREAD_ROLE_DISPLAY, context->View->display_thread_id, context);
+		PlaceThread( THREAD_ROLE_DISPLAY, context->View->handler_thread_id, context);
+	}
+}
 
-#if PRINT_STATEMENTS
-	printf ("%d camera(s) on the network\n", numCamera);
-#endif
+// Drain the output queue to stdout (so a slow reader only holds up this thread).
+void * OutputWriterThread( void *context)
+{
+	MY_CONTEXT *displayContext = (MY_CONTEXT *)context;
+	FRAME_QUEUE_ENTRY *entry = NULL;
 
-	// Select the first camera found (unless the command line has a parameter = the camera index)
-	if (numCamera != 0)
+	PlaceThread( THREAD_ROLE_OUTPUT, pthread_self(), displayContext);
+	while ((entry = FrameQueue_Pop( displayContext->outputQueue)) != NULL)
 	{
-		if (argc > 1)
-		{
-			sscanf(argv[1], "%d", &camIndex);
-			if (camIndex >= (int)numCamera)
-			{
-#if PRINT_STATEMENTS
-				printf("Camera index out of range - only %d camera(s) are present\n", numCamera);
-#endif
-				camIndex = -1;
-			}
-		}
-
-		if (camIndex != -1)
-		{
-			//====================================================================
-			// Connect to Camera
-			//
-			//
-			int i;
-			int type;
-			UINT32 height = 0;
-			UINT32 width = 0;
-			UINT32 format = 0;
-			UINT32 maxHeight = 1600;
-			UINT32 maxWidth = 2048;
-			UINT32 maxDepth = 2;
-			UINT64 size;
-			UINT64 payload_size;
-			int numBuffers = NUM_BUF;
-			PUINT8 bufAddress[NUM_BUF];
-			GEV_CAMERA_HANDLE handle = NULL;
-			UINT32 pixFormat = 0;
-			UINT32 pixDepth = 0;
-			UINT32 convertedGevFormat = 0;
-			
-			//====================================================================
-			// Open the camera.
-			status = GevOpenCamera( &pCamera[camIndex], GevExclusiveMode, &handle);
-			// Get the low part of the MAC address (use it as part of a unique file name for saving images).
-			// Generate a unique base name to be used for saving image files
-			// based on the last 3 octets of the MAC address.
-			macLow = pCamera[camIndex].macLow;
-			macLow &= 0x00FFFFFF;
-			snprintf(uniqueName, sizeof(uniqueName), "img_%06x", macLow); 
-			
-			
-			// Go on to adjust some API related settings (for tuning / diagnostics / etc....).
-			if ( status == 0 )
-			{
-				GEV_CAMERA_OPTIONS camOptions = {0};
-
-				// Adjust the camera interface options if desired (see the manual)
-				GevGetCameraInterfaceOptions( handle, &camOptions);
-				//camOptions.heartbeat_timeout_ms = 60000;		// For debugging (delay camera timeout while in debugger)
-				camOptions.heartbeat_timeout_ms = 10000;		// Disconnect detection (10 seconds)
-
-#if TUNE_STREAMING_THREADS
-				// Some tuning can be done here. (see the manual)
-				camOptions.streamFrame_timeout_ms = 1001;				// Internal timeout for frame reception.
-				camOptions.streamNumFramesBuffered = 4;				// Buffer frames internally.
-				camOptions.streamMemoryLimitMax = 64*1024*1024;		// Adjust packet memory buffering limit.	
-				camOptions.streamPktSize = 9180;							// Adjust the GVSP packet size.
-				camOptions.streamPktDelay = 10;							// Add usecs between packets to pace arrival at NIC.
-				
-				// Assign specific CPUs to threads (affinity) - if required for better performance.
-				{
-					int numCpus = _GetNumCpus();
-					if (numCpus > 1)
-					{
-						camOptions.streamThreadAffinity = numCpus-1;
-						camOptions.serverThreadAffinity = numCpus-2;
-					}
-				}
-#endif
-				// Write the adjusted interface options back.
-				GevSetCameraInterfaceOptions( handle, &camOptions);
-
-				//=====================================================================
-				// Get the GenICam FeatureNodeMap object and access the camera features.
-				GenApi::CNodeMapRef *Camera = static_cast<GenApi::CNodeMapRef*>(GevGetFeatureNodeMap(handle));
-				
-				if (Camera)
-				{
-					// Access some features using the bare GenApi interface methods
-					try 
-					{
-						//Mandatory features....
-						GenApi::CIntegerPtr ptrIntNode = Camera->_GetNode("Width");
-						width = (UINT32) ptrIntNode->GetValue();
-						ptrIntNode = Camera->_GetNode("Height");
-						height = (UINT32) ptrIntNode->GetValue();
-						ptrIntNode = Camera->_GetNode("PayloadSize");
-						payload_size = (UINT64) ptrIntNode->GetValue();
-						GenApi::CEnumerationPtr ptrEnumNode = Camera->_GetNode("PixelFormat") ;
-						format = (UINT32)ptrEnumNode->GetIntValue();
-					}
-					// Catch all possible exceptions from a node access.
-					CATCH_GENAPI_ERROR(status);
-				}
+		// Frames queued by reference hold a lease - the pipe takes one of its own if it keeps the buffer (vmsplice).
+		FRAME_LEASE *ref = FrameLease_Ref( (FRAME_LEASE *)entry->ref);
 
-				if (status == 0)
-				{
-					//=================================================================
-					// Set up a grab/transfer from this camera
-					//
-#if PRINT_STATEMENTS
-					printf("Camera ROI set for \n\tHeight = %d\n\tWidth = %d\n\tPixelFormat (val) = 0x%08x\n", height,width,format);
-#endif
+		pthread_mutex_lock(displayContext->pipeLock);
+		if ((PipeSplice_WriteFrame( displayContext->pipeOut, entry->data, entry->headerLen, 
+											entry->payload, entry->length, ref) != 1) && (ref != NULL))
+		{
+			FrameLease_Release( ref);
+		}
+		pthread_mutex_unlock(displayContext->pipeLock);
+		FrameQueue_Done( displayContext->outputQueue, entry);
+	}
+	pthread_exit(0);
+}
 
-					maxHeight = height;
-					maxWidth = width;
-					maxDepth = GetPixelSizeInBytes(format);
+// Give back to the transfer the image buffers whose last holder is done with them.
+static void ReclaimLeases( MY_CONTEXT *displayContext)
+{
+	void *img = NULL;
 
-					// Allocate image buffers
-					// (Either the image size or the payload_size, whichever is larger - allows for packed pixel formats).
-					size = maxDepth * maxWidth * maxHeight;
-					size = (payload_size > size) ? payload_size : size;
-					for (i = 0; i < numBuffers; i++)
-					{
-						bufAddress[i] = (PUINT8)malloc(size);
-						memset(bufAddress[i], 0, size);
+	while ( FrameLease_Reclaim( displayContext->leases, &img) )
+	{
+		s_acq->ReleaseImage( displayContext->camHandle, (GEV_BUFFER_OBJECT *)img);
+	}
+}
 
-					}
+// Drop the leases the consumers are done with (vmspliced buffers drained from the pipe, 
+// memfd buffers released by every consumer) and give the buffers back.
+// (The stdout pipe is shared : the leases it hands back can be another camera's - they go back to their own pool).
+static void ReleaseDrainedBuffers( MY_CONTEXT *displayContext)
+{
+	void *ref = NULL;
 
-#if USE_SYNCHRONOUS_BUFFER_CYCLING
-					// Initialize a transfer with synchronous buffer handling.
-					status = GevInitializeTransfer( handle, SynchronousNextEmpty, size, numBuffers, bufAddress);
-#else
-					// Initialize a transfer with asynchronous buffer handling.
-					status = GevInitializeTransfer( handle, Asynchronous, size, numBuffers, bufAddress);
-#endif
+	pthread_mutex_lock(displayContext->pipeLock);
+	while ( PipeSplice_Reclaim( displayContext->pipeOut, &ref) )
+	{
+		FrameLease_Release( ref);
+	}
+	pthread_mutex_unlock(displayContext->pipeLock);
+	if (displayContext->memfdServer != NULL)
+	{
+		// Pick up new consumers and their releases.
+		pthread_mutex_lock(&displayContext->memfdLock);
+		FrameMemfd_Poll( displayContext->memfdServer);
+		while ( FrameMemfd_Reclaim( displayContext->memfdServer, &ref) )
+		{
+			FrameLease_Release( ref);
+		}
+		pthread_mutex_unlock(&displayContext->memfdLock);
+	}
+	ReclaimLeases( displayContext);
+}
 
-					// Create an image display window.
-					// This works best for monochrome and RGB. The packed color formats (with Y, U, V, etc..) require 
-					// conversion as do, if desired, Bayer formats.
-					// (Packed pixels are unpacked internally unless passthru mode is enabled).
+static void PollDrainedBuffers( void *context)
+{
+	ReleaseDrainedBuffers( (MY_CONTEXT *)context);
+}
 
-					// Translate the raw pixel format to one suitable for the (limited) Linux display routines.			
+// Statistics cause of a received buffer's status.
+static ACQ_FRAME_CAUSE FrameCause( INT32 status)
+{
+	switch (status)
+	{
+		case GEV_FRAME_STATUS_RECVD:		return ACQ_FRAME_COMPLETE;
+		case GEV_FRAME_STATUS_TIMEOUT:	return ACQ_FRAME_TIMEOUT;
+		case GEV_FRAME_STATUS_OVERFLOW:	return ACQ_FRAME_OVERFLOW;
+		case GEV_FRAME_STATUS_BANDWIDTH:	return ACQ_FRAME_BANDWIDTH;
+		case GEV_FRAME_STATUS_LOST:		return ACQ_FRAME_LOST;
+		default:									return ACQ_FRAME_OTHER;
+	}
+}
 
-					status = GetX11DisplayablePixelFormat( ENABLE_BAYER_CONVERSION, format, &convertedGevFormat, &pixFormat);
+// Number of image buffers held by the consumers (not yet given back to the transfer).
+static int HeldBufferCount( MY_CONTEXT *displayContext)
+{
+	return FrameLease_Outstanding( displayContext->leases);
+}
 
-					if (format != convertedGevFormat) 
-					{
-						// We MAY need to convert the data on the fly to display it.
-						if (GevIsPixelTypeRGB(convertedGevFormat))
-						{
-							// Conversion to RGB888 required.
-							pixDepth = 32;	// Assume 4 8bit components for color display (RGBA)
-							context.format = Convert_SaperaFormat_To_X11( pixFormat);
-							context.depth = pixDepth;
-							context.convertBuffer = malloc((maxWidth * maxHeight * ((pixDepth + 7)/8)));
-							context.convertFormat = TRUE;
-						}
-						else
-						{
-							// Converted format is MONO - generally this is handled
-							// internally (unpacking etc...) unless in passthru mode.
-							// (						
-							pixDepth = GevGetPixelDepthInBits(convertedGevFormat);
-							context.format = Convert_SaperaFormat_To_X11( pixFormat);
-							context.depth = pixDepth;							
-							context.convertBuffer = NULL;
-							context.convertFormat = FALSE;
-						}
-					}
-					else
-					{
-						pixDepth = GevGetPixelDepthInBits(convertedGevFormat);
-						context.format = Convert_SaperaFormat_To_X11( pixFormat);
-						context.depth = pixDepth;
-						context.convertBuffer = NULL;
-						context.convertFormat = FALSE;
-					}
-					
-#if DISPLAY_WINDOW
-					View = CreateDisplayWindow("GigE-V GenApi Console Demo", TRUE, height, width, pixDepth, pixFormat, FALSE ); 
+// Let go of a frame's image buffer (it goes back to the transfer once the outputs are done with it too), and of its handle.
+static void ReleaseFrame( MY_CONTEXT *displayContext, FRAME_JOB *job)
+{
+	if (job->lease != NULL)
+	{
+		// (Given back by the acquisition thread - ReclaimLeases).
+		FrameLease_Release( job->lease);
+	}
+	else if (displayContext->config->syncCycling)
+	{
+		s_acq->ReleaseImage( displayContext->camHandle, job->img);
+	}
+	job->lease = NULL;
+	job->img = NULL;
+	__atomic_store_n(&job->busy, 0, __ATOMIC_RELEASE);
+}
 
-					// Create a thread to receive images from the API and display them.
-					context.View = View;
-#endif
-					context.camHandle = handle;
-					context.exit = FALSE;
-					pthread_create(&tid, NULL, ImageDisplayThread, &context); 
+// Hand a frame on to the next stage (a frame dropped to make room, or one the stage will not take, is let go of).
+static void PassFrame( MY_CONTEXT *displayContext, SPSC_RING *ring, FRAME_JOB *job)
+{
+	void *dropped = NULL;
 
+	if (SpscRing_Push( ring, job, &dropped) != 0)
+	{
+		ReleaseFrame( displayContext, job);
+	}
+	if (dropped != NULL)
+	{
+		ReleaseFrame( displayContext, (FRAME_JOB *)dropped);
+	}
+}
 
-					// main loop
-					int setup = 0;
-					while(!done)
-					{
-						if (!setup) {
-							// Check if turboMode works
-							turboDriveAvailable = IsTurboDriveAvailable(handle);
-							if(turboDriveAvailable)
-							{
-								UINT32 val = TURBO_DRIVE;
-								GevGetFeatureValue(handle, "transferTurboMode", &type, sizeof(UINT32), &val);
-								val = (val == 0) ? 1 : 0;
-								GevSetFeatureValue(handle, "transferTurboMode", sizeof(UINT32), &val);
-								GevGetFeatureValue(handle, "transferTurboMode", &type, sizeof(UINT32), &val);
-
-#if PRINT_STATEMENTS
-								if (val == 1)
-								{
-									printf("TurboMode Enabled\n");
-								}
-								else
-								{
-									printf("TurboMode Disabled\n");
-								}
-#endif
-							}
-							else 
-							{
-#if PRINT_STATEMENTS
-								printf("*** TurboDrive is NOT Available for this device/pixel format combination ***\n");
-#endif
-							}
+// A free frame handle (acquisition thread) - there are more than the pipeline can hold, one is always free.
+static FRAME_JOB *NextFreeJob( MY_CONTEXT *displayContext)
+{
+	for (;;)
+	{
+		FRAME_JOB *job = &displayContext->jobs[displayContext->nextJob++ % displayContext->numJobs];
 
-							// Stream images
-							for (i = 0; i < numBuffers; i++)
-							{
-								memset(bufAddress[i], 0, size);
-							}
-							status = GevStartTransfer( handle, -1);
-#if PRINT_STATEMENTS
-							if (status != 0) printf("Error starting grab - 0x%x  or %d\n", status, status); 
-#endif
+		if (!__atomic_load_n(&job->busy, __ATOMIC_ACQUIRE))
+		{
+			job->busy = 1;
+			return job;
+		}
+	}
+}
 
-							// Setup complete
-							setup = 1;
-						}
-					}
+// Conversion stage : converts the frames dealt to this thread to the output format (or passes them on as they are).
+static void * ConvertThread( void *context)
+{
+	CONVERT_WORKER *worker = (CONVERT_WORKER *)context;
+	MY_CONTEXT *displayContext = worker->context;
+	void *item = NULL;
+	int next = 0;		// Conversion buffer the next frame goes to.
 
-					GevAbortTransfer(handle);
-					status = GevFreeTransfer(handle);
+	PlaceThread( THREAD_ROLE_CONVERTER, pthread_self(), displayContext);
+	while (SpscRing_Pop( &worker->input, &item) == 0)
+	{
+		FRAME_JOB *job = (FRAME_JOB *)item;
+		GEV_BUFFER_OBJECT *img = job->img;
+		uint64_t startNs = ClockSync_Now();
 
-#if DISPLAY_WINDOW
-					DestroyDisplayWindow(View);
-#endif
+		// Convert the image format if required.
+		if (displayContext->convertFormat)
+		{
+			int gev_depth = GevGetPixelDepthInBits(img->format);
+			void *convertBuffer = NULL;
 
+			SetFrameHeader( &job->hdr, job, displayContext->outputFormat, (displayContext->depth + 7)/8, displayContext->channel);
 
-					for (i = 0; i < numBuffers; i++)
-					{	
-						free(bufAddress[i]);
-					}
-					if (context.convertBuffer != NULL)
+			// Convert straight into the shared memory slot when possible (saves a copy) - the publication thread commits it.
+			// (Only with a single conversion thread, and once the frames before are out : the ring has one slot being written at a time).
+			if ((displayContext->shmRing != NULL) && (displayContext->numWorkers == 1))
+			{
+				if (__atomic_load_n(&worker->finished, __ATOMIC_ACQUIRE) == worker->frames)
+				{
+					char *slot = (char *)FrameShm_BeginWrite( displayContext->shmRing, sizeof(FRAME_HEADER) + job->hdr.payload_length);
+					if (slot != NULL)
 					{
-						free(context.convertBuffer);
-						context.convertBuffer = NULL;
+						memcpy(slot, &job->hdr, sizeof(FRAME_HEADER));
+						convertBuffer = slot + sizeof(FRAME_HEADER);
 					}
 				}
-				GevCloseCamera(&handle);
 			}
-			else
+			else if ((displayContext->memfdServer != NULL) && (displayContext->numWorkers == 1))
 			{
-#if PRINT_STATEMENTS
-				printf("Error : 0x%0x : opening camera\n", status);
-#endif
+				// Or straight into a shared memfd output buffer (claimed : the publication thread
+				// does not copy a frame of its own into it meanwhile - publishing it frees it).
+				pthread_mutex_lock(&displayContext->memfdLock);
+				if (displayContext->memfdServer->numClients > 0)
+				{
+					int index = FrameMemfd_ClaimBuffer( displayContext->memfdServer, displayContext->memfdSlot, displayContext->memfdSlots);
+					convertBuffer = FrameMemfd_BufferAddress( displayContext->memfdServer, index);
+				}
+				pthread_mutex_unlock(&displayContext->memfdLock);
+			}
+			job->inOutput = (convertBuffer != NULL);
+			if (convertBuffer == NULL)
+			{
+				// The frames before it may still be waiting to be sent - there is one more buffer than they can hold.
+				convertBuffer = worker->buffers[next];
+				next = (next + 1) % worker->numBuffers;
 			}
+
+			// Convert the image to a displayable format.
+			//(Note : Not all formats can be displayed properly at this time (planar, YUV*, 10/12 bit packed).
+			ConvertGevImageToX11Format( img->w, img->h, gev_depth, img->format, img->address, \
+									displayContext->depth, displayContext->format, convertBuffer);
+			job->data = convertBuffer;
+			job->convertedNs = ClockSync_Now();
 		}
-	}
+		else
+		{
+			// print depth width and height for debugging purposes
+			// printf("Width %d\n", img->w);
+			// printf("Height %d\n", img->h);
+			// printf("Depth %d\n", img->d);
+			SetFrameHeader( &job->hdr, job, img->format, img->d, displayContext->channel);
+			job->data = img->address;
+			job->inOutput = FALSE;
+			job->convertedNs = ClockSync_Now();
+		}
+		__atomic_store_n(&worker->frames, worker->frames + 1, __ATOMIC_RELAXED);
+		__atomic_store_n(&worker->nsBusy, worker->nsBusy + (job->convertedNs - startNs), __ATOMIC_RELAXED);
 
-	// Close down the API.
-	GevApiUninitialize();
+		// (Never dropped here : the frames in the ring are in this thread's conversion buffers).
+		PassFrame( displayContext, &worker->output, job);
+	}
+	// (The publication stage stops once it has sent what is left).
+	SpscRing_Shutdown( &worker->output);
+	pthread_exit(0);
+}
 
-	// Close socket API
-	_CloseSocketAPI ();	// must close API even on error
+// Next frame out of a conversion thread for the publication stage (NULL = it has stopped and has nothing left).
+static FRAME_JOB *NextConvertedFrame( CONVERT_WORKER *worker)
+{
+	FRAME_JOB *job = worker->pending;
+	void *item = NULL;
 
+	worker->pending = NULL;
+	if ((job == NULL) && !worker->done)
+	{
+		if (SpscRing_Pop( &worker->output, &item) == 0)
+		{
+			job = (FRAME_JOB *)item;
+		}
+		else
+		{
+			worker->done = TRUE;
+		}
+	}
+	return job;
+}
+
+// Publication stage : sends the frames to the output and the display in the order they came in, then lets go of their buffers.
+// The frames were dealt out to the conversion threads in turn, so they are taken back in the same turn - the frame whose
+// turn it is may be late, then the ones converted after it wait (counted). A frame that does not come out of its conversion
+// thread in its turn was dropped before it was converted : its turn is skipped (and the frame that came instead waits for its own).
+static void * PublishThread( void *context)
+{
+	MY_CONTEXT *displayContext = (MY_CONTEXT *)context;
+	uint32_t sequence = 0;		// Frame whose turn it is.
+	int numPending = 0;
+	int numDone = 0;
+
+	PlaceThread( THREAD_ROLE_OUTPUT, pthread_self(), displayContext);
+	while ((numDone < displayContext->numWorkers) || (numPending > 0))
+	{
+		CONVERT_WORKER *worker = &displayContext->workers[sequence % displayContext->numWorkers];
+		BOOL wasDone = worker->done;
+		BOOL wasPending = (worker->pending != NULL);
+		FRAME_JOB *job = NextConvertedFrame( worker);
+		GEV_BUFFER_OBJECT *img = NULL;
+		BOOL inPlace = FALSE;
+		uint32_t waiting = 0;
+		int i;
+
+		numDone += (worker->done && !wasDone) ? 1 : 0;
+		numPending -= wasPending ? 1 : 0;
+		if ((job != NULL) && (job->sequence != sequence))
+		{
+			// Its frame was dropped.
+			worker->pending = job;
+			numPending++;
+			job = NULL;
+		}
+		sequence++;
+		if (job == NULL)
+		{
+			continue;
+		}
+
+		// Converted frames waiting for this one (reorder buffer).
+		for (i = 0; i < displayContext->numWorkers; i++)
+		{
+			if (&displayContext->workers[i] != worker)
+			{
+				waiting += SpscRing_Depth( &displayContext->workers[i].output) + ((displayContext->workers[i].pending != NULL) ? 1 : 0);
+			}
+		}
+		__atomic_store_n(&displayContext->published, displayContext->published + 1, __ATOMIC_RELAXED);
+		__atomic_store_n(&displayContext->reorderTotal, displayContext->reorderTotal + waiting, __ATOMIC_RELAXED);
+		if (waiting > displayContext->reorderMax)
+		{
+			__atomic_store_n(&displayContext->reorderMax, waiting, __ATOMIC_RELAXED);
+		}
+
+		img = job->img;
+		inPlace = (job->data == img->address);
+		if (s_config.display)
+		{
+			// Display the image in the (supported) received / converted format. 
+			Display_Image( displayContext->View, inPlace ? img->d : displayContext->depth, img->w, img->h, job->data );
+		}
+		if (job->inOutput && (displayContext->shmRing != NULL))
+		{
+			FrameShm_CommitWrite( displayContext->shmRing, sizeof(FRAME_HEADER) + job->hdr.payload_length);
+		}
+		else
+		{
+			// The image buffer itself is shared by reference - a converted copy is ours
+			// (a claimed memfd buffer is found by its address and published as it is).
+			OutputFrame( displayContext, &job->hdr, job->data, inPlace ? job->lease : NULL);
+		}
+		job->publishedNs = ClockSync_Now();
+		LatencyStats_Frame( &displayContext->latency, job->exposureNs, job->arrivalNs, job->convertedNs, job->publishedNs);
+
+		// Done with the frame here - the buffer goes back to the transfer unless an output still holds it
+		// (eg. until the reader has drained it from the pipe).
+		ReleaseFrame( displayContext, job);
+		__atomic_store_n(&worker->finished, worker->finished + 1, __ATOMIC_RELEASE);
+	}
+	pthread_exit(0);
+}
+
+// Stop the conversion threads started (the first "numStarted") and the publication thread (when started) :
+// they finish the frames they have, then stop.
+static void StopPipelineThreads( MY_CONTEXT *displayContext, int numStarted, pthread_t *publishTid)
+{
+	int i;
+
+	for (i = 0; i < numStarted; i++)
+	{
+		SpscRing_Shutdown( &displayContext->workers[i].input);
+	}
+	for (i = 0; i < numStarted; i++)
+	{
+		pthread_join( displayContext->workers[i].tid, NULL);
+	}
+	if (publishTid != NULL)
+	{
+		pthread_join( *publishTid, NULL);
+	}
+}
+
+// Start the conversion and publication threads (none is left running if one cannot be started).
+static int StartPipelineThreads( MY_CONTEXT *displayContext, pthread_t *publishTid)
+{
+	int i;
+
+	for (i = 0; i < displayContext->numWorkers; i++)
+	{
+		CONVERT_WORKER *worker = &displayContext->workers[i];
+
+		SpscRing_Restart( &worker->input);
+		SpscRing_Restart( &worker->output);
+		worker->pending = NULL;
+		worker->done = FALSE;
+		if (pthread_create( &worker->tid, NULL, ConvertThread, worker) != 0)
+		{
+			StopPipelineThreads( displayContext, i, NULL);
+			return -1;
+		}
+	}
+	if (pthread_create( publishTid, NULL, PublishThread, displayContext) != 0)
+	{
+		StopPipelineThreads( displayContext, displayContext->numWorkers, NULL);
+		return -1;
+	}
+	return 0;
+}
+
+void * ImageDisplayThread( void *context)
+{
+	MY_CONTEXT *displayContext = (MY_CONTEXT *)context;
+
+	if (displayContext != NULL)
+	{
+		unsigned long prev_time = 0;
+		pthread_t publishTid;
+		PlaceThread( THREAD_ROLE_ACQUISITION, pthread_self(), displayContext);
+		//unsigned long cur_time = 0;
+		//unsigned long deltatime = 0;
+		unsigned long lastCheck = ms_timer_init();	// Last frame (or connection check).
+		prev_time = us_timer_init();
+
+		// The conversion and publication stages run for as long as this thread does (the frames are numbered from 0).
+		displayContext->nextSequence = 0;
+		if (displayContext->pipelineStartNs == 0)
+		{
+			displayContext->pipelineStartNs = ClockSync_Now();
+		}
+		if (StartPipelineThreads( displayContext, &publishTid) != 0)
+		{
+			fprintf(stderr, "camera %d : cannot start the conversion / publication threads\n", displayContext->channel);
+			pthread_exit(0);
+		}
+
+		// While we are still running.
+		while(!displayContext->exit)
+		{
+			GEV_BUFFER_OBJECT *img = NULL;
+			GEV_STATUS status = 0;
+			FRAME_LEASE *lease = NULL;
+			uint64_t arrivalNs = 0;
+			uint64_t exposureNs = 0;
+
+			ReleaseDrainedBuffers( displayContext);
+			// Keep at least one buffer available to the transfer while the consumers catch up
+			// (the leases are one less than the buffers - with the "wait" policy, wait for one to come back).
+			FrameLease_WaitFree( displayContext->leases, PollDrainedBuffers, displayContext, &displayContext->exit);
+	
+			// Wait for images to be received
+			status = s_acq->WaitForNextImage(displayContext->camHandle, &img, 1000);
+			if ((img != NULL) && (status == GEVLIB_OK))
+			{
+				arrivalNs = ClockSync_Now();
+				if (ClockSync_ToHost( &displayContext->clock, ((uint64_t)img->timestamp_hi << 32) | img->timestamp_lo, &exposureNs) != 0)
+				{
+					exposureNs = 0;
+				}
+				lastCheck = ms_timer_init();
+				AcqStats_Frame( &displayContext->stats, FrameCause( img->status), img->id);
+				if (displayContext->recorder != NULL)
+				{
+					// Copied as received (dropped from the recording if its writer is behind).
+					FRAME_RECORD record;
+
+					memset(&record, 0, sizeof(record));
+					record.frameId = img->id;
+					record.timestamp = ((uint64_t)img->timestamp_hi << 32) | img->timestamp_lo;
+					record.status = img->status;
+					record.format = img->format;
+					record.width = img->w;
+					record.height = img->h;
+					record.depth = img->d;
+					record.length = img->recv_size;
+					FrameRecord_Add( displayContext->recorder, &record, img->address);
+				}
+			}
+			else
+			{
+				AcqStats_Wait( &displayContext->stats, (status == GEVLIB_ERROR_TIME_OUT));
+				if ((displayContext->lostFd >= 0) && ms_timer_interval_elapsed( lastCheck, 
+						(status == GEVLIB_ERROR_TIME_OUT) ? displayContext->config->heartbeatTimeoutMs : RECONNECT_CHECK_MS))
+				{
+					// Nothing for a while : is the camera still there (or just not sending) ?
+					if (s_acq->CheckConnection( displayContext->camHandle) != 0)
+					{
+						// Gone - the main thread closes it and looks for it (this thread stops here).
+						displayContext->lost = TRUE;
+						eventfd_write( displayContext->lostFd, 1);
+						break;
+					}
+					lastCheck = ms_timer_init();
+				}
+			}
+
+			if ((img != NULL) && (status == GEVLIB_OK) && (img->status == 0) && (displayContext->leases != NULL))
+			{
+				// Hold the buffer for as long as it is used here or by an output.
+				lease = FrameLease_Acquire( displayContext->leases, img, img->address, img->id);
+				if (lease == NULL)
+				{
+					// Every buffer is held ("drop" policy) : this frame is skipped.
+					s_acq->ReleaseImage( displayContext->camHandle, img);
+					img = NULL;
+				}
+			}
+
+			if ((img != NULL) && (status == GEVLIB_OK))
+			{
+				if ((img->status == 0) && !displayContext->calibrating &&
+					 ( IsGevPixelTypeX11Displayable(img->format) || displayContext->convertFormat ))
+				{
+					// On to the conversion thread whose turn it is (the publication stage lets go of the buffer).
+					FRAME_JOB *job = NextFreeJob( displayContext);
+
+					job->img = img;
+					job->lease = lease;
+					job->flags = NextHeaderFlags( displayContext);
+					job->exposureNs = exposureNs;
+					job->arrivalNs = arrivalNs;
+					job->convertedNs = 0;
+					job->publishedNs = 0;
+					job->sequence = displayContext->nextSequence++;
+					PassFrame( displayContext, &displayContext->workers[job->sequence % displayContext->numWorkers].input, job);
+					continue;
+				}
+				else if (img->status != 0)
+				{
+					// Image had an error (incomplete (timeout/overflow/lost)) : counted by cause above, not output.
+				}
+				else if (displayContext->calibrating)
+				{
+					// Only the delivery is measured.
+				}
+				else if (s_config.print)
+				{
+					printf("Not displayable\n");
+				}
+			}
+			if (lease != NULL)
+			{
+				FrameLease_Release( lease);
+				ReclaimLeases( displayContext);
+			}
+			else if (displayContext->config->syncCycling && (img != NULL))
+			{
+				// Release the buffer back to the image transfer process.
+				s_acq->ReleaseImage( displayContext->camHandle, img);
+			}
+		}
+
+		// The later stages finish the frames they have, then stop.
+		StopPipelineThreads( displayContext, displayContext->numWorkers, &publishTid);
+		ReleaseDrainedBuffers( displayContext);
+	}
+	pthread_exit(0);	
+}
+
+// Let go of the conversion buffers.
+static void FreeConvertBuffers( MY_CONTEXT *context)
+{
+	int i;
+	int j;
+
+	for (i = 0; i < context->numWorkers; i++)
+	{
+		CONVERT_WORKER *worker = &context->workers[i];
+
+		for (j = 0; j < worker->numBuffers; j++)
+		{
+			BufferAlloc_Free(worker->buffers[j]);
+			worker->buffers[j] = NULL;
+		}
+		worker->numBuffers = 0;
+	}
+}
+
+// Let go of the frame pipeline (rings, frames and conversion buffers) of a stopped camera.
+static void FreePipeline( MY_CONTEXT *context)
+{
+	int i;
+
+	FreeConvertBuffers( context);
+	for (i = 0; i < context->numWorkers; i++)
+	{
+		SpscRing_Destroy( &context->workers[i].input);
+		SpscRing_Destroy( &context->workers[i].output);
+	}
+	context->numWorkers = 0;
+	free(context->jobs);
+	context->jobs = NULL;
+}
+
+// Set up the frame pipeline of a camera : the rings to and from its conversion threads, and the
+// frame handles (all the rings full, one frame in each thread, and the one being taken).
+static GEV_STATUS CreatePipeline( MY_CONTEXT *context)
+{
+	SPSC_RING_POLICY overflow = (SPSC_RING_POLICY)SpscRing_ParsePolicy( s_config.stageOverflow);
+	// (The frames waiting to be published are shared out between the conversion threads).
+	uint32_t outputDepth = (s_config.stageDepth + s_config.convertThreads - 1) / s_config.convertThreads;
+	int i;
+
+	context->numWorkers = s_config.convertThreads;
+	context->numJobs = 2;
+	for (i = 0; i < context->numWorkers; i++)
+	{
+		CONVERT_WORKER *worker = &context->workers[i];
+
+		worker->context = context;
+		worker->index = i;
+		if ((SpscRing_Create( &worker->input, s_config.stageDepth, overflow) != 0) ||
+			 (SpscRing_Create( &worker->output, outputDepth, SPSC_RING_BLOCK) != 0))
+		{
+			FreePipeline( context);
+			return GEVLIB_ERROR_INSUFFICIENT_MEMORY;
+		}
+		context->numJobs += worker->input.size + worker->output.size + 2;
+	}
+	context->jobs = (FRAME_JOB *)calloc( context->numJobs, sizeof(FRAME_JOB));
+	if (context->jobs == NULL)
+	{
+		FreePipeline( context);
+		return GEVLIB_ERROR_INSUFFICIENT_MEMORY;
+	}
+	return 0;
+}
+
+// Translate the raw pixel format to one suitable for the (limited) Linux display routines
+// and set up the conversion (and the buffers of each conversion thread - one per frame its ring to the
+// publication thread holds, plus the one being sent and the one being converted) for images of up to width x height.
+// This works best for monochrome and RGB. The packed color formats (with Y, U, V, etc..) require 
+// conversion as do, if desired, Bayer formats.
+// (Packed pixels are unpacked internally unless passthru mode is enabled).
+static GEV_STATUS SetupConversion( MY_CONTEXT *context, UINT32 format, UINT32 width, UINT32 height, UINT32 *pPixFormat, UINT32 *pPixDepth)
+{
+	GEV_STATUS status = 0;
+	UINT32 convertedGevFormat = 0;
+	UINT32 pixFormat = 0;
+	UINT32 pixDepth = 0;
+	int i;
+
+	FreeConvertBuffers( context);
+
+	status = GetX11DisplayablePixelFormat( ENABLE_BAYER_CONVERSION, format, &convertedGevFormat, &pixFormat);
+
+	if (format != convertedGevFormat) 
+	{
+		// We MAY need to convert the data on the fly to display it.
+		if (GevIsPixelTypeRGB(convertedGevFormat))
+		{
+			// Conversion to RGB888 required.
+			pixDepth = 32;	// Assume 4 8bit components for color display (RGBA)
+			context->format = Convert_SaperaFormat_To_X11( pixFormat);
+			context->depth = pixDepth;
+			for (i = 0; i < context->numWorkers; i++)
+			{
+				CONVERT_WORKER *worker = &context->workers[i];
+
+				for (worker->numBuffers = 0; worker->numBuffers < (int)(worker->output.size + 2); worker->numBuffers++)
+				{
+					worker->buffers[worker->numBuffers] = BufferAlloc_Get( (width * height * ((pixDepth + 7)/8)), &context->alloc);
+				}
+				BufferAlloc_Commit( worker->buffers, worker->numBuffers, (width * height * ((pixDepth + 7)/8)), &context->alloc);
+			}
+			context->convertFormat = TRUE;
+			// (The X11 RGB8888 format is BGRA in memory - blue is in byte 0).
+			context->outputFormat = fmtBGRA8Packed;
+		}
+		else
+		{
+			// Converted format is MONO - generally this is handled
+			// internally (unpacking etc...) unless in passthru mode.
+			// (						
+			pixDepth = GevGetPixelDepthInBits(convertedGevFormat);
+			context->format = Convert_SaperaFormat_To_X11( pixFormat);
+			context->depth = pixDepth;							
+			context->convertFormat = FALSE;
+			context->outputFormat = convertedGevFormat;
+		}
+	}
+	else
+	{
+		pixDepth = GevGetPixelDepthInBits(convertedGevFormat);
+		context->format = Convert_SaperaFormat_To_X11( pixFormat);
+		context->depth = pixDepth;
+		context->convertFormat = FALSE;
+		context->outputFormat = convertedGevFormat;
+	}
+
+	*pPixFormat = pixFormat;
+	*pPixDepth = pixDepth;
+	return status;
+}
+
+// Periodic timer (statistics, reconnection attempts) (-1 if it can't be created).
+static int CreatePeriodicTimer( unsigned long intervalMs)
+{
+	struct itimerspec period = {0};
+	int fd = timerfd_create( CLOCK_MONOTONIC, TFD_CLOEXEC);
+
+	if (fd >= 0)
+	{
+		period.it_interval.tv_sec = intervalMs / 1000;
+		period.it_interval.tv_nsec = (intervalMs % 1000) * 1000000;
+		period.it_value = period.it_interval;
+		if (timerfd_settime( fd, 0, &period, NULL) != 0)
+		{
+			close(fd);
+			fd = -1;
+		}
+	}
+	return fd;
+}
+
+// Traffic through the pipeline of a camera since "prev" (NULL = since it started) - "now" is filled in : the rings
+// to and from each conversion thread, how busy each was, and the converted frames waiting for their turn.
+static void PrintPipeline( MY_CONTEXT *context, PIPELINE_STATS *now, const PIPELINE_STATS *prev)
+{
+	uint64_t nsElapsed = 0;
+	uint64_t published = 0;
+	char label[64];
+	int i;
+
+	memset(now, 0, sizeof(PIPELINE_STATS));
+	now->nsTaken = ClockSync_Now();
+	for (i = 0; i < context->numWorkers; i++)
+	{
+		CONVERT_WORKER *worker = &context->workers[i];
+
+		SpscRing_GetStats( &worker->input, &now->input[i]);
+		SpscRing_GetStats( &worker->output, &now->output[i]);
+		now->frames[i] = __atomic_load_n(&worker->frames, __ATOMIC_RELAXED);
+		now->nsBusy[i] = __atomic_load_n(&worker->nsBusy, __ATOMIC_RELAXED);
+	}
+	now->published = __atomic_load_n(&context->published, __ATOMIC_RELAXED);
+	now->reorderTotal = __atomic_load_n(&context->reorderTotal, __ATOMIC_RELAXED);
+	now->reorderMax = __atomic_load_n(&context->reorderMax, __ATOMIC_RELAXED);
+	if ((context->numWorkers == 0) || (context->pipelineStartNs == 0))
+	{
+		return;
+	}
+
+	nsElapsed = now->nsTaken - ((prev != NULL) ? prev->nsTaken : context->pipelineStartNs);
+	for (i = 0; i < context->numWorkers; i++)
+	{
+		snprintf(label, sizeof(label), "camera %d acquisition -> conversion %d", context->channel, i);
+		SpscRing_PrintStats( &context->workers[i].input, &now->input[i], (prev != NULL) ? &prev->input[i] : NULL, label);
+		snprintf(label, sizeof(label), "camera %d conversion %d -> publication", context->channel, i);
+		SpscRing_PrintStats( &context->workers[i].output, &now->output[i], (prev != NULL) ? &prev->output[i] : NULL, label);
+	}
+	fprintf(stderr, "camera %d conversion threads (%% busy, frames) :", context->channel);
+	for (i = 0; i < context->numWorkers; i++)
+	{
+		uint64_t nsBusy = now->nsBusy[i] - ((prev != NULL) ? prev->nsBusy[i] : 0);
+
+		fprintf(stderr, "%s %.1f%% %llu", (i > 0) ? "," : "", (nsElapsed > 0) ? (100.0 * (double)nsBusy / (double)nsElapsed) : 0.0,
+					(unsigned long long)(now->frames[i] - ((prev != NULL) ? prev->frames[i] : 0)));
+	}
+	published = now->published - ((prev != NULL) ? prev->published : 0);
+	fprintf(stderr, " - waiting for their turn %.2f mean / %u max\n",
+				(published > 0) ? (double)(now->reorderTotal - ((prev != NULL) ? prev->reorderTotal : 0)) / (double)published : 0.0, now->reorderMax);
+}
+
+// Frame rate, latencies, pipeline and output counters of a camera since the last report (the shared stdout is reported apart).
+static void PrintStats( MY_CONTEXT *context, ACQ_STATS_SNAPSHOT *lastStats, LATENCY_SNAPSHOT *lastLatency, PIPELINE_STATS *lastPipeline)
+{
+	ACQ_STATS_SNAPSHOT stats;
+	LATENCY_SNAPSHOT latency;
+	PIPELINE_STATS pipeline;
+	char label[32];
+
+	AcqStats_Read( &context->stats, &stats);
+	snprintf(label, sizeof(label), "camera %d", context->channel);
+	AcqStats_Print( &stats, (lastStats->nsTaken != 0) ? lastStats : NULL, label);
+	LatencyStats_Read( &context->latency, &latency);
+	LatencyStats_Print( &latency, lastLatency, label);
+	if (context->clock.tickFrequency != 0)
+	{
+		CLOCK_SYNC_MODEL model;
+
+		ClockSync_Read( &context->clock, &model);
+		ClockSync_Print( &model, label);
+	}
+	PrintPipeline( context, &pipeline, (lastPipeline->nsTaken != 0) ? lastPipeline : NULL);
+	*lastStats = stats;
+	*lastLatency = latency;
+	*lastPipeline = pipeline;
+	if (context->memfdServer != NULL)
+	{
+		FrameMemfd_PrintStats( context->memfdServer, context->memfdServer->path);
+	}
+	else if (context->frameServer != NULL)
+	{
+		FrameServer_PrintStats( context->frameServer, context->frameServer->path);
+	}
+	else if (context->outputQueue != NULL)
+	{
+		FrameQueue_PrintStats( context->outputQueue, "stdout queue");
+	}
+	if (context->leases != NULL)
+	{
+		FrameLease_PrintStats( context->leases, "buffer leases");
+	}
+}
+
+int IsTurboDriveAvailable(GEV_CAMERA_HANDLE handle)
+{
+	int type;
+	UINT32 val = 0;
+	
+	if ( 0 == s_acq->GetFeatureValue( handle, "transferTurboCurrentlyAbailable",  &type, sizeof(UINT32), &val) )
+	{
+		// Current / Standard method present - this feature indicates if TurboMode is available.
+		// (Yes - it is spelled that odd way on purpose).
+		return (val != 0);
+	}
+	else
+	{
+		// Legacy mode check - standard feature is not there try it manually.
+		char pxlfmt_str[64] = {0};
+
+		// Mandatory feature (always present).
+		s_acq->GetFeatureValueAsString( handle, "PixelFormat", &type, sizeof(pxlfmt_str), pxlfmt_str);
+
+		// Set the "turbo" capability selector for this format.
+		if ( 0 != s_acq->SetFeatureValueAsString( handle, "transferTurboCapabilitySelector", pxlfmt_str) )
+		{
+			// Either the capability selector is not present or the pixel format is not part of the 
+			// capability set.
+			// Either way - TurboMode is NOT AVAILABLE.....
+			return 0; 
+		}
+		else
+		{
+			// The capabilty set exists so TurboMode is AVAILABLE.
+			// It is up to the camera to send TurboMode data if it can - so we let it.
+			return 1;
+		}
+	}
+	return 0;
+}
+
+// Bits per pixel of the frames sent to the outputs for a camera pixel format (after any conversion).
+static UINT32 OutputPixelDepth( UINT32 format)
+{
+	UINT32 convertedGevFormat = 0;
+	UINT32 pixFormat = 0;
+
+	GetX11DisplayablePixelFormat( ENABLE_BAYER_CONVERSION, format, &convertedGevFormat, &pixFormat);
+	if ((format != convertedGevFormat) && GevIsPixelTypeRGB(convertedGevFormat))
+	{
+		return 32;
+	}
+	return GevGetPixelDepthInBits(convertedGevFormat);
+}
+
+// Bytes each output can take per frame (0 = no limit).
+static UINT64 OutputCapacity( MY_CONTEXT *context)
+{
+	if (context->shmRing != NULL)
+	{
+		return context->shmRing->hdr->slot_size - sizeof(FRAME_HEADER);
+	}
+	if ((context->memfdServer != NULL) && (context->memfdSlot < context->memfdServer->numBuffers))
+	{
+		return context->memfdServer->buffers[context->memfdSlot].size;
+	}
+	if (context->outputQueue != NULL)
+	{
+		return context->outputQueue->entrySize - sizeof(FRAME_HEADER);
+	}
+	return 0;
+}
+
+// Set up the transfer for the current camera settings : the image buffers are reallocated if they are
+// too small now (not possible when they are shared with memfd), the conversion is set up again and the
+// frames are checked against what the output can take. A short reason is left in "reply" on failure 
+// (the image geometry on success).
+static GEV_STATUS SetupTransfer( MY_CONTEXT *context, PUINT8 *bufAddress, int numBuffers, UINT64 *pSize, char *reply, size_t replySize)
+{
+	GEV_CAMERA_HANDLE handle = context->camHandle;
+	GEV_STATUS status = 0;
+	UINT32 width = 0;
+	UINT32 height = 0;
+	UINT32 format = 0;
+	UINT32 pixFormat = 0;
+	UINT32 pixDepth = 0;
+	UINT64 payload_size = 0;
+	UINT64 size = 0;
+	UINT64 outputSize = 0;
+	UINT64 capacity = OutputCapacity( context);
+	int type = 0;
+	int i;
+
+	status = s_acq->GetImageGeometry( handle, &width, &height, &payload_size, &format);
+	if (status != 0)
+	{
+		snprintf(reply, replySize, "cannot read the image geometry");
+		return status;
+	}
+
+	size = GetPixelSizeInBytes(format) * width * height;
+	size = (payload_size > size) ? payload_size : size;
+	outputSize = width * height * ((OutputPixelDepth(format) + 7)/8);
+	outputSize = (size > outputSize) ? size : outputSize;
+	if ((capacity > 0) && (outputSize > capacity))
+	{
+		snprintf(reply, replySize, "%llu byte frames do not fit the output (%llu bytes)", 
+					(unsigned long long)outputSize, (unsigned long long)capacity);
+		return GEVLIB_ERROR_INSUFFICIENT_MEMORY;
+	}
+	if (size > *pSize)
+	{
+		PUINT8 newAddress[APP_CONFIG_MAX_BUFFERS] = {0};
+
+		if (context->memfdServer != NULL)
+		{
+			// The consumers have mapped the buffers already.
+			snprintf(reply, replySize, "shared image buffers are too small (%llu bytes)", (unsigned long long)*pSize);
+			return GEVLIB_ERROR_INSUFFICIENT_MEMORY;
+		}
+		// Get all the new buffers before letting go of the old ones (so a failure changes nothing).
+		for (i = 0; i < numBuffers; i++)
+		{
+			newAddress[i] = (PUINT8)BufferAlloc_Get( size, &context->alloc);
+			if (newAddress[i] == NULL)
+			{
+				while (i-- > 0)
+				{
+					BufferAlloc_Free(newAddress[i]);
+				}
+				snprintf(reply, replySize, "cannot allocate %llu byte buffers", (unsigned long long)size);
+				return GEVLIB_ERROR_INSUFFICIENT_MEMORY;
+			}
+		}
+		BufferAlloc_Commit( (void **)newAddress, numBuffers, size, &context->alloc);
+		for (i = 0; i < numBuffers; i++)
+		{
+			BufferAlloc_Free(bufAddress[i]);
+			bufAddress[i] = newAddress[i];
+		}
+		*pSize = size;
+	}
+
+	status = SetupConversion( context, format, width, height, &pixFormat, &pixDepth);
+	if (s_config.display)
+	{
+		DestroyDisplayWindow(context->View);
+		context->View = CreateDisplayWindow("GigE-V GenApi Console Demo", TRUE, height, width, pixDepth, pixFormat, FALSE ); 
+		PlaceDisplayThreads( context);
+	}
+
+	status = s_acq->InitializeTransfer( handle, context->config->syncCycling ? SynchronousNextEmpty : Asynchronous, *pSize, numBuffers, bufAddress);
+	if (status != 0)
+	{
+		snprintf(reply, replySize, "cannot initialize the transfer");
+	}
+	else if (replySize > 0)
+	{
+		char formatName[64] = {0};
+		s_acq->GetFeatureValueAsString( handle, "PixelFormat", &type, sizeof(formatName), formatName);
+		snprintf(reply, replySize, "%ux%u %s", width, height, formatName);
+	}
+	return status;
+}
+
+#if COMMAND_INPUT
+// Apply a change that needs the transfer stopped (a transfer feature written, or a restart).
+// The acquisition thread is stopped, the transfer is set up again for the new settings and restarted. 
+// If that does not work the old value is put back (and the transfer set up for it again).
+static GEV_STATUS ChangeTransfer( MY_CONTEXT *context, pthread_t *tid, const COMMAND *cmd, PUINT8 *bufAddress, int numBuffers, UINT64 *pSize, char *reply, size_t replySize)
+{
+	GEV_CAMERA_HANDLE handle = context->camHandle;
+	GEV_STATUS status = 0;
+	char oldValue[COMMAND_MAX_VALUE] = {0};
+	unsigned long start = ms_timer_init();
+	int type = 0;
+
+	// Stop the acquisition thread and give the consumers a moment to hand back the buffers they hold.
+	context->exit = TRUE;
+	if (*tid != 0)
+	{
+		pthread_join( *tid, NULL);
+		*tid = 0;
+	}
+	ReleaseDrainedBuffers( context);
+	while ( (HeldBufferCount( context) > 0) && !ms_timer_interval_elapsed( start, 1000) )
+	{
+		usleep(1000);
+		ReleaseDrainedBuffers( context);
+	}
+
+	if (HeldBufferCount( context) > 0)
+	{
+		// (The buffers can't be pulled from under a consumer - leave the transfer alone).
+		snprintf(reply, replySize, "image buffers still held by a consumer");
+		status = GEVLIB_ERROR_TIME_OUT;
+	}
+	else
+	{
+		s_acq->AbortTransfer(handle);
+		s_acq->FreeTransfer(handle);
+
+		if (cmd->verb == COMMAND_SET)
+		{
+			s_acq->GetFeatureValueAsString( handle, cmd->name, &type, sizeof(oldValue), oldValue);
+			status = s_acq->SetFeatureValueAsString( handle, cmd->name, cmd->value);
+			if (status != 0)
+			{
+				snprintf(reply, replySize, "cannot write the feature");
+			}
+		}
+		if (status == 0)
+		{
+			status = SetupTransfer( context, bufAddress, numBuffers, pSize, reply, replySize);
+		}
+		if (status != 0)
+		{
+			// Back to the settings that worked (keeping the reason in the reply).
+			if ((cmd->verb == COMMAND_SET) && (oldValue[0] != '\0'))
+			{
+				s_acq->SetFeatureValueAsString( handle, cmd->name, oldValue);
+			}
+			SetupTransfer( context, bufAddress, numBuffers, pSize, NULL, 0);
+		}
+	}
+
+	// Start streaming again.
+	context->exit = FALSE;
+	if (pthread_create( tid, NULL, ImageDisplayThread, context) != 0)
+	{
+		*tid = 0;
+		snprintf(reply, replySize, "cannot start the acquisition thread");
+		return GEVLIB_ERROR_SOFTWARE;
+	}
+	s_acq->StartTransfer( handle, -1);
+
+	if ((status == 0) && (cmd->verb == COMMAND_SET))
+	{
+		// Report the value the camera actually took.
+		s_acq->GetFeatureValueAsString( handle, cmd->name, &type, replySize, reply);
+	}
+	return status;
+}
+
+// Features that change the image size / format - the transfer is set up again when they are written.
+static const char *s_transferFeatures[] = 
+{
+	"Width", "Height", "OffsetX", "OffsetY", "PixelFormat", 
+	"BinningHorizontal", "BinningVertical", "DecimationHorizontal", "DecimationVertical",
+	"transferTurboMode"
+};
+
+static int IsTransferFeature( const char *name)
+{
+	UINT32 i;
+
+	for (i = 0; i < (sizeof(s_transferFeatures) / sizeof(s_transferFeatures[0])); i++)
+	{
+		if (strcmp(name, s_transferFeatures[i]) == 0)
+		{
+			return TRUE;
+		}
+	}
+	return FALSE;
+}
+
+// Hand a transfer change to the main thread and wait for it to be applied.
+static GEV_STATUS RequestTransferChange( MY_CONTROL *control, MY_CAMERA *cam, const COMMAND *cmd, char *reply, size_t replySize)
+{
+	GEV_STATUS status = 0;
+
+	pthread_mutex_lock(&control->lock);
+	if (control->shutdown)
+	{
+		pthread_mutex_unlock(&control->lock);
+		snprintf(reply, replySize, "shutting down");
+		return GEVLIB_ERROR_SOFTWARE;
+	}
+	control->request = cmd;
+	control->target = cam;
+	control->reply[0] = '\0';
+	if (eventfd_write( control->wakeFd, 1) != 0)
+	{
+		control->request = NULL;
+		pthread_mutex_unlock(&control->lock);
+		snprintf(reply, replySize, "main loop not reachable");
+		return GEVLIB_ERROR_SOFTWARE;
+	}
+	while (control->request != NULL)
+	{
+		pthread_cond_wait(&control->cond, &control->lock);
+	}
+	status = control->status;
+	snprintf(reply, replySize, "%s", control->reply);
+	pthread_mutex_unlock(&control->lock);
+	return status;
+}
+
+// Read commands from the command channel and acknowledge each of them.
+// Features are read / written from here directly, except those that change the image
+// size or format : those are handed to the main thread (which owns the transfer).
+void * CommandThread( void *arg)
+{
+	MY_CONTROL *control = (MY_CONTROL *)arg;
+	COMMAND cmd;
+	int status = 0;
+
+	while (((status = CommandChannel_Read( &control->channel, &cmd)) != COMMAND_ERROR_EOF) && (status != COMMAND_ERROR_SHUTDOWN))
+	{
+		char value[COMMAND_MAX_VALUE] = {0};
+		MY_CAMERA *cam = NULL;
+		int type = 0;
+
+		if (status == COMMAND_ERROR_TOO_LONG)
+		{
+			CommandChannel_Reply( &control->channel, &cmd, status, "line too long");
+			continue;
+		}
+		if (status != 0)
+		{
+			CommandChannel_Reply( &control->channel, &cmd, status, "expected [cam<N>] get|set|exec|restart|ping");
+			continue;
+		}
+		if (cmd.camera >= control->numCameras)
+		{
+			CommandChannel_Reply( &control->channel, &cmd, GEVLIB_ERROR_INVALID_HANDLE, "no such camera");
+			continue;
+		}
+		// Commands without "cam<N>" are for the first camera.
+		cam = &control->cameras[(cmd.camera > 0) ? cmd.camera : 0];
+		if (cam->context.lost)
+		{
+			CommandChannel_Reply( &control->channel, &cmd, GEVLIB_ERROR_INVALID_HANDLE, "camera lost - reconnecting");
+			continue;
+		}
+		if (cam->handle == NULL)
+		{
+			CommandChannel_Reply( &control->channel, &cmd, GEVLIB_ERROR_INVALID_HANDLE, "no such camera");
+			continue;
+		}
+		switch (cmd.verb)
+		{
+			case COMMAND_GET:
+				status = s_acq->GetFeatureValueAsString( cam->handle, cmd.name, &type, sizeof(value), value);
+				break;
+			case COMMAND_SET:
+				if (IsTransferFeature( cmd.name))
+				{
+					status = RequestTransferChange( control, cam, &cmd, value, sizeof(value));
+				}
+				else
+				{
+					status = s_acq->SetFeatureValueAsString( cam->handle, cmd.name, cmd.value);
+					if (status == 0)
+					{
+						// Report the value the camera actually took.
+						s_acq->GetFeatureValueAsString( cam->handle, cmd.name, &type, sizeof(value), value);
+					}
+				}
+				break;
+			case COMMAND_EXEC:
+				status = s_acq->ExecuteCommand( cam->handle, cmd.name);
+				break;
+			case COMMAND_RESTART:
+				status = RequestTransferChange( control, cam, &cmd, value, sizeof(value));
+				break;
+			default:
+				break;
+		}
+		if ((status != 0) && (value[0] == '\0'))
+		{
+			snprintf(value, sizeof(value), "feature access failed");
+		}
+		CommandChannel_Reply( &control->channel, &cmd, status, value);
+	}
+	pthread_exit(0);
+}
+#endif
+
+// Name of an output of camera "channel" : the first camera uses the base name as is, the others get
+// ".<channel>" inserted before the extension (eg. /tmp/genicam_frames.sock -> /tmp/genicam_frames.1.sock).
+static void ChannelName( char *name, size_t size, const char *base, int channel)
+{
+	const char *dot = strrchr(base, '.');
+	const char *slash = strrchr(base, '/');
+
+	if (channel == 0)
+	{
+		snprintf(name, size, "%s", base);
+	}
+	else if ((dot != NULL) && ((slash == NULL) || (dot > slash)))
+	{
+		snprintf(name, size, "%.*s.%d%s", (int)(dot - base), base, channel, dot);
+	}
+	else
+	{
+		snprintf(name, size, "%s.%d", base, channel);
+	}
+}
+
+// Tell (on stderr) about the stream settings the library or the camera did not take as asked
+// and keep the ones in effect in the camera's settings.
+static void CheckStreamSettings( MY_CAMERA *cam)
+{
+	GEV_CAMERA_OPTIONS applied = {0};
+	UINT32 packetSize = 0;
+	int type = 0;
+	int i;
+
+	s_acq->GetCameraInterfaceOptions( cam->handle, &applied);
+	{
+		struct { const char *name; UINT32 *value; UINT32 applied; } checks[] =
+		{
+			{ "heartbeat-timeout", &cam->config.heartbeatTimeoutMs, applied.heartbeat_timeout_ms },
+			{ "frame-timeout", &cam->config.frameTimeoutMs, applied.streamFrame_timeout_ms },
+			{ "frames-buffered", &cam->config.framesBuffered, applied.streamNumFramesBuffered },
+			{ "memory-limit", &cam->config.memoryLimit, applied.streamMemoryLimitMax },
+			{ "packet-size", &cam->config.packetSize, applied.streamPktSize },
+			{ "packet-delay", &cam->config.packetDelay, applied.streamPktDelay }
+		};
+		// (Only the heartbeat is set without tune-streaming).
+		int numChecks = cam->config.tuneStreaming ? (int)(sizeof(checks) / sizeof(checks[0])) : 1;
+
+		for (i = 0; i < numChecks; i++)
+		{
+			if (*checks[i].value != checks[i].applied)
+			{
+				fprintf(stderr, "camera %d : %s %u not taken - using %u\n", cam->context.channel, checks[i].name, *checks[i].value, checks[i].applied);
+				*checks[i].value = checks[i].applied;
+			}
+		}
+	}
+
+	// The camera has the last word on the packet size (it is negotiated when the transfer is set up).
+	if (cam->config.tuneStreaming && (s_acq->GetFeatureValue( cam->handle, "GevSCPSPacketSize", &type, sizeof(UINT32), &packetSize) == 0)
+		&& (packetSize != cam->config.packetSize))
+	{
+		fprintf(stderr, "camera %d : packet-size %u not taken by the camera - using %u\n", cam->context.channel, cam->config.packetSize, packetSize);
+		cam->config.packetSize = packetSize;
+	}
+}
+
+// CPUs of a camera's GEV stream thread and of the GEV server threads (-1 = single CPU, not pinned).
+// Each camera's stream thread gets a core of its own (counting down from the last one)
+// and the server threads (light load) of all the cameras share the next one down.
+static void StreamThreadCpus( int channel, int numStreams, int *streamCpu, int *serverCpu)
+{
+	int numCpus = _GetNumCpus();
+
+	*streamCpu = -1;
+	*serverCpu = -1;
+	if (numCpus > 1)
+	{
+		*streamCpu = numCpus - 1 - (channel % numCpus);
+		*serverCpu = numCpus - 1 - (numStreams % numCpus);
+	}
+}
+
+// Set the interface options of an opened camera : the heartbeat (disconnect detection) and, with
+// tune-streaming, the stream settings and the stream / server thread affinities.
+static void SetInterfaceOptions( MY_CAMERA *cam, int numStreams)
+{
+	GEV_CAMERA_HANDLE handle = cam->handle;
+	int channel = cam->context.channel;
+	GEV_CAMERA_OPTIONS camOptions = {0};
+
+	// Adjust the camera interface options if desired (see the manual)
+	s_acq->GetCameraInterfaceOptions( handle, &camOptions);
+	//camOptions.heartbeat_timeout_ms = 60000;		// For debugging (delay camera timeout while in debugger)
+	camOptions.heartbeat_timeout_ms = cam->config.heartbeatTimeoutMs;		// Disconnect detection
+
+	if (cam->config.tuneStreaming)
+	{
+		// Some tuning can be done here. (see the manual)
+		camOptions.streamFrame_timeout_ms = cam->config.frameTimeoutMs;		// Internal timeout for frame reception.
+		camOptions.streamNumFramesBuffered = cam->config.framesBuffered;		// Buffer frames internally.
+		camOptions.streamMemoryLimitMax = cam->config.memoryLimit;			// Adjust packet memory buffering limit.
+		camOptions.streamPktSize = cam->config.packetSize;						// Adjust the GVSP packet size.
+		camOptions.streamPktDelay = cam->config.packetDelay;					// Add usecs between packets to pace arrival at NIC.
+
+		// Assign specific CPUs to threads (affinity) - if required for better performance.
+		{
+			int streamCpu = -1;
+			int serverCpu = -1;
+
+			StreamThreadCpus( channel, numStreams, &streamCpu, &serverCpu);
+			if (streamCpu >= 0)
+			{
+				camOptions.streamThreadAffinity = streamCpu;
+				camOptions.serverThreadAffinity = serverCpu;
+			}
+		}
+	}
+	// Write the adjusted interface options back.
+	s_acq->SetCameraInterfaceOptions( handle, &camOptions);
+}
+
+// Free the first "count" image buffers of a camera (memfd buffers all go with the server, output buffers too).
+static void FreeImageBuffers( MY_CAMERA *cam, int count)
+{
+	MY_CONTEXT *context = &cam->context;
+	int i;
+
+	if (context->memfdServer != NULL)
+	{
+		FrameMemfd_Destroy(context->memfdServer);
+		context->memfdServer = NULL;
+	}
+	else
+	{
+		for (i = 0; i < count; i++)
+		{
+			BufferAlloc_Free(cam->bufAddress[i]);
+		}
+	}
+	for (i = 0; i < count; i++)
+	{
+		cam->bufAddress[i] = NULL;
+	}
+}
+
+// Open a camera and set up its transfer and output (everything but starting it).
+// "channel" is the position of the camera on the command line : it is sent in the frame header,
+// names the camera's own outputs and spreads the streaming threads of the cameras over the cores.
+static GEV_STATUS OpenCamera( MY_CAMERA *cam, GEV_DEVICE_INTERFACE *device, int channel, int numStreams, PIPE_SPLICE *pipeOut, pthread_mutex_t *pipeLock)
+{
+	MY_CONTEXT *context = &cam->context;
+	GEV_STATUS status = 0;
+	GEV_CAMERA_HANDLE handle = NULL;
+	int i;
+	UINT32 height = 0;
+	UINT32 width = 0;
+	UINT32 format = 0;
+	UINT32 maxHeight = 1600;
+	UINT32 maxWidth = 2048;
+	UINT32 maxDepth = 2;
+	UINT64 size;
+	UINT64 payload_size;
+	UINT32 pixFormat = 0;
+	UINT32 pixDepth = 0;
+	uint32_t macLow = 0; // Low 32-bits of the mac address (for file naming).
+	char name[128];		// Name of the camera's own output.
+
+	memset(cam, 0, sizeof(MY_CAMERA));
+	AppConfig_GetCamera( &s_config, channel, &cam->config);
+	cam->numBuffers = cam->config.numBuffers;
+	context->config = &cam->config;
+	context->channel = channel;
+	context->lostFd = -1;
+	cam->device = *device;
+	AcqStats_Init( &context->stats);
+	LatencyStats_Init( &context->latency);
+	context->pipeOut = pipeOut;
+	context->pipeLock = pipeLock;
+	pthread_mutex_init(&context->memfdLock, NULL);
+
+	status = CreatePipeline( context);
+	if (status != 0)
+	{
+		return status;
+	}
+
+	//====================================================================
+	// Open the camera.
+	status = s_acq->OpenCamera( device, GevExclusiveMode, &handle);
+	// Get the low part of the MAC address (use it as part of a unique file name for saving images).
+	// Generate a unique base name to be used for saving image files
+	// based on the last 3 octets of the MAC address.
+	macLow = device->macLow;
+	macLow &= 0x00FFFFFF;
+	snprintf(cam->uniqueName, sizeof(cam->uniqueName), "img_%06x", macLow);
+	if ( status != 0 )
+	{
+		if (s_config.print)
+		{
+			printf("Error : 0x%0x : opening camera %d\n", status, channel);
+		}
+		return status;
+	}
+	cam->handle = handle;
+	context->camHandle = handle;
+
+#if (OUTPUT_TRANSPORT == OUTPUT_TRANSPORT_MEMFD)
+	if (cam->config.syncCycling && ((FRAME_MEMFD_CLIENTS * FRAME_MEMFD_HOLD) >= (cam->numBuffers - 1)))
+	{
+		// The consumers could hold every buffer the transfer has.
+		fprintf(stderr, "camera %d : %d buffers are too few for %d memfd consumers holding %d each\n", 
+					channel, cam->numBuffers, FRAME_MEMFD_CLIENTS, FRAME_MEMFD_HOLD);
+		s_acq->CloseCamera(&cam->handle);
+		cam->handle = NULL;
+		return GEVLIB_ERROR_PARAMETER_INVALID;
+	}
+#endif
+	if (cam->config.syncCycling)
+	{
+		// Received buffers are leased to the consumers (one buffer is always left to the transfer).
+		FrameLease_Init( &cam->leasePool, cam->numBuffers - 1, (FRAME_LEASE_POLICY)FrameLease_ParsePolicy( s_config.leasePolicy));
+		context->leases = &cam->leasePool;
+	}
+
+	// Outputs are named after the channel.
+#if (OUTPUT_TRANSPORT == OUTPUT_TRANSPORT_SHM)
+	ChannelName( name, sizeof(name), SHM_RING_NAME, channel);
+#elif (OUTPUT_TRANSPORT == OUTPUT_TRANSPORT_SOCKET)
+	ChannelName( name, sizeof(name), FRAME_SERVER_PATH, channel);
+#elif (OUTPUT_TRANSPORT == OUTPUT_TRANSPORT_MEMFD)
+	ChannelName( name, sizeof(name), FRAME_MEMFD_PATH, channel);
+#else
+	snprintf(name, sizeof(name), "stdout");
+#endif
+
+	// Go on to adjust some API related settings (for tuning / diagnostics / etc....).
+	SetInterfaceOptions( cam, numStreams);
+
+	//=====================================================================
+	// Read the mandatory image features (Width, Height, PayloadSize, PixelFormat).
+	status = s_acq->GetImageGeometry( handle, &width, &height, &payload_size, &format);
+	if (status != 0)
+	{
+		s_acq->CloseCamera(&cam->handle);
+		cam->handle = NULL;
+		return status;
+	}
+
+	//=================================================================
+	// Set up a grab/transfer from this camera
+	//
+	if (s_config.print)
+	{
+		printf("Camera %d ROI set for \n\tHeight = %d\n\tWidth = %d\n\tPixelFormat (val) = 0x%08x\n", channel, height,width,format);
+	}
+
+	maxHeight = height;
+	maxWidth = width;
+	maxDepth = GetPixelSizeInBytes(format);
+
+	// Allocate image buffers
+	// (Either the image size or the payload_size, whichever is larger - allows for packed pixel formats).
+	// Buffers are page aligned so they can be handed to the output pipe by reference (vmsplice).
+	context->alloc.hugePages = cam->config.hugePages;
+	context->alloc.lock = cam->config.lockBuffers;
+	context->alloc.prefaultThreads = cam->config.prefaultThreads;
+	context->nicNode = BufferAlloc_NicNode( device->host.ipAddr);
+	context->alloc.numaNode = (cam->config.numaBind) ? context->nicNode : -1;
+	size = maxDepth * maxWidth * maxHeight;
+	size = (payload_size > size) ? payload_size : size;
+#if (OUTPUT_TRANSPORT == OUTPUT_TRANSPORT_MEMFD)
+	// Image buffers come from memfd regions that consumers can map.
+	status = FrameMemfd_Create( &cam->memfdServer, name, FRAME_MEMFD_CLIENTS, FRAME_MEMFD_HOLD);
+	if (status == 0)
+	{
+		context->memfdServer = &cam->memfdServer;
+	}
+	else
+	{
+		// Fall back to writing the frames to stdout.
+		if (s_config.print)
+		{
+			printf("Error %d creating buffer sharing socket %s - using stdout\n", status, name);
+		}
+		context->memfdServer = NULL;
+		status = 0;
+	}
+#endif
+	for (i = 0; i < cam->numBuffers; i++)
+	{
+		void *buf = NULL;
+		if (context->memfdServer != NULL)
+		{
+			if (FrameMemfd_AllocBuffer( context->memfdServer, size, &buf) < 0)
+			{
+				buf = NULL;
+			}
+		}
+		else
+		{
+			buf = BufferAlloc_Get( size, &context->alloc);
+		}
+		if (buf == NULL)
+		{
+			fprintf(stderr, "camera %d : cannot allocate image buffer %d (%llu bytes)\n", channel, i, (unsigned long long)size);
+			FreeImageBuffers( cam, i);
+			s_acq->CloseCamera(&cam->handle);
+			cam->handle = NULL;
+			return GEVLIB_ERROR_INSUFFICIENT_MEMORY;
+		}
+		cam->bufAddress[i] = (PUINT8)buf;
+	}
+	cam->size = size;
+	// Fault the pages in now (several threads at once) and lock them, not while the first frames come in.
+	if (BufferAlloc_Commit( (void **)cam->bufAddress, cam->numBuffers, size, &context->alloc) == BUFFERALLOC_ERROR_LOCK)
+	{
+		fprintf(stderr, "camera %d : image buffers not locked in memory (raise the RLIMIT_MEMLOCK limit - ulimit -l)\n", channel);
+	}
+	if (s_config.print)
+	{
+		BUFFER_ALLOC_INFO info = {0};
+		BufferAlloc_GetInfo( cam->bufAddress[0], &info);
+		printf("Camera %d : %d x %llu byte buffers, %s pages%s, node %d\n", channel, cam->numBuffers, (unsigned long long)size, 
+				(info.pageSize == BUFFER_ALLOC_HUGE_PAGE) ? "2 MB" : (info.transparentHuge ? "transparent huge" : "4 KB"),
+				info.locked ? ", locked" : "", info.numaNode);
+	}
+
+	// Initialize a transfer with synchronous or asynchronous buffer handling.
+	status = s_acq->InitializeTransfer( handle, cam->config.syncCycling ? SynchronousNextEmpty : Asynchronous, size, cam->numBuffers, cam->bufAddress);
+	CheckStreamSettings( cam);
+
+	// Record the frames received (not while calibrating).
+	if ((s_config.record[0] != '\0') && (s_config.calibrate == 0))
+	{
+		char path[APP_CONFIG_MAX_STRING + 16];
+		int result = 0;
+
+		ChannelName( path, sizeof(path), s_config.record, channel);
+		result = FrameRecord_Create( &cam->recorder, path, RECORD_QUEUE_DEPTH, size);
+		if (result == 0)
+		{
+			context->recorder = &cam->recorder;
+			PlaceThread( THREAD_ROLE_OUTPUT, cam->recorder.writer, context);
+		}
+		else
+		{
+			fprintf(stderr, "camera %d : error %d creating recording %s - not recording\n", channel, result, path);
+		}
+	}
+
+	// Set up the format conversion for display / output.
+	status = SetupConversion( context, format, maxWidth, maxHeight, &pixFormat, &pixDepth);
+
+#if (OUTPUT_TRANSPORT == OUTPUT_TRANSPORT_SHM)
+	// Create the shared memory ring (slots hold a frame header and either the raw or the converted image).
+	{
+		UINT64 slotSize = (maxWidth * maxHeight * ((pixDepth + 7)/8));
+		slotSize = (size > slotSize) ? size : slotSize;
+		slotSize += sizeof(FRAME_HEADER);
+		status = FrameShm_Create( &cam->shmRing, name, SHM_RING_SLOTS, slotSize);
+		if (status == 0)
+		{
+			context->shmRing = &cam->shmRing;
+		}
+		else
+		{
+			// Fall back to writing the frames to stdout.
+			if (s_config.print)
+			{
+				printf("Error %d creating shared memory ring %s - using stdout\n", status, name);
+			}
+			context->shmRing = NULL;
+			status = 0;
+		}
+	}
+#endif
+	if (context->memfdServer != NULL)
+	{
+		// Shared output buffers for converted frames (and copies of raw frames with asynchronous cycling).
+		UINT64 outputSize = (maxWidth * maxHeight * ((pixDepth + 7)/8));
+		void *buf = NULL;
+		outputSize = (size > outputSize) ? size : outputSize;
+		context->memfdSlot = context->memfdServer->numBuffers;
+		context->memfdSlots = 0;
+		while ((context->memfdSlots < FRAME_MEMFD_SLOTS) && (FrameMemfd_AllocBuffer( context->memfdServer, outputSize, &buf) >= 0))
+		{
+			context->memfdSlots++;
+		}
+		if (context->memfdSlots < FRAME_MEMFD_SLOTS)
+		{
+			// (Fewer frames can be held by the consumers at once - frames with no free buffer are not shared).
+			fprintf(stderr, "camera %d : %d of %d memfd output buffers allocated\n", channel, context->memfdSlots, FRAME_MEMFD_SLOTS);
+		}
+	}
+#if (OUTPUT_TRANSPORT == OUTPUT_TRANSPORT_SOCKET)
+	// Serve the frames to socket subscribers.
+	status = FrameServer_Create( &cam->frameServer, name, FRAME_SERVER_CLIENTS, FRAME_SERVER_QUEUE);
+	if (status == 0)
+	{
+		context->frameServer = &cam->frameServer;
+		PlaceThread( THREAD_ROLE_OUTPUT, cam->frameServer.thread, context);
+	}
+	else
+	{
+		// Fall back to writing the frames to stdout.
+		if (s_config.print)
+		{
+			printf("Error %d creating frame server socket %s - using stdout\n", status, name);
+		}
+		context->frameServer = NULL;
+		status = 0;
+	}
+#endif
+
+	if (s_config.display)
+	{
+		// Create a window to display the images in.
+		char title[128];
+		snprintf(title, sizeof(title), "GigE-V GenApi Console Demo - camera %d", channel);
+		context->View = CreateDisplayWindow(title, TRUE, height, width, pixDepth, pixFormat, FALSE );
+		PlaceDisplayThreads( context);
+	}
+
+	// Backpressure policy for stdout.
+	if ((context->shmRing == NULL) && (context->frameServer == NULL) && (context->memfdServer == NULL))
+	{
+		const char *policyName = s_config.backpressure;
+		int policy = FrameQueue_ParsePolicy( policyName);
+		if (policy >= 0)
+		{
+			UINT64 frameSize = (maxWidth * maxHeight * ((pixDepth + 7)/8));
+			frameSize = ((size > frameSize) ? size : frameSize) + sizeof(FRAME_HEADER);
+			if (FrameQueue_Create( &cam->outputQueue, OUTPUT_QUEUE_DEPTH, frameSize, (FRAME_QUEUE_POLICY)policy) == 0)
+			{
+				context->outputQueue = &cam->outputQueue;
+				if (pthread_create(&cam->writerTid, NULL, OutputWriterThread, context) != 0)
+				{
+					// (Written to stdout directly instead).
+					fprintf(stderr, "camera %d : cannot start the stdout writer thread\n", channel);
+					FrameQueue_Destroy( &cam->outputQueue);
+					context->outputQueue = NULL;
+				}
+			}
+		}
+		if (s_config.print)
+		{
+			if (context->outputQueue != NULL)
+			{
+				printf("Camera %d stdout backpressure policy : %s\n", channel, FrameQueue_PolicyName( context->outputQueue->policy));
+			}
+			else if (strcmp(policyName, "none") != 0)
+			{
+				printf("Backpressure policy \"%s\" not available - writing to stdout directly\n", policyName);
+			}
+		}
+	}
+	return 0;
+}
+
+// Latch the camera clock "samples" times against the host clock (main thread - the acquisition thread maps with the result).
+static void SyncCameraClock( MY_CAMERA *cam, int samples)
+{
+	MY_CONTEXT *context = &cam->context;
+	int type;
+	int i;
+
+	if ((cam->handle == NULL) || context->lost || (context->clock.tickFrequency == 0))
+	{
+		return;
+	}
+	for (i = 0; i < samples; i++)
+	{
+		UINT64 ticks = 0;
+		uint64_t before = ClockSync_Now();
+
+		if ((s_acq->ExecuteCommand( cam->handle, "GevTimestampControlLatch") != 0) ||
+			 (s_acq->GetFeatureValue( cam->handle, "GevTimestampValue", &type, sizeof(UINT64), &ticks) != 0))
+		{
+			break;
+		}
+		ClockSync_AddSample( &context->clock, before, ClockSync_Now(), ticks);
+	}
+}
+
+// Start the acquisition thread and the transfer of an opened camera.
+static void StartCamera( MY_CAMERA *cam)
+{
+	GEV_CAMERA_HANDLE handle = cam->handle;
+	GEV_STATUS status = 0;
+	int turboDriveAvailable = 0;
+	int type;
+
+	// Map its clock to the host before the first frame (it starts again after a reconnection).
+	// A camera without the timestamp features (or --clock-sync=0) sends frames with no exposure time.
+	{
+		UINT64 frequency = 0;
+
+		ClockSync_Init( &cam->context.clock, 0);
+		if ((s_config.clockSyncMs > 0) &&
+			 (s_acq->GetFeatureValue( handle, "GevTimestampTickFrequency", &type, sizeof(UINT64), &frequency) == 0) &&
+			 (ClockSync_Init( &cam->context.clock, frequency) == 0))
+		{
+			SyncCameraClock( cam, CLOCK_SYNC_START_SAMPLES);
+		}
+	}
+
+	// Create a thread to receive images from the API and display / output them.
+	cam->context.exit = FALSE;
+	if (pthread_create(&cam->tid, NULL, ImageDisplayThread, &cam->context) != 0)
+	{
+		cam->tid = 0;
+		fprintf(stderr, "camera %d : cannot start the acquisition thread\n", cam->context.channel);
+		return;
+	}
+
+	// Check if turboMode works
+	turboDriveAvailable = IsTurboDriveAvailable(handle);
+	if(turboDriveAvailable)
+	{
+		UINT32 val = cam->config.turboDrive;
+		s_acq->SetFeatureValue(handle, "transferTurboMode", sizeof(UINT32), &val);
+		s_acq->GetFeatureValue(handle, "transferTurboMode", &type, sizeof(UINT32), &val);
+
+		if (val != cam->config.turboDrive)
+		{
+			fprintf(stderr, "camera %d : TurboDrive could not be turned %s\n", cam->context.channel, cam->config.turboDrive ? "on" : "off");
+			cam->config.turboDrive = val;
+		}
+		if (s_config.print)
+		{
+			printf("TurboMode %s\n", (val == 1) ? "Enabled" : "Disabled");
+		}
+	}
+	else if (cam->config.turboDrive)
+	{
+		fprintf(stderr, "camera %d : TurboDrive is not available for this device / pixel format combination\n", cam->context.channel);
+	}
+	else if (s_config.print)
+	{
+		printf("*** TurboDrive is NOT Available for this device/pixel format combination ***\n");
+	}
+
+	// Stream images
+	status = s_acq->StartTransfer( handle, -1);
+	if (s_config.print && (status != 0))
+	{
+		printf("Error starting grab - 0x%x  or %d\n", status, status);
+	}
+}
+
+// Stop a camera and let go of its transfer, buffers and output.
+static void CloseCamera( MY_CAMERA *cam)
+{
+	MY_CONTEXT *context = &cam->context;
+
+	if ((cam->handle == NULL) && !context->lost)
+	{
+		// (Not opened, or not all the way).
+		FreePipeline( context);
+		pthread_mutex_destroy(&context->memfdLock);
+		return;
+	}
+
+	// Stop the display thread (and the stdout writer once the queue is drained).
+	context->exit = TRUE;
+	FrameQueue_Shutdown( context->outputQueue);
+	if (cam->tid != 0)
+	{
+		pthread_join( cam->tid, NULL);
+	}
+	if (context->outputQueue != NULL)
+	{
+		pthread_join( cam->writerTid, NULL);
+		if (s_config.print)
+		{
+			FrameQueue_PrintStats( context->outputQueue, "stdout queue");
+		}
+		FrameQueue_Destroy( context->outputQueue);
+		context->outputQueue = NULL;
+	}
+	if (s_config.print)
+	{
+		ACQ_STATS_SNAPSHOT stats;
+		char label[32];
+
+		AcqStats_Read( &context->stats, &stats);
+		snprintf(label, sizeof(label), "camera %d", context->channel);
+		AcqStats_Print( &stats, NULL, label);
+		{
+			LATENCY_SNAPSHOT latency;
+
+			LatencyStats_Read( &context->latency, &latency);
+			LatencyStats_Print( &latency, NULL, label);
+		}
+		{
+			PIPELINE_STATS pipeline;
+
+			PrintPipeline( context, &pipeline, NULL);
+		}
+		if (context->leases != NULL)
+		{
+			FrameLease_PrintStats( context->leases, "buffer leases");
+		}
+		if (cam->reconnects > 0)
+		{
+			fprintf(stderr, "%s : reconnected %u times\n", label, cam->reconnects);
+		}
+	}
+	if (context->recorder != NULL)
+	{
+		// (Writes the frames still queued).
+		FrameRecord_Destroy( context->recorder);
+		if (s_config.print)
+		{
+			FrameRecord_PrintStats( context->recorder, cam->recorder.path);
+		}
+		context->recorder = NULL;
+	}
+
+	// (A lost camera may be closed already).
+	if (cam->handle != NULL)
+	{
+		s_acq->AbortTransfer(cam->handle);
+		s_acq->FreeTransfer(cam->handle);
+	}
+
+	if (s_config.display)
+	{
+		DestroyDisplayWindow(context->View);
+	}
+
+	if ((context->memfdServer != NULL) && s_config.print)
+	{
+		FrameMemfd_PrintStats( context->memfdServer, cam->memfdServer.path);
+	}
+	FreeImageBuffers( cam, cam->numBuffers);
+	FreePipeline( context);
+	if (context->shmRing != NULL)
+	{
+		FrameShm_Destroy(context->shmRing);
+		context->shmRing = NULL;
+	}
+	if (context->frameServer != NULL)
+	{
+		if (s_config.print)
+		{
+			FrameServer_PrintStats( context->frameServer, cam->frameServer.path);
+		}
+		FrameServer_Destroy(context->frameServer);
+		context->frameServer = NULL;
+	}
+	if (cam->handle != NULL)
+	{
+		s_acq->CloseCamera(&cam->handle);
+	}
+	cam->handle = NULL;
+	context->camHandle = NULL;
+	context->lost = FALSE;
+	pthread_mutex_destroy(&context->memfdLock);
+}
+
+// !
+// ReconnectCameras
+//
+/*!
+	Bring back the cameras that were lost (from the main loop : as soon as one is lost, then every
+	reconnect interval while some are). A lost camera is closed once its consumers have handed back
+	the image buffers, then looked for on the network (by MAC address, else serial number). When it
+	is found it is opened again with the same settings, streams into the buffers it had and sends
+	to the same outputs - its first frame is flagged as a discontinuity.
+
+	\param numStreams  Cameras opened (spreads the thread affinities as when they were first opened).
+
+	\return Number of cameras still lost.
+*/
+static int ReconnectCameras( MY_CAMERA *cameras, int numStreams)
+{
+	static GEV_DEVICE_INTERFACE devices[MAX_CAMERAS];
+	int numDevices = -1;		// (Not looked for yet).
+	int numLost = 0;
+	int i;
+	int j;
+
+	for (i = 0; i < numStreams; i++)
+	{
+		MY_CAMERA *cam = &cameras[i];
+		MY_CONTEXT *context = &cam->context;
+		GEV_DEVICE_INTERFACE *device = NULL;
+		GEV_STATUS status = 0;
+		char reply[COMMAND_MAX_VALUE] = {0};
+
+		if (!context->lost)
+		{
+			continue;
+		}
+		if (cam->tid != 0)
+		{
+			// (The acquisition thread stopped when it found the camera gone).
+			pthread_join( cam->tid, NULL);
+			cam->tid = 0;
+			fprintf(stderr, "camera %d : lost - reconnecting\n", context->channel);
+		}
+		if (cam->handle != NULL)
+		{
+			// The buffers go back to the transfer before it is freed (a consumer may still hold some).
+			ReleaseDrainedBuffers( context);
+			if (HeldBufferCount( context) > 0)
+			{
+				numLost++;
+				continue;
+			}
+			s_acq->AbortTransfer( cam->handle);
+			s_acq->FreeTransfer( cam->handle);
+			s_acq->CloseCamera( &cam->handle);
+			cam->handle = NULL;
+			context->camHandle = NULL;
+		}
+
+		// Is it back ?
+		if (numDevices < 0)
+		{
+			numDevices = 0;
+			s_acq->GetCameraList( devices, MAX_CAMERAS, &numDevices);
+		}
+		for (j = 0; (j < numDevices) && (device == NULL); j++)
+		{
+			if (((devices[j].macHigh == cam->device.macHigh) && (devices[j].macLow == cam->device.macLow)) ||
+				 ((cam->device.serial[0] != '\0') && (strcmp(devices[j].serial, cam->device.serial) == 0)))
+			{
+				device = &devices[j];
+			}
+		}
+		if (device == NULL)
+		{
+			numLost++;
+			continue;
+		}
+
+		// Same settings, same buffers (only replaced if the camera now sends larger frames).
+		status = s_acq->OpenCamera( device, GevExclusiveMode, &cam->handle);
+		if (status == 0)
+		{
+			context->camHandle = cam->handle;
+			SetInterfaceOptions( cam, numStreams);
+			status = SetupTransfer( context, cam->bufAddress, cam->numBuffers, &cam->size, reply, sizeof(reply));
+			if (status != 0)
+			{
+				s_acq->CloseCamera( &cam->handle);
+				cam->handle = NULL;
+				context->camHandle = NULL;
+			}
+		}
+		if (status != 0)
+		{
+			fprintf(stderr, "camera %d : found but not reopened (%d%s%s) - retrying\n", context->channel, status, 
+						(reply[0] != '\0') ? " : " : "", reply);
+			cam->handle = NULL;
+			numLost++;
+			continue;
+		}
+		cam->device = *device;
+		cam->reconnects++;
+		CheckStreamSettings( cam);
+		context->discontinuity = TRUE;
+		context->lost = FALSE;
+		StartCamera( cam);
+		fprintf(stderr, "camera %d : reconnected\n", context->channel);
+	}
+	return numLost;
+}
+
+// Wait for "ms" unless SIGINT / SIGTERM comes (they are blocked - picked up here).
+// Returns the signal (0 = none).
+static int WaitForSignal( const sigset_t *signals, unsigned long ms)
+{
+	unsigned long origin = ms_timer_init();
+	unsigned long elapsed = 0;
 
+	while (elapsed < ms)
+	{
+		struct timespec timeout;
+		int sig = 0;
+
+		timeout.tv_sec = (ms - elapsed) / 1000;
+		timeout.tv_nsec = ((ms - elapsed) % 1000) * 1000000L;
+		sig = sigtimedwait( signals, NULL, &timeout);
+		if (sig > 0)
+		{
+			return sig;
+		}
+		if (errno != EINTR)
+		{
+			break;
+		}
+		elapsed = ms_timer_init() - origin;
+	}
 	return 0;
 }
 
+// Tune the stream settings of a camera (see Calibration.h) : stream with the settings of each trial
+// (only counting the frames) and save the best ones for this camera / NIC pair.
+// Returns the signal that stopped it (0 = ran to the end).
+static int CalibrateCamera( GEV_DEVICE_INTERFACE *device, int channel, const sigset_t *signals)
+{
+	MY_CAMERA *cam = (MY_CAMERA *)calloc(1, sizeof(MY_CAMERA));
+	CALIBRATION *cal = (CALIBRATION *)calloc(1, sizeof(CALIBRATION));
+	APP_CAMERA_CONFIG start;
+	APP_CAMERA_CONFIG trial;
+	PIPE_SPLICE idle;		// (Nothing is output while calibrating).
+	pthread_mutex_t idleLock = PTHREAD_MUTEX_INITIALIZER;
+	char nic[32];
+	char path[256];
+	char comment[128];
+	uint32_t mtu = 0;
+	int sig = 0;
+
+	if ((cam == NULL) || (cal == NULL))
+	{
+		free(cam);
+		free(cal);
+		return 0;
+	}
+	memset(&idle, 0, sizeof(idle));
+	Calibration_NicInfo( device->host.ipAddr, nic, sizeof(nic), &mtu);
+	AppConfig_GetCamera( &s_config, channel, &start);
+	Calibration_Init( cal, &start, mtu);
+	fprintf(stderr, "camera %d : calibrating on %s (MTU %u), %u s per setting\n", channel, nic, mtu, s_config.calibrate);
+
+	while ((sig == 0) && Calibration_Next( cal, &trial))
+	{
+		CALIBRATION_RESULT result;
+
+		memset(&result, 0, sizeof(result));
+		result.applied = trial;
+		AppConfig_SetCamera( &s_config, channel, &trial);
+		result.status = OpenCamera( cam, device, channel, 1, &idle, &idleLock);
+		if (result.status == 0)
+		{
+			ACQ_STATS_SNAPSHOT before;
+			ACQ_STATS_SNAPSHOT after;
+
+			cam->context.calibrating = TRUE;
+			StartCamera( cam);
+			sig = WaitForSignal( signals, CALIBRATE_WARMUP_MS);
+			AcqStats_Read( &cam->context.stats, &before);
+			if (sig == 0)
+			{
+				sig = WaitForSignal( signals, s_config.calibrate * 1000);
+			}
+			AcqStats_Read( &cam->context.stats, &after);
+			result.seconds = (double)(after.nsTaken - before.nsTaken) / 1e9;
+			result.frames = after.frames[ACQ_FRAME_COMPLETE] - before.frames[ACQ_FRAME_COMPLETE];
+			result.incomplete = AcqStats_Incomplete( &after) - AcqStats_Incomplete( &before);
+			result.missed = after.missed - before.missed;
+			result.applied = cam->config;
+		}
+		// (Also what a failed open had set up).
+		CloseCamera( cam);
+		FrameLease_Destroy( &cam->leasePool);
+		if (sig == 0)
+		{
+			Calibration_Report( cal, &result);
+			fprintf(stderr, "camera %d : ", channel);
+			Calibration_Print( &result, stderr);
+		}
+	}
+
+	if (sig != 0)
+	{
+		fprintf(stderr, "camera %d : calibration stopped - nothing saved\n", channel);
+	}
+	else
+	{
+		snprintf(path, sizeof(path), CALIBRATION_FILE, device->macHigh & 0xFFFF, device->macLow, nic);
+		snprintf(comment, sizeof(comment), "camera %04x%08x on %s (MTU %u)", device->macHigh & 0xFFFF, device->macLow, nic, mtu);
+		if (Calibration_Write( cal, path, comment) == 0)
+		{
+			fprintf(stderr, "camera %d : settings saved to %s (run with --config %s)\n", channel, path, path);
+		}
+		else
+		{
+			fprintf(stderr, "camera %d : settings could not be saved to %s\n", channel, path);
+		}
+	}
+	free(cal);
+	free(cam);
+	return sig;
+}
+
+int main(int argc, char* argv[])
+{
+	// Setup Gev
+	GEV_DEVICE_INTERFACE  pCamera[MAX_CAMERAS] = {0};
+	GEV_STATUS status;
+	int numCamera = 0;
+	int camIndex[MAX_STREAMS] = {0};
+	int numStreams = 0;
+	int numOpen = 0;
+	MY_CAMERA *cameras = NULL;
+	PIPE_SPLICE pipeOut;
+	pthread_mutex_t pipeLock = PTHREAD_MUTEX_INITIALIZER;
+#if COMMAND_INPUT
+	MY_CONTROL control;
+	pthread_t  commandTid;
+#endif
+	int done = FALSE;
+	sigset_t signals;
+	int signalFd = -1;
+	int timerFd = -1;
+	int lostFd = -1;			// Cameras lost (written by their acquisition threads).
+	int reconnectFd = -1;	// Reconnection attempts (while cameras are lost).
+	int syncFd = -1;			// Camera clock samples.
+	int firstArg = 1;
+	int i;
+
+	// Settings : the defaults above, then the configuration file, the environment and the command line.
+	memset(&s_config, 0, sizeof(s_config));
+	s_config.print = PRINT_STATEMENTS;
+	s_config.display = DISPLAY_WINDOW;
+	snprintf(s_config.backend, sizeof(s_config.backend), "%s", ACQ_BACKEND_NAME);
+	snprintf(s_config.backpressure, sizeof(s_config.backpressure), "%s", OUTPUT_BACKPRESSURE);
+	snprintf(s_config.leasePolicy, sizeof(s_config.leasePolicy), "%s", BUFFER_LEASE_POLICY);
+	s_config.camera.numBuffers = NUM_BUF;
+	s_config.camera.syncCycling = USE_SYNCHRONOUS_BUFFER_CYCLING;
+	s_config.camera.turboDrive = TURBO_DRIVE;
+	s_config.camera.tuneStreaming = TUNE_STREAMING_THREADS;
+	s_config.camera.packetSize = STREAM_PACKET_SIZE;
+	s_config.camera.packetDelay = STREAM_PACKET_DELAY;
+	s_config.camera.framesBuffered = STREAM_FRAMES_BUFFERED;
+	s_config.camera.memoryLimit = STREAM_MEMORY_LIMIT;
+	s_config.camera.frameTimeoutMs = STREAM_FRAME_TIMEOUT_MS;
+	s_config.camera.heartbeatTimeoutMs = HEARTBEAT_TIMEOUT_MS;
+	s_config.camera.hugePages = BUFFER_HUGE_PAGES;
+	s_config.camera.lockBuffers = BUFFER_LOCK;
+	s_config.camera.prefaultThreads = BUFFER_PREFAULT_THREADS;
+	s_config.camera.numaBind = BUFFER_NUMA_BIND;
+	s_config.calibrate = CALIBRATE_SECONDS;
+	s_config.reconnectMs = RECONNECT_INTERVAL_MS;
+	s_config.clockSyncMs = CLOCK_SYNC_INTERVAL_MS;
+	snprintf(s_config.record, sizeof(s_config.record), "%s", RECORD_PATH);
+	snprintf(s_config.acquisitionThreads, sizeof(s_config.acquisitionThreads), "%s", THREAD_POLICY_ACQUISITION);
+	snprintf(s_config.converterThreads, sizeof(s_config.converterThreads), "%s", THREAD_POLICY_CONVERTER);
+	snprintf(s_config.outputThreads, sizeof(s_config.outputThreads), "%s", THREAD_POLICY_OUTPUT);
+	snprintf(s_config.displayThreads, sizeof(s_config.displayThreads), "%s", THREAD_POLICY_DISPLAY);
+	s_config.stageDepth = PIPELINE_STAGE_DEPTH;
+	snprintf(s_config.stageOverflow, sizeof(s_config.stageOverflow), "%s", PIPELINE_STAGE_OVERFLOW);
+	s_config.convertThreads = PIPELINE_CONVERT_WORKERS;
+	s_config.convertBands = PIPELINE_CONVERT_BANDS;
+	snprintf(s_config.simd, sizeof(s_config.simd), "%s", CONVERT_SIMD);
+	status = AppConfig_Parse( &s_config, argc, argv, &firstArg);
+	if (status != 0)
+	{
+		return (status == CONFIG_ERROR_HELP) ? 0 : -1;
+	}
+
+	// SIGINT / SIGTERM are picked up by the main loop (signalfd) to shut down in order.
+	// They are blocked before any thread is started so that every thread inherits the mask.
+	sigemptyset(&signals);
+	sigaddset(&signals, SIGINT);
+	sigaddset(&signals, SIGTERM);
+	pthread_sigmask(SIG_BLOCK, &signals, NULL);
+
+	// Helper info
+	if (s_config.print)
+	{
+		printf("*** DISPLAY WINDOW %s, TO CHANGE USE --display=%d ***\n", s_config.display ? "ENABLED" : "DISABLED", !s_config.display);
+	}
+
+	// Boost application RT response per thread (not too high since GEV library boosts data receive thread to max allowed).
+	// SCHED_FIFO can cause many unintentional side effects.
+	// SCHED_RR has fewer side effects.
+	// SCHED_OTHER (normal default scheduler) is not too bad afer all.
+	{
+		const char *policies[THREAD_NUM_ROLES] = { s_config.acquisitionThreads, s_config.converterThreads, s_config.outputThreads, s_config.displayThreads };
+
+		for (i = 0; i < THREAD_NUM_ROLES; i++)
+		{
+			if (ThreadPolicy_Parse( policies[i], &s_threadPolicies[i]) != 0)
+			{
+				fprintf(stderr, "Bad %s thread policy \"%s\" (<class>[:<priority>][@<cpus>])\n", ThreadPolicy_RoleName( (THREAD_ROLE)i), policies[i]);
+				return -1;
+			}
+		}
+	}
+
+
+	if (FrameLease_ParsePolicy( s_config.leasePolicy) < 0)
+	{
+		fprintf(stderr, "Unknown buffer lease policy \"%s\"\n", s_config.leasePolicy);
+		return -1;
+	}
+	if (SpscRing_ParsePolicy( s_config.stageOverflow) < 0)
+	{
+		fprintf(stderr, "Unknown pipeline overflow policy \"%s\"\n", s_config.stageOverflow);
+		return -1;
+	}
+	if (ConvertSimd_ParseLevel( s_config.simd) < 0)
+	{
+		fprintf(stderr, "Unknown instruction set \"%s\" (auto | avx2 | sse4.1 | ssse3 | scalar)\n", s_config.simd);
+		return -1;
+	}
+	{
+		int level = ConvertSimd_Init( ConvertSimd_ParseLevel( s_config.simd));
+
+		if (s_config.print)
+		{
+			printf("Pixel conversion kernels : %s\n", ConvertSimd_LevelName( level));
+		}
+	}
+
+	// Pick the acquisition backend.
+	s_acq = AcqBackend_Select( s_config.backend);
+	if (s_acq == NULL)
+	{
+		fprintf(stderr, "Unknown acquisition backend (or bad settings) \"%s\"\n", s_config.backend);
+		return -1;
+	}
+
+	// Set default options for the library.
+	{
+		GEVLIB_CONFIG_OPTIONS options = {0};
+
+		GevGetLibraryConfigOptions( &options);
+		//options.logLevel = GEV_LOG_LEVEL_OFF;
+		//options.logLevel = GEV_LOG_LEVEL_TRACE;
+		options.logLevel = GEV_LOG_LEVEL_NORMAL;
+		GevSetLibraryConfigOptions( &options);
+	}
+
+	//====================================================================================
+	// DISCOVER Cameras
+	//
+	// Get all the IP addresses of attached network cards.
+
+	status = s_acq->GetCameraList( pCamera, MAX_CAMERAS, &numCamera);
+
+	if (s_config.print)
+	{
+		printf ("%d camera(s) on the network\n", numCamera);
+	}
+
+	// Select the first camera found (unless the command line has parameters = the camera indexes, or "all").
+	if (numCamera != 0)
+	{
+		if ((argc > firstArg) && (strcmp(argv[firstArg], "all") == 0))
+		{
+			for (i = 0; (i < numCamera) && (numStreams < MAX_STREAMS); i++)
+			{
+				camIndex[numStreams++] = i;
+			}
+		}
+		else if (argc > firstArg)
+		{
+			for (i = firstArg; (i < argc) && (numStreams < MAX_STREAMS); i++)
+			{
+				int index = -1;
+				sscanf(argv[i], "%d", &index);
+				if ((index < 0) || (index >= (int)numCamera))
+				{
+					if (s_config.print)
+					{
+						printf("Camera index %s out of range - only %d camera(s) are present\n", argv[i], numCamera);
+					}
+					continue;
+				}
+				camIndex[numStreams++] = index;
+			}
+		}
+		else
+		{
+			camIndex[numStreams++] = 0;
+		}
+	}
+
+	if ((numStreams > 0) && (s_config.calibrate > 0))
+	{
+		// Calibrate the cameras one after the other (each has the link to itself), then stop.
+		// (No window : only the delivery is measured).
+		s_config.display = FALSE;
+		for (i = 0; i < numStreams; i++)
+		{
+			if (CalibrateCamera( &pCamera[camIndex[i]], i, &signals) != 0)
+			{
+				break;
+			}
+		}
+		numStreams = 0;
+	}
+
+	if (numStreams > 0)
+	{
+		UINT64 maxSize = 0;
+
+		//====================================================================
+		// Connect to the cameras
+		//
+		// Each one gets its own context, buffers, acquisition thread and output. The cameras that
+		// write to stdout share it (the channel in the frame header tells their frames apart).
+		// Our threads stay off the cores the GEV stream / server threads are pinned to.
+		for (i = 0; i < numStreams; i++)
+		{
+			APP_CAMERA_CONFIG config;
+			int streamCpu = -1;
+			int serverCpu = -1;
+
+			AppConfig_GetCamera( &s_config, i, &config);
+			if (config.tuneStreaming)
+			{
+				StreamThreadCpus( i, numStreams, &streamCpu, &serverCpu);
+				ThreadPolicy_Reserve( streamCpu);
+				ThreadPolicy_Reserve( serverCpu);
+			}
+		}
+		// Pool converting the bands of the frames (placed with the conversion threads, off the reserved cores).
+		if (BandPool_Init( s_config.convertBands) == 0)
+		{
+			pthread_t bandThreads[BAND_POOL_MAX_THREADS];
+			int numBandThreads = BandPool_Threads( bandThreads, BAND_POOL_MAX_THREADS);
+
+			for (i = 0; i < numBandThreads; i++)
+			{
+				ThreadPolicy_Apply( bandThreads[i], &s_threadPolicies[THREAD_ROLE_CONVERTER], -1);
+			}
+		}
+		else
+		{
+			fprintf(stderr, "Band pool not started - frames are converted in one go\n");
+		}
+		cameras = (MY_CAMERA *)calloc(numStreams, sizeof(MY_CAMERA));
+		for (i = 0; (cameras != NULL) && (i < numStreams); i++)
+		{
+			if (OpenCamera( &cameras[i], &pCamera[camIndex[i]], i, numStreams, &pipeOut, &pipeLock) == 0)
+			{
+				maxSize = (cameras[i].size > maxSize) ? cameras[i].size : maxSize;
+				numOpen++;
+			}
+		}
+
+		if (numOpen > 0)
+		{
+			// stdout output (used when frames are not going to a camera's own output).
+			// Frames of several cameras are interleaved on it : leased frames are handed over by reference
+			// (vmsplice) and each lease drained from the pipe goes back to the camera it came from.
+			PipeSplice_Init( &pipeOut, STDOUT_FILENO, PIPE_OUTPUT_VMSPLICE,
+								PIPE_OUTPUT_FRAMES * numOpen * (maxSize + sizeof(FRAME_HEADER)));
+
+			// Cameras that stop answering are reconnected by the main loop.
+			if (s_config.reconnectMs > 0)
+			{
+				lostFd = eventfd(0, EFD_CLOEXEC);
+			}
+			for (i = 0; i < numStreams; i++)
+			{
+				if (cameras[i].handle != NULL)
+				{
+					cameras[i].context.lostFd = lostFd;
+					StartCamera( &cameras[i]);
+				}
+			}
+
+#if COMMAND_INPUT
+			// Take commands on stdin (the replies go to stderr unless GENICAM_ACK_FD names another descriptor).
+			{
+				const char *ackFd = getenv("GENICAM_ACK_FD");
+
+				memset(&control, 0, sizeof(control));
+				control.cameras = cameras;
+				control.numCameras = numStreams;
+				pthread_mutex_init(&control.lock, NULL);
+				pthread_cond_init(&control.cond, NULL);
+				control.wakeFd = eventfd(0, EFD_CLOEXEC);
+				if ((CommandChannel_Open( &control.channel, STDIN_FILENO, (ackFd != NULL) ? atoi(ackFd) : STDERR_FILENO) != 0) ||
+					 (pthread_create(&commandTid, NULL, CommandThread, &control) != 0))
+				{
+					fprintf(stderr, "Cannot take commands on stdin\n");
+					commandTid = 0;
+				}
+			}
+#endif
+
+			// main loop
+			// Sleeps until there is something to do : a signal (SIGINT / SIGTERM = shut down),
+			// a transfer change from the command thread, the stats timer, a camera to reconnect
+			// or the camera clocks to sample.
+			signalFd = signalfd( -1, &signals, SFD_CLOEXEC);
+			if (s_config.print)
+			{
+				timerFd = CreatePeriodicTimer( STATS_INTERVAL_MS);
+			}
+			if (s_config.clockSyncMs > 0)
+			{
+				syncFd = CreatePeriodicTimer( s_config.clockSyncMs);
+			}
+			while(!done)
+			{
+				struct pollfd fds[6];
+
+				fds[0].fd = signalFd;
+				fds[1].fd = timerFd;
+#if COMMAND_INPUT
+				fds[2].fd = control.wakeFd;
+#else
+				fds[2].fd = -1;
+#endif
+				fds[3].fd = lostFd;
+				fds[4].fd = reconnectFd;
+				fds[5].fd = syncFd;
+				for (i = 0; i < 6; i++)
+				{
+					fds[i].events = POLLIN;
+					fds[i].revents = 0;
+				}
+				if (poll(fds, 6, -1) < 0)
+				{
+					if (errno == EINTR)
+					{
+						continue;
+					}
+					break;
+				}
+
+				if (fds[0].revents & POLLIN)
+				{
+					struct signalfd_siginfo info;
+					if (read(signalFd, &info, sizeof(info)) == sizeof(info))
+					{
+						if (s_config.print)
+						{
+							printf("Signal %u - stopping\n", info.ssi_signo);
+						}
+						done = TRUE;
+					}
+				}
+				if (fds[1].revents & POLLIN)
+				{
+					uint64_t expirations = 0;
+					if (read(timerFd, &expirations, sizeof(expirations)) == sizeof(expirations))
+					{
+						for (i = 0; i < numStreams; i++)
+						{
+							if (cameras[i].handle != NULL)
+							{
+								PrintStats( &cameras[i].context, &cameras[i].lastStats, &cameras[i].lastLatency, &cameras[i].lastPipeline);
+							}
+						}
+						if (pipeOut.stats.frames > 0)
+						{
+							PipeSplice_PrintStats( &pipeOut, "stdout");
+						}
+						if (s_config.convertBands > 1)
+						{
+							BandPool_PrintStats( NULL);
+						}
+					}
+				}
+				if (fds[5].revents & POLLIN)
+				{
+					uint64_t expirations = 0;
+					if (read(syncFd, &expirations, sizeof(expirations)) == sizeof(expirations))
+					{
+						for (i = 0; i < numStreams; i++)
+						{
+							SyncCameraClock( &cameras[i], 1);
+						}
+					}
+				}
+				if ((fds[3].revents & POLLIN) || (fds[4].revents & POLLIN))
+				{
+					// A camera was lost (try straight away), or time for another attempt.
+					uint64_t count = 0;
+					if (((fds[3].revents & POLLIN) && (read(lostFd, &count, sizeof(count)) < 0)) ||
+						 ((fds[4].revents & POLLIN) && (read(reconnectFd, &count, sizeof(count)) < 0)))
+					{
+						count = 0;
+					}
+					if (ReconnectCameras( cameras, numStreams) > 0)
+					{
+						if (reconnectFd < 0)
+						{
+							reconnectFd = CreatePeriodicTimer( s_config.reconnectMs);
+						}
+					}
+					else if (reconnectFd >= 0)
+					{
+						close(reconnectFd);
+						reconnectFd = -1;
+					}
+				}
+#if COMMAND_INPUT
+				if (fds[2].revents & POLLIN)
+				{
+					// Apply the transfer change handed over by the command thread.
+					uint64_t count = 0;
+					if (read(control.wakeFd, &count, sizeof(count)) < 0)
+					{
+						count = 0;
+					}
+					pthread_mutex_lock(&control.lock);
+					if ((control.request != NULL) && control.target->context.lost)
+					{
+						// (Lost since the command was taken).
+						control.status = GEVLIB_ERROR_INVALID_HANDLE;
+						snprintf(control.reply, sizeof(control.reply), "camera lost - reconnecting");
+						control.request = NULL;
+						pthread_cond_broadcast(&control.cond);
+					}
+					else if (control.request != NULL)
+					{
+						MY_CAMERA *cam = control.target;
+						control.status = ChangeTransfer( &cam->context, &cam->tid, control.request, cam->bufAddress, cam->numBuffers, &cam->size,
+																	control.reply, sizeof(control.reply));
+						control.request = NULL;
+						pthread_cond_broadcast(&control.cond);
+					}
+					pthread_mutex_unlock(&control.lock);
+				}
+#endif
+			}
+			if (timerFd >= 0)
+			{
+				close(timerFd);
+			}
+			if (signalFd >= 0)
+			{
+				close(signalFd);
+			}
+			if (reconnectFd >= 0)
+			{
+				close(reconnectFd);
+			}
+			if (syncFd >= 0)
+			{
+				close(syncFd);
+			}
+
+#if COMMAND_INPUT
+			// Fail a transfer change still waiting for the main loop (and any that comes now) ...
+			pthread_mutex_lock(&control.lock);
+			control.shutdown = TRUE;
+			if (control.request != NULL)
+			{
+				control.status = GEVLIB_ERROR_SOFTWARE;
+				snprintf(control.reply, sizeof(control.reply), "shutting down");
+				control.request = NULL;
+				pthread_cond_broadcast(&control.cond);
+			}
+			pthread_mutex_unlock(&control.lock);
+			// ... then stop the command thread once the command it is on is answered (not cancelled in a feature access).
+			CommandChannel_Shutdown( &control.channel);
+			if (commandTid != 0)
+			{
+				pthread_join( commandTid, NULL);
+			}
+			CommandChannel_Close( &control.channel);
+			pthread_cond_destroy(&control.cond);
+			close(control.wakeFd);
+			pthread_mutex_destroy(&control.lock);
+#endif
+		}
+
+		for (i = 0; (cameras != NULL) && (i < numStreams); i++)
+		{
+			CloseCamera( &cameras[i]);
+		}
+		// (Only once every camera is closed : the shared pipe can hand a lease back to any camera's pool).
+		for (i = 0; (cameras != NULL) && (i < numStreams); i++)
+		{
+			FrameLease_Destroy( &cameras[i].leasePool);
+		}
+		if (lostFd >= 0)
+		{
+			close(lostFd);
+		}
+		if (s_config.print && (numOpen > 0))
+		{
+			PipeSplice_PrintStats( &pipeOut, "stdout");
+			if (s_config.convertBands > 1)
+			{
+				BandPool_PrintStats( NULL);
+			}
+		}
+		// (The cameras are closed : no frame is being converted).
+		BandPool_Close();
+		free(cameras);
+	}
+
+	// Close down the API.
+	GevApiUninitialize();
+
+	// Close socket API
+	_CloseSocketAPI ();	// must close API even on error
+
+
+	return 0;
+}
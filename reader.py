@@ -1,25 +1,308 @@
+import array
+import mmap
+import os
+import socket
+import struct
 import subprocess
+import time
 import numpy as np
 import cv2
 import traceback as tb
 import matplotlib.pyplot as plt
 
-# Obtained from running genicam with print statements
-IMG_HEIGHT = 1024
-IMG_WIDTH = 1280
-IMG_DEPTH = 1
+# Must match OUTPUT_TRANSPORT in cpp/genicam.cpp ('pipe', 'shm', 'socket' or 'memfd')
+TRANSPORT = 'pipe'
 
+# Command line of genicam, eg. ['--config', 'genicam.conf', '0', '1'] (see ./cpp/genicam --help)
+GENICAM_ARGS = []
+
+SHM_RING_PATH = '/dev/shm/genicam_frames'
+SOCKET_PATH = '/tmp/genicam_frames.sock'
+MEMFD_PATH = '/tmp/genicam_buffers.sock'
+
+# Shared memory ring layout (see cpp/FrameShmRing.h)
+FRAMESHM_MAGIC = 0x52465647
+RING_HEADER = struct.Struct('<IIIIQQQI20x')
+SLOT_HEADER = struct.Struct('<QQ48x')
+
+# memfd buffer sharing messages (see cpp/FrameMemfd.h)
+MEMFD_MAX_BUFFERS = 32
+MEMFD_HELLO_MAGIC = 0x484D5647
+MEMFD_NOTICE_MAGIC = 0x4E4D5647
+MEMFD_RELEASE_MAGIC = 0x524D5647
+MEMFD_HELLO = struct.Struct('<IIII%dQ' % MEMFD_MAX_BUFFERS)
+MEMFD_NOTICE = struct.Struct('<IIQQII64s')
+MEMFD_RELEASE = struct.Struct('<IIQ')
+
+# Frame header sent before every frame (see cpp/FrameHeader.h)
+FRAME_HEADER_MAGIC = 0x48465647
+FRAME_HEADER_FLAG_DISCONTINUITY = 0x0001
+FRAME_HEADER = struct.Struct('<IHHQQIIIIIHHQQ')
+MAGIC_BYTES = struct.pack('<I', FRAME_HEADER_MAGIC)
+
+# Bytes per pixel component for the payload pixel formats genicam sends.
+PIXEL_DTYPES = {
+    0x01080001: ('uint8', 1),    # Mono8
+    0x01100003: ('uint16', 1),   # Mono10
+    0x01100005: ('uint16', 1),   # Mono12
+    0x01100025: ('uint16', 1),   # Mono14
+    0x01100007: ('uint16', 1),   # Mono16
+    0x02180014: ('uint8', 3),    # RGB8Packed
+    0x02180015: ('uint8', 3),    # BGR8Packed
+    0x02200016: ('uint8', 4),    # RGBA8Packed
+    0x02200017: ('uint8', 4),    # BGRA8Packed
+}
+
+
+def parse_header(buf, offset=0):
+    """Return a dict with the header fields, or None if buf is not at a header."""
+    (magic, version, header_size, frame_id, timestamp, width, height,
+     pixel_format, stride, payload_length, channel, flags,
+     exposure_ns, arrival_ns) = FRAME_HEADER.unpack_from(buf, offset)
+    if magic != FRAME_HEADER_MAGIC or header_size < FRAME_HEADER.size:
+        return None
+    return dict(version=version, header_size=header_size, frame_id=frame_id,
+                timestamp=timestamp, width=width, height=height,
+                pixel_format=pixel_format, stride=stride,
+                payload_length=payload_length, channel=channel,
+                discontinuity=bool(flags & FRAME_HEADER_FLAG_DISCONTINUITY),
+                exposure_ns=exposure_ns, arrival_ns=arrival_ns)
+
+
+def to_image(header, payload):
+    dtype, channels = PIXEL_DTYPES.get(header['pixel_format'], ('uint8', 1))
+    image = np.frombuffer(payload, dtype=dtype)
+    if channels > 1:
+        return image.reshape((header['height'], header['width'], channels))
+    return image.reshape((header['height'], -1))[:, :header['width']]
+
+
+class PipeFrameReader(object):
+    """Reads header + payload frames from the genicam stdout pipe."""
+
+    def __init__(self, stream):
+        self.stream = stream
+        self.payload = bytearray()
+        self.pushback = b''   # Bytes read past a header while resyncing (read first).
+
+    def _read_exact(self, size):
+        data, self.pushback = self.pushback[:size], self.pushback[size:]
+        if len(data) < size:
+            data += self.stream.read(size - len(data))
+        if len(data) != size:
+            raise EOFError('genicam stream closed')
+        return data
+
+    def _resync(self, data):
+        # Lost alignment (partial read) - scan forward for the next magic.
+        start = 1
+        while True:
+            index = data.find(MAGIC_BYTES, start)
+            if index >= 0:
+                data = data[index:]
+                data += self._read_exact(max(0, FRAME_HEADER.size - len(data)))
+                self.pushback = data[FRAME_HEADER.size:] + self.pushback
+                return data[:FRAME_HEADER.size]
+            data = data[-(len(MAGIC_BYTES) - 1):] + self._read_exact(FRAME_HEADER.size)
+            start = 0
+
+    def read(self):
+        data = self._read_exact(FRAME_HEADER.size)
+        header = parse_header(data)
+        while header is None:
+            data = self._resync(data)
+            header = parse_header(data)
+        if header['header_size'] > FRAME_HEADER.size:
+            self._read_exact(header['header_size'] - FRAME_HEADER.size)
+        # The payload buffer is only reallocated when the geometry changes.
+        if len(self.payload) != header['payload_length']:
+            self.payload = bytearray(header['payload_length'])
+        view = memoryview(self.payload)
+        got = min(len(self.pushback), len(self.payload))
+        view[:got] = self.pushback[:got]
+        self.pushback = self.pushback[got:]
+        while got < len(self.payload):
+            n = self.stream.readinto(view[got:])
+            if not n:
+                raise EOFError('genicam stream closed')
+            got += n
+        return header, self.payload
+
+
+class ShmFrameReader(object):
+    """Follows the genicam shared memory frame ring without copying frames."""
+
+    def __init__(self, path, timeout=10.0):
+        deadline = time.time() + timeout
+        while True:
+            try:
+                with open(path, 'rb') as f:
+                    self.map = mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ)
+                magic = RING_HEADER.unpack_from(self.map, 0)[0]
+                if magic == FRAMESHM_MAGIC:
+                    break
+                self.map.close()
+            except (IOError, OSError, ValueError):
+                pass
+            if time.time() > deadline:
+                raise IOError('No frame ring at %s' % path)
+            time.sleep(0.1)
+        (_, _, self.num_slots, self.header_size, self.slot_size,
+         self.slot_stride, _, _) = RING_HEADER.unpack_from(self.map, 0)
+        self.next = 1
+
+    def _publish_count(self):
+        return RING_HEADER.unpack_from(self.map, 0)[6]
+
+    def _slot_offset(self, number):
+        return self.header_size + ((number - 1) % self.num_slots) * self.slot_stride
+
+    def read(self):
+        """Return (frame_number, view) for the newest frame. The view aliases
+        the shared memory - call valid() after using it."""
+        count = self._publish_count()
+        while count == 0 or count < self.next:
+            time.sleep(0.001)
+            count = self._publish_count()
+        # Always jump to the newest frame (a slow consumer just skips frames).
+        number = count
+        offset = self._slot_offset(number)
+        sequence, length = SLOT_HEADER.unpack_from(self.map, offset)
+        if sequence != 2 * number:
+            return None, None, None
+        self.next = number + 1
+        start = offset + SLOT_HEADER.size
+        header = parse_header(self.map, start)
+        if header is None:
+            return None, None, None
+        start += header['header_size']
+        return number, header, memoryview(self.map)[start:start + header['payload_length']]
+
+    def valid(self, number):
+        """True if the frame was not overwritten while it was in use."""
+        return SLOT_HEADER.unpack_from(self.map, self._slot_offset(number))[0] == 2 * number
+
+
+class MemfdFrameReader(object):
+    """Maps the genicam image buffers (memfd) - frames are never copied through the socket."""
+
+    def __init__(self, path, timeout=10.0):
+        deadline = time.time() + timeout
+        while True:
+            self.sock = socket.socket(socket.AF_UNIX, socket.SOCK_SEQPACKET)
+            try:
+                self.sock.connect(path)
+                break
+            except (IOError, OSError):
+                self.sock.close()
+                if time.time() > deadline:
+                    raise
+                time.sleep(0.1)
+        # The buffer descriptors come once, with the hello message.
+        fds = array.array('i')
+        msg, ancdata, _, _ = self.sock.recvmsg(
+            MEMFD_HELLO.size, socket.CMSG_SPACE(MEMFD_MAX_BUFFERS * fds.itemsize))
+        fields = MEMFD_HELLO.unpack(msg)
+        if fields[0] != MEMFD_HELLO_MAGIC:
+            raise IOError('Not a genicam buffer socket : %s' % path)
+        for level, kind, data in ancdata:
+            if level == socket.SOL_SOCKET and kind == socket.SCM_RIGHTS:
+                fds.frombytes(data[:len(data) - (len(data) % fds.itemsize)])
+        self.maps = []
+        for fd, size in zip(fds, fields[4:4 + fields[2]]):
+            self.maps.append(mmap.mmap(fd, size, mmap.MAP_SHARED, mmap.PROT_READ))
+            os.close(fd)
+
+    def read(self):
+        """Return (token, header, view). The view aliases the genicam buffer -
+        call release(token) when done with it so the buffer can be reused."""
+        while True:
+            data = self.sock.recv(MEMFD_NOTICE.size)
+            if len(data) != MEMFD_NOTICE.size:
+                raise EOFError('genicam buffer socket closed')
+            (magic, buffer, sequence, offset, header_size, _,
+             raw) = MEMFD_NOTICE.unpack(data)
+            header = parse_header(raw) if magic == MEMFD_NOTICE_MAGIC else None
+            if header is not None:
+                break
+        view = memoryview(self.maps[buffer])[offset:offset + header['payload_length']]
+        return (buffer, sequence), header, view
+
+    def release(self, token):
+        self.sock.send(MEMFD_RELEASE.pack(MEMFD_RELEASE_MAGIC, token[0], token[1]))
+
+
+def camera_command(line):
+    """Send one command line to genicam and return its reply line (see cpp/CommandChannel.h),
+    eg. camera_command('set ExposureTime 5000') -> 'ok set ExposureTime 5000'."""
+    process.stdin.write((line.strip() + '\n').encode())
+    process.stdin.flush()
+    return ack_stream.readline().decode().rstrip('\n')
+
+
+def connect_frame_server(path, timeout=10.0):
+    """Subscribe to the genicam frame socket (same stream format as stdout)."""
+    deadline = time.time() + timeout
+    while True:
+        sock = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+        try:
+            sock.connect(path)
+            return sock.makefile('rb')
+        except (IOError, OSError):
+            sock.close()
+            if time.time() > deadline:
+                raise
+            time.sleep(0.1)
+
+
+# Commands go to genicam's stdin, the replies come back on their own pipe (not mixed with the frames).
+ack_read, ack_write = os.pipe()
 process = subprocess.Popen(
-    "./cpp/genicam",
-    # stdin=subprocess.PIPE,
-    stdout=subprocess.PIPE)
+    ["./cpp/genicam"] + GENICAM_ARGS,
+    stdin=subprocess.PIPE,
+    stdout=subprocess.PIPE,
+    pass_fds=(ack_write,),
+    env=dict(os.environ, GENICAM_ACK_FD=str(ack_write)))
+os.close(ack_write)
+ack_stream = os.fdopen(ack_read, 'rb')
+print(camera_command('ping'))
+
+shm_reader = ShmFrameReader(SHM_RING_PATH) if TRANSPORT == 'shm' else None
+memfd_reader = MemfdFrameReader(MEMFD_PATH) if TRANSPORT == 'memfd' else None
+if TRANSPORT == 'socket':
+    # Any number of readers can subscribe to the same camera this way.
+    pipe_reader = PipeFrameReader(connect_frame_server(SOCKET_PATH))
+else:
+    pipe_reader = PipeFrameReader(process.stdout)
 
 while True:
     try:
-        data = process.stdout.read(IMG_HEIGHT * IMG_WIDTH)
-        image = np.fromstring(data, dtype='uint8')
-        image = image.reshape((IMG_HEIGHT, IMG_WIDTH))
-        print(image)
+        if memfd_reader is not None:
+            token, header, view = memfd_reader.read()
+            # Copy the frame out so the buffer can go back to genicam while it is displayed.
+            image = to_image(header, view).copy()
+            memfd_reader.release(token)
+        elif shm_reader is not None:
+            number, header, view = shm_reader.read()
+            if view is None:
+                continue
+            # Copy the frame out so it stays valid while it is being displayed.
+            image = to_image(header, view).copy()
+            if not shm_reader.valid(number):
+                # Overwritten while we copied it out - get a newer one.
+                continue
+        else:
+            header, payload = pipe_reader.read()
+            image = to_image(header, payload)
+        if header['discontinuity']:
+            # The camera was reconnected - the frame ids start again.
+            print('camera', header['channel'], 'reconnected')
+        if header['exposure_ns']:
+            # Exposure and arrival are on the host CLOCK_MONOTONIC_RAW, as time.clock_gettime_ns reads it.
+            now = time.clock_gettime_ns(time.CLOCK_MONOTONIC_RAW)
+            print('latency : wire %.3f ms, total %.3f ms' % ((header['arrival_ns'] - header['exposure_ns']) / 1e6,
+                                                          (now - header['exposure_ns']) / 1e6))
+        print(header['channel'], header['frame_id'], header['width'], header['height'], image)
         # cv2.imshow('Video', image)
         plt.imshow(image)
         plt.show()
@@ -29,4 +312,4 @@ while True:
 
 
 process.stdout.flush()
-cv2.destroyAllWindows()
\ No newline at end of file
+cv2.destroyAllWindows()